@@ -0,0 +1,600 @@
+#include "BenchmarkRunner.h"
+#include "DownloadManager.h"
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QTimer>
+#include <QUrl>
+#include <cstring>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// 校验文件时的读取块大小
+static const qint64 VERIFY_CHUNK = 1024 * 1024;
+
+// 超时取消后等待任务结束的最长时间
+static const int CANCEL_WAIT_MS = 10 * 1000;
+
+static const double BYTES_PER_MIB = 1024.0 * 1024.0;
+static const double BYTES_PER_GIB = 1024.0 * 1024.0 * 1024.0;
+
+BenchmarkRunner::BenchmarkRunner(const Options &options)
+    : m_options(options)
+    , m_manager(nullptr)
+{
+    // 测试模式下下载记录和缓存写入Qt的测试目录，先清空上次留下的数据，不影响用户的数据
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/ZiyanOS").removeRecursively();
+
+    m_manager = new DownloadManager();
+
+    // 测量网络下载本身，不使用下载缓存
+    m_manager->setCacheSizeLimit(0);
+}
+
+BenchmarkRunner::~BenchmarkRunner()
+{
+    delete m_manager;
+    m_server.stop();
+}
+
+QStringList BenchmarkRunner::scenarioNames()
+{
+    return { "large-h1", "large-h2", "small-h1", "small-h2", "resume", "concurrent" };
+}
+
+int BenchmarkRunner::run()
+{
+    QTextStream out(stdout);
+
+    if (!m_tempDir.isValid()) {
+        out << "无法创建临时目录" << Qt::endl;
+        return 2;
+    }
+    if (!m_server.start()) {
+        out << "无法启动回环测试服务器" << Qt::endl;
+        return 2;
+    }
+    out << "测试服务器: " << QString::fromStdString(m_server.url("/"))
+        << (LoopbackServer::http2Supported() ? "（HTTP/1.1 + HTTP/2）" : "（仅HTTP/1.1）") << Qt::endl;
+
+    const QStringList names = m_options.scenarios.isEmpty() ? scenarioNames() : m_options.scenarios;
+    QList<Result> results;
+    int failures = 0;
+
+    for (const QString &name : names) {
+        if (!scenarioNames().contains(name)) {
+            out << "未知的场景: " << name << Qt::endl;
+            ++failures;
+            continue;
+        }
+        if (name.endsWith("-h2") && !LoopbackServer::http2Supported()) {
+            out << name << ": 跳过（编译时没有nghttp2）" << Qt::endl;
+            continue;
+        }
+
+        Result result = runScenario(name);
+        printResult(result);
+        if (!result.ok) {
+            ++failures;
+        }
+        results.append(result);
+    }
+
+    // 写入结果，可以直接作为下一次运行的基线
+    if (!m_options.outputPath.isEmpty()) {
+        QJsonObject scenarios;
+        for (const Result &result : results) {
+            scenarios.insert(result.name, resultToJson(result));
+        }
+        QJsonObject root;
+        root.insert("version", 1);
+        root.insert("timestamp", QDateTime::currentDateTime().toString(Qt::ISODate));
+        root.insert("http2", LoopbackServer::http2Supported());
+        root.insert("scenarios", scenarios);
+
+        QFile file(m_options.outputPath);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            file.write(QJsonDocument(root).toJson());
+            out << "结果已写入: " << m_options.outputPath << Qt::endl;
+        } else {
+            out << "无法写入结果文件: " << m_options.outputPath << Qt::endl;
+            ++failures;
+        }
+    }
+
+    int regressions = 0;
+    if (!m_options.baselinePath.isEmpty()) {
+        regressions = compareBaseline(results);
+    }
+
+    return (failures > 0 || regressions > 0) ? 1 : 0;
+}
+
+BenchmarkRunner::Result BenchmarkRunner::runScenario(const QString &name)
+{
+    const QString dir = scenarioDir(name);
+    QDir().mkpath(dir);
+
+    auto dataUrl = [this](qint64 size, const QString &fileName, const QString &query = QString()) {
+        QString path = QString("/data/%1/%2").arg(size).arg(fileName);
+        if (!query.isEmpty()) {
+            path += "?" + query;
+        }
+        return QString::fromStdString(m_server.url(path.toStdString()));
+    };
+
+    Result result;
+    if (name == "large-h1" || name == "large-h2") {
+        // 单个大文件：主要衡量写入管线和校验的吞吐量
+        const qint64 size = m_options.largeSize;
+        result = runTasks(name, { dataUrl(size, name + ".bin") }, { dir + "/" + name + ".bin" }, { size },
+                          name.endsWith("-h2"), 1);
+    } else if (name == "small-h1" || name == "small-h2") {
+        // 大量小文件：主要衡量每个请求的固定开销和HTTP/2多路复用
+        QStringList urls;
+        QList<qint64> sizes;
+        for (int i = 0; i < m_options.smallCount; ++i) {
+            urls.append(dataUrl(m_options.smallSize, QString("f%1.bin").arg(i)));
+            sizes.append(m_options.smallSize);
+        }
+        result = runBatch(name, urls, dir, sizes, name.endsWith("-h2"));
+    } else if (name == "resume") {
+        // 传输到1/4处时连接被重置，1/2处停顿，任务应自动续传并得到完整正确的文件
+        const qint64 size = qMax<qint64>(16 * 1024 * 1024, m_options.largeSize / 4);
+        const QString query = QString("reset=%1&stall=%2:500").arg(size / 4).arg(size / 2);
+        result = runTasks(name, { dataUrl(size, "resume.bin", query) }, { dir + "/resume.bin" }, { size },
+                          false, 1);
+        if (result.ok && result.connections < 2) {
+            result.ok = false;
+            result.error = "连接重置没有生效";
+        }
+    } else if (name == "concurrent") {
+        // 多个任务同时下载：衡量任务线程和写入线程的扩展性
+        QStringList urls;
+        QStringList paths;
+        QList<qint64> sizes;
+        for (int i = 0; i < m_options.concurrentTasks; ++i) {
+            const QString fileName = QString("c%1.bin").arg(i);
+            urls.append(dataUrl(m_options.concurrentSize, fileName));
+            paths.append(dir + "/" + fileName);
+            sizes.append(m_options.concurrentSize);
+        }
+        result = runTasks(name, urls, paths, sizes, false, m_options.concurrentTasks);
+    }
+
+    QDir(dir).removeRecursively();
+    return result;
+}
+
+BenchmarkRunner::Result BenchmarkRunner::runTasks(const QString &name, const QStringList &urls,
+                                                  const QStringList &savePaths, const QList<qint64> &sizes,
+                                                  bool http2, int maxConcurrent)
+{
+    Result result;
+    result.name = name;
+
+    m_manager->setCleartextHttp2(http2);
+    m_manager->setMaxConcurrentDownloads(maxConcurrent);
+
+    QEventLoop loop;
+    QSet<int> pending;
+    QHash<int, int> finalStates;
+    QString lastError;
+    bool allEnqueued = false;
+    QElapsedTimer clock;
+
+    QList<QMetaObject::Connection> connections;
+    connections << QObject::connect(m_manager, &DownloadManager::taskStateChanged, [&](int taskId, int state) {
+        if (state == DownloadManager::Finished || state == DownloadManager::Failed
+            || state == DownloadManager::Canceled) {
+            finalStates.insert(taskId, state);
+            pending.remove(taskId);
+            if (allEnqueued && pending.isEmpty()) {
+                loop.quit();
+            }
+        }
+    });
+    connections << QObject::connect(m_manager, &DownloadManager::taskProgress, [&](int, qint64 received, qint64) {
+        if (result.ttfbMs < 0 && received > 0) {
+            result.ttfbMs = static_cast<double>(clock.nsecsElapsed()) / 1e6;
+        }
+    });
+    connections << QObject::connect(m_manager, &DownloadManager::downloadError, [&](const QString &message) {
+        lastError = message;
+    });
+
+    const Measure measure = beginMeasure();
+    clock.start();
+
+    for (int i = 0; i < urls.size(); ++i) {
+        const int taskId = m_manager->enqueueDownload(urls[i], savePaths[i]);
+        if (taskId < 0) {
+            lastError = "无法创建下载任务: " + urls[i];
+            break;
+        }
+        if (!finalStates.contains(taskId)) {
+            pending.insert(taskId);
+        }
+        result.bytes += sizes[i];
+    }
+    allEnqueued = true;
+
+    bool timedOut = false;
+    if (!pending.isEmpty()) {
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        QObject::connect(&timeout, &QTimer::timeout, &loop, [&]() {
+            timedOut = true;
+            loop.quit();
+        });
+        timeout.start(m_options.timeoutSeconds * 1000);
+        loop.exec();
+    }
+    endMeasure(measure, &result);
+
+    if (timedOut) {
+        // 取消剩余任务并等待它们结束
+        for (int taskId : pending) {
+            m_manager->cancelTask(taskId);
+        }
+        QTimer::singleShot(CANCEL_WAIT_MS, &loop, &QEventLoop::quit);
+        if (!pending.isEmpty()) {
+            loop.exec();
+        }
+    }
+
+    for (const QMetaObject::Connection &connection : connections) {
+        QObject::disconnect(connection);
+    }
+
+    int failed = 0;
+    for (int state : finalStates) {
+        if (state != DownloadManager::Finished) {
+            ++failed;
+        }
+    }
+
+    if (timedOut) {
+        result.error = QString("超过%1秒没有完成").arg(m_options.timeoutSeconds);
+    } else if (failed > 0 || finalStates.size() != urls.size()) {
+        result.error = QString("%1个任务失败: %2").arg(qMax(failed, 1)).arg(lastError);
+    } else {
+        result.ok = true;
+    }
+
+    if (result.ok && m_options.verify) {
+        for (int i = 0; i < savePaths.size() && result.ok; ++i) {
+            result.ok = verifyFile(savePaths[i], sizes[i], &result.error);
+        }
+    }
+
+    // 不保留测试任务的下载记录
+    m_manager->clearHistory();
+    return result;
+}
+
+BenchmarkRunner::Result BenchmarkRunner::runBatch(const QString &name, const QStringList &urls,
+                                                  const QString &targetDir, const QList<qint64> &sizes, bool http2)
+{
+    Result result;
+    result.name = name;
+
+    m_manager->setCleartextHttp2(http2);
+
+    QEventLoop loop;
+    int batchId = -1;
+    bool finished = false;
+    int succeeded = 0;
+    int failed = 0;
+    QString lastError;
+    QElapsedTimer clock;
+
+    QList<QMetaObject::Connection> connections;
+    connections << QObject::connect(m_manager, &DownloadManager::batchProgress,
+                                    [&](int id, int, int, qint64 bytesReceived) {
+        if (id == batchId && result.ttfbMs < 0 && bytesReceived > 0) {
+            result.ttfbMs = static_cast<double>(clock.nsecsElapsed()) / 1e6;
+        }
+    });
+    connections << QObject::connect(m_manager, &DownloadManager::batchFileFailed,
+                                    [&](int id, const QString &url, const QString &message) {
+        if (id == batchId) {
+            lastError = url + ": " + message;
+        }
+    });
+    connections << QObject::connect(m_manager, &DownloadManager::batchFinished,
+                                    [&](int id, int ok, int bad, bool) {
+        if (id == batchId) {
+            finished = true;
+            succeeded = ok;
+            failed = bad;
+            loop.quit();
+        }
+    });
+    connections << QObject::connect(m_manager, &DownloadManager::downloadError, [&](const QString &message) {
+        lastError = message;
+    });
+
+    for (qint64 size : sizes) {
+        result.bytes += size;
+    }
+
+    const Measure measure = beginMeasure();
+    clock.start();
+    batchId = m_manager->startBatchDownload(urls, targetDir);
+
+    bool timedOut = false;
+    if (batchId >= 0) {
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        QObject::connect(&timeout, &QTimer::timeout, &loop, [&]() {
+            timedOut = true;
+            loop.quit();
+        });
+        timeout.start(m_options.timeoutSeconds * 1000);
+        loop.exec();
+    }
+    endMeasure(measure, &result);
+
+    if (timedOut && !finished) {
+        m_manager->cancelBatch(batchId);
+        QTimer::singleShot(CANCEL_WAIT_MS, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    for (const QMetaObject::Connection &connection : connections) {
+        QObject::disconnect(connection);
+    }
+
+    if (batchId < 0) {
+        result.error = "无法开始批量下载: " + lastError;
+    } else if (timedOut) {
+        result.error = QString("超过%1秒没有完成").arg(m_options.timeoutSeconds);
+    } else if (failed > 0 || succeeded != urls.size()) {
+        result.error = QString("%1个文件失败: %2").arg(qMax(failed, 1)).arg(lastError);
+    } else {
+        result.ok = true;
+    }
+
+    if (result.ok && m_options.verify) {
+        for (int i = 0; i < urls.size() && result.ok; ++i) {
+            const QString path = targetDir + "/" + QUrl(urls[i]).fileName();
+            result.ok = verifyFile(path, sizes[i], &result.error);
+        }
+    }
+    return result;
+}
+
+BenchmarkRunner::Measure BenchmarkRunner::beginMeasure()
+{
+    resetPeakRss();
+
+    Measure measure;
+    measure.startServer = m_server.stats();
+    measure.startCpu = processCpuSeconds();
+    measure.timer.start();
+    return measure;
+}
+
+void BenchmarkRunner::endMeasure(const Measure &measure, Result *result)
+{
+    const qint64 elapsedNs = measure.timer.nsecsElapsed();
+    const double cpu = processCpuSeconds() - measure.startCpu;
+    const LoopbackServer::Stats server = m_server.stats();
+
+    result->seconds = qMax(1e-6, static_cast<double>(elapsedNs) / 1e9);
+    result->mibPerSecond = static_cast<double>(result->bytes) / BYTES_PER_MIB / result->seconds;
+    result->serverCpuSeconds = server.cpuSeconds - measure.startServer.cpuSeconds;
+    result->connections = server.connections - measure.startServer.connections;
+
+    // 测试服务器运行在同一进程中，扣除它消耗的CPU时间
+    const double clientCpu = qMax(0.0, cpu - result->serverCpuSeconds);
+    if (result->bytes > 0) {
+        result->clientCpuPerGiB = clientCpu / (static_cast<double>(result->bytes) / BYTES_PER_GIB);
+    }
+    result->peakRssMiB = peakRssMiB();
+}
+
+bool BenchmarkRunner::verifyFile(const QString &path, qint64 size, QString *error) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = "无法打开下载的文件: " + path;
+        return false;
+    }
+    if (file.size() != size) {
+        *error = QString("文件大小不符: %1（期望%2，实际%3）").arg(path).arg(size).arg(file.size());
+        return false;
+    }
+
+    QByteArray actual(static_cast<qsizetype>(VERIFY_CHUNK), Qt::Uninitialized);
+    QByteArray expected(static_cast<qsizetype>(VERIFY_CHUNK), Qt::Uninitialized);
+    qint64 offset = 0;
+    while (offset < size) {
+        const qint64 bytesRead = file.read(actual.data(), qMin(VERIFY_CHUNK, size - offset));
+        if (bytesRead <= 0) {
+            *error = "读取下载的文件失败: " + path;
+            return false;
+        }
+        LoopbackServer::fillContent(static_cast<uint64_t>(offset), expected.data(), static_cast<size_t>(bytesRead));
+        if (std::memcmp(actual.constData(), expected.constData(), static_cast<size_t>(bytesRead)) != 0) {
+            *error = QString("文件内容不符: %1（偏移%2之后）").arg(path).arg(offset);
+            return false;
+        }
+        offset += bytesRead;
+    }
+    return true;
+}
+
+QString BenchmarkRunner::scenarioDir(const QString &name) const
+{
+    return m_tempDir.path() + "/" + name;
+}
+
+QJsonObject BenchmarkRunner::resultToJson(const Result &result) const
+{
+    QJsonObject object;
+    object.insert("ok", result.ok);
+    if (!result.error.isEmpty()) {
+        object.insert("error", result.error);
+    }
+    object.insert("bytes", static_cast<double>(result.bytes));
+    object.insert("seconds", result.seconds);
+    object.insert("mibPerSecond", result.mibPerSecond);
+    object.insert("ttfbMs", result.ttfbMs);
+    object.insert("clientCpuPerGiB", result.clientCpuPerGiB);
+    object.insert("serverCpuSeconds", result.serverCpuSeconds);
+    object.insert("peakRssMiB", result.peakRssMiB);
+    object.insert("connections", result.connections);
+    return object;
+}
+
+void BenchmarkRunner::printResult(const Result &result) const
+{
+    QTextStream out(stdout);
+    out << QString("%1 %2 MiB/s  首字节 %3 ms  CPU %4 s/GiB  内存峰值 %5 MiB  连接 %6")
+               .arg(result.name, -12)
+               .arg(result.mibPerSecond, 9, 'f', 1)
+               .arg(result.ttfbMs, 7, 'f', 1)
+               .arg(result.clientCpuPerGiB, 6, 'f', 2)
+               .arg(result.peakRssMiB, 7, 'f', 1)
+               .arg(result.connections);
+    if (!result.ok) {
+        out << "  失败: " << result.error;
+    }
+    out << Qt::endl;
+}
+
+int BenchmarkRunner::compareBaseline(const QList<Result> &results) const
+{
+    QTextStream out(stdout);
+
+    QFile file(m_options.baselinePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        out << "无法读取基线文件: " << m_options.baselinePath << Qt::endl;
+        return 1;
+    }
+    const QJsonObject baseline = QJsonDocument::fromJson(file.readAll()).object().value("scenarios").toObject();
+    if (baseline.isEmpty()) {
+        out << "基线文件中没有场景数据: " << m_options.baselinePath << Qt::endl;
+        return 1;
+    }
+
+    const double tolerance = m_options.tolerance;
+    int regressions = 0;
+    auto report = [&](const QString &scenario, const QString &metric, double value, double base) {
+        out << QString("退化: %1 %2 %3（基线 %4，允许 %5%）")
+                   .arg(scenario, metric)
+                   .arg(value, 0, 'f', 2)
+                   .arg(base, 0, 'f', 2)
+                   .arg(tolerance * 100, 0, 'f', 0)
+            << Qt::endl;
+        ++regressions;
+    };
+
+    for (const Result &result : results) {
+        if (!result.ok || !baseline.contains(result.name)) {
+            continue;
+        }
+        const QJsonObject base = baseline.value(result.name).toObject();
+
+        // 吞吐量越高越好，CPU和内存越低越好
+        const double baseSpeed = base.value("mibPerSecond").toDouble();
+        if (baseSpeed > 0 && result.mibPerSecond < baseSpeed * (1.0 - tolerance)) {
+            report(result.name, "吞吐量(MiB/s)", result.mibPerSecond, baseSpeed);
+        }
+        const double baseCpu = base.value("clientCpuPerGiB").toDouble();
+        if (baseCpu > 0 && result.clientCpuPerGiB > baseCpu * (1.0 + tolerance)) {
+            report(result.name, "CPU(s/GiB)", result.clientCpuPerGiB, baseCpu);
+        }
+        const double baseRss = base.value("peakRssMiB").toDouble();
+        if (baseRss > 0 && result.peakRssMiB > baseRss * (1.0 + tolerance)) {
+            report(result.name, "内存峰值(MiB)", result.peakRssMiB, baseRss);
+        }
+    }
+
+    if (regressions == 0) {
+        out << "与基线相比没有退化" << Qt::endl;
+    }
+    return regressions;
+}
+
+double BenchmarkRunner::processCpuSeconds()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return static_cast<double>(kernel.QuadPart + user.QuadPart) / 1e7;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+           + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+void BenchmarkRunner::resetPeakRss()
+{
+#if defined(Q_OS_LINUX)
+    // 写入5把VmHWM重置为当前RSS，使每个场景单独统计峰值
+    QFile clearRefs("/proc/self/clear_refs");
+    if (clearRefs.open(QIODevice::WriteOnly)) {
+        clearRefs.write("5");
+    }
+#endif
+    // 其他平台无法重置，报告的是进程启动以来的峰值
+}
+
+double BenchmarkRunner::peakRssMiB()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return static_cast<double>(counters.PeakWorkingSetSize) / BYTES_PER_MIB;
+#elif defined(Q_OS_LINUX)
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith("VmHWM:")) {
+            return line.mid(6).trimmed().split(' ').value(0).toDouble() / 1024.0;   // kB
+        }
+    }
+    return 0;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(Q_OS_MACOS)
+    return static_cast<double>(usage.ru_maxrss) / BYTES_PER_MIB;        // 字节
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;               // kB
+#endif
+#endif
+}
@@ -0,0 +1,100 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include "LoopbackServer.h"
+
+class DownloadManager;
+
+// 下载性能测试：在回环测试服务器上按脚本场景运行DownloadManager，
+// 报告吞吐量、首字节时间、每GiB的客户端CPU时间和内存峰值，并可以与基线比较
+class BenchmarkRunner
+{
+public:
+    struct Options {
+        QStringList scenarios;          // 为空时运行全部场景
+        bool verify = true;             // 下载完成后校验文件内容（不计入耗时）
+        QString outputPath;             // 结果JSON输出路径
+        QString baselinePath;           // 基线JSON路径
+        double tolerance = 0.15;        // 与基线比较时允许的相对退化
+        qint64 largeSize = 1024LL * 1024 * 1024;
+        int smallCount = 1000;
+        qint64 smallSize = 16 * 1024;
+        int concurrentTasks = 8;
+        qint64 concurrentSize = 128LL * 1024 * 1024;
+        int timeoutSeconds = 600;       // 单个场景的最长时间
+    };
+
+    // 单个场景的结果
+    struct Result {
+        QString name;
+        bool ok = false;
+        QString error;
+        qint64 bytes = 0;
+        double seconds = 0;
+        double mibPerSecond = 0;
+        double ttfbMs = -1;             // 开始到收到第一批数据的时间
+        double clientCpuPerGiB = 0;     // 客户端（不含测试服务器）每GiB消耗的CPU秒数
+        double serverCpuSeconds = 0;
+        double peakRssMiB = 0;
+        int connections = 0;
+    };
+
+    explicit BenchmarkRunner(const Options &options);
+    ~BenchmarkRunner();
+
+    // 运行所选场景，返回进程退出码（有失败或相对基线退化时非0）
+    int run();
+
+    // 全部场景名称
+    static QStringList scenarioNames();
+
+private:
+    // 单个文件任务（可以多个并发），urls与保存路径一一对应
+    Result runTasks(const QString &name, const QStringList &urls, const QStringList &savePaths,
+                    const QList<qint64> &sizes, bool http2, int maxConcurrent);
+
+    // 批量下载（同一主机的请求多路复用）
+    Result runBatch(const QString &name, const QStringList &urls, const QString &targetDir,
+                    const QList<qint64> &sizes, bool http2);
+
+    Result runScenario(const QString &name);
+
+    // 准备和结束一次测量
+    struct Measure {
+        QElapsedTimer timer;
+        double startCpu = 0;
+        LoopbackServer::Stats startServer;
+    };
+    Measure beginMeasure();
+    void endMeasure(const Measure &measure, Result *result);
+
+    // 按测试服务器的内容规则校验下载的文件
+    bool verifyFile(const QString &path, qint64 size, QString *error) const;
+
+    QString scenarioDir(const QString &name) const;
+
+    QJsonObject resultToJson(const Result &result) const;
+    void printResult(const Result &result) const;
+
+    // 与基线比较，返回退化的项目数
+    int compareBaseline(const QList<Result> &results) const;
+
+    // 进程CPU时间（秒）和内存峰值（MiB）
+    static double processCpuSeconds();
+    static void resetPeakRss();
+    static double peakRssMiB();
+
+    Options m_options;
+    LoopbackServer m_server;
+    QTemporaryDir m_tempDir;
+    DownloadManager *m_manager;
+};
+
+#endif // BENCHMARKRUNNER_H
@@ -0,0 +1,960 @@
+#include "LoopbackServer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#include <windows.h>
+#define pollSockets WSAPoll
+#define closeSocket closesocket
+static const SocketHandle INVALID_HANDLE = INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#define pollSockets poll
+#define closeSocket close
+static const SocketHandle INVALID_HANDLE = -1;
+#endif
+
+#ifdef ZIYANOS_HAVE_NGHTTP2
+#ifdef _MSC_VER
+#include <basetsd.h>
+typedef SSIZE_T ssize_t;                // nghttp2的回调使用ssize_t
+#endif
+#include <nghttp2/nghttp2.h>
+#endif
+
+// 响应体单次发送的最大长度
+static const size_t BODY_CHUNK = 64 * 1024;
+
+// 请求头的最大长度
+static const size_t MAX_HEADER_SIZE = 64 * 1024;
+
+// 等待套接字时单次等待的最长时间，保证stop()能及时生效
+static const int POLL_SLICE_MS = 100;
+
+// 限速时单次发送不超过1/20秒的数据量，使速率平滑
+static const uint64_t RATE_SLICES_PER_SECOND = 20;
+
+// HTTP/2客户端连接序言
+static const char HTTP2_PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+static const size_t HTTP2_PREFACE_LENGTH = sizeof(HTTP2_PREFACE) - 1;
+
+static double nowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void sleepMs(int ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// 解析十进制整数，不允许空串和多余字符
+static bool parseNumber(const std::string &text, uint64_t *value)
+{
+    if (text.empty() || text.size() > 19) {
+        return false;
+    }
+    uint64_t result = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        result = result * 10 + static_cast<uint64_t>(c - '0');
+    }
+    *value = result;
+    return true;
+}
+
+static std::string toLower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+        return static_cast<char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+    });
+    return text;
+}
+
+static std::string trim(const std::string &text)
+{
+    const size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    const size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+// 等待套接字可读，超时返回false（出错时返回true，由随后的recv报告）
+static bool waitReadable(SocketHandle socket, int timeoutMs)
+{
+    pollfd descriptor;
+    descriptor.fd = socket;
+    descriptor.events = POLLIN;
+    descriptor.revents = 0;
+    return pollSockets(&descriptor, 1, timeoutMs) != 0;
+}
+
+static int receiveSome(SocketHandle socket, char *data, size_t length)
+{
+    return static_cast<int>(recv(socket, data, static_cast<int>(length), 0));
+}
+
+static const char *reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 416: return "Range Not Satisfiable";
+    default: return "Error";
+    }
+}
+
+#ifdef ZIYANOS_HAVE_NGHTTP2
+// HTTP/2的一个请求流
+struct Http2Stream {
+    std::string method;
+    std::string path;
+    std::string range;
+    LoopbackServer::BodyCursor cursor;
+};
+
+// HTTP/2连接状态及nghttp2回调
+struct Http2Session {
+    LoopbackServer *server;
+    LoopbackServer::Connection *connection;
+    std::map<int32_t, std::unique_ptr<Http2Stream>> streams;
+
+    static ssize_t send(nghttp2_session *, const uint8_t *data, size_t length, int, void *userData)
+    {
+        Http2Session *self = static_cast<Http2Session*>(userData);
+        if (!LoopbackServer::sendAll(self->connection->socket, reinterpret_cast<const char*>(data), length)) {
+            return NGHTTP2_ERR_CALLBACK_FAILURE;
+        }
+        return static_cast<ssize_t>(length);
+    }
+
+    static int beginHeaders(nghttp2_session *, const nghttp2_frame *frame, void *userData)
+    {
+        Http2Session *self = static_cast<Http2Session*>(userData);
+        if (frame->hd.type == NGHTTP2_HEADERS && frame->headers.cat == NGHTTP2_HCAT_REQUEST) {
+            self->streams[frame->hd.stream_id].reset(new Http2Stream());
+        }
+        return 0;
+    }
+
+    static int header(nghttp2_session *, const nghttp2_frame *frame, const uint8_t *name, size_t nameLength,
+                      const uint8_t *value, size_t valueLength, uint8_t, void *userData)
+    {
+        Http2Session *self = static_cast<Http2Session*>(userData);
+        auto it = self->streams.find(frame->hd.stream_id);
+        if (it == self->streams.end()) {
+            return 0;
+        }
+        const std::string headerName(reinterpret_cast<const char*>(name), nameLength);
+        const std::string headerValue(reinterpret_cast<const char*>(value), valueLength);
+        if (headerName == ":method") {
+            it->second->method = headerValue;
+        } else if (headerName == ":path") {
+            it->second->path = headerValue;
+        } else if (headerName == "range") {
+            it->second->range = headerValue;
+        }
+        return 0;
+    }
+
+    static int frameReceived(nghttp2_session *session, const nghttp2_frame *frame, void *userData)
+    {
+        Http2Session *self = static_cast<Http2Session*>(userData);
+        const bool requestEnded = (frame->hd.type == NGHTTP2_HEADERS || frame->hd.type == NGHTTP2_DATA)
+                                  && (frame->hd.flags & NGHTTP2_FLAG_END_STREAM);
+        if (!requestEnded) {
+            return 0;
+        }
+        auto it = self->streams.find(frame->hd.stream_id);
+        if (it == self->streams.end()) {
+            return 0;
+        }
+        return self->respond(session, frame->hd.stream_id, it->second.get());
+    }
+
+    static int streamClosed(nghttp2_session *, int32_t streamId, uint32_t, void *userData)
+    {
+        Http2Session *self = static_cast<Http2Session*>(userData);
+        self->streams.erase(streamId);
+        return 0;
+    }
+
+    static ssize_t readBody(nghttp2_session *, int32_t, uint8_t *buffer, size_t length, uint32_t *dataFlags,
+                            nghttp2_data_source *source, void *userData)
+    {
+        Http2Session *self = static_cast<Http2Session*>(userData);
+        Http2Stream *stream = static_cast<Http2Stream*>(source->ptr);
+        LoopbackServer::BodyCursor *cursor = &stream->cursor;
+
+        // 重置故障只影响这个流，连接上的其他请求继续
+        if (self->server->applyFaults(cursor)) {
+            return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+        }
+
+        const size_t chunk = self->server->nextChunk(cursor, length);
+        if (chunk > 0) {
+            LoopbackServer::fillContent(cursor->position, reinterpret_cast<char*>(buffer), chunk);
+            cursor->position += chunk;
+            cursor->sent += chunk;
+            self->server->m_bytesSent += chunk;
+            self->server->accountCpu(self->connection);
+        }
+        if (cursor->position >= cursor->end) {
+            *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+        }
+        return static_cast<ssize_t>(chunk);
+    }
+
+    int respond(nghttp2_session *session, int32_t streamId, Http2Stream *stream)
+    {
+        LoopbackServer::HeaderList headers;
+        const int status = server->prepareResponse(stream->method, stream->path, stream->range,
+                                                   &stream->cursor, &headers);
+        const std::string statusText = std::to_string(status);
+
+        std::vector<nghttp2_nv> nva;
+        nva.reserve(headers.size() + 1);
+        auto addHeader = [&nva](const std::string &name, const std::string &value) {
+            nghttp2_nv nv;
+            nv.name = reinterpret_cast<uint8_t*>(const_cast<char*>(name.data()));
+            nv.value = reinterpret_cast<uint8_t*>(const_cast<char*>(value.data()));
+            nv.namelen = name.size();
+            nv.valuelen = value.size();
+            nv.flags = NGHTTP2_NV_FLAG_NONE;
+            nva.push_back(nv);
+        };
+        static const std::string statusName(":status");
+        addHeader(statusName, statusText);
+        for (const auto &entry : headers) {
+            addHeader(entry.first, entry.second);
+        }
+
+        nghttp2_data_provider provider;
+        provider.source.ptr = stream;
+        provider.read_callback = readBody;
+        const bool hasBody = stream->cursor.end > stream->cursor.position;
+        return nghttp2_submit_response(session, streamId, nva.data(), nva.size(), hasBody ? &provider : nullptr);
+    }
+};
+#endif
+
+LoopbackServer::LoopbackServer()
+    : m_listenSocket(INVALID_HANDLE)
+    , m_port(0)
+    , m_stopping(false)
+    , m_bytesSent(0)
+    , m_connectionCount(0)
+    , m_http2Count(0)
+    , m_cpuMicros(0)
+{
+}
+
+LoopbackServer::~LoopbackServer()
+{
+    stop();
+}
+
+bool LoopbackServer::start()
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        return false;
+    }
+#endif
+
+    m_listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (m_listenSocket == INVALID_HANDLE) {
+        return false;
+    }
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    socklen_t addressLength = sizeof(address);
+    if (bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(m_listenSocket, SOMAXCONN) != 0
+        || getsockname(m_listenSocket, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0) {
+        closeSocket(m_listenSocket);
+        m_listenSocket = INVALID_HANDLE;
+        return false;
+    }
+    m_port = ntohs(address.sin_port);
+
+    m_stopping = false;
+    m_acceptThread = std::thread([this]() { acceptLoop(); });
+    return true;
+}
+
+void LoopbackServer::stop()
+{
+    if (!m_acceptThread.joinable()) {
+        return;
+    }
+
+    m_stopping = true;
+    m_acceptThread.join();
+
+    // 断开所有连接，唤醒阻塞在收发中的连接线程
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+    for (const auto &connection : m_connections) {
+        std::lock_guard<std::mutex> socketLock(connection->socketMutex);
+        if (connection->socket != INVALID_HANDLE) {
+            shutdown(connection->socket, 2);
+        }
+    }
+    for (const auto &connection : m_connections) {
+        connection->thread.join();
+    }
+    m_connections.clear();
+
+    closeSocket(m_listenSocket);
+    m_listenSocket = INVALID_HANDLE;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+std::string LoopbackServer::url(const std::string &path) const
+{
+    return "http://127.0.0.1:" + std::to_string(m_port) + path;
+}
+
+bool LoopbackServer::http2Supported()
+{
+#ifdef ZIYANOS_HAVE_NGHTTP2
+    return true;
+#else
+    return false;
+#endif
+}
+
+LoopbackServer::Stats LoopbackServer::stats() const
+{
+    Stats result;
+    result.bytesSent = m_bytesSent.load();
+    result.connections = m_connectionCount.load();
+    result.http2Connections = m_http2Count.load();
+    result.cpuSeconds = static_cast<double>(m_cpuMicros.load()) / 1e6;
+    return result;
+}
+
+// splitmix64：每8字节一个值，任意偏移都可以直接计算
+static inline uint64_t contentWord(uint64_t index)
+{
+    uint64_t x = index + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// 把一个值的指定字节按小端字节序写出，与主机字节序无关
+static inline void storeWordBytes(uint64_t word, size_t first, size_t count, char *data)
+{
+    for (size_t i = 0; i < count; ++i) {
+        data[i] = static_cast<char>(word >> (8 * (first + i)));
+    }
+}
+
+void LoopbackServer::fillContent(uint64_t offset, char *data, size_t length)
+{
+    // 起始位置不是8字节对齐时先补齐
+    const size_t skip = static_cast<size_t>(offset % 8);
+    if (skip != 0 && length > 0) {
+        const size_t count = std::min<size_t>(8 - skip, length);
+        storeWordBytes(contentWord(offset / 8), skip, count, data);
+        data += count;
+        offset += count;
+        length -= count;
+    }
+
+    uint64_t index = offset / 8;
+    while (length >= 8) {
+        const uint64_t word = contentWord(index++);
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        std::memcpy(data, &word, 8);    // 小端主机直接整体写入，逐字节写出会慢好几倍
+#else
+        storeWordBytes(word, 0, 8, data);
+#endif
+        data += 8;
+        length -= 8;
+    }
+
+    if (length > 0) {
+        storeWordBytes(contentWord(index), 0, length, data);
+    }
+}
+
+int64_t LoopbackServer::parseSize(const std::string &text)
+{
+    if (text.empty()) {
+        return -1;
+    }
+    uint64_t multiplier = 1;
+    std::string digits = text;
+    switch (text.back()) {
+    case 'k': case 'K': multiplier = 1024ULL; break;
+    case 'm': case 'M': multiplier = 1024ULL * 1024; break;
+    case 'g': case 'G': multiplier = 1024ULL * 1024 * 1024; break;
+    default: break;
+    }
+    if (multiplier > 1) {
+        digits.pop_back();
+    }
+    uint64_t value = 0;
+    if (!parseNumber(digits, &value) || value > (static_cast<uint64_t>(INT64_MAX) / multiplier)) {
+        return -1;
+    }
+    return static_cast<int64_t>(value * multiplier);
+}
+
+void LoopbackServer::acceptLoop()
+{
+    while (!m_stopping) {
+        if (!waitReadable(m_listenSocket, POLL_SLICE_MS)) {
+            continue;
+        }
+        SocketHandle client = accept(m_listenSocket, nullptr, nullptr);
+        if (client == INVALID_HANDLE) {
+            continue;
+        }
+
+        // 小文件的响应头和数据不等待合并，直接发送
+        int noDelay = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->socket = client;
+        connection->finished = false;
+        connection->lastCpu = 0;
+        Connection *raw = connection.get();
+        m_connectionCount++;
+
+        std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+        // 回收已结束的连接线程
+        for (auto it = m_connections.begin(); it != m_connections.end();) {
+            if ((*it)->finished) {
+                (*it)->thread.join();
+                it = m_connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        raw->thread = std::thread([this, raw]() { serveConnection(raw); });
+        m_connections.push_back(std::move(connection));
+    }
+}
+
+void LoopbackServer::serveConnection(Connection *connection)
+{
+    connection->lastCpu = threadCpuSeconds();
+
+    // 读到足够判断协议的数据：HTTP/2序言，或者一个完整的HTTP/1.1请求头
+    std::string buffer;
+    char input[4096];
+    while (buffer.size() < HTTP2_PREFACE_LENGTH && buffer.find("\r\n\r\n") == std::string::npos) {
+        const int received = receiveSome(connection->socket, input, sizeof(input));
+        if (received <= 0) {
+            break;
+        }
+        buffer.append(input, static_cast<size_t>(received));
+    }
+
+    if (buffer.compare(0, HTTP2_PREFACE_LENGTH, HTTP2_PREFACE) == 0) {
+        serveHttp2(connection, buffer);
+    } else if (!buffer.empty()) {
+        serveHttp1(connection, buffer);
+    }
+
+    accountCpu(connection);
+    closeConnection(connection);
+    connection->finished = true;
+}
+
+void LoopbackServer::serveHttp1(Connection *connection, std::string buffer)
+{
+    std::vector<char> body(BODY_CHUNK);
+    char input[4096];
+
+    while (!m_stopping) {
+        // 读取完整的请求头
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (buffer.size() > MAX_HEADER_SIZE) {
+                return;
+            }
+            const int received = receiveSome(connection->socket, input, sizeof(input));
+            if (received <= 0) {
+                return;
+            }
+            buffer.append(input, static_cast<size_t>(received));
+        }
+        const std::string head = buffer.substr(0, headerEnd);
+        buffer.erase(0, headerEnd + 4);
+
+        // 请求行
+        const size_t lineEnd = head.find("\r\n");
+        const std::string requestLine = head.substr(0, lineEnd);
+        const size_t firstSpace = requestLine.find(' ');
+        const size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+        if (firstSpace == std::string::npos || secondSpace == std::string::npos) {
+            return;
+        }
+        const std::string method = requestLine.substr(0, firstSpace);
+        const std::string target = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+        const std::string version = requestLine.substr(secondSpace + 1);
+
+        // 只关心Range和Connection请求头
+        std::string range;
+        bool keepAlive = (version == "HTTP/1.1");
+        size_t position = (lineEnd == std::string::npos) ? head.size() : lineEnd + 2;
+        while (position < head.size()) {
+            size_t next = head.find("\r\n", position);
+            if (next == std::string::npos) {
+                next = head.size();
+            }
+            const std::string line = head.substr(position, next - position);
+            position = next + 2;
+
+            const size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            const std::string name = toLower(trim(line.substr(0, colon)));
+            const std::string value = trim(line.substr(colon + 1));
+            if (name == "range") {
+                range = value;
+            } else if (name == "connection") {
+                const std::string option = toLower(value);
+                if (option == "close") {
+                    keepAlive = false;
+                } else if (option == "keep-alive") {
+                    keepAlive = true;
+                }
+            }
+        }
+
+        BodyCursor cursor;
+        HeaderList headers;
+        const int status = prepareResponse(method, target, range, &cursor, &headers);
+
+        std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reasonPhrase(status) + "\r\n";
+        for (const auto &entry : headers) {
+            response += entry.first + ": " + entry.second + "\r\n";
+        }
+        response += keepAlive ? "connection: keep-alive\r\n\r\n" : "connection: close\r\n\r\n";
+        if (!sendAll(connection->socket, response.data(), response.size())) {
+            return;
+        }
+
+        // 响应体
+        while (cursor.position < cursor.end) {
+            if (applyFaults(&cursor)) {
+                resetConnection(connection);
+                return;
+            }
+            const size_t chunk = nextChunk(&cursor, body.size());
+            fillContent(cursor.position, body.data(), chunk);
+            if (!sendAll(connection->socket, body.data(), chunk)) {
+                return;
+            }
+            cursor.position += chunk;
+            cursor.sent += chunk;
+            m_bytesSent += chunk;
+
+            // 大文件的响应持续时间长，边发送边统计，测量结束时不会漏掉
+            accountCpu(connection);
+        }
+
+        if (!keepAlive) {
+            return;
+        }
+    }
+}
+
+void LoopbackServer::serveHttp2(Connection *connection, const std::string &preface)
+{
+#ifdef ZIYANOS_HAVE_NGHTTP2
+    m_http2Count++;
+
+    Http2Session state;
+    state.server = this;
+    state.connection = connection;
+
+    nghttp2_session_callbacks *callbacks = nullptr;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_send_callback(callbacks, Http2Session::send);
+    nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, Http2Session::beginHeaders);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, Http2Session::header);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, Http2Session::frameReceived);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, Http2Session::streamClosed);
+
+    nghttp2_session *session = nullptr;
+    const int created = nghttp2_session_server_new(&session, callbacks, &state);
+    nghttp2_session_callbacks_del(callbacks);
+    if (created != 0) {
+        return;
+    }
+
+    // 允许批量下载的大量请求同时在一个连接上进行
+    nghttp2_settings_entry settings[] = {
+        { NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 256 }
+    };
+    nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE, settings, 1);
+
+    bool ok = nghttp2_session_mem_recv(session, reinterpret_cast<const uint8_t*>(preface.data()),
+                                       preface.size()) >= 0;
+    std::vector<char> input(BODY_CHUNK);
+    while (ok && !m_stopping) {
+        // 发送所有可以发送的帧，流量控制窗口用完时等待客户端的WINDOW_UPDATE
+        if (nghttp2_session_send(session) != 0) {
+            break;
+        }
+        if (!nghttp2_session_want_read(session) && !nghttp2_session_want_write(session)) {
+            break;
+        }
+        accountCpu(connection);
+
+        if (!waitReadable(connection->socket, POLL_SLICE_MS)) {
+            continue;
+        }
+        const int received = receiveSome(connection->socket, input.data(), input.size());
+        if (received <= 0) {
+            break;
+        }
+        ok = nghttp2_session_mem_recv(session, reinterpret_cast<const uint8_t*>(input.data()),
+                                      static_cast<size_t>(received)) >= 0;
+    }
+
+    nghttp2_session_del(session);
+#else
+    // 没有nghttp2时不支持HTTP/2，直接断开
+    (void)connection;
+    (void)preface;
+#endif
+}
+
+LoopbackServer::Resource LoopbackServer::parseTarget(const std::string &target)
+{
+    Resource resource;
+
+    const size_t queryStart = target.find('?');
+    const std::string path = target.substr(0, queryStart);
+    const std::string query = (queryStart == std::string::npos) ? std::string() : target.substr(queryStart + 1);
+
+    static const std::string prefix("/data/");
+    if (path.compare(0, prefix.size(), prefix) != 0) {
+        return resource;
+    }
+    const size_t sizeEnd = path.find('/', prefix.size());
+    const int64_t size = parseSize(path.substr(prefix.size(), sizeEnd == std::string::npos
+                                                                ? std::string::npos : sizeEnd - prefix.size()));
+    if (size < 0) {
+        return resource;
+    }
+    resource.size = static_cast<uint64_t>(size);
+    resource.key = target;
+    resource.valid = true;
+
+    // 故障参数，无法解析的参数忽略
+    size_t position = 0;
+    while (position < query.size()) {
+        size_t next = query.find('&', position);
+        if (next == std::string::npos) {
+            next = query.size();
+        }
+        const std::string parameter = query.substr(position, next - position);
+        position = next + 1;
+
+        const size_t equals = parameter.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        const std::string name = parameter.substr(0, equals);
+        const std::string value = parameter.substr(equals + 1);
+
+        if (name == "rate") {
+            resource.rate = static_cast<uint64_t>(std::max<int64_t>(0, parseSize(value)));
+        } else if (name == "reset") {
+            resource.resetAt = parseSize(value);
+        } else if (name == "stall") {
+            const size_t colon = value.find(':');
+            uint64_t ms = 0;
+            if (colon != std::string::npos && parseNumber(value.substr(colon + 1), &ms)) {
+                resource.stallAt = parseSize(value.substr(0, colon));
+                resource.stallMs = static_cast<int>(ms);
+            }
+        } else if (name == "slowstart") {
+            uint64_t ms = 0;
+            if (parseNumber(value, &ms)) {
+                resource.slowStartMs = static_cast<int>(ms);
+            }
+        }
+    }
+    return resource;
+}
+
+bool LoopbackServer::parseRange(const std::string &value, uint64_t size, uint64_t *begin, uint64_t *end,
+                                bool *unsatisfiable)
+{
+    *unsatisfiable = false;
+
+    // 只支持单个范围，多个范围按完整内容响应
+    static const std::string unit("bytes=");
+    if (value.compare(0, unit.size(), unit) != 0 || value.find(',') != std::string::npos) {
+        return false;
+    }
+    const std::string spec = value.substr(unit.size());
+    const size_t dash = spec.find('-');
+    if (dash == std::string::npos) {
+        return false;
+    }
+    const std::string first = spec.substr(0, dash);
+    const std::string last = spec.substr(dash + 1);
+
+    uint64_t from = 0;
+    uint64_t to = 0;
+    if (first.empty()) {
+        // bytes=-N：最后N个字节
+        if (!parseNumber(last, &to)) {
+            return false;
+        }
+        if (to == 0 || size == 0) {
+            *unsatisfiable = true;
+            return true;
+        }
+        *begin = size - std::min(to, size);
+        *end = size;
+        return true;
+    }
+
+    if (!parseNumber(first, &from)) {
+        return false;
+    }
+    if (last.empty()) {
+        to = size;
+    } else {
+        if (!parseNumber(last, &to) || to < from) {
+            return false;
+        }
+        to = std::min(to + 1, size);
+    }
+    if (from >= size) {
+        *unsatisfiable = true;
+        return true;
+    }
+    *begin = from;
+    *end = to;
+    return true;
+}
+
+std::string LoopbackServer::etagFor(const Resource &resource)
+{
+    // 内容只由大小决定，同样大小的资源ETag相同
+    return "\"z" + std::to_string(resource.size) + "\"";
+}
+
+int LoopbackServer::prepareResponse(const std::string &method, const std::string &target, const std::string &range,
+                                    BodyCursor *cursor, HeaderList *headers)
+{
+    cursor->position = 0;
+    cursor->end = 0;
+
+    const Resource resource = parseTarget(target);
+    if (!resource.valid) {
+        headers->push_back({ "content-length", "0" });
+        return 404;
+    }
+    if (method != "GET" && method != "HEAD") {
+        headers->push_back({ "allow", "GET, HEAD" });
+        headers->push_back({ "content-length", "0" });
+        return 405;
+    }
+
+    if (resource.slowStartMs > 0) {
+        sleepMs(resource.slowStartMs);
+    }
+
+    uint64_t begin = 0;
+    uint64_t end = resource.size;
+    bool unsatisfiable = false;
+    int status = 200;
+    if (!range.empty() && parseRange(range, resource.size, &begin, &end, &unsatisfiable)) {
+        if (unsatisfiable) {
+            headers->push_back({ "content-range", "bytes */" + std::to_string(resource.size) });
+            headers->push_back({ "content-length", "0" });
+            return 416;
+        }
+        status = 206;
+        headers->push_back({ "content-range", "bytes " + std::to_string(begin) + "-" + std::to_string(end - 1)
+                                              + "/" + std::to_string(resource.size) });
+    }
+
+    headers->push_back({ "content-type", "application/octet-stream" });
+    headers->push_back({ "content-length", std::to_string(end - begin) });
+    headers->push_back({ "accept-ranges", "bytes" });
+    headers->push_back({ "etag", etagFor(resource) });
+
+    cursor->resource = resource;
+    cursor->position = begin;
+    cursor->end = (method == "HEAD") ? begin : end;
+    cursor->sent = 0;
+    cursor->startTime = nowSeconds();
+    return status;
+}
+
+size_t LoopbackServer::nextChunk(BodyCursor *cursor, size_t maxLength)
+{
+    uint64_t length = std::min<uint64_t>(maxLength, cursor->end - cursor->position);
+    if (length == 0) {
+        return 0;
+    }
+    const Resource &resource = cursor->resource;
+
+    // 在尚未触发的故障位置之前截断，下一次发送时由applyFaults()处理
+    const int64_t faults[] = { resource.resetAt, resource.stallAt };
+    const char *faultNames[] = { "reset:", "stall:" };
+    for (int i = 0; i < 2; ++i) {
+        const int64_t at = faults[i];
+        if (at > static_cast<int64_t>(cursor->position)
+            && static_cast<uint64_t>(at) < cursor->position + length
+            && faultPending(faultNames[i] + resource.key, false)) {
+            length = static_cast<uint64_t>(at) - cursor->position;
+        }
+    }
+
+    // 限速：每次只发送一小段，并等待到这段数据应当发出的时间
+    if (resource.rate > 0) {
+        length = std::min<uint64_t>(length, std::max<uint64_t>(1, resource.rate / RATE_SLICES_PER_SECOND));
+        const double due = cursor->startTime + static_cast<double>(cursor->sent) / static_cast<double>(resource.rate);
+        const double wait = due - nowSeconds();
+        if (wait > 0) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+        }
+    }
+    return static_cast<size_t>(length);
+}
+
+bool LoopbackServer::applyFaults(BodyCursor *cursor)
+{
+    const Resource &resource = cursor->resource;
+    if (resource.stallAt >= 0 && cursor->position == static_cast<uint64_t>(resource.stallAt)
+        && faultPending("stall:" + resource.key, true)) {
+        sleepMs(resource.stallMs);
+
+        // 停顿之后重新计算限速，不补发停顿期间的数据
+        cursor->sent = 0;
+        cursor->startTime = nowSeconds();
+    }
+    return resource.resetAt >= 0 && cursor->position == static_cast<uint64_t>(resource.resetAt)
+           && faultPending("reset:" + resource.key, true);
+}
+
+bool LoopbackServer::faultPending(const std::string &key, bool take)
+{
+    std::lock_guard<std::mutex> lock(m_faultMutex);
+    if (m_triggeredFaults.count(key) > 0) {
+        return false;
+    }
+    if (take) {
+        m_triggeredFaults.insert(key);
+    }
+    return true;
+}
+
+bool LoopbackServer::sendAll(SocketHandle socket, const char *data, size_t length)
+{
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;     // 对端已断开时返回错误，而不是产生SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    while (length > 0) {
+        const int chunk = static_cast<int>(std::min<size_t>(length, 1 << 30));
+        const int sent = static_cast<int>(::send(socket, data, chunk, flags));
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+void LoopbackServer::resetConnection(Connection *connection)
+{
+    std::lock_guard<std::mutex> lock(connection->socketMutex);
+    if (connection->socket == INVALID_HANDLE) {
+        return;
+    }
+    // 立即关闭且不等待发送缓冲区，对端收到RST
+    linger option;
+    option.l_onoff = 1;
+    option.l_linger = 0;
+    setsockopt(connection->socket, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&option), sizeof(option));
+    closeSocket(connection->socket);
+    connection->socket = INVALID_HANDLE;
+}
+
+void LoopbackServer::closeConnection(Connection *connection)
+{
+    std::lock_guard<std::mutex> lock(connection->socketMutex);
+    if (connection->socket != INVALID_HANDLE) {
+        closeSocket(connection->socket);
+        connection->socket = INVALID_HANDLE;
+    }
+}
+
+void LoopbackServer::accountCpu(Connection *connection)
+{
+    const double now = threadCpuSeconds();
+    const double delta = now - connection->lastCpu;
+    connection->lastCpu = now;
+    if (delta > 0) {
+        m_cpuMicros += static_cast<uint64_t>(delta * 1e6);
+    }
+}
+
+double LoopbackServer::threadCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return static_cast<double>(kernel.QuadPart + user.QuadPart) / 1e7;   // 100纳秒为单位
+#else
+    timespec now;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) {
+        return 0;
+    }
+    return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) / 1e9;
+#endif
+}
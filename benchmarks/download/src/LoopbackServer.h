@@ -0,0 +1,160 @@
+#ifndef LOOPBACKSERVER_H
+#define LOOPBACKSERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET SocketHandle;
+#else
+typedef int SocketHandle;
+#endif
+
+// 回环HTTP测试服务器：在127.0.0.1的随机端口上提供确定性的测试数据，不依赖外网。
+// 地址格式为"/data/<大小>/<文件名>?<参数>"，大小可以带K/M/G后缀（1024进制），
+// 内容由字节偏移计算得出（不可压缩），客户端可以用fillContent()在任意位置校验。
+// 支持的参数：
+//   rate=<字节/秒>           限速，可以带K/M/G后缀
+//   reset=<偏移>             发送到该位置时重置连接（HTTP/2下重置该流），每个地址只触发一次
+//   stall=<偏移>:<毫秒>      发送到该位置时停顿，每个地址只触发一次
+//   slowstart=<毫秒>         延迟发送响应头，模拟服务器处理时间
+// HTTP/1.1支持HEAD、Range和keep-alive；编译时找到nghttp2时，以先验知识方式（h2c）连接的客户端使用HTTP/2。
+// 每个连接一个线程，HTTP/2下限速和停顿作用于整个连接。
+class LoopbackServer
+{
+public:
+    // 服务器统计
+    struct Stats {
+        uint64_t bytesSent = 0;         // 已发送的响应体字节数
+        int connections = 0;            // 接受的连接数
+        int http2Connections = 0;       // 其中使用HTTP/2的连接数
+        double cpuSeconds = 0;          // 服务器线程消耗的CPU时间（秒）
+    };
+
+    LoopbackServer();
+    ~LoopbackServer();
+
+    // 在127.0.0.1的随机端口上开始监听
+    bool start();
+
+    // 停止监听并断开所有连接
+    void stop();
+
+    uint16_t port() const { return m_port; }
+
+    // 生成完整的URL，path以"/"开头
+    std::string url(const std::string &path) const;
+
+    // 是否支持HTTP/2（编译时找到nghttp2）
+    static bool http2Supported();
+
+    Stats stats() const;
+
+    // 计算指定偏移处的测试数据
+    static void fillContent(uint64_t offset, char *data, size_t length);
+
+    // 解析带K/M/G后缀的大小，失败返回-1
+    static int64_t parseSize(const std::string &text);
+
+private:
+    // 一个客户端连接
+    struct Connection {
+        std::thread thread;
+        SocketHandle socket;
+        std::mutex socketMutex;         // 保护socket的关闭，stop()可能同时断开连接
+        std::atomic<bool> finished;
+        double lastCpu;                 // 上次统计时线程的CPU时间
+    };
+
+    // 请求的测试资源及故障参数
+    struct Resource {
+        bool valid = false;
+        std::string key;                // 故障只触发一次的判断依据（请求路径）
+        uint64_t size = 0;
+        uint64_t rate = 0;              // 0表示不限速
+        int64_t resetAt = -1;
+        int64_t stallAt = -1;
+        int stallMs = 0;
+        int slowStartMs = 0;
+    };
+
+    // 响应体的发送进度（HTTP/1.1和HTTP/2共用）
+    struct BodyCursor {
+        Resource resource;
+        uint64_t position = 0;
+        uint64_t end = 0;
+        uint64_t sent = 0;              // 本次响应已发送的字节数，用于限速
+        double startTime = 0;
+    };
+
+    friend struct Http2Session;
+    friend struct Http2Stream;
+
+    // 响应头列表（名称均为小写，HTTP/1.1和HTTP/2共用）
+    typedef std::vector<std::pair<std::string, std::string>> HeaderList;
+
+    void acceptLoop();
+    void serveConnection(Connection *connection);
+    void serveHttp1(Connection *connection, std::string buffer);
+    void serveHttp2(Connection *connection, const std::string &preface);
+
+    // 解析请求目标，例如"/data/64M/a.bin?reset=1M"
+    static Resource parseTarget(const std::string &target);
+
+    // 解析Range请求头，返回false时按完整内容响应；范围无效时unsatisfiable为true
+    static bool parseRange(const std::string &value, uint64_t size, uint64_t *begin, uint64_t *end,
+                           bool *unsatisfiable);
+
+    static std::string etagFor(const Resource &resource);
+
+    // 根据请求生成响应状态码和响应头，并设置响应体范围（慢启动在这里等待）
+    int prepareResponse(const std::string &method, const std::string &target, const std::string &range,
+                        BodyCursor *cursor, HeaderList *headers);
+
+    // 本次可以发送的长度：限速时等待，遇到尚未触发的故障时截断到故障位置，返回0表示已到末尾
+    size_t nextChunk(BodyCursor *cursor, size_t maxLength);
+
+    // 当前位置是否需要重置连接（触发后返回true），停顿在这里执行
+    bool applyFaults(BodyCursor *cursor);
+
+    // 故障是否尚未触发；take为true时标记为已触发
+    bool faultPending(const std::string &key, bool take);
+
+    // 发送全部数据，失败返回false
+    static bool sendAll(SocketHandle socket, const char *data, size_t length);
+
+    // 以RST方式关闭连接
+    void resetConnection(Connection *connection);
+    void closeConnection(Connection *connection);
+
+    // 把连接线程新消耗的CPU时间计入统计
+    void accountCpu(Connection *connection);
+    static double threadCpuSeconds();
+
+    SocketHandle m_listenSocket;
+    uint16_t m_port;
+    std::thread m_acceptThread;
+    std::atomic<bool> m_stopping;
+
+    std::mutex m_connectionsMutex;
+    std::list<std::unique_ptr<Connection>> m_connections;
+
+    std::mutex m_faultMutex;
+    std::set<std::string> m_triggeredFaults;
+
+    std::atomic<uint64_t> m_bytesSent;
+    std::atomic<int> m_connectionCount;
+    std::atomic<int> m_http2Count;
+    std::atomic<uint64_t> m_cpuMicros;
+};
+
+#endif // LOOPBACKSERVER_H
@@ -0,0 +1,94 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QTextStream>
+
+#include "BenchmarkRunner.h"
+
+// 解析带K/M/G后缀的大小参数，无效时返回false
+static bool parseSizeOption(const QCommandLineParser &parser, const QString &name, qint64 *value)
+{
+    if (!parser.isSet(name)) {
+        return true;
+    }
+    const int64_t size = LoopbackServer::parseSize(parser.value(name).toStdString());
+    if (size <= 0) {
+        return false;
+    }
+    *value = size;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("ZiyanOSDownloadBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("ZiyanOS下载模块性能测试：在回环地址上启动HTTP/1.1 + HTTP/2测试服务器，"
+                                     "按场景测量吞吐量、首字节时间、每GiB的CPU时间和内存峰值");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "scenario", "要运行的场景，可以重复或用逗号分隔（默认全部）", "名称" },
+        { "list", "列出所有场景" },
+        { "no-verify", "不校验下载的文件内容" },
+        { "output", "把结果写入JSON文件（可以作为基线）", "文件" },
+        { "baseline", "与基线JSON比较，有退化时以非0退出", "文件" },
+        { "tolerance", "允许的相对退化（默认0.15）", "比例" },
+        { "large-size", "大文件场景的文件大小（默认1G）", "大小" },
+        { "small-count", "小文件场景的文件数（默认1000）", "数量" },
+        { "small-size", "小文件场景的文件大小（默认16K）", "大小" },
+        { "concurrent", "并发场景的任务数（默认8）", "数量" },
+        { "concurrent-size", "并发场景每个文件的大小（默认128M）", "大小" },
+        { "timeout", "单个场景的超时时间（秒，默认600）", "秒" },
+        { "verbose", "输出下载模块的调试日志" },
+    });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    if (parser.isSet("list")) {
+        for (const QString &name : BenchmarkRunner::scenarioNames()) {
+            out << name << Qt::endl;
+        }
+        return 0;
+    }
+
+    BenchmarkRunner::Options options;
+    for (const QString &value : parser.values("scenario")) {
+        options.scenarios.append(value.split(',', Qt::SkipEmptyParts));
+    }
+    options.verify = !parser.isSet("no-verify");
+    options.outputPath = parser.value("output");
+    options.baselinePath = parser.value("baseline");
+
+    bool valid = parseSizeOption(parser, "large-size", &options.largeSize)
+                 && parseSizeOption(parser, "small-size", &options.smallSize)
+                 && parseSizeOption(parser, "concurrent-size", &options.concurrentSize);
+    auto readNumber = [&](const QString &name, int *value) {
+        if (parser.isSet(name)) {
+            bool ok = false;
+            *value = parser.value(name).toInt(&ok);
+            valid = valid && ok && *value > 0;
+        }
+    };
+    readNumber("small-count", &options.smallCount);
+    readNumber("concurrent", &options.concurrentTasks);
+    readNumber("timeout", &options.timeoutSeconds);
+    if (parser.isSet("tolerance")) {
+        bool ok = false;
+        options.tolerance = parser.value("tolerance").toDouble(&ok);
+        valid = valid && ok && options.tolerance >= 0;
+    }
+    if (!valid) {
+        out << "参数无效，使用--help查看用法" << Qt::endl;
+        return 2;
+    }
+
+    // 下载模块的调试日志很多，默认只保留警告
+    if (!parser.isSet("verbose")) {
+        QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+    }
+
+    BenchmarkRunner runner(options);
+    return runner.run();
+}
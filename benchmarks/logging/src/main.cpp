@@ -0,0 +1,297 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "LogManager.h"
+#include "LogBinaryFormat.h"
+#include "LogFilter.h"
+
+// 每条测试日志都带有这个标记，用于统计写入文件的条数
+static const char BENCHMARK_MARKER[] = "性能测试消息";
+
+// 被过滤模式使用的分类，测试时关闭调试等级
+static const char BENCHMARK_CATEGORY[] = "ziyanos.benchmark";
+Q_LOGGING_CATEGORY(lcBenchmark, BENCHMARK_CATEGORY)
+
+// 测试时不输出到控制台，只测量日志文件的写入
+static void discardMessage(QtMsgType, const QMessageLogContext &, const QString &)
+{
+}
+
+// 写入模式
+enum Mode {
+    ModeSync,           // 每条日志在调用线程中加锁写入并刷新
+    ModeAsync,          // qDebug + 异步文本日志
+    ModeBinary,         // qDebug + 二进制日志
+    ModeStructured,     // ZLOG_DEBUG + 二进制日志（预注册格式，不在调用线程中格式化）
+    ModeFiltered,       // qCDebug，分类的调试等级被过滤（只测量调用开销，不写入文件）
+    ModeFilteredStructured, // ZLOG_DEBUG，分类的调试等级被过滤
+    ModeCrashRing,      // qDebug，只写入崩溃日志环（文件等级为警告）
+    ModeStorm           // qDebug相同的日志 + 异步文本日志，开启风暴抑制（重复日志被折叠）
+};
+
+// 测试日志不写入文件的模式
+static bool isFiltered(Mode mode)
+{
+    return mode == ModeFiltered || mode == ModeFilteredStructured || mode == ModeCrashRing;
+}
+
+static const char *modeName(Mode mode)
+{
+    switch (mode) {
+    case ModeSync:      return "sync";
+    case ModeAsync:     return "async";
+    case ModeBinary:    return "binary";
+    case ModeStructured: return "structured";
+    case ModeFiltered:  return "filtered";
+    case ModeFilteredStructured: return "filtered-structured";
+    case ModeCrashRing: return "crash-ring";
+    case ModeStorm:     return "storm";
+    }
+    return "";
+}
+
+// 单次测试的结果
+struct RunResult {
+    double seconds = 0;         // 从开始到全部写入文件的时间
+    double callSeconds = 0;     // 所有线程完成qDebug调用的时间（异步模式下不含后台写入）
+    qint64 lines = 0;           // 文件中的测试日志条数
+};
+
+// 统计日志文件中的测试日志条数
+static qint64 countLines(const QString &path, bool binary)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    const QString marker = QString::fromUtf8(BENCHMARK_MARKER);
+    qint64 count = 0;
+
+    if (binary) {
+        LogBinaryReader reader(&file);
+        if (!reader.open()) {
+            return -1;
+        }
+        LogBinaryReader::Entry entry;
+        while (reader.next(&entry)) {
+            if (entry.message.contains(marker)) {
+                count++;
+            }
+        }
+        return reader.errorString().isEmpty() ? count : -1;
+    }
+
+    const QByteArray markerBytes = marker.toUtf8();
+    while (!file.atEnd()) {
+        if (file.readLine().contains(markerBytes)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static RunResult runOnce(Mode mode, int threadCount, int messages, const QString &logDir)
+{
+    LogManager *manager = LogManager::instance();
+    manager->setAsynchronous(mode != ModeSync);
+    manager->setBinaryFormat(mode == ModeBinary || mode == ModeStructured);
+    manager->setLogDirectory(logDir);
+
+    // 测试结束后要统计同一个文件中的条数，不切换分段
+    LogRotator::Policy policy;
+    policy.maxSegmentSize = 0;
+    policy.maxSegmentAgeSeconds = 0;
+    policy.totalBudget = 0;
+    policy.compress = false;
+    manager->setRotationPolicy(policy);
+    manager->setFileLevel(mode == ModeCrashRing ? QtWarningMsg : QtDebugMsg);
+
+    // 其他模式要统计全部写入的条数，关闭风暴抑制
+    LogStormGuard::Policy stormPolicy;
+    if (mode != ModeStorm) {
+        stormPolicy.foldWindowMs = 0;
+        stormPolicy.categoryRate = 0;
+    }
+    manager->setStormPolicy(stormPolicy);
+    manager->initialize();
+
+    // 被过滤模式：只记录警告以上，调试日志应该在构造任何字符串之前跳过
+    LogFilter::instance()->setCategoryLevel(BENCHMARK_CATEGORY, isFiltered(mode) ? "warning" : "");
+
+    const int perThread = messages / threadCount;
+    std::atomic<bool> go(false);
+    std::atomic<int> ready(0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            ready.fetch_add(1);
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            if (mode == ModeStructured) {
+                for (int i = 0; i < perThread; ++i) {
+                    ZLOG_DEBUG("benchmark", "性能测试消息 线程 %1 序号 %2", t, i);
+                }
+            } else if (mode == ModeFiltered) {
+                for (int i = 0; i < perThread; ++i) {
+                    qCDebug(lcBenchmark) << BENCHMARK_MARKER << "线程" << t << "序号" << i;
+                }
+            } else if (mode == ModeFilteredStructured) {
+                for (int i = 0; i < perThread; ++i) {
+                    ZLOG_DEBUG(BENCHMARK_CATEGORY, "性能测试消息 线程 %1 序号 %2", t, i);
+                }
+            } else if (mode == ModeStorm) {
+                for (int i = 0; i < perThread; ++i) {
+                    qDebug() << BENCHMARK_MARKER << "重复";
+                }
+            } else {
+                for (int i = 0; i < perThread; ++i) {
+                    qDebug() << BENCHMARK_MARKER << "线程" << t << "序号" << i;
+                }
+            }
+        });
+    }
+
+    // 所有线程就绪后同时开始
+    while (ready.load() < threadCount) {
+        std::this_thread::yield();
+    }
+
+    RunResult result;
+    QElapsedTimer timer;
+    timer.start();
+    go.store(true);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    result.callSeconds = timer.nsecsElapsed() / 1e9;
+
+    manager->flush();
+    result.seconds = timer.nsecsElapsed() / 1e9;
+
+    const QString path = manager->logFilePath();
+    manager->shutdown();
+    result.lines = countLines(path, mode == ModeBinary || mode == ModeStructured);
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("ZiyanOSLogBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("ZiyanOS日志模块性能测试：多个线程同时通过qDebug写日志，测量每秒写入的条数");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "threads", "线程数列表，用逗号分隔（默认1,2,4,8,16）", "列表" },
+        { "messages", "每次测试的日志总条数（默认200000）", "数量" },
+        { "mode", "写入模式，可以用逗号分隔：sync、async、binary、structured、filtered、"
+                  "filtered-structured、crash-ring、storm或all（默认all）", "模式" },
+    });
+    parser.process(app);
+
+    QTextStream out(stdout);
+
+    QList<int> threadCounts = { 1, 2, 4, 8, 16 };
+    if (parser.isSet("threads")) {
+        threadCounts.clear();
+        for (const QString &value : parser.value("threads").split(',', Qt::SkipEmptyParts)) {
+            bool ok = false;
+            const int count = value.toInt(&ok);
+            if (!ok || count <= 0) {
+                out << "线程数无效: " << value << Qt::endl;
+                return 2;
+            }
+            threadCounts.append(count);
+        }
+    }
+
+    int messages = 200000;
+    if (parser.isSet("messages")) {
+        bool ok = false;
+        messages = parser.value("messages").toInt(&ok);
+        if (!ok || messages <= 0) {
+            out << "日志条数无效" << Qt::endl;
+            return 2;
+        }
+    }
+
+    QList<Mode> modes;
+    const QStringList modeNames = parser.value("mode").isEmpty() ? QStringList { "all" }
+                                                                 : parser.value("mode").split(',', Qt::SkipEmptyParts);
+    for (const QString &name : modeNames) {
+        if (name == "all") {
+            modes = { ModeSync, ModeAsync, ModeBinary, ModeStructured, ModeFiltered, ModeFilteredStructured, ModeCrashRing,
+                      ModeStorm };
+            break;
+        }
+        bool found = false;
+        for (Mode mode : { ModeSync, ModeAsync, ModeBinary, ModeStructured, ModeFiltered, ModeFilteredStructured,
+                           ModeCrashRing, ModeStorm }) {
+            if (name == modeName(mode)) {
+                modes.append(mode);
+                found = true;
+            }
+        }
+        if (!found) {
+            out << "写入模式无效: " << name << Qt::endl;
+            return 2;
+        }
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        out << "无法创建临时目录" << Qt::endl;
+        return 2;
+    }
+
+    qInstallMessageHandler(discardMessage);
+
+    out << QString("%1 %2 %3 %4 %5")
+               .arg("模式", -10)
+               .arg("线程", 6)
+               .arg("条/秒", 12)
+               .arg("调用耗时(ns/条)", 16)
+               .arg("写入条数", 10)
+        << Qt::endl;
+
+    int failures = 0;
+    for (Mode mode : modes) {
+        for (int threadCount : threadCounts) {
+            const QString name = QString("%1-%2").arg(modeName(mode)).arg(threadCount);
+            const QString logDir = tempDir.path() + "/" + name;
+            QDir().mkpath(logDir);
+
+            const int total = messages / threadCount * threadCount;
+            const RunResult result = runOnce(mode, threadCount, total, logDir);
+            // 被过滤的日志不应该出现在文件中；风暴模式只写入第一条和重复次数的汇总
+            const bool complete = mode == ModeStorm ? (result.lines > 0 && result.lines < total)
+                                                    : result.lines == (isFiltered(mode) ? 0 : total);
+            if (!complete) {
+                failures++;
+            }
+
+            out << QString("%1 %2 %3 %4 %5%6")
+                       .arg(modeName(mode), -10)
+                       .arg(threadCount, 6)
+                       .arg(total / result.seconds, 12, 'f', 0)
+                       .arg(result.callSeconds * 1e9 / total, 16, 'f', 0)
+                       .arg(result.lines, 10)
+                       .arg(complete ? "" : "  （日志不完整）")
+                << Qt::endl;
+        }
+    }
+
+    return failures > 0 ? 1 : 0;
+}
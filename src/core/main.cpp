@@ -8,14 +8,24 @@
 #include <QQmlContext>
 #include <QCommandLineParser>
 #include <QCommandLineOption>
+#include <QStandardPaths>
 
 #include "filesystem.h"
 #include "SettingsManager.h"
+#include "SettingsWriter.h"
+#include "SettingsStore.h"
 #include "SystemUtils.h"
 #include "DownloadManager.h"
+#include "DownloadStream.h"
 #include "MouseOverlayManager.h"
 #include "LogManager.h"
+#include "LogFilter.h"
+#include "LogViewerModel.h"
 #include "WallpaperManager.h"
+#include "WallpaperCache.h"
+#include "WallpaperImageProvider.h"
+#include "ThumbnailService.h"
+#include "DownloadTaskStore.h"
 
 int main(int argc, char *argv[])
 {
@@ -38,9 +48,24 @@ int main(int argc, char *argv[])
                                      "应用程序崩溃后由启动器重新启动");
     parser.addOption(restartOption);
 
+    // 新增：二进制结构化日志（用ZiyanLogDecoder转换为文本或JSON）
+    QCommandLineOption binaryLogOption("binary-log",
+                                       "使用二进制结构化日志格式（.zlog）");
+    parser.addOption(binaryLogOption);
+
+    // 新增：写入日志文件的最低等级，更低等级的日志只保留在崩溃日志环中
+    QCommandLineOption fileLogLevelOption("file-log-level",
+                                          "写入日志文件的最低等级：debug、info、warning、critical（默认debug）",
+                                          "等级", "debug");
+    parser.addOption(fileLogLevelOption);
+
     // 解析命令行参数
     parser.process(app);
 
+    // 新增：日志过滤规则（logging.ini的[Rules]段，修改后立即生效），在第一条日志之前加载
+    LogFilter::instance()->load(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
+                                + "/ZiyanOS/logging.ini");
+
     // 检查是否是异常重启
     bool restartAfterCrash = parser.isSet(restartOption);
 
@@ -63,9 +88,69 @@ int main(int argc, char *argv[])
 
     // 6. 初始化日志系统（尽可能早）
     qDebug() << "开始初始化日志系统...";
+
+    // 新增：异常重启时先从崩溃日志环提取上次退出前的日志（初始化会清空崩溃日志环）
+    QString crashReportPath;
+    if (restartAfterCrash) {
+        crashReportPath = LogManager::instance()->extractCrashReport();
+    }
+
+    const QString fileLogLevel = parser.value(fileLogLevelOption).toLower();
+    if (fileLogLevel == "info") {
+        LogManager::instance()->setFileLevel(QtInfoMsg);
+    } else if (fileLogLevel == "warning") {
+        LogManager::instance()->setFileLevel(QtWarningMsg);
+    } else if (fileLogLevel == "critical") {
+        LogManager::instance()->setFileLevel(QtCriticalMsg);
+    } else if (fileLogLevel != "debug") {
+        qWarning() << "无效的日志等级:" << fileLogLevel << "，使用debug";
+    }
+
+    LogManager::instance()->setBinaryFormat(parser.isSet(binaryLogOption));
     LogManager::instance()->initialize();
     qDebug() << "日志系统初始化完成";
 
+    if (!crashReportPath.isEmpty()) {
+        qWarning() << "上次异常退出前的日志已保存到崩溃报告:" << crashReportPath;
+    }
+
+    // 新增：异常重启时清理上次写入设置时中断留下的临时文件（在任何窗口加载设置之前）
+    if (restartAfterCrash) {
+        SettingsWriter::instance()->recoverAfterCrash();
+    }
+
+    // 新增：解析一次配置文件，所有窗口的SettingsManager共用
+    SettingsStore::instance()->load();
+
+    // 新增：设置在后台延迟写入，退出前写入剩余的修改（失败的修改留到事件循环结束后的shutdown()重试）
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
+        if (!SettingsWriter::instance()->flush()) {
+            qWarning() << "退出时设置写入失败，稍后重试";
+        }
+        // 新增：停止生成壁纸缓存
+        WallpaperCache::instance()->stop();
+        // 新增：停止生成缩略图
+        ThumbnailService::instance()->stop();
+        // 新增：停止下载，未完成的任务写回记录，下次启动时续传
+        DownloadManager::instance()->shutdown();
+    });
+
+    // 预加载下载任务记录，下载管理器打开时无需再解析
+    DownloadTaskStore::instance()->load();
+
+    // 新增：下载缓存默认关闭，设置Download/CacheLimitMB（MB）大于0时启用，修改后立即生效
+    DownloadManager::instance()->setCacheSizeLimit(
+        SettingsStore::instance()->value(SettingsSchema::DownloadCacheLimit).toLongLong() * 1024 * 1024);
+    QObject::connect(SettingsStore::instance(), &SettingsStore::settingChanged, &app,
+                     [](SettingsSchema::Id id, const QVariant &value) {
+                         if (id == SettingsSchema::DownloadCacheLimit) {
+                             DownloadManager::instance()->setCacheSizeLimit(value.toLongLong() * 1024 * 1024);
+                         }
+                     });
+
+    // 新增：下载管理器全局只有一个，启动时恢复上次未完成的下载（不需要打开下载管理器窗口）
+    DownloadManager::instance()->restoreTasks();
+
     // 7. 创建鼠标覆盖管理器实例
     MouseOverlayManager mouseOverlayManager;
 
@@ -167,11 +252,28 @@ int main(int argc, char *argv[])
     qmlRegisterType<FileSystem>("ZiyanOS.FileSystem", 1, 0, "FileSystem");
     qmlRegisterType<SettingsManager>("ZiyanOS.SettingsManager", 1, 0, "SettingsManager");
     qmlRegisterType<SystemUtils>("ZiyanOS.SystemUtils", 1, 0, "SystemUtils");
-    qmlRegisterType<DownloadManager>("ZiyanOS.DownloadManager", 1, 0, "DownloadManager");
+    // 新增：下载管理器（全局只有一个，注册为单例，关闭窗口后下载继续进行）
+    qmlRegisterSingletonInstance("ZiyanOS.DownloadManager", 1, 0, "DownloadManager", DownloadManager::instance());
+    qmlRegisterType<DownloadStream>("ZiyanOS.DownloadStream", 1, 0, "DownloadStream");
     qmlRegisterType<MouseOverlayManager>("ZiyanOS.MouseOverlayManager", 1, 0, "MouseOverlayManager");
     qmlRegisterType<LogManager>("ZiyanOS.LogManager", 1, 0, "LogManager");
     qmlRegisterType<WallpaperManager>("ZiyanOS.WallpaperManager", 1, 0, "WallpaperManager");
     qmlRegisterType<WallpaperInfo>("ZiyanOS.WallpaperInfo", 1, 0, "WallpaperInfo");
+    // 新增：按屏幕分辨率缩放的壁纸缓存（全局只有一个，注册为单例）
+    qmlRegisterSingletonInstance("ZiyanOS.WallpaperCache", 1, 0, "WallpaperCache", WallpaperCache::instance());
+    // 新增：图片文件的缩略图（全局只有一个，注册为单例）
+    qmlRegisterSingletonInstance("ZiyanOS.ThumbnailService", 1, 0, "ThumbnailService", ThumbnailService::instance());
+    // 新增：日志过滤（全局只有一个，注册为单例）
+    qmlRegisterSingletonInstance("ZiyanOS.LogFilter", 1, 0, "LogFilter", LogFilter::instance());
+    // 新增：日志查看器的索引模型
+    qmlRegisterType<LogViewerModel>("ZiyanOS.LogViewerModel", 1, 0, "LogViewerModel");
+
+    // 新增：下载中图片的异步提供器（image://download/），引擎负责释放
+    engine.addImageProvider("download", new DownloadImageProvider());
+    // 新增：壁纸的异步提供器（image://wallpaper/），锁屏和桌面共用解码后的图像
+    engine.addImageProvider("wallpaper", new WallpaperImageProvider());
+    // 新增：缩略图的异步提供器（image://thumbnail/），解码在缩略图服务的线程中进行
+    engine.addImageProvider("thumbnail", new ThumbnailImageProvider());
 
     qDebug() << "已注册C++类到QML系统";
 
@@ -188,6 +290,7 @@ int main(int argc, char *argv[])
 
     if (engine.rootObjects().isEmpty()) {
         qCritical() << "无法加载QML主模块，应用程序退出";
+        SettingsWriter::instance()->shutdown();
         return -1;
     }
 
@@ -197,6 +300,9 @@ int main(int argc, char *argv[])
     // 20. 执行应用程序事件循环
     int exitCode = app.exec();
 
+    // 新增：写入还在等待的设置修改并停止写入线程（aboutToQuit中已写入时不再重复，失败时重试一次）
+    SettingsWriter::instance()->shutdown();
+
     // 21. 应用程序退出前，停止鼠标覆盖程序
     if (mouseOverlayManager.isRunning()) {
         qDebug() << "应用程序退出，停止鼠标覆盖程序";
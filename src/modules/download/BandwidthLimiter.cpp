@@ -0,0 +1,70 @@
+#include "BandwidthLimiter.h"
+
+// 桶容量最少允许一次性通过的字节数，避免低速率时每个数据块都要等待
+static const qint64 MIN_BURST_BYTES = 16 * 1024;
+
+BandwidthLimiter::BandwidthLimiter()
+    : m_rate(0)
+    , m_tokens(0.0)
+    , m_lastRefill(0)
+{
+    m_clock.start();
+}
+
+void BandwidthLimiter::setRate(qint64 bytesPerSecond)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    refillLocked();
+    m_rate = qMax<qint64>(0, bytesPerSecond);
+
+    // 取消限速或修改速率时清除透支，新速率立即生效
+    if (m_rate.load() == 0 || m_tokens < 0) {
+        m_tokens = 0.0;
+    }
+}
+
+void BandwidthLimiter::consume(qint64 bytes)
+{
+    if (!isLimited()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    refillLocked();
+    m_tokens -= static_cast<double>(bytes);
+}
+
+qint64 BandwidthLimiter::pendingDelay()
+{
+    qint64 rate = m_rate.load();
+    if (rate <= 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    refillLocked();
+
+    if (m_tokens >= 0) {
+        return 0;
+    }
+
+    // 透支部分按当前速率换算成等待时间（向上取整）
+    return static_cast<qint64>(-m_tokens * 1000.0 / rate) + 1;
+}
+
+void BandwidthLimiter::refillLocked()
+{
+    qint64 now = m_clock.elapsed();
+    qint64 elapsed = now - m_lastRefill;
+    m_lastRefill = now;
+
+    qint64 rate = m_rate.load();
+    if (rate <= 0 || elapsed <= 0) {
+        return;
+    }
+
+    // 桶容量为一秒的流量
+    double burst = static_cast<double>(qMax(rate, MIN_BURST_BYTES));
+    m_tokens = qMin(burst, m_tokens + static_cast<double>(elapsed) * rate / 1000.0);
+}
@@ -0,0 +1,59 @@
+#ifndef BANDWIDTHLIMITER_H
+#define BANDWIDTHLIMITER_H
+
+#include <QElapsedTimer>
+#include <QTime>
+#include <QtGlobal>
+#include <atomic>
+#include <mutex>
+
+// 令牌桶限速器：
+// 速率单位为字节/秒，0表示不限速。
+// 调用方先消费令牌（允许透支），再根据透支量计算需要等待的时间，
+// 等待由调用线程休眠完成，不会忙等。速率可以在下载过程中随时修改。
+class BandwidthLimiter
+{
+public:
+    BandwidthLimiter();
+
+    // 设置速率（字节/秒），0表示不限速
+    void setRate(qint64 bytesPerSecond);
+    qint64 rate() const { return m_rate.load(); }
+
+    // 是否启用了限速
+    bool isLimited() const { return m_rate.load() > 0; }
+
+    // 消费令牌
+    void consume(qint64 bytes);
+
+    // 当前还需要等待的毫秒数（0表示可以继续）
+    qint64 pendingDelay();
+
+private:
+    // 按经过的时间补充令牌（调用方需持有锁）
+    void refillLocked();
+
+    std::atomic<qint64> m_rate;
+    std::mutex m_mutex;
+    double m_tokens;
+    QElapsedTimer m_clock;
+    qint64 m_lastRefill;
+};
+
+// 限速时间窗口：在[start, end)时间段内使用指定的全局速率
+// end早于start时表示跨越午夜（例如 22:00 - 06:00）
+struct BandwidthScheduleWindow {
+    QTime start;
+    QTime end;
+    qint64 rate;    // 字节/秒，0表示不限速
+
+    bool contains(const QTime &time) const
+    {
+        if (start <= end) {
+            return time >= start && time < end;
+        }
+        return time >= start || time < end;
+    }
+};
+
+#endif // BANDWIDTHLIMITER_H
@@ -0,0 +1,408 @@
+#include "DownloadBatch.h"
+#include "LogCategories.h"
+#include "BandwidthLimiter.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QUrl>
+#include <vector>
+
+// 汇总进度信号的最小间隔
+static const qint64 PROGRESS_INTERVAL_MS = 100;
+
+// 限速等待时单次休眠的最长时间
+static const qint64 THROTTLE_SLICE_MS = 100;
+
+// multi句柄在没有网络事件时的最长等待时间
+static const int POLL_TIMEOUT_MS = 1000;
+
+struct DownloadBatch::Transfer {
+    int index = -1;                 // 对应的条目下标
+    CURL *curl = nullptr;           // 进行中的请求句柄
+    QSaveFile *file = nullptr;      // 写入临时文件，成功后原子替换
+    DownloadBatch *batch = nullptr;
+    bool writeFailed = false;
+    QString errorMessage;
+};
+
+DownloadBatch::DownloadBatch(int batchId, const QList<Entry> &entries, QObject *parent)
+    : QObject(parent)
+    , m_batchId(batchId)
+    , m_entries(entries)
+    , m_ignoreSslErrors(false)
+    , m_cleartextHttp2(false)
+    , m_globalLimiter(nullptr)
+    , m_thread(nullptr)
+    , m_multi(nullptr)
+    , m_canceled(false)
+    , m_completed(0)
+    , m_bytesReceived(0)
+    , m_lastReportMs(0)
+{
+}
+
+DownloadBatch::~DownloadBatch()
+{
+    cancel();
+    wait();
+    delete m_thread;
+}
+
+QList<DownloadBatch::Entry> DownloadBatch::entriesFromUrls(const QStringList &urls, const QString &targetDir)
+{
+    QList<Entry> entries;
+    QHash<QString, int> usedNames;
+
+    for (const QString &rawUrl : urls) {
+        QString url = rawUrl.trimmed();
+        if (url.isEmpty()) {
+            continue;
+        }
+
+        // 文件名取URL路径的最后一段，去掉非法字符
+        QString fileName = QUrl(url).fileName();
+        fileName.replace(QRegularExpression("[<>:\"/\\\\|?*]"), "_");
+        if (fileName.isEmpty()) {
+            fileName = "download";
+        }
+
+        // 重名时追加序号：name_2.ext
+        int &count = usedNames[fileName.toLower()];
+        count++;
+        if (count > 1) {
+            QFileInfo info(fileName);
+            QString suffix = info.completeSuffix();
+            fileName = info.baseName() + "_" + QString::number(count)
+                       + (suffix.isEmpty() ? QString() : "." + suffix);
+        }
+
+        entries.append({url, QDir(targetDir).filePath(fileName)});
+    }
+    return entries;
+}
+
+QList<DownloadBatch::Entry> DownloadBatch::parseManifest(const QByteArray &content, const QString &targetDir,
+                                                         QString *errorMessage)
+{
+    QStringList plainUrls;
+    QList<Entry> namedEntries;
+
+    const QList<QByteArray> lines = content.split('\n');
+    int lineNumber = 0;
+    for (const QByteArray &rawLine : lines) {
+        lineNumber++;
+        QString line = QString::fromUtf8(rawLine).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        int separator = line.indexOf(QRegularExpression("\\s"));
+        if (separator < 0) {
+            plainUrls.append(line);
+            continue;
+        }
+
+        // 指定了相对路径：不允许跳出目标目录
+        QString url = line.left(separator);
+        QString relativePath = QDir::cleanPath(line.mid(separator + 1).trimmed());
+        if (QDir::isAbsolutePath(relativePath) || relativePath == ".."
+            || relativePath.startsWith("../") || relativePath.isEmpty()) {
+            *errorMessage = QString("清单第%1行的保存路径无效: %2").arg(lineNumber).arg(relativePath);
+            return QList<Entry>();
+        }
+        namedEntries.append({url, QDir(targetDir).filePath(relativePath)});
+    }
+
+    return namedEntries + entriesFromUrls(plainUrls, targetDir);
+}
+
+bool DownloadBatch::start()
+{
+    if (m_thread) {
+        return false;
+    }
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+    return true;
+}
+
+void DownloadBatch::cancel()
+{
+    m_canceled = true;
+
+    // 唤醒阻塞在curl_multi_poll中的下载线程
+    std::lock_guard<std::mutex> lock(m_multiMutex);
+    if (m_multi) {
+        curl_multi_wakeup(m_multi);
+    }
+}
+
+void DownloadBatch::wait()
+{
+    if (m_thread) {
+        m_thread->wait();
+    }
+}
+
+void DownloadBatch::run()
+{
+    CURLM *multi = curl_multi_init();
+    if (!multi) {
+        qCWarning(lcDownload) << "批量下载" << m_batchId << "无法创建CURL multi句柄";
+        emit finished(m_batchId, 0, m_entries.size(), false);
+        return;
+    }
+
+    // 同一主机的请求在HTTP/2连接上多路复用，不支持时退回到有限的并行连接
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(MaxHostConnections));
+
+    {
+        std::lock_guard<std::mutex> lock(m_multiMutex);
+        m_multi = multi;
+    }
+
+    std::vector<Transfer> transfers(static_cast<size_t>(m_entries.size()));
+    QList<CURL*> idleHandles;       // 已完成请求的句柄，重置后给下一个请求复用
+    int nextEntry = 0;
+    int active = 0;
+    int succeeded = 0;
+    int failed = 0;
+    long newConnections = 0;
+    int http2Transfers = 0;
+
+    m_clock.start();
+
+    while (!m_canceled) {
+        // 补充请求，保持multi句柄上有足够的并发流
+        while (active < MaxActiveTransfers && nextEntry < m_entries.size()) {
+            Transfer *transfer = &transfers[static_cast<size_t>(nextEntry)];
+            transfer->index = nextEntry++;
+            transfer->batch = this;
+
+            CURL *curl = idleHandles.isEmpty() ? curl_easy_init() : idleHandles.takeLast();
+            if (!curl) {
+                transfer->errorMessage = "CURL初始化失败";
+            } else if (addTransfer(multi, transfer, curl)) {
+                transfer->curl = curl;
+                active++;
+                continue;
+            } else {
+                idleHandles.append(curl);
+            }
+
+            failed++;
+            m_completed++;
+            emit fileFailed(m_batchId, m_entries[transfer->index].url, transfer->errorMessage);
+        }
+
+        if (active == 0) {
+            break;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        // 回收已结束的请求
+        CURLMsg *message = nullptr;
+        int queued = 0;
+        while ((message = curl_multi_info_read(multi, &queued))) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            CURL *curl = message->easy_handle;
+            CURLcode result = message->data.result;
+
+            char *privateData = nullptr;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, &privateData);
+            Transfer *transfer = reinterpret_cast<Transfer*>(privateData);
+
+            long connects = 0;
+            curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+            newConnections += connects;
+
+            long httpVersion = 0;
+            curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &httpVersion);
+            if (httpVersion == CURL_HTTP_VERSION_2_0) {
+                http2Transfers++;
+            }
+
+            long httpCode = 0;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+
+            curl_multi_remove_handle(multi, curl);
+            curl_easy_reset(curl);
+            idleHandles.append(curl);
+            transfer->curl = nullptr;
+            active--;
+            m_completed++;
+
+            bool ok = (result == CURLE_OK) && transfer->file->commit();
+            if (ok) {
+                succeeded++;
+            } else {
+                if (transfer->writeFailed || result == CURLE_OK) {
+                    transfer->errorMessage = "写入文件失败: " + transfer->file->errorString();
+                } else if (result == CURLE_HTTP_RETURNED_ERROR) {
+                    transfer->errorMessage = QString("HTTP错误: %1").arg(httpCode);
+                } else {
+                    transfer->errorMessage = QString("下载失败: %1").arg(curl_easy_strerror(result));
+                }
+                transfer->file->cancelWriting();
+                failed++;
+                emit fileFailed(m_batchId, m_entries[transfer->index].url, transfer->errorMessage);
+            }
+
+            delete transfer->file;
+            transfer->file = nullptr;
+        }
+
+        reportProgress(false);
+
+        // 等待网络事件，cancel()会通过curl_multi_wakeup立即唤醒
+        if (active > 0 && !m_canceled) {
+            curl_multi_poll(multi, nullptr, 0, POLL_TIMEOUT_MS, nullptr);
+        }
+    }
+
+    // 取消时移除未完成的请求，临时文件直接丢弃
+    for (Transfer &transfer : transfers) {
+        if (transfer.curl) {
+            curl_multi_remove_handle(multi, transfer.curl);
+            curl_easy_cleanup(transfer.curl);
+            transfer.curl = nullptr;
+        }
+        if (transfer.file) {
+            transfer.file->cancelWriting();
+            delete transfer.file;
+            transfer.file = nullptr;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_multiMutex);
+        m_multi = nullptr;
+    }
+    curl_multi_cleanup(multi);
+    for (CURL *curl : std::as_const(idleHandles)) {
+        curl_easy_cleanup(curl);
+    }
+
+    reportProgress(true);
+
+    const bool canceled = m_canceled.load();
+    qCInfo(lcDownload) << "批量下载" << m_batchId << (canceled ? "已取消:" : "已结束:")
+            << succeeded << "个成功，" << failed << "个失败，共" << m_bytesReceived << "字节，用时"
+            << m_clock.elapsed() << "ms，新建连接" << newConnections << "条，HTTP/2传输" << http2Transfers << "个";
+
+    emit finished(m_batchId, succeeded, failed, canceled);
+}
+
+bool DownloadBatch::addTransfer(CURLM *multi, Transfer *transfer, CURL *curl)
+{
+    const Entry &entry = m_entries[transfer->index];
+
+    QDir dir = QFileInfo(entry.savePath).absoluteDir();
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    transfer->file = new QSaveFile(entry.savePath);
+    if (!transfer->file->open(QIODevice::WriteOnly)) {
+        transfer->errorMessage = "无法创建文件: " + entry.savePath;
+        delete transfer->file;
+        transfer->file = nullptr;
+        return false;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, entry.url.toUtf8().constData());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeData);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+
+    // 优先使用HTTP/2，新请求等待已有连接确认是否支持多路复用，而不是立即另开连接；
+    // 明文HTTP默认仍使用HTTP/1.1，确认服务器支持时才直接使用h2c
+    const bool cleartextHttp2 = m_cleartextHttp2 && entry.url.startsWith("http://", Qt::CaseInsensitive);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, cleartextHttp2 ? CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE
+                                                                : CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+
+    // 保存服务器上原样的字节，不请求内容编码（以gzip传输的.gz文件不会被解压）
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, nullptr);
+
+    // HTTP错误状态码视为失败，不把错误页面写入文件
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "ZiyanOS-Downloader/1.0");
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 10L);
+
+    if (m_ignoreSslErrors) {
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+    }
+
+    CURLMcode code = curl_multi_add_handle(multi, curl);
+    if (code != CURLM_OK) {
+        transfer->errorMessage = QString("无法添加请求: %1").arg(curl_multi_strerror(code));
+        transfer->file->cancelWriting();
+        delete transfer->file;
+        transfer->file = nullptr;
+        curl_easy_reset(curl);
+        return false;
+    }
+    return true;
+}
+
+void DownloadBatch::reportProgress(bool force)
+{
+    qint64 now = m_clock.elapsed();
+    if (!force && now - m_lastReportMs < PROGRESS_INTERVAL_MS) {
+        return;
+    }
+    m_lastReportMs = now;
+    emit progress(m_batchId, m_completed, m_entries.size(), m_bytesReceived);
+}
+
+size_t DownloadBatch::writeData(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    Transfer *transfer = static_cast<Transfer*>(userdata);
+    DownloadBatch *batch = transfer->batch;
+    size_t total = size * nmemb;
+
+    if (batch->m_canceled) {
+        return 0;
+    }
+
+    // 全局限速：所有请求在同一线程中驱动，这里等待相当于整个批次暂停接收
+    BandwidthLimiter *limiter = batch->m_globalLimiter;
+    if (limiter && limiter->isLimited()) {
+        limiter->consume(static_cast<qint64>(total));
+        while (!batch->m_canceled) {
+            qint64 delay = limiter->pendingDelay();
+            if (delay <= 0) {
+                break;
+            }
+            QThread::msleep(static_cast<unsigned long>(qMin(delay, THROTTLE_SLICE_MS)));
+        }
+    }
+
+    if (transfer->file->write(static_cast<const char*>(ptr), static_cast<qint64>(total)) != static_cast<qint64>(total)) {
+        transfer->writeFailed = true;
+        return 0;
+    }
+
+    batch->m_bytesReceived += static_cast<qint64>(total);
+    return total;
+}
@@ -0,0 +1,107 @@
+#ifndef DOWNLOADBATCH_H
+#define DOWNLOADBATCH_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QThread>
+#include <QElapsedTimer>
+#include <atomic>
+#include <mutex>
+#include <curl/curl.h>
+
+class BandwidthLimiter;
+
+// 批量下载：
+// 大量小文件（图标、软件包索引、更新清单等）逐个下载时，耗时主要花在
+// 每个请求的连接、TLS握手和线程创建上。批量任务在一个线程中用CURL multi接口
+// 同时驱动所有请求，同一主机的请求尽量复用一条HTTP/2连接（多路复用），
+// 并汇总报告整个批次的进度。
+class DownloadBatch : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 批次中的一个文件
+    struct Entry {
+        QString url;
+        QString savePath;
+    };
+
+    // 同时挂在multi句柄上的最大请求数
+    static constexpr int MaxActiveTransfers = 128;
+
+    // 每个主机的最大连接数（支持HTTP/2时通常只会用到一条）
+    static constexpr int MaxHostConnections = 4;
+
+    DownloadBatch(int batchId, const QList<Entry> &entries, QObject *parent = nullptr);
+    ~DownloadBatch();
+
+    // 由URL列表生成批次条目，文件名取自URL路径，重名时自动编号
+    static QList<Entry> entriesFromUrls(const QStringList &urls, const QString &targetDir);
+
+    // 解析清单文件：每行"<url>"或"<url> <相对路径>"，#开头为注释
+    static QList<Entry> parseManifest(const QByteArray &content, const QString &targetDir, QString *errorMessage);
+
+    // 在start()之前设置
+    void setIgnoreSslErrors(bool ignore) { m_ignoreSslErrors = ignore; }
+    void setCleartextHttp2(bool enabled) { m_cleartextHttp2 = enabled; }
+    void setGlobalLimiter(BandwidthLimiter *limiter) { m_globalLimiter = limiter; }
+
+    int batchId() const { return m_batchId; }
+    int fileCount() const { return m_entries.size(); }
+
+    // 启动下载线程
+    bool start();
+
+    // 请求取消（立即唤醒下载线程）
+    void cancel();
+
+    // 等待下载线程退出
+    void wait();
+
+signals:
+    // 汇总进度：completedFiles已结束的文件数（含失败），bytesReceived已接收的字节数
+    void progress(int batchId, int completedFiles, int totalFiles, qint64 bytesReceived);
+
+    // 单个文件下载失败
+    void fileFailed(int batchId, const QString &url, const QString &errorMessage);
+
+    // 批次结束
+    void finished(int batchId, int succeeded, int failed, bool canceled);
+
+private:
+    // 单个请求的传输状态
+    struct Transfer;
+
+    // 下载线程主体
+    void run();
+
+    // 为条目准备CURL句柄并加入multi句柄
+    bool addTransfer(CURLM *multi, Transfer *transfer, CURL *curl);
+
+    // 发送进度（限制频率）
+    void reportProgress(bool force);
+
+    static size_t writeData(void *ptr, size_t size, size_t nmemb, void *userdata);
+
+    int m_batchId;
+    QList<Entry> m_entries;
+    bool m_ignoreSslErrors;
+    bool m_cleartextHttp2;              // 明文HTTP直接使用HTTP/2（h2c）
+    BandwidthLimiter *m_globalLimiter;
+
+    QThread *m_thread;
+    CURLM *m_multi;                     // 由下载线程创建和销毁
+    std::mutex m_multiMutex;            // 保护m_multi，cancel()通过它唤醒下载线程
+    std::atomic<bool> m_canceled;
+
+    // 以下仅在下载线程中访问
+    int m_completed;
+    qint64 m_bytesReceived;
+    QElapsedTimer m_clock;
+    qint64 m_lastReportMs;
+};
+
+#endif // DOWNLOADBATCH_H
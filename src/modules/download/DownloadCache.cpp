@@ -0,0 +1,524 @@
+#include "DownloadCache.h"
+#include "LogCategories.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+// 索引文件头：魔数 + 版本
+static const quint32 CACHE_MAGIC = 0x4344445A;     // "ZDDC"
+static const quint32 CACHE_VERSION = 1;
+
+// 默认缓存上限：0表示关闭，在设置中指定上限后启用
+static const qint64 DEFAULT_CACHE_LIMIT = 0;
+
+DownloadCache* DownloadCache::m_instance = nullptr;
+
+DownloadCache::DownloadCache(QObject *parent)
+    : QObject(parent)
+    , m_loaded(false)
+    , m_sizeLimit(DEFAULT_CACHE_LIMIT)
+    , m_totalSize(0)
+    , m_hits(0)
+    , m_misses(0)
+    , m_bytesSaved(0)
+    , m_stopping(false)
+    , m_insertThread(nullptr)
+{
+}
+
+DownloadCache* DownloadCache::instance()
+{
+    static std::mutex instanceMutex;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+
+    if (!m_instance) {
+        m_instance = new DownloadCache();
+    }
+    return m_instance;
+}
+
+QString DownloadCache::cacheDir() const
+{
+    // 测试模式（性能测试程序）下使用Qt的测试目录，不影响用户的缓存
+    const QStandardPaths::StandardLocation location = QStandardPaths::isTestModeEnabled()
+        ? QStandardPaths::AppLocalDataLocation : QStandardPaths::DocumentsLocation;
+    return QStandardPaths::writableLocation(location) + "/ZiyanOS/download_cache";
+}
+
+QString DownloadCache::objectPath(const QString &sha256) const
+{
+    // 按哈希前两位分目录，避免单个目录中文件过多
+    return cacheDir() + "/objects/" + sha256.left(2) + "/" + sha256;
+}
+
+QString DownloadCache::indexFilePath() const
+{
+    return cacheDir() + "/index.dat";
+}
+
+QString DownloadCache::urlKey(const QString &url, const QString &etag)
+{
+    return url + QLatin1Char('\n') + etag;
+}
+
+void DownloadCache::load()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    QDir().mkpath(cacheDir() + "/objects");
+
+    QFile file(indexFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        qCWarning(lcDownload) << "下载缓存索引格式不正确，已忽略:" << indexFilePath();
+        return;
+    }
+
+    // 上限由设置决定（启动时通过setSizeLimit设置），索引中保存的上限不再使用
+    qint64 storedLimit = 0;
+    qint32 entryCount = 0;
+    in >> storedLimit >> m_hits >> m_misses >> m_bytesSaved >> entryCount;
+    for (qint32 i = 0; i < entryCount && in.status() == QDataStream::Ok; ++i) {
+        Entry entry;
+        in >> entry.sha256 >> entry.xxh64 >> entry.size >> entry.modifiedAt >> entry.lastAccess;
+        m_entries.insert(entry.sha256, entry);
+        m_totalSize += entry.size;
+    }
+
+    qint32 urlCount = 0;
+    in >> urlCount;
+    for (qint32 i = 0; i < urlCount && in.status() == QDataStream::Ok; ++i) {
+        QString key;
+        QString sha256;
+        in >> key >> sha256;
+        if (m_entries.contains(sha256)) {
+            m_urlIndex.insert(key, sha256);
+        }
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qCWarning(lcDownload) << "下载缓存索引不完整，已加载" << m_entries.size() << "项";
+    }
+    qCDebug(lcDownload) << "下载缓存已加载:" << m_entries.size() << "项，共" << m_totalSize << "字节";
+}
+
+void DownloadCache::saveLocked()
+{
+    QSaveFile file(indexFilePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcDownload) << "无法写入下载缓存索引:" << file.errorString();
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << CACHE_MAGIC << CACHE_VERSION;
+    out << m_sizeLimit << m_hits << m_misses << m_bytesSaved << static_cast<qint32>(m_entries.size());
+    for (const Entry &entry : std::as_const(m_entries)) {
+        out << entry.sha256 << entry.xxh64 << entry.size << entry.modifiedAt << entry.lastAccess;
+    }
+    out << static_cast<qint32>(m_urlIndex.size());
+    for (auto it = m_urlIndex.cbegin(); it != m_urlIndex.cend(); ++it) {
+        out << it.key() << it.value();
+    }
+
+    if (!file.commit()) {
+        qCWarning(lcDownload) << "下载缓存索引提交失败:" << file.errorString();
+    }
+}
+
+qint64 DownloadCache::sizeLimit() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sizeLimit;
+}
+
+void DownloadCache::setSizeLimit(qint64 bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bytes = qMax<qint64>(0, bytes);
+        // 上限不变时不需要处理，但关闭的缓存中还留有上次运行的内容时要清理
+        if (m_sizeLimit == bytes && m_totalSize <= m_sizeLimit) {
+            return;
+        }
+        m_sizeLimit = bytes;
+        evictLocked();
+        saveLocked();
+    }
+    emit statsChanged();
+}
+
+qint64 DownloadCache::totalSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalSize;
+}
+
+qint64 DownloadCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+qint64 DownloadCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+qint64 DownloadCache::bytesSaved() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytesSaved;
+}
+
+bool DownloadCache::validateLocked(const Entry &entry)
+{
+    QFileInfo info(objectPath(entry.sha256));
+    if (info.exists() && info.size() == entry.size
+        && info.lastModified().toMSecsSinceEpoch() == entry.modifiedAt) {
+        return true;
+    }
+
+    // 缓存文件丢失或被改动过
+    qCWarning(lcDownload) << "下载缓存内容已失效，移除:" << entry.sha256;
+    removeLocked(entry.sha256);
+    saveLocked();
+    return false;
+}
+
+bool DownloadCache::findByHash(const QString &sha256, Entry *entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.constFind(sha256.toLower());
+    if (it == m_entries.cend()) {
+        return false;
+    }
+    *entry = it.value();
+    return validateLocked(*entry);
+}
+
+bool DownloadCache::findByUrl(const QString &url, const QString &etag, Entry *entry)
+{
+    if (etag.isEmpty()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const QString sha256 = m_urlIndex.value(urlKey(url, etag));
+    auto it = m_entries.constFind(sha256);
+    if (sha256.isEmpty() || it == m_entries.cend()) {
+        return false;
+    }
+    *entry = it.value();
+    return validateLocked(*entry);
+}
+
+bool DownloadCache::materialize(const Entry &entry, const QString &savePath)
+{
+    // 先放到临时文件，成功后再替换保存路径上的旧文件（例如未完成的部分文件）：
+    // 放置失败时旧文件保持不变，任务仍然可以从部分文件续传
+    QDir().mkpath(QFileInfo(savePath).absolutePath());
+    const QString tempPath = savePath + ".tmp";
+    QFile::remove(tempPath);
+
+    // 放置文件可能需要复制，不持有锁
+    LinkMethod method = placeFile(objectPath(entry.sha256), tempPath);
+    if (method == LinkFailed) {
+        qCWarning(lcDownload) << "无法从下载缓存放置文件:" << savePath;
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    if (QFileInfo::exists(savePath) && !QFile::remove(savePath)) {
+        qCWarning(lcDownload) << "无法替换已有文件，不使用缓存:" << savePath;
+        QFile::remove(tempPath);
+        return false;
+    }
+    if (!QFile::rename(tempPath, savePath)) {
+        qCWarning(lcDownload) << "无法从下载缓存放置文件:" << savePath;
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(entry.sha256);
+        if (it != m_entries.end()) {
+            it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+        }
+        m_hits++;
+        m_bytesSaved += entry.size;
+        saveLocked();
+    }
+    emit statsChanged();
+
+    static const char *methodNames[] = { "", "反射链接", "复制" };
+    qCInfo(lcDownload) << "下载缓存命中:" << savePath << "(" << methodNames[method] << "," << entry.size << "字节)";
+    return true;
+}
+
+void DownloadCache::recordMiss()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_misses++;
+    }
+    emit statsChanged();
+}
+
+void DownloadCache::insert(const QString &url, const QString &etag, const QString &filePath,
+                           const QString &sha256, const QString &xxh64)
+{
+    if (sha256.isEmpty() || !isEnabled()) {
+        return;
+    }
+
+    PendingInsert pending;
+    pending.url = url;
+    pending.etag = etag;
+    pending.filePath = filePath;
+    pending.sha256 = sha256;
+    pending.xxh64 = xxh64;
+    const QFileInfo info(filePath);
+    pending.size = info.size();
+    pending.modifiedAt = info.lastModified().toMSecsSinceEpoch();
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    if (m_stopping) {
+        return;
+    }
+    m_pending.append(pending);
+    if (!m_insertThread) {
+        m_insertThread = QThread::create([this]() { insertLoop(); });
+        m_insertThread->start(QThread::LowPriority);
+    }
+    m_pendingCondition.notify_one();
+}
+
+void DownloadCache::stop()
+{
+    QThread *thread = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_stopping = true;
+        m_pending.clear();
+        thread = m_insertThread;
+        m_insertThread = nullptr;
+    }
+    m_pendingCondition.notify_all();
+
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void DownloadCache::insertLoop()
+{
+    for (;;) {
+        PendingInsert pending;
+        {
+            std::unique_lock<std::mutex> lock(m_pendingMutex);
+            m_pendingCondition.wait(lock, [this]() { return !m_pending.isEmpty() || m_stopping; });
+            if (m_stopping) {
+                return;
+            }
+            pending = m_pending.takeFirst();
+        }
+        store(pending);
+    }
+}
+
+void DownloadCache::store(const PendingInsert &pending)
+{
+    const QString &url = pending.url;
+    const QString &etag = pending.etag;
+    const QString &filePath = pending.filePath;
+    const QString &sha256 = pending.sha256;
+    const QString object = objectPath(sha256);
+    const qint64 size = pending.size;
+    bool stored = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_sizeLimit <= 0 || size > m_sizeLimit) {
+            return;
+        }
+
+        auto it = m_entries.find(sha256);
+        if (it != m_entries.end() && validateLocked(it.value())) {
+            // 相同内容已经缓存过（可能来自其他URL），只记录新的映射
+            it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+            stored = true;
+        }
+        if (stored) {
+            if (!etag.isEmpty()) {
+                m_urlIndex.insert(urlKey(url, etag), sha256);
+            }
+            saveLocked();
+        }
+    }
+    if (stored) {
+        emit statsChanged();
+        return;
+    }
+
+    // 新内容：放入缓存目录（可能需要复制，不持有锁）
+    QDir().mkpath(QFileInfo(object).absolutePath());
+    QFile::remove(object);
+    if (placeFile(filePath, object) == LinkFailed) {
+        qCWarning(lcDownload) << "无法把下载的文件加入缓存:" << filePath;
+        return;
+    }
+
+    // 下载完成后文件已交给用户，排队或复制期间被修改过时，缓存的内容与哈希不一致
+    const QFileInfo source(filePath);
+    if (source.size() != pending.size || source.lastModified().toMSecsSinceEpoch() != pending.modifiedAt) {
+        qCDebug(lcDownload) << "文件在加入缓存前被修改，放弃:" << filePath;
+        QFile::remove(object);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry entry;
+        entry.sha256 = sha256;
+        entry.xxh64 = pending.xxh64;
+        entry.size = size;
+        entry.modifiedAt = QFileInfo(object).lastModified().toMSecsSinceEpoch();
+        entry.lastAccess = QDateTime::currentMSecsSinceEpoch();
+
+        auto it = m_entries.find(sha256);
+        if (it != m_entries.end()) {
+            m_totalSize -= it->size;
+        }
+        m_entries.insert(sha256, entry);
+        m_totalSize += size;
+        if (!etag.isEmpty()) {
+            m_urlIndex.insert(urlKey(url, etag), sha256);
+        }
+
+        evictLocked();
+        saveLocked();
+    }
+    emit statsChanged();
+}
+
+void DownloadCache::clear()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const QStringList hashes = m_entries.keys();
+        for (const QString &sha256 : hashes) {
+            removeLocked(sha256);
+        }
+        saveLocked();
+    }
+    emit statsChanged();
+}
+
+void DownloadCache::removeLocked(const QString &sha256)
+{
+    auto it = m_entries.find(sha256);
+    if (it == m_entries.end()) {
+        return;
+    }
+    m_totalSize -= it->size;
+    m_entries.erase(it);
+    QFile::remove(objectPath(sha256));
+
+    for (auto urlIt = m_urlIndex.begin(); urlIt != m_urlIndex.end();) {
+        if (urlIt.value() == sha256) {
+            urlIt = m_urlIndex.erase(urlIt);
+        } else {
+            ++urlIt;
+        }
+    }
+}
+
+void DownloadCache::evictLocked()
+{
+    if (m_totalSize <= m_sizeLimit) {
+        return;
+    }
+
+    // 按最近使用时间从旧到新淘汰
+    QList<Entry> entries = m_entries.values();
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.lastAccess < b.lastAccess;
+    });
+
+    for (const Entry &entry : std::as_const(entries)) {
+        if (m_totalSize <= m_sizeLimit) {
+            break;
+        }
+        qCDebug(lcDownload) << "下载缓存淘汰:" << entry.sha256 << entry.size << "字节";
+        removeLocked(entry.sha256);
+    }
+}
+
+DownloadCache::LinkMethod DownloadCache::placeFile(const QString &from, const QString &to)
+{
+    if (reflinkFile(from, to)) {
+        return LinkReflink;
+    }
+    // Windows上CopyFile在ReFS/开发驱动器上会自动使用块克隆
+    if (QFile::copy(from, to)) {
+        return LinkCopy;
+    }
+    return LinkFailed;
+}
+
+bool DownloadCache::reflinkFile(const QString &from, const QString &to)
+{
+#ifdef Q_OS_LINUX
+    // btrfs、xfs等支持写时复制的文件系统
+    int source = ::open(QFile::encodeName(from).constData(), O_RDONLY | O_CLOEXEC);
+    if (source < 0) {
+        return false;
+    }
+    int target = ::open(QFile::encodeName(to).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (target < 0) {
+        ::close(source);
+        return false;
+    }
+    bool ok = ::ioctl(target, FICLONE, source) == 0;
+    ::close(target);
+    ::close(source);
+    if (!ok) {
+        QFile::remove(to);
+    }
+    return ok;
+#else
+    Q_UNUSED(from);
+    Q_UNUSED(to);
+    return false;
+#endif
+}
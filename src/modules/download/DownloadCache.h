@@ -0,0 +1,148 @@
+#ifndef DOWNLOADCACHE_H
+#define DOWNLOADCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QThread>
+#include <condition_variable>
+#include <mutex>
+
+// 内容寻址的下载缓存（进程内单例）：
+// 下载完成的文件按SHA-256存放一份，同时记录"URL + ETag -> SHA-256"的映射，
+// 相同内容即使来自不同URL也只保存一次。
+// 再次下载时按期望的SHA-256或URL + ETag命中缓存，通过反射链接（写时复制）放到保存路径，
+// 不支持时退回普通复制，不再走网络。缓存文件和保存的文件从不共享数据（不使用硬链接），
+// 任何一边被原地改写（续传、用户编辑）都不会影响另一边。
+// 缓存总大小超过上限时按最近使用时间淘汰。缓存默认关闭（上限为0），由设置Download/CacheLimitMB启用：
+// 文件系统不支持反射链接时加入缓存需要完整复制一次文件。所有方法都可以在下载线程中调用。
+class DownloadCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 缓存中的一份内容
+    struct Entry {
+        QString sha256;
+        QString xxh64;
+        qint64 size = 0;
+        qint64 modifiedAt = 0;      // 缓存文件的修改时间（毫秒），用于发现被改动的缓存文件
+        qint64 lastAccess = 0;      // 最近使用时间（毫秒），用于LRU淘汰
+    };
+
+    // 单例模式访问
+    static DownloadCache* instance();
+
+    // 加载索引（只在第一次调用时执行）
+    void load();
+
+    // 缓存上限（字节），0表示禁用缓存
+    qint64 sizeLimit() const;
+    void setSizeLimit(qint64 bytes);
+    bool isEnabled() const { return sizeLimit() > 0; }
+
+    // 当前缓存占用（字节）
+    qint64 totalSize() const;
+
+    // 按内容哈希或URL + ETag查找，缓存文件已被改动或丢失时视为未命中并移除
+    bool findByHash(const QString &sha256, Entry *entry);
+    bool findByUrl(const QString &url, const QString &etag, Entry *entry);
+
+    // 把缓存内容放到保存路径（反射链接 > 复制），成功时计为一次命中
+    bool materialize(const Entry &entry, const QString &savePath);
+
+    // 记录一次未命中（需要从网络下载）
+    void recordMiss();
+
+    // 下载完成后加入缓存，相同内容只保存一份。只是排队，复制文件在后台线程中进行，
+    // 下载任务不等待；复制前后文件被修改过时放弃
+    void insert(const QString &url, const QString &etag, const QString &filePath,
+                const QString &sha256, const QString &xxh64);
+
+    // 停止后台线程，等待正在加入的文件，丢弃还没开始的（应用程序退出前调用）
+    void stop();
+
+    // 清空缓存（统计数据保留）
+    void clear();
+
+    // 命中统计
+    qint64 hits() const;
+    qint64 misses() const;
+    qint64 bytesSaved() const;
+
+signals:
+    // 统计数据或占用变化（可能在下载线程中发出）
+    void statsChanged();
+
+private:
+    explicit DownloadCache(QObject *parent = nullptr);
+
+    // 等待加入缓存的文件（记录排队时的大小和修改时间）
+    struct PendingInsert {
+        QString url;
+        QString etag;
+        QString filePath;
+        QString sha256;
+        QString xxh64;
+        qint64 size = 0;
+        qint64 modifiedAt = 0;
+    };
+
+    // 后台线程主循环
+    void insertLoop();
+
+    // 把一个文件加入缓存（在后台线程中调用）
+    void store(const PendingInsert &pending);
+
+    // 文件放置方式
+    enum LinkMethod {
+        LinkFailed,
+        LinkReflink,    // 写时复制，两边互不影响
+        LinkCopy        // 普通复制
+    };
+
+    QString cacheDir() const;
+    QString objectPath(const QString &sha256) const;
+    QString indexFilePath() const;
+
+    // 检查缓存文件是否与记录一致（调用方需持有锁）
+    bool validateLocked(const Entry &entry);
+
+    // 移除一份内容及其URL映射（调用方需持有锁）
+    void removeLocked(const QString &sha256);
+
+    // 按LRU淘汰到上限以内（调用方需持有锁）
+    void evictLocked();
+
+    // 写入索引文件（调用方需持有锁）
+    void saveLocked();
+
+    // 放置文件：先尝试反射链接，不支持时复制
+    static LinkMethod placeFile(const QString &from, const QString &to);
+    static bool reflinkFile(const QString &from, const QString &to);
+
+    static QString urlKey(const QString &url, const QString &etag);
+
+    static DownloadCache *m_instance;
+
+    mutable std::mutex m_mutex;
+    bool m_loaded;
+    qint64 m_sizeLimit;
+    qint64 m_totalSize;
+    QHash<QString, Entry> m_entries;        // SHA-256 -> 内容
+    QHash<QString, QString> m_urlIndex;     // URL + ETag -> SHA-256
+
+    qint64 m_hits;
+    qint64 m_misses;
+    qint64 m_bytesSaved;
+
+    // 等待加入缓存的文件（m_pendingMutex保护）
+    std::mutex m_pendingMutex;
+    std::condition_variable m_pendingCondition;
+    QList<PendingInsert> m_pending;
+    bool m_stopping;
+    QThread *m_insertThread;
+};
+
+#endif // DOWNLOADCACHE_H
@@ -0,0 +1,896 @@
+#include "DownloadExtractor.h"
+#include "LogCategories.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+#ifdef ZIYANOS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef ZIYANOS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// tar块大小
+static const qint64 TAR_BLOCK_SIZE = 512;
+
+// GNU长文件名和pax扩展头的最大长度，防止异常数据占用大量内存
+static const qint64 TAR_META_MAX_SIZE = 1024 * 1024;
+
+// 解压输出缓冲区大小
+static const qsizetype DECODE_BUFFER_SIZE = 256 * 1024;
+
+// zip记录签名
+static const quint32 ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+static const quint32 ZIP_DESCRIPTOR_SIGNATURE = 0x08074b50;
+static const quint32 ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+static const quint32 ZIP_END_SIGNATURE = 0x06054b50;
+static const quint32 ZIP64_END_SIGNATURE = 0x06064b50;
+
+// zip通用标志位
+static const quint16 ZIP_FLAG_ENCRYPTED = 0x0001;
+static const quint16 ZIP_FLAG_DESCRIPTOR = 0x0008;
+static const quint16 ZIP_FLAG_UTF8 = 0x0800;
+
+struct DownloadExtractor::Decoder {
+#ifdef ZIYANOS_HAVE_ZLIB
+    z_stream gzip;                  // 外层gzip
+    bool gzipActive = false;
+    bool gzipEnded = false;
+    z_stream zipInflate;            // zip条目的raw deflate
+    bool zipActive = false;
+#endif
+#ifdef ZIYANOS_HAVE_ZSTD
+    ZSTD_DCtx *zstd = nullptr;
+    bool zstdEnded = false;
+#endif
+};
+
+// 解析tar头中的八进制数字字段
+static qint64 parseOctal(const char *field, int length)
+{
+    qint64 value = 0;
+    int i = 0;
+    while (i < length && (field[i] == ' ' || field[i] == '\0')) {
+        ++i;
+    }
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; ++i) {
+        value = (value << 3) + (field[i] - '0');
+    }
+    return value;
+}
+
+// 解析tar头中的大小字段（超过8GB时使用base-256编码）
+static qint64 parseTarSize(const char *field)
+{
+    if (static_cast<uchar>(field[0]) & 0x80) {
+        qint64 value = static_cast<uchar>(field[0]) & 0x7f;
+        for (int i = 1; i < 12; ++i) {
+            value = (value << 8) | static_cast<uchar>(field[i]);
+        }
+        return value;
+    }
+    return parseOctal(field, 12);
+}
+
+// tar头中的字符串字段（不一定以\0结尾）
+static QString tarField(const char *field, int length)
+{
+    const char *end = static_cast<const char*>(memchr(field, '\0', static_cast<size_t>(length)));
+    return QString::fromUtf8(field, end ? static_cast<qsizetype>(end - field) : length);
+}
+
+DownloadExtractor::DownloadExtractor(const QString &destinationDir)
+    : m_destination(destinationDir)
+    , m_format(Unknown)
+    , m_decoder(new Decoder())
+    , m_tarState(TarHeader)
+    , m_entryKind(EntrySkip)
+    , m_entryRemaining(0)
+    , m_paddingRemaining(0)
+    , m_zeroBlocks(0)
+    , m_paxSize(-1)
+    , m_zipState(ZipSignature)
+    , m_zipFlags(0)
+    , m_zipMethod(0)
+    , m_zipCrc(0)
+    , m_zipCompressedSize(0)
+    , m_zipUncompressedSize(0)
+    , m_zipRemaining(0)
+    , m_zipNameLength(0)
+    , m_zipHeaderExtra(0)
+    , m_zip64(false)
+    , m_outputCrc(0)
+    , m_outputMode(0)
+    , m_filesExtracted(0)
+    , m_bytesExtracted(0)
+{
+}
+
+DownloadExtractor::~DownloadExtractor()
+{
+    if (m_output.isOpen()) {
+        m_output.close();
+    }
+
+#ifdef ZIYANOS_HAVE_ZLIB
+    if (m_decoder->gzipActive) {
+        inflateEnd(&m_decoder->gzip);
+    }
+    if (m_decoder->zipActive) {
+        inflateEnd(&m_decoder->zipInflate);
+    }
+#endif
+#ifdef ZIYANOS_HAVE_ZSTD
+    if (m_decoder->zstd) {
+        ZSTD_freeDCtx(m_decoder->zstd);
+    }
+#endif
+    delete m_decoder;
+}
+
+bool DownloadExtractor::isSupported(Format format)
+{
+    switch (format) {
+    case Tar:
+    case Zip:
+        return true;
+    case TarGzip:
+#ifdef ZIYANOS_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    case TarZstd:
+#ifdef ZIYANOS_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool DownloadExtractor::addData(const char *data, qint64 size)
+{
+    if (hasError()) {
+        return false;
+    }
+
+    if (m_format == Unknown) {
+        // 攒够魔数长度再识别格式
+        m_head.append(data, static_cast<qsizetype>(size));
+        if (m_head.size() < 4) {
+            return true;
+        }
+        if (!detectFormat()) {
+            return false;
+        }
+        const QByteArray head = m_head;
+        m_head.clear();
+        return addData(head.constData(), head.size());
+    }
+
+    switch (m_format) {
+    case Tar:
+        return feedTar(data, size);
+    case TarGzip:
+    case TarZstd:
+        return decompress(data, size);
+    case Zip:
+        return feedZip(data, size);
+    default:
+        return fail("无法识别的压缩包格式");
+    }
+}
+
+bool DownloadExtractor::finish()
+{
+    if (hasError()) {
+        return false;
+    }
+
+    if (m_format == Unknown) {
+        if (m_head.isEmpty()) {
+            return fail("下载内容为空");
+        }
+        // 不足4字节的数据只可能按tar解析，下面会报告不完整
+        m_format = Tar;
+        const QByteArray head = m_head;
+        m_head.clear();
+        if (!feedTar(head.constData(), head.size())) {
+            return false;
+        }
+    }
+
+#ifdef ZIYANOS_HAVE_ZLIB
+    if (m_format == TarGzip && !m_decoder->gzipEnded) {
+        return fail("gzip数据不完整");
+    }
+#endif
+#ifdef ZIYANOS_HAVE_ZSTD
+    if (m_format == TarZstd && !m_decoder->zstdEnded) {
+        return fail("zstd数据不完整");
+    }
+#endif
+
+    if (m_format == Zip) {
+        if (m_zipState != ZipEnd) {
+            return fail("zip数据不完整");
+        }
+    } else if (m_tarState != TarEnd && (m_tarState != TarHeader || !m_collect.isEmpty())) {
+        // 有的打包工具不写结束块，只要停在条目边界上就认为完整
+        return fail("tar数据不完整");
+    }
+
+    qCDebug(lcDownload) << "解包完成:" << m_filesExtracted << "个文件，" << m_bytesExtracted << "字节";
+    return true;
+}
+
+bool DownloadExtractor::detectFormat()
+{
+    const uchar *magic = reinterpret_cast<const uchar*>(m_head.constData());
+
+    if (magic[0] == 0x1f && magic[1] == 0x8b) {
+        m_format = TarGzip;
+    } else if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        m_format = TarZstd;
+    } else if (qFromLittleEndian<quint32>(magic) == ZIP_LOCAL_HEADER_SIGNATURE) {
+        m_format = Zip;
+    } else {
+        // 未压缩的tar没有固定在开头的魔数，解析头部时再校验
+        m_format = Tar;
+    }
+
+    if (!isSupported(m_format)) {
+        return fail(m_format == TarGzip ? "当前版本不支持gzip解压" : "当前版本不支持zstd解压");
+    }
+
+    m_decodeBuffer.resize(DECODE_BUFFER_SIZE);
+
+#ifdef ZIYANOS_HAVE_ZLIB
+    if (m_format == TarGzip) {
+        // 16 + MAX_WBITS：只接受gzip格式
+        memset(&m_decoder->gzip, 0, sizeof(z_stream));
+        if (inflateInit2(&m_decoder->gzip, 16 + MAX_WBITS) != Z_OK) {
+            return fail("无法初始化gzip解压");
+        }
+        m_decoder->gzipActive = true;
+    } else if (m_format == Zip) {
+        // 负的窗口大小：zip条目是不带头尾的raw deflate
+        memset(&m_decoder->zipInflate, 0, sizeof(z_stream));
+        if (inflateInit2(&m_decoder->zipInflate, -MAX_WBITS) != Z_OK) {
+            return fail("无法初始化zip解压");
+        }
+        m_decoder->zipActive = true;
+    }
+#endif
+#ifdef ZIYANOS_HAVE_ZSTD
+    if (m_format == TarZstd) {
+        m_decoder->zstd = ZSTD_createDCtx();
+        if (!m_decoder->zstd) {
+            return fail("无法初始化zstd解压");
+        }
+    }
+#endif
+
+    return true;
+}
+
+bool DownloadExtractor::decompress(const char *data, qint64 size)
+{
+#ifdef ZIYANOS_HAVE_ZLIB
+    if (m_format == TarGzip) {
+        z_stream &stream = m_decoder->gzip;
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream.avail_in = static_cast<uInt>(size);
+
+        while (true) {
+            stream.next_out = reinterpret_cast<Bytef*>(m_decodeBuffer.data());
+            stream.avail_out = static_cast<uInt>(m_decodeBuffer.size());
+
+            int ret = inflate(&stream, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                return fail(QString("gzip数据损坏: %1").arg(stream.msg ? stream.msg : "未知错误"));
+            }
+
+            qint64 produced = m_decodeBuffer.size() - stream.avail_out;
+            if (produced > 0 && !feedTar(m_decodeBuffer.constData(), produced)) {
+                return false;
+            }
+
+            if (ret == Z_STREAM_END) {
+                m_decoder->gzipEnded = true;
+                // tar已结束时忽略尾部数据，否则按多段gzip继续解压
+                if (stream.avail_in == 0 || m_tarState == TarEnd) {
+                    break;
+                }
+                inflateReset(&stream);
+                m_decoder->gzipEnded = false;
+                continue;
+            }
+
+            // 输入用完且输出缓冲区没有写满，说明zlib内部没有剩余数据
+            if ((stream.avail_in == 0 && stream.avail_out > 0) || (ret == Z_BUF_ERROR && produced == 0)) {
+                break;
+            }
+        }
+        return true;
+    }
+#endif
+
+#ifdef ZIYANOS_HAVE_ZSTD
+    if (m_format == TarZstd) {
+        ZSTD_inBuffer input = { data, static_cast<size_t>(size), 0 };
+
+        while (true) {
+            ZSTD_outBuffer output = { m_decodeBuffer.data(), static_cast<size_t>(m_decodeBuffer.size()), 0 };
+            size_t ret = ZSTD_decompressStream(m_decoder->zstd, &output, &input);
+            if (ZSTD_isError(ret)) {
+                return fail(QString("zstd数据损坏: %1").arg(ZSTD_getErrorName(ret)));
+            }
+
+            if (output.pos > 0 && !feedTar(m_decodeBuffer.constData(), static_cast<qint64>(output.pos))) {
+                return false;
+            }
+
+            // 返回0表示一帧已完整解出
+            m_decoder->zstdEnded = (ret == 0);
+
+            if (input.pos == input.size && output.pos < output.size) {
+                break;
+            }
+        }
+        return true;
+    }
+#endif
+
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    return fail("当前版本不支持该压缩格式");
+}
+
+bool DownloadExtractor::feedTar(const char *data, qint64 size)
+{
+    while (size > 0) {
+        switch (m_tarState) {
+        case TarHeader:
+            if (!collect(data, size, TAR_BLOCK_SIZE)) {
+                return true;
+            }
+            if (!processTarHeader(m_collect.constData())) {
+                return false;
+            }
+            m_collect.clear();
+            break;
+
+        case TarEntryData: {
+            qint64 chunk = qMin(size, m_entryRemaining);
+            if (m_entryKind == EntryFile) {
+                if (!writeOutput(data, chunk)) {
+                    return false;
+                }
+            } else if (m_entryKind == EntryLongName || m_entryKind == EntryPax) {
+                m_entryBuffer.append(data, static_cast<qsizetype>(chunk));
+            }
+            data += chunk;
+            size -= chunk;
+            m_entryRemaining -= chunk;
+
+            if (m_entryRemaining == 0 && !finishTarEntry()) {
+                return false;
+            }
+            break;
+        }
+
+        case TarPadding: {
+            qint64 chunk = qMin(size, m_paddingRemaining);
+            data += chunk;
+            size -= chunk;
+            m_paddingRemaining -= chunk;
+            if (m_paddingRemaining == 0) {
+                m_tarState = TarHeader;
+            }
+            break;
+        }
+
+        case TarEnd:
+            // 结束块之后的填充数据直接忽略
+            return true;
+        }
+    }
+    return true;
+}
+
+bool DownloadExtractor::processTarHeader(const char *header)
+{
+    // 连续两个全零块表示归档结束
+    if (std::all_of(header, header + TAR_BLOCK_SIZE, [](char c) { return c == '\0'; })) {
+        if (++m_zeroBlocks >= 2) {
+            m_tarState = TarEnd;
+        }
+        return true;
+    }
+    m_zeroBlocks = 0;
+
+    // 头部校验和：校验和字段本身按空格计算
+    qint64 storedSum = parseOctal(header + 148, 8);
+    qint64 sum = 0;
+    for (int i = 0; i < TAR_BLOCK_SIZE; ++i) {
+        sum += (i >= 148 && i < 156) ? ' ' : static_cast<uchar>(header[i]);
+    }
+    if (sum != storedSum) {
+        return fail("tar头校验失败，压缩包可能已损坏");
+    }
+
+    QString name = tarField(header, 100);
+    if (memcmp(header + 257, "ustar", 5) == 0) {
+        QString prefix = tarField(header + 345, 155);
+        if (!prefix.isEmpty()) {
+            name = prefix + "/" + name;
+        }
+    }
+    qint64 size = parseTarSize(header + 124);
+    int mode = static_cast<int>(parseOctal(header + 100, 8));
+    char type = header[156];
+
+    // 前面的GNU长文件名或pax扩展头覆盖本条目的字段
+    if (!m_longName.isEmpty()) {
+        name = m_longName;
+        m_longName.clear();
+    }
+    if (!m_paxPath.isEmpty()) {
+        name = m_paxPath;
+        m_paxPath.clear();
+    }
+    if (m_paxSize >= 0) {
+        size = m_paxSize;
+        m_paxSize = -1;
+    }
+
+    if (size < 0) {
+        return fail("tar条目大小无效: " + name);
+    }
+
+    m_entryRemaining = size;
+    m_paddingRemaining = (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+    m_entryBuffer.clear();
+
+    switch (type) {
+    case '0':
+    case '\0':
+    case '7':
+        m_entryKind = EntryFile;
+        if (!openOutput(name, false, mode)) {
+            return false;
+        }
+        break;
+    case '5':
+        m_entryKind = EntrySkip;
+        if (!openOutput(name, true, mode)) {
+            return false;
+        }
+        break;
+    case 'L':
+    case 'x':
+        if (size > TAR_META_MAX_SIZE) {
+            return fail("tar扩展头过大");
+        }
+        m_entryKind = (type == 'L') ? EntryLongName : EntryPax;
+        break;
+    default:
+        // 链接、设备文件和全局扩展头不解出
+        if (type == '1' || type == '2') {
+            qCDebug(lcDownload) << "跳过压缩包中的链接:" << name;
+        }
+        m_entryKind = EntrySkip;
+        break;
+    }
+
+    m_tarState = TarEntryData;
+    if (m_entryRemaining == 0) {
+        return finishTarEntry();
+    }
+    return true;
+}
+
+bool DownloadExtractor::finishTarEntry()
+{
+    switch (m_entryKind) {
+    case EntryFile:
+        if (!closeOutput()) {
+            return false;
+        }
+        break;
+    case EntryLongName: {
+        int end = m_entryBuffer.indexOf('\0');
+        m_longName = QString::fromUtf8(end >= 0 ? m_entryBuffer.left(end) : m_entryBuffer);
+        break;
+    }
+    case EntryPax:
+        parsePaxHeader(m_entryBuffer);
+        break;
+    case EntrySkip:
+        break;
+    }
+
+    m_entryBuffer.clear();
+    m_tarState = m_paddingRemaining > 0 ? TarPadding : TarHeader;
+    return true;
+}
+
+void DownloadExtractor::parsePaxHeader(const QByteArray &content)
+{
+    // 每条记录的格式："<长度> <键>=<值>\n"，长度包含整条记录
+    qsizetype pos = 0;
+    while (pos < content.size()) {
+        qsizetype space = content.indexOf(' ', pos);
+        if (space < 0) {
+            break;
+        }
+        bool ok = false;
+        qsizetype length = content.mid(pos, space - pos).toLongLong(&ok);
+        if (!ok || length <= space - pos || pos + length > content.size()) {
+            break;
+        }
+
+        QByteArray record = content.mid(space + 1, pos + length - space - 2);
+        qsizetype equals = record.indexOf('=');
+        if (equals > 0) {
+            QByteArray key = record.left(equals);
+            QByteArray value = record.mid(equals + 1);
+            if (key == "path") {
+                m_paxPath = QString::fromUtf8(value);
+            } else if (key == "size") {
+                m_paxSize = value.toLongLong();
+            }
+        }
+        pos += length;
+    }
+}
+
+bool DownloadExtractor::feedZip(const char *data, qint64 size)
+{
+    while (size > 0) {
+        switch (m_zipState) {
+        case ZipSignature: {
+            if (!collect(data, size, 4)) {
+                return true;
+            }
+            quint32 signature = qFromLittleEndian<quint32>(m_collect.constData());
+            m_collect.clear();
+
+            if (signature == ZIP_LOCAL_HEADER_SIGNATURE) {
+                m_zipState = ZipLocalHeader;
+            } else if (signature == ZIP_CENTRAL_HEADER_SIGNATURE || signature == ZIP_END_SIGNATURE
+                       || signature == ZIP64_END_SIGNATURE) {
+                // 所有条目都已解出，中央目录不需要解析
+                m_zipState = ZipEnd;
+                return true;
+            } else {
+                return fail("zip数据损坏：未知的记录签名");
+            }
+            break;
+        }
+
+        case ZipLocalHeader: {
+            if (!collect(data, size, 26)) {
+                return true;
+            }
+            const uchar *header = reinterpret_cast<const uchar*>(m_collect.constData());
+            m_zipFlags = qFromLittleEndian<quint16>(header + 2);
+            m_zipMethod = qFromLittleEndian<quint16>(header + 4);
+            m_zipCrc = qFromLittleEndian<quint32>(header + 10);
+            m_zipCompressedSize = qFromLittleEndian<quint32>(header + 14);
+            m_zipUncompressedSize = qFromLittleEndian<quint32>(header + 18);
+            m_zipNameLength = qFromLittleEndian<quint16>(header + 22);
+            m_zipHeaderExtra = m_zipNameLength + qFromLittleEndian<quint16>(header + 24);
+            m_collect.clear();
+            m_zipState = ZipNameExtra;
+            break;
+        }
+
+        case ZipNameExtra:
+            if (!collect(data, size, m_zipHeaderExtra)) {
+                return true;
+            }
+            if (!beginZipEntry()) {
+                return false;
+            }
+            break;
+
+        case ZipData:
+            if (!feedZipData(data, size)) {
+                return false;
+            }
+            break;
+
+        case ZipDescriptor: {
+            // 数据描述符：可选的签名 + CRC + 压缩后大小 + 原始大小（zip64时大小为8字节）
+            if (!collect(data, size, 4)) {
+                return true;
+            }
+            const bool hasSignature = qFromLittleEndian<quint32>(m_collect.constData()) == ZIP_DESCRIPTOR_SIGNATURE;
+            const qint64 need = (hasSignature ? 4 : 0) + (m_zip64 ? 20 : 12);
+            if (!collect(data, size, need)) {
+                return true;
+            }
+            quint32 crc = qFromLittleEndian<quint32>(m_collect.constData() + (hasSignature ? 4 : 0));
+            m_collect.clear();
+            if (!finishZipEntry(crc)) {
+                return false;
+            }
+            break;
+        }
+
+        case ZipEnd:
+            return true;
+        }
+    }
+    return true;
+}
+
+bool DownloadExtractor::beginZipEntry()
+{
+    const char *field = m_collect.constData();
+    QString name = (m_zipFlags & ZIP_FLAG_UTF8)
+                   ? QString::fromUtf8(field, m_zipNameLength)
+                   : QString::fromLocal8Bit(field, m_zipNameLength);
+
+    // zip64扩展字段：本地头中的大小为0xFFFFFFFF时，真实值在这里
+    m_zip64 = false;
+    qint64 pos = m_zipNameLength;
+    while (pos + 4 <= m_zipHeaderExtra) {
+        const uchar *extra = reinterpret_cast<const uchar*>(field + pos);
+        quint16 id = qFromLittleEndian<quint16>(extra);
+        quint16 length = qFromLittleEndian<quint16>(extra + 2);
+        if (id == 0x0001 && pos + 4 + length <= m_zipHeaderExtra) {
+            m_zip64 = true;
+            // 顺序为原始大小、压缩后大小，只有头中为0xFFFFFFFF的字段才会出现
+            qint64 offset = 4;
+            if (m_zipUncompressedSize == 0xFFFFFFFFLL && offset + 8 <= 4 + length) {
+                m_zipUncompressedSize = qFromLittleEndian<qint64>(extra + offset);
+                offset += 8;
+            }
+            if (m_zipCompressedSize == 0xFFFFFFFFLL && offset + 8 <= 4 + length) {
+                m_zipCompressedSize = qFromLittleEndian<qint64>(extra + offset);
+            }
+        }
+        pos += 4 + length;
+    }
+    m_collect.clear();
+
+    if (m_zipFlags & ZIP_FLAG_ENCRYPTED) {
+        return fail("不支持加密的zip文件: " + name);
+    }
+    if (m_zipMethod != 0 && m_zipMethod != 8) {
+        return fail(QString("不支持的zip压缩方法 %1: %2").arg(m_zipMethod).arg(name));
+    }
+    if (m_zipMethod == 0 && (m_zipFlags & ZIP_FLAG_DESCRIPTOR)) {
+        return fail("不支持未记录大小的存储条目: " + name);
+    }
+#ifndef ZIYANOS_HAVE_ZLIB
+    if (m_zipMethod == 8) {
+        return fail("当前版本不支持deflate解压");
+    }
+#endif
+
+    if (!openOutput(name, name.endsWith('/'), 0)) {
+        return false;
+    }
+
+#ifdef ZIYANOS_HAVE_ZLIB
+    if (m_zipMethod == 8) {
+        inflateReset(&m_decoder->zipInflate);
+    }
+#endif
+
+    m_zipRemaining = m_zipCompressedSize;
+    m_zipState = ZipData;
+
+    // 空的存储条目（通常是目录）没有数据
+    if (m_zipMethod == 0 && m_zipRemaining == 0) {
+        return endZipData();
+    }
+    return true;
+}
+
+bool DownloadExtractor::feedZipData(const char *&data, qint64 &size)
+{
+    if (m_zipMethod == 0) {
+        qint64 chunk = qMin(size, m_zipRemaining);
+        if (!writeOutput(data, chunk)) {
+            return false;
+        }
+        data += chunk;
+        size -= chunk;
+        m_zipRemaining -= chunk;
+        return m_zipRemaining > 0 || endZipData();
+    }
+
+#ifdef ZIYANOS_HAVE_ZLIB
+    // deflate条目以数据流结束标记为准，不依赖头中的大小（可能在数据描述符中）
+    z_stream &stream = m_decoder->zipInflate;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+
+    bool ended = false;
+    while (true) {
+        stream.next_out = reinterpret_cast<Bytef*>(m_decodeBuffer.data());
+        stream.avail_out = static_cast<uInt>(m_decodeBuffer.size());
+
+        int ret = inflate(&stream, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            return fail(QString("zip数据损坏: %1").arg(stream.msg ? stream.msg : "未知错误"));
+        }
+
+        qint64 produced = m_decodeBuffer.size() - stream.avail_out;
+        if (produced > 0 && !writeOutput(m_decodeBuffer.constData(), produced)) {
+            return false;
+        }
+
+        if (ret == Z_STREAM_END) {
+            ended = true;
+            break;
+        }
+        if ((stream.avail_in == 0 && stream.avail_out > 0) || (ret == Z_BUF_ERROR && produced == 0)) {
+            break;
+        }
+    }
+
+    // 数据流结束后剩余的输入属于下一条记录
+    qint64 consumed = size - stream.avail_in;
+    data += consumed;
+    size -= consumed;
+    return !ended || endZipData();
+#else
+    return fail("当前版本不支持deflate解压");
+#endif
+}
+
+bool DownloadExtractor::endZipData()
+{
+    if (m_zipFlags & ZIP_FLAG_DESCRIPTOR) {
+        m_zipState = ZipDescriptor;
+        return true;
+    }
+    return finishZipEntry(m_zipCrc);
+}
+
+bool DownloadExtractor::finishZipEntry(quint32 crc)
+{
+    const QString path = m_outputPath;
+    const bool wasFile = m_output.isOpen();
+    if (!closeOutput()) {
+        return false;
+    }
+
+#ifdef ZIYANOS_HAVE_ZLIB
+    if (wasFile && m_outputCrc != crc) {
+        return fail("zip条目CRC校验失败: " + path);
+    }
+#else
+    Q_UNUSED(crc);
+    Q_UNUSED(wasFile);
+#endif
+
+    m_zipState = ZipSignature;
+    return true;
+}
+
+bool DownloadExtractor::openOutput(const QString &name, bool directory, int mode)
+{
+    QString path = resolvePath(name);
+    if (path.isEmpty()) {
+        return fail("压缩包中包含不安全的路径: " + name);
+    }
+
+    if (directory) {
+        if (!QDir().mkpath(path)) {
+            return fail("无法创建目录: " + path);
+        }
+        return true;
+    }
+
+    QDir parent = QFileInfo(path).absoluteDir();
+    if (!parent.exists() && !parent.mkpath(".")) {
+        return fail("无法创建目录: " + parent.absolutePath());
+    }
+
+    m_output.setFileName(path);
+    if (!m_output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail("无法创建文件: " + path + " (" + m_output.errorString() + ")");
+    }
+
+    m_outputPath = path;
+    m_outputMode = mode;
+#ifdef ZIYANOS_HAVE_ZLIB
+    m_outputCrc = static_cast<quint32>(crc32(0L, Z_NULL, 0));
+#endif
+    return true;
+}
+
+bool DownloadExtractor::writeOutput(const char *data, qint64 size)
+{
+    if (!m_output.isOpen() || size <= 0) {
+        return true;
+    }
+
+    if (m_output.write(data, size) != size) {
+        return fail("写入文件失败: " + m_outputPath + " (" + m_output.errorString() + ")");
+    }
+
+#ifdef ZIYANOS_HAVE_ZLIB
+    if (m_format == Zip) {
+        m_outputCrc = static_cast<quint32>(crc32(m_outputCrc, reinterpret_cast<const Bytef*>(data),
+                                                 static_cast<uInt>(size)));
+    }
+#endif
+
+    m_bytesExtracted += size;
+    return true;
+}
+
+bool DownloadExtractor::closeOutput()
+{
+    if (!m_output.isOpen()) {
+        return true;
+    }
+
+    m_output.close();
+    if (m_output.error() != QFileDevice::NoError) {
+        return fail("写入文件失败: " + m_outputPath + " (" + m_output.errorString() + ")");
+    }
+
+    // 保留tar中的可执行权限
+    if (m_outputMode & 0111) {
+        m_output.setPermissions(m_output.permissions()
+                                | QFileDevice::ExeOwner | QFileDevice::ExeGroup | QFileDevice::ExeOther);
+    }
+
+    m_filesExtracted++;
+    return true;
+}
+
+QString DownloadExtractor::resolvePath(const QString &name) const
+{
+    QString clean = name;
+    clean.replace('\\', '/');
+    clean = QDir::cleanPath(clean);
+    while (clean.startsWith("./")) {
+        clean.remove(0, 2);
+    }
+
+    if (clean.isEmpty() || clean == "." || clean == ".." || clean.startsWith('/')
+        || clean.startsWith("../") || clean.contains(':')) {
+        return QString();
+    }
+    return m_destination.filePath(clean);
+}
+
+bool DownloadExtractor::collect(const char *&data, qint64 &size, qint64 need)
+{
+    qint64 take = qMin(size, need - static_cast<qint64>(m_collect.size()));
+    if (take > 0) {
+        m_collect.append(data, static_cast<qsizetype>(take));
+        data += take;
+        size -= take;
+    }
+    return m_collect.size() >= need;
+}
+
+bool DownloadExtractor::fail(const QString &message)
+{
+    if (m_errorString.isEmpty()) {
+        m_errorString = message;
+        qCWarning(lcDownload) << "解包失败:" << message;
+    }
+    if (m_output.isOpen()) {
+        m_output.close();
+    }
+    return false;
+}
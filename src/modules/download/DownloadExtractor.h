@@ -0,0 +1,148 @@
+#ifndef DOWNLOADEXTRACTOR_H
+#define DOWNLOADEXTRACTOR_H
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QString>
+
+// 边下载边解包：
+// 压缩包数据按顺序流入，先按需解压（gzip/zstd），再解析tar或zip结构，
+// 解出的文件直接写入目标目录。压缩包本身不落盘，也不需要下载完成后再读一遍。
+// 格式根据数据开头的魔数判断：gzip、zstd（内部为tar）、zip、未压缩的tar。
+// gzip和zip的deflate需要zlib（ZIYANOS_HAVE_ZLIB），zstd需要libzstd（ZIYANOS_HAVE_ZSTD）。
+class DownloadExtractor
+{
+public:
+    enum Format {
+        Unknown,
+        Tar,
+        TarGzip,
+        TarZstd,
+        Zip
+    };
+
+    explicit DownloadExtractor(const QString &destinationDir);
+    ~DownloadExtractor();
+
+    // 追加压缩包数据（必须按顺序调用），返回false表示解包失败
+    bool addData(const char *data, qint64 size);
+
+    // 数据结束：检查压缩包是否完整
+    bool finish();
+
+    bool hasError() const { return !m_errorString.isEmpty(); }
+    QString errorString() const { return m_errorString; }
+
+    Format format() const { return m_format; }
+    int filesExtracted() const { return m_filesExtracted; }
+    qint64 bytesExtracted() const { return m_bytesExtracted; }
+
+    // 当前构建是否支持该格式
+    static bool isSupported(Format format);
+
+private:
+    // tar解析状态
+    enum TarState {
+        TarHeader,      // 读取512字节的头
+        TarEntryData,   // 条目数据
+        TarPadding,     // 数据后补齐到512字节的填充
+        TarEnd          // 已遇到结束块
+    };
+
+    // tar条目数据的去向
+    enum EntryKind {
+        EntryFile,      // 普通文件，写入磁盘
+        EntrySkip,      // 不解出的条目（链接、设备等）
+        EntryLongName,  // GNU长文件名
+        EntryPax        // pax扩展头
+    };
+
+    // zip解析状态
+    enum ZipState {
+        ZipSignature,   // 读取4字节签名
+        ZipLocalHeader, // 本地文件头的固定部分
+        ZipNameExtra,   // 文件名和扩展字段
+        ZipData,        // 条目数据
+        ZipDescriptor,  // 数据描述符
+        ZipEnd          // 已到达中央目录
+    };
+
+    // 从数据开头识别格式
+    bool detectFormat();
+
+    // 解压层：把解压后的数据交给tar解析
+    bool decompress(const char *data, qint64 size);
+
+    // tar解析
+    bool feedTar(const char *data, qint64 size);
+    bool processTarHeader(const char *header);
+    bool finishTarEntry();
+    void parsePaxHeader(const QByteArray &content);
+
+    // zip解析
+    bool feedZip(const char *data, qint64 size);
+    bool beginZipEntry();
+    bool feedZipData(const char *&data, qint64 &size);
+    bool endZipData();
+    bool finishZipEntry(quint32 crc);
+
+    // 输出文件
+    bool openOutput(const QString &name, bool directory, int mode);
+    bool writeOutput(const char *data, qint64 size);
+    bool closeOutput();
+
+    // 把条目名转换为目标目录下的安全路径（拒绝绝对路径和..）
+    QString resolvePath(const QString &name) const;
+
+    // 把数据收集到m_collect中，收满need字节时返回true
+    bool collect(const char *&data, qint64 &size, qint64 need);
+
+    bool fail(const QString &message);
+
+    QDir m_destination;
+    Format m_format;
+    QByteArray m_head;              // 识别格式前缓存的开头数据
+    QString m_errorString;
+
+    // 解压器状态（实现相关，见.cpp）
+    struct Decoder;
+    Decoder *m_decoder;
+    QByteArray m_decodeBuffer;      // 解压输出缓冲区
+
+    // tar状态
+    TarState m_tarState;
+    EntryKind m_entryKind;
+    qint64 m_entryRemaining;
+    qint64 m_paddingRemaining;
+    int m_zeroBlocks;
+    QByteArray m_entryBuffer;       // GNU长文件名或pax扩展头的内容
+    QString m_longName;
+    QString m_paxPath;
+    qint64 m_paxSize;
+
+    // zip状态
+    ZipState m_zipState;
+    quint16 m_zipFlags;
+    quint16 m_zipMethod;
+    quint32 m_zipCrc;
+    qint64 m_zipCompressedSize;
+    qint64 m_zipUncompressedSize;
+    qint64 m_zipRemaining;
+    int m_zipNameLength;
+    qint64 m_zipHeaderExtra;        // 文件名和扩展字段总长度
+    bool m_zip64;
+    quint32 m_outputCrc;
+
+    QByteArray m_collect;           // 跨数据块的头部拼接缓冲
+
+    // 当前输出文件
+    QFile m_output;
+    QString m_outputPath;
+    int m_outputMode;
+
+    int m_filesExtracted;
+    qint64 m_bytesExtracted;
+};
+
+#endif // DOWNLOADEXTRACTOR_H
@@ -0,0 +1,254 @@
+#include "DownloadHasher.h"
+#include <QList>
+#include <QRegularExpression>
+#include <QtEndian>
+#include <cstring>
+
+// XXH64常量
+static const quint64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const quint64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const quint64 PRIME64_3 = 0x165667B19E3779F9ULL;
+static const quint64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const quint64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline quint64 rotl64(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline quint64 readLE64(const uchar *p)
+{
+    quint64 value;
+    memcpy(&value, p, sizeof(value));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    value = qbswap(value);
+#endif
+    return value;
+}
+
+static inline quint32 readLE32(const uchar *p)
+{
+    quint32 value;
+    memcpy(&value, p, sizeof(value));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    value = qbswap(value);
+#endif
+    return value;
+}
+
+static inline quint64 xxh64Round(quint64 acc, quint64 input)
+{
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    acc *= PRIME64_1;
+    return acc;
+}
+
+static inline quint64 xxh64MergeRound(quint64 acc, quint64 value)
+{
+    value = xxh64Round(0, value);
+    acc ^= value;
+    acc = acc * PRIME64_1 + PRIME64_4;
+    return acc;
+}
+
+DownloadHasher::DownloadHasher()
+    : m_sha256(QCryptographicHash::Sha256)
+{
+    reset();
+}
+
+void DownloadHasher::reset()
+{
+    m_sha256.reset();
+
+    // 种子为0
+    m_acc[0] = PRIME64_1 + PRIME64_2;
+    m_acc[1] = PRIME64_2;
+    m_acc[2] = 0;
+    m_acc[3] = 0 - PRIME64_1;
+    m_pendingSize = 0;
+    m_totalLength = 0;
+
+    m_sha256Hex.clear();
+    m_xxh64Hex.clear();
+}
+
+void DownloadHasher::addData(const char *data, qint64 size)
+{
+    if (size <= 0) {
+        return;
+    }
+
+    m_sha256.addData(QByteArrayView(data, size));
+    xxh64Consume(reinterpret_cast<const uchar*>(data), size);
+}
+
+void DownloadHasher::finish()
+{
+    m_sha256Hex = QString::fromLatin1(m_sha256.result().toHex());
+    m_xxh64Hex = QString("%1").arg(xxh64Digest(), 16, 16, QChar('0'));
+}
+
+QString DownloadHasher::resultHex(Algorithm algorithm) const
+{
+    return algorithm == Xxh64 ? m_xxh64Hex : m_sha256Hex;
+}
+
+void DownloadHasher::xxh64Consume(const uchar *data, qint64 size)
+{
+    m_totalLength += size;
+
+    // 先补齐上次剩余的不足32字节的数据
+    if (m_pendingSize > 0) {
+        int fill = static_cast<int>(qMin<qint64>(32 - m_pendingSize, size));
+        memcpy(m_pending + m_pendingSize, data, static_cast<size_t>(fill));
+        m_pendingSize += fill;
+        data += fill;
+        size -= fill;
+
+        if (m_pendingSize < 32) {
+            return;
+        }
+
+        m_acc[0] = xxh64Round(m_acc[0], readLE64(m_pending));
+        m_acc[1] = xxh64Round(m_acc[1], readLE64(m_pending + 8));
+        m_acc[2] = xxh64Round(m_acc[2], readLE64(m_pending + 16));
+        m_acc[3] = xxh64Round(m_acc[3], readLE64(m_pending + 24));
+        m_pendingSize = 0;
+    }
+
+    // 主循环：每次处理32字节
+    while (size >= 32) {
+        m_acc[0] = xxh64Round(m_acc[0], readLE64(data));
+        m_acc[1] = xxh64Round(m_acc[1], readLE64(data + 8));
+        m_acc[2] = xxh64Round(m_acc[2], readLE64(data + 16));
+        m_acc[3] = xxh64Round(m_acc[3], readLE64(data + 24));
+        data += 32;
+        size -= 32;
+    }
+
+    if (size > 0) {
+        memcpy(m_pending, data, static_cast<size_t>(size));
+        m_pendingSize = static_cast<int>(size);
+    }
+}
+
+quint64 DownloadHasher::xxh64Digest() const
+{
+    quint64 hash;
+
+    if (m_totalLength >= 32) {
+        hash = rotl64(m_acc[0], 1) + rotl64(m_acc[1], 7)
+             + rotl64(m_acc[2], 12) + rotl64(m_acc[3], 18);
+        hash = xxh64MergeRound(hash, m_acc[0]);
+        hash = xxh64MergeRound(hash, m_acc[1]);
+        hash = xxh64MergeRound(hash, m_acc[2]);
+        hash = xxh64MergeRound(hash, m_acc[3]);
+    } else {
+        hash = m_acc[2] + PRIME64_5;
+    }
+
+    hash += static_cast<quint64>(m_totalLength);
+
+    // 处理剩余的尾部数据
+    const uchar *p = m_pending;
+    int remaining = m_pendingSize;
+
+    while (remaining >= 8) {
+        hash ^= xxh64Round(0, readLE64(p));
+        hash = rotl64(hash, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+        remaining -= 8;
+    }
+
+    if (remaining >= 4) {
+        hash ^= static_cast<quint64>(readLE32(p)) * PRIME64_1;
+        hash = rotl64(hash, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+        remaining -= 4;
+    }
+
+    while (remaining > 0) {
+        hash ^= (*p) * PRIME64_5;
+        hash = rotl64(hash, 11) * PRIME64_1;
+        p++;
+        remaining--;
+    }
+
+    // 最终混合
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+bool DownloadHasher::parseChecksum(const QString &text, Algorithm *algorithm, QString *hex)
+{
+    QString value = text.trimmed().toLower();
+    Algorithm parsed = Sha256;
+    int expectedLength = 64;
+
+    if (value.startsWith("sha256:")) {
+        value = value.mid(7);
+    } else if (value.startsWith("xxh64:")) {
+        value = value.mid(6);
+        parsed = Xxh64;
+        expectedLength = 16;
+    }
+
+    static const QRegularExpression hexRegex("^[0-9a-f]+$");
+    if (value.length() != expectedLength || !hexRegex.match(value).hasMatch()) {
+        return false;
+    }
+
+    *algorithm = parsed;
+    *hex = value;
+    return true;
+}
+
+QString DownloadHasher::parseSidecar(const QByteArray &content, const QString &fileName)
+{
+    QString firstHash;
+    int hashCount = 0;
+    const QList<QByteArray> lines = content.split('\n');
+
+    for (const QByteArray &rawLine : lines) {
+        QString line = QString::fromUtf8(rawLine).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        // sha256sum格式："<hex>  <文件名>"，二进制模式下文件名前有'*'
+        QString hash = line.section(QRegularExpression("\\s+"), 0, 0).toLower();
+        QString name = line.section(QRegularExpression("\\s+"), 1).trimmed();
+        if (name.startsWith('*')) {
+            name = name.mid(1);
+        }
+
+        Algorithm algorithm;
+        QString hex;
+        if (!parseChecksum(hash, &algorithm, &hex) || algorithm != Sha256) {
+            continue;
+        }
+
+        if (name.isEmpty() || name == fileName) {
+            return hex;
+        }
+        if (hashCount++ == 0) {
+            firstHash = hex;
+        }
+    }
+
+    // 旁路文件只包含一个校验值时，保存的文件名可能与发布时不同，直接使用
+    return hashCount == 1 ? firstHash : QString();
+}
+
+bool DownloadHasher::isSidecarUrl(const QString &text)
+{
+    QString value = text.trimmed().toLower();
+    return value.startsWith("http://") || value.startsWith("https://") || value.startsWith("ftp://");
+}
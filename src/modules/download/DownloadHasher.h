@@ -0,0 +1,65 @@
+#ifndef DOWNLOADHASHER_H
+#define DOWNLOADHASHER_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+
+// 下载数据流式校验：
+// 数据在写入管线中按顺序流过时同时计算SHA-256和XXH64，
+// 下载完成时即可得到结果，不需要再把文件完整读一遍。
+class DownloadHasher
+{
+public:
+    // 校验算法
+    enum Algorithm {
+        Sha256,     // 用于与发布方提供的校验值比对
+        Xxh64       // 快速非加密哈希，用于本地完整性检查
+    };
+
+    DownloadHasher();
+
+    // 追加数据（必须按文件顺序调用）
+    void addData(const char *data, qint64 size);
+
+    // 结束计算，之后可以读取结果
+    void finish();
+
+    // 清空状态，重新开始计算
+    void reset();
+
+    // 计算结果（十六进制小写字符串）
+    QString sha256Hex() const { return m_sha256Hex; }
+    QString xxh64Hex() const { return m_xxh64Hex; }
+    QString resultHex(Algorithm algorithm) const;
+
+    // 已处理的字节数
+    qint64 bytesHashed() const { return m_totalLength; }
+
+    // 解析期望的校验值："sha256:<hex>"、"xxh64:<hex>"，或不带前缀的64位十六进制（SHA-256）
+    static bool parseChecksum(const QString &text, Algorithm *algorithm, QString *hex);
+
+    // 从.sha256旁路文件内容中找出指定文件的校验值（格式："<hex>  <文件名>"，每行一个）
+    static QString parseSidecar(const QByteArray &content, const QString &fileName);
+
+    // 判断字符串是否为校验值旁路文件的URL
+    static bool isSidecarUrl(const QString &text);
+
+private:
+    // XXH64分块处理
+    void xxh64Consume(const uchar *data, qint64 size);
+    quint64 xxh64Digest() const;
+
+    QCryptographicHash m_sha256;
+
+    // XXH64状态
+    quint64 m_acc[4];
+    uchar m_pending[32];
+    int m_pendingSize;
+    qint64 m_totalLength;
+
+    QString m_sha256Hex;
+    QString m_xxh64Hex;
+};
+
+#endif // DOWNLOADHASHER_H
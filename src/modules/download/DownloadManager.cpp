@@ -1,41 +1,161 @@
 #include "DownloadManager.h"
+#include "LogCategories.h"
+#include "DownloadWriter.h"
+#include "DownloadHasher.h"
+#include "DownloadExtractor.h"
+#include "DownloadStreamDevice.h"
+#include "DownloadTaskStore.h"
+#include "DownloadTaskModel.h"
+#include <QDateTime>
 #include <QFileInfo>
+#include <QDir>
+#include <QUrl>
 #include <QCoreApplication>
 
+// 限速等待时单次休眠的最长时间，保证取消和速率修改能及时生效
+static const qint64 THROTTLE_SLICE_MS = 100;
+
+// 校验值旁路文件的最大长度
+static const int SIDECAR_MAX_SIZE = 1024 * 1024;
+
+// 暂停超过该时间后释放连接，恢复时通过Range请求续传
+static const qint64 PAUSE_RELEASE_MS = 30 * 1000;
+
+// 续传时读取已下载部分的块大小
+static const qint64 RESUME_HASH_CHUNK = 1024 * 1024;
+
+// 连接中断后自动续传的最大次数，以及每次递增的等待时间
+static const int MAX_TRANSFER_RETRIES = 5;
+static const qint64 RETRY_DELAY_STEP_MS = 500;
+
+// 连接被重置、超时或数据不完整等可以通过续传恢复的错误
+static bool isTransientError(CURLcode code)
+{
+    switch (code) {
+    case CURLE_PARTIAL_FILE:
+    case CURLE_RECV_ERROR:
+    case CURLE_SEND_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+DownloadManager* DownloadManager::m_instance = nullptr;
+
 DownloadManager::DownloadManager(QObject *parent)
     : QObject(parent)
-    , m_curl(nullptr)
-    , m_isDownloading(false)
+    , m_curlInitialized(false)
     , m_ignoreSslErrors(false)  // 默认不忽略SSL错误
-    , m_currentDownloadData(nullptr)
+    , m_cleartextHttp2(false)
+    , m_maxConcurrentDownloads(3)
+    , m_store(DownloadTaskStore::instance())
+    , m_taskModel(nullptr)
+    , m_cache(DownloadCache::instance())
+    , m_runningCount(0)
+    , m_globalRateLimit(0)      // 默认不限速
+    , m_nextBatchId(1)
 {
+    // 加载持久化的下载记录（进程内只加载一次）
+    m_store->load();
+    m_taskModel = new DownloadTaskModel(m_store, this);
+    connect(this, &DownloadManager::taskProgress, m_taskModel, &DownloadTaskModel::setProgress);
+
+    // 加载下载缓存索引，统计变化可能来自下载线程，通过排队连接转到主线程
+    m_cache->load();
+    connect(m_cache, &DownloadCache::statsChanged, this, &DownloadManager::cacheStatsChanged);
+
     // 初始化CURL全局库
     CURLcode res = curl_global_init(CURL_GLOBAL_DEFAULT);
     if (res != CURLE_OK) {
-        qWarning() << "Failed to initialize curl: " << curl_easy_strerror(res);
+        qCWarning(lcDownload) << "Failed to initialize curl: " << curl_easy_strerror(res);
         return;
     }
+    m_curlInitialized = true;
 
-    // 创建CURL句柄
-    m_curl = curl_easy_init();
-    if (!m_curl) {
-        qWarning() << "Failed to create curl handle";
-    }
+    // 每30秒检查一次限速时间窗口
+    m_scheduleTimer.setInterval(30 * 1000);
+    connect(&m_scheduleTimer, &QTimer::timeout, this, &DownloadManager::applyScheduleWindows);
 }
 
 DownloadManager::~DownloadManager()
 {
-    // 清理CURL句柄
-    if (m_curl) {
-        curl_easy_cleanup(m_curl);
-    }
+    shutdown();
 
     // 清理CURL全局状态
-    curl_global_cleanup();
+    if (m_curlInitialized) {
+        curl_global_cleanup();
+    }
+}
 
-    // 清理下载数据
-    if (m_currentDownloadData) {
-        delete m_currentDownloadData;
+DownloadManager* DownloadManager::instance()
+{
+    static std::mutex instanceMutex;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+
+    if (!m_instance) {
+        m_instance = new DownloadManager();
+    }
+    return m_instance;
+}
+
+void DownloadManager::shutdown()
+{
+    // 取消所有批量下载，等待其线程退出
+    for (DownloadBatch *batch : std::as_const(m_batches)) {
+        batch->cancel();
+    }
+    qDeleteAll(m_batches);
+    m_batches.clear();
+
+    // 中止所有传输并等待下载线程退出
+    for (DownloadData *data : std::as_const(m_tasks)) {
+        if (data->thread) {
+            requestCancel(data);
+        }
+    }
+
+    int interrupted = 0;
+    for (DownloadData *data : std::as_const(m_tasks)) {
+        if (data->thread) {
+            data->thread->wait();
+            delete data->thread;
+        }
+        if (data->curl) {
+            curl_easy_cleanup(data->curl);
+        }
+        if (data->stream) {
+            data->stream->setFailed();
+        }
+
+        // 写回状态：下载中的任务保持"下载中"，下次启动时自动续传；暂停和排队的任务保持原状态。
+        // 写入管线中止时缓冲的数据没有落盘，以实际的文件长度作为进度
+        TaskState state = data->state;
+        if (state == Running && !data->resumable && data->downloadedSize == 0) {
+            // 还没有收到数据（可能还没打开保存路径），下次启动时按新任务从头下载
+            state = Queued;
+        } else if (state == Running || state == Paused) {
+            if (!data->extract && (data->resumable || data->downloadedSize > 0)) {
+                data->downloadedSize = QFileInfo(data->savePath).size();
+            }
+            interrupted++;
+        }
+        m_store->updateTask(data->id, state, data->downloadedSize, data->totalSize);
+        delete data;
+    }
+    m_tasks.clear();
+    m_queue.clear();
+    m_runningCount = 0;
+
+    // 下载线程都已退出，不会再有新的缓存请求，停止加入缓存的后台线程
+    m_cache->stop();
+
+    if (interrupted > 0) {
+        qCInfo(lcDownload) << "退出时保存了" << interrupted << "个未完成的下载任务";
     }
 }
 
@@ -52,13 +172,88 @@ void DownloadManager::setIgnoreSslErrors(bool ignore)
         emit ignoreSslErrorsChanged(ignore);
 
         if (ignore) {
-            qWarning() << "SSL证书验证已禁用。注意：这可能导致安全风险！";
+            qCWarning(lcDownload) << "SSL证书验证已禁用。注意：这可能导致安全风险！";
         } else {
-            qInfo() << "SSL证书验证已启用";
+            qCInfo(lcDownload) << "SSL证书验证已启用";
         }
     }
 }
 
+// 全局限速属性访问器
+qint64 DownloadManager::globalRateLimit() const
+{
+    return m_globalRateLimit;
+}
+
+void DownloadManager::setGlobalRateLimit(qint64 bytesPerSecond)
+{
+    bytesPerSecond = qMax<qint64>(0, bytesPerSecond);
+    if (m_globalRateLimit != bytesPerSecond) {
+        m_globalRateLimit = bytesPerSecond;
+        applyScheduleWindows();
+        emit globalRateLimitChanged(bytesPerSecond);
+
+        qCInfo(lcDownload) << "全局限速已设置为:" << (bytesPerSecond > 0 ? formatFileSize(bytesPerSecond) + "/s" : QString("不限速"));
+    }
+}
+
+int DownloadManager::maxConcurrentDownloads() const
+{
+    return m_maxConcurrentDownloads;
+}
+
+void DownloadManager::setMaxConcurrentDownloads(int count)
+{
+    count = qMax(1, count);
+    if (m_maxConcurrentDownloads != count) {
+        m_maxConcurrentDownloads = count;
+        emit maxConcurrentDownloadsChanged(count);
+
+        // 槽位增加时立即启动排队任务
+        scheduleNext();
+    }
+}
+
+QAbstractListModel *DownloadManager::taskModel() const
+{
+    return m_taskModel;
+}
+
+qint64 DownloadManager::cacheSizeLimit() const
+{
+    return m_cache->sizeLimit();
+}
+
+void DownloadManager::setCacheSizeLimit(qint64 bytes)
+{
+    m_cache->setSizeLimit(bytes);
+}
+
+qint64 DownloadManager::cacheSize() const
+{
+    return m_cache->totalSize();
+}
+
+qint64 DownloadManager::cacheHits() const
+{
+    return m_cache->hits();
+}
+
+qint64 DownloadManager::cacheMisses() const
+{
+    return m_cache->misses();
+}
+
+qint64 DownloadManager::cacheBytesSaved() const
+{
+    return m_cache->bytesSaved();
+}
+
+void DownloadManager::clearCache()
+{
+    m_cache->clear();
+}
+
 QString DownloadManager::formatFileSize(qint64 bytes) const
 {
     if (bytes == 0) return "0 B";
@@ -76,176 +271,1078 @@ QString DownloadManager::formatFileSize(qint64 bytes) const
     return QString("%1 %2").arg(QString::number(size, 'f', 1)).arg(units[unitIndex]);
 }
 
-void DownloadManager::startDownload(const QString &url, const QString &savePath)
+int DownloadManager::startDownload(const QString &url, const QString &savePath)
 {
-    // 检查是否已有下载任务
-    if (m_isDownloading) {
-        emit downloadError("已有下载任务正在进行");
-        return;
-    }
+    return enqueueDownload(url, savePath, 0);
+}
 
-    // 检查CURL句柄是否有效
-    if (!m_curl) {
+int DownloadManager::startVerifiedDownload(const QString &url, const QString &savePath, const QString &expectedChecksum)
+{
+    return enqueueDownload(url, savePath, 0, expectedChecksum);
+}
+
+int DownloadManager::enqueueDownload(const QString &url, const QString &savePath, int priority,
+                                     const QString &expectedChecksum)
+{
+    return enqueueTask(url, savePath, priority, expectedChecksum, 0);
+}
+
+int DownloadManager::startExtractDownload(const QString &url, const QString &destinationDir,
+                                          const QString &expectedChecksum)
+{
+    return enqueueTask(url, destinationDir, 0, expectedChecksum, TaskFlagExtract);
+}
+
+int DownloadManager::enqueueTask(const QString &url, const QString &savePath, int priority,
+                                 const QString &expectedChecksum, int flags)
+{
+    // 检查CURL是否初始化成功
+    if (!m_curlInitialized) {
         emit downloadError("CURL初始化失败");
-        return;
+        return -1;
     }
 
     // 检查URL是否为空
     if (url.isEmpty()) {
         emit downloadError("URL不能为空");
-        return;
+        return -1;
     }
 
     // 检查保存路径是否为空
     if (savePath.isEmpty()) {
         emit downloadError("保存路径不能为空");
+        return -1;
+    }
+
+    // 检查校验值格式（旁路文件URL在下载时再解析）
+    QString checksum = expectedChecksum.trimmed();
+    if (!checksum.isEmpty() && !DownloadHasher::isSidecarUrl(checksum)) {
+        DownloadHasher::Algorithm algorithm;
+        QString hex;
+        if (!DownloadHasher::parseChecksum(checksum, &algorithm, &hex)) {
+            emit downloadError("无效的校验值: " + checksum);
+            return -1;
+        }
+    }
+
+    // 写入持久化记录
+    DownloadTaskRecord record;
+    record.id = m_store->allocateTaskId();
+    record.url = url;
+    record.savePath = savePath;
+    record.expectedChecksum = checksum;
+    record.priority = priority;
+    record.state = Queued;
+    record.createdAt = QDateTime::currentMSecsSinceEpoch();
+    record.flags = flags;
+    m_store->addTask(record);
+
+    // 创建下载数据结构
+    DownloadData *data = createTaskData(record);
+    m_tasks.insert(data->id, data);
+    m_queue.append(data->id);
+
+    qCDebug(lcDownload) << "下载任务已加入队列:" << data->id << url << "优先级:" << priority;
+    emit taskStateChanged(data->id, Queued);
+
+    scheduleNext();
+    return data->id;
+}
+
+void DownloadManager::cancelDownload()
+{
+    // 取消所有任务（包括排队中的任务）
+    const QList<int> taskIds = m_tasks.keys();
+    for (int taskId : taskIds) {
+        cancelTask(taskId);
+    }
+}
+
+void DownloadManager::cancelTask(int taskId)
+{
+    DownloadData *data = m_tasks.value(taskId, nullptr);
+    if (!data) {
+        return;
+    }
+
+    if (!data->thread) {
+        // 排队中或已释放连接的暂停任务直接移除
+        m_queue.removeAll(taskId);
+        m_tasks.remove(taskId);
+        setTaskState(data, Canceled);
+        delete data;
+        return;
+    }
+
+    // 下载线程在下一次CURL回调中中止传输
+    requestCancel(data);
+}
+
+void DownloadManager::pauseTask(int taskId)
+{
+    DownloadData *data = m_tasks.value(taskId, nullptr);
+    if (!data) {
+        return;
+    }
+
+    if (data->state == Queued) {
+        // 尚未开始的任务移出队列，恢复时重新排队
+        m_queue.removeAll(taskId);
+        setTaskState(data, Paused);
+        return;
+    }
+
+    if (data->state == Running && data->thread) {
+        // 下载线程在回调中暂停传输，连接暂时保留
+        data->control = ControlPause;
+        setTaskState(data, Paused);
+    }
+}
+
+void DownloadManager::resumeTask(int taskId)
+{
+    DownloadData *data = m_tasks.value(taskId, nullptr);
+    if (!data || data->state != Paused) {
+        return;
+    }
+
+    data->control = ControlRun;
+
+    if (data->thread) {
+        // 连接还在，下载线程在下一次进度回调中继续传输
+        setTaskState(data, Running);
+        return;
+    }
+
+    // 连接已释放，重新排队后从已下载的位置续传（resumable在传输释放时设置；
+    // 排队中就被暂停的任务没有写过文件，保存路径上已有的文件不是它的，仍然从头下载）
+    setTaskState(data, Queued);
+    m_queue.append(taskId);
+    scheduleNext();
+}
+
+void DownloadManager::requestCancel(DownloadData *data)
+{
+    data->control = ControlCancel;
+
+    // 写入管线缓冲区已满时下载线程会阻塞在append中，这里直接唤醒
+    std::lock_guard<std::mutex> lock(data->writerMutex);
+    if (data->writer) {
+        data->writer->abort();
+    }
+}
+
+void DownloadManager::setTaskPriority(int taskId, int priority)
+{
+    DownloadData *data = m_tasks.value(taskId, nullptr);
+    if (data) {
+        data->priority = priority;
+    }
+}
+
+void DownloadManager::setTaskRateLimit(int taskId, qint64 bytesPerSecond)
+{
+    DownloadData *data = m_tasks.value(taskId, nullptr);
+    if (data) {
+        data->limiter.setRate(bytesPerSecond);
+    }
+}
+
+bool DownloadManager::addScheduleWindow(const QString &start, const QString &end, qint64 bytesPerSecond)
+{
+    QTime startTime = QTime::fromString(start, "HH:mm");
+    QTime endTime = QTime::fromString(end, "HH:mm");
+
+    if (!startTime.isValid() || !endTime.isValid() || startTime == endTime) {
+        qCWarning(lcDownload) << "无效的限速时间窗口:" << start << "-" << end;
+        return false;
+    }
+
+    BandwidthScheduleWindow window;
+    window.start = startTime;
+    window.end = endTime;
+    window.rate = qMax<qint64>(0, bytesPerSecond);
+    m_scheduleWindows.append(window);
+
+    qCInfo(lcDownload) << "已添加限速时间窗口:" << start << "-" << end
+            << (window.rate > 0 ? formatFileSize(window.rate) + "/s" : QString("不限速"));
+
+    applyScheduleWindows();
+    if (!m_scheduleTimer.isActive()) {
+        m_scheduleTimer.start();
+    }
+    return true;
+}
+
+void DownloadManager::clearScheduleWindows()
+{
+    m_scheduleWindows.clear();
+    m_scheduleTimer.stop();
+    applyScheduleWindows();
+}
+
+int DownloadManager::taskState(int taskId) const
+{
+    DownloadData *data = m_tasks.value(taskId, nullptr);
+    if (data) {
+        return data->state;
+    }
+
+    // 已结束的任务从记录中查询
+    return m_store->contains(taskId) ? m_store->task(taskId).state : -1;
+}
+
+void DownloadManager::removeTask(int taskId)
+{
+    if (m_tasks.contains(taskId)) {
+        qCWarning(lcDownload) << "无法删除进行中的下载任务:" << taskId;
+        return;
+    }
+    m_store->removeTask(taskId);
+}
+
+void DownloadManager::clearHistory()
+{
+    m_store->clearFinished({Finished, Failed, Canceled});
+}
+
+int DownloadManager::startBatchDownload(const QStringList &urls, const QString &targetDir)
+{
+    if (targetDir.isEmpty()) {
+        emit downloadError("保存目录不能为空");
+        return -1;
+    }
+    return launchBatch(DownloadBatch::entriesFromUrls(urls, targetDir));
+}
+
+int DownloadManager::startManifestDownload(const QString &manifestPath, const QString &targetDir)
+{
+    if (targetDir.isEmpty()) {
+        emit downloadError("保存目录不能为空");
+        return -1;
+    }
+
+    QFile manifest(manifestPath);
+    if (!manifest.open(QIODevice::ReadOnly)) {
+        emit downloadError("无法打开下载清单: " + manifestPath);
+        return -1;
+    }
+
+    QString errorMessage;
+    QList<DownloadBatch::Entry> entries = DownloadBatch::parseManifest(manifest.readAll(), targetDir, &errorMessage);
+    if (!errorMessage.isEmpty()) {
+        emit downloadError(errorMessage);
+        return -1;
+    }
+    return launchBatch(entries);
+}
+
+void DownloadManager::cancelBatch(int batchId)
+{
+    DownloadBatch *batch = m_batches.value(batchId, nullptr);
+    if (batch) {
+        batch->cancel();
+    }
+}
+
+int DownloadManager::launchBatch(const QList<DownloadBatch::Entry> &entries)
+{
+    if (!m_curlInitialized) {
+        emit downloadError("CURL初始化失败");
+        return -1;
+    }
+
+    if (entries.isEmpty()) {
+        emit downloadError("下载列表为空");
+        return -1;
+    }
+
+    const int batchId = m_nextBatchId++;
+    DownloadBatch *batch = new DownloadBatch(batchId, entries, this);
+    batch->setIgnoreSslErrors(m_ignoreSslErrors);
+    batch->setCleartextHttp2(m_cleartextHttp2);
+    batch->setGlobalLimiter(&m_globalLimiter);
+
+    // 批次信号在下载线程中发出，排队到主线程转发
+    connect(batch, &DownloadBatch::progress, this, &DownloadManager::batchProgress);
+    connect(batch, &DownloadBatch::fileFailed, this, &DownloadManager::batchFileFailed);
+    connect(batch, &DownloadBatch::finished, this, [this](int id, int succeeded, int failed, bool canceled) {
+        DownloadBatch *finishedBatch = m_batches.take(id);
+        if (finishedBatch) {
+            finishedBatch->wait();
+            finishedBatch->deleteLater();
+        }
+        emit batchFinished(id, succeeded, failed, canceled);
+    });
+
+    m_batches.insert(batchId, batch);
+    batch->start();
+
+    qCDebug(lcDownload) << "批量下载已开始:" << batchId << "共" << entries.size() << "个文件";
+    return batchId;
+}
+
+DownloadManager::DownloadData *DownloadManager::createTaskData(const DownloadTaskRecord &record)
+{
+    DownloadData *data = new DownloadData();
+    data->id = record.id;
+    data->url = record.url;
+    data->savePath = record.savePath;
+    data->priority = record.priority;
+    data->state = Queued;
+    data->file = nullptr;
+    data->extract = (record.flags & TaskFlagExtract) != 0;
+    data->extractor = nullptr;
+    data->writer = nullptr;
+    data->expectedChecksum = record.expectedChecksum;
+    data->hasher = nullptr;
+    data->curl = nullptr;
+    data->thread = nullptr;
+    data->totalSize = record.totalSize;
+    data->downloadedSize = record.downloadedSize;
+    data->control = ControlRun;
+    // 只有本任务写过部分文件时才续传：上次运行中被中断，或者记录了已下载的长度；
+    // 排队中就被暂停的任务从没打开过保存路径，那里的同名文件不能当作已下载的部分。
+    // 解包任务的解析状态无法恢复，总是从头开始
+    data->resumable = !data->extract && (record.state == Running || record.downloadedSize > 0);
+    if (!data->extract) {
+        // 下载过程中查看器和播放器可以直接读取已到达的数据，可续传的部分文件开始前就能读取
+        qint64 existingSize = data->resumable ? QFileInfo(record.savePath).size() : 0;
+        data->stream = DownloadStreamSource::create(record.savePath, existingSize);
+        if (record.totalSize > 0) {
+            data->stream->setTotalSize(record.totalSize);
+        }
+    }
+    data->resumeOffset = 0;
+    data->transferPaused = false;
+    data->manager = this;
+    return data;
+}
+
+void DownloadManager::restoreTasks()
+{
+    // 上次退出时仍在运行的任务重新排队，暂停的任务保持暂停
+    const QList<DownloadTaskRecord> records = m_store->takeRestorableTasks({Queued, Running, Paused});
+    if (records.isEmpty()) {
+        return;
+    }
+
+    for (const DownloadTaskRecord &record : records) {
+        DownloadData *data = createTaskData(record);
+        m_tasks.insert(data->id, data);
+
+        if (record.state == Paused) {
+            data->state = Paused;
+            continue;
+        }
+
+        m_queue.append(data->id);
+        if (record.state != Queued) {
+            // 异常退出时进度没有写入记录，以部分文件的实际长度为准，再次中断后仍然可以续传
+            if (data->resumable) {
+                data->downloadedSize = QFileInfo(record.savePath).size();
+            }
+            m_store->updateTask(record.id, Queued, data->downloadedSize, record.totalSize);
+        }
+    }
+
+    qCInfo(lcDownload) << "已恢复" << records.size() << "个未完成的下载任务";
+
+    // 等QML完成信号连接后再开始调度
+    QMetaObject::invokeMethod(this, [this]() { scheduleNext(); }, Qt::QueuedConnection);
+}
+
+void DownloadManager::applyScheduleWindows()
+{
+    // 第一个包含当前时间的窗口生效，否则使用用户设置的全局速率
+    qint64 rate = m_globalRateLimit;
+    QTime now = QTime::currentTime();
+    for (const BandwidthScheduleWindow &window : std::as_const(m_scheduleWindows)) {
+        if (window.contains(now)) {
+            rate = window.rate;
+            break;
+        }
+    }
+
+    if (m_globalLimiter.rate() != rate) {
+        m_globalLimiter.setRate(rate);
+        qCDebug(lcDownload) << "当前全局速率:" << (rate > 0 ? formatFileSize(rate) + "/s" : QString("不限速"));
+    }
+}
+
+void DownloadManager::setTaskState(DownloadData *data, TaskState state)
+{
+    if (data->state != state) {
+        data->state = state;
+
+        // 只在状态变化时追加记录，进度变化不写入存储
+        bool finished = (state == Finished || state == Failed || state == Canceled);
+        m_store->updateTask(data->id, state, data->downloadedSize, data->totalSize, finished);
+
+        // 通知正在读取该文件的查看器和播放器
+        if (data->stream && state == Finished) {
+            data->stream->setFinished(QFileInfo(data->savePath).size());
+        } else if (data->stream && (state == Failed || state == Canceled)) {
+            data->stream->setFailed();
+        }
+
+        emit taskStateChanged(data->id, state);
+    }
+}
+
+void DownloadManager::scheduleNext()
+{
+    while (m_runningCount < m_maxConcurrentDownloads && !m_queue.isEmpty()) {
+        // 选出优先级最高的任务，同优先级按加入顺序
+        int bestIndex = 0;
+        for (int i = 1; i < m_queue.size(); ++i) {
+            if (m_tasks.value(m_queue[i])->priority > m_tasks.value(m_queue[bestIndex])->priority) {
+                bestIndex = i;
+            }
+        }
+
+        DownloadData *data = m_tasks.value(m_queue.takeAt(bestIndex));
+        launchTask(data);
+    }
+}
+
+void DownloadManager::launchTask(DownloadData *data)
+{
+    // CURL句柄由主线程创建和回收，下载线程只负责使用
+    data->curl = curl_easy_init();
+    if (!data->curl) {
+        qCWarning(lcDownload) << "Failed to create curl handle";
+        emit downloadError("CURL初始化失败");
+        m_tasks.remove(data->id);
+        setTaskState(data, Failed);
+        delete data;
         return;
     }
 
-    m_currentUrl = url;
-    m_currentSavePath = savePath;
+    m_runningCount++;
+    setTaskState(data, Running);
+
+    const int taskId = data->id;
 
     // 在新线程中执行下载，避免阻塞UI
-    QThread *downloadThread = QThread::create([this, url, savePath]() {
-        m_isDownloading = true;
+    data->thread = QThread::create([this, data, taskId]() {
+        TaskState result = runTask(data);
 
-        // 创建下载数据结构
-        DownloadData *downloadData = new DownloadData();
-        downloadData->file = new QFile(savePath);
-        downloadData->totalSize = 0;
-        downloadData->downloadedSize = 0;
-        downloadData->manager = this;
+        // 回到主线程回收任务并调度下一个
+        QMetaObject::invokeMethod(this, [this, taskId, result]() {
+            onTaskThreadFinished(taskId, result);
+        }, Qt::QueuedConnection);
+    });
+    data->thread->start();
+}
 
-        m_currentDownloadData = downloadData;
+void DownloadManager::onTaskThreadFinished(int taskId, int state)
+{
+    DownloadData *data = m_tasks.value(taskId, nullptr);
+    if (!data) {
+        return;
+    }
 
-        // 尝试打开文件进行写入
-        if (!downloadData->file->open(QIODevice::WriteOnly)) {
-            emit downloadError("无法创建文件: " + savePath);
-            delete downloadData->file;
-            delete downloadData;
-            m_currentDownloadData = nullptr;
-            m_isDownloading = false;
-            return;
-        }
-
-        CURLcode res;
-
-        // 重置CURL句柄选项
-        curl_easy_reset(m_curl);
-
-        // 设置CURL选项
-        curl_easy_setopt(m_curl, CURLOPT_URL, url.toUtf8().constData());
-        curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, writeData);
-        curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, downloadData);
-        curl_easy_setopt(m_curl, CURLOPT_NOPROGRESS, 0L);
-        curl_easy_setopt(m_curl, CURLOPT_XFERINFOFUNCTION, progressCallback);
-        curl_easy_setopt(m_curl, CURLOPT_XFERINFODATA, downloadData);
-
-        // 设置超时
-        curl_easy_setopt(m_curl, CURLOPT_CONNECTTIMEOUT, 30L);
-        curl_easy_setopt(m_curl, CURLOPT_TIMEOUT, 300L); // 总超时300秒
-
-        // 设置用户代理
-        curl_easy_setopt(m_curl, CURLOPT_USERAGENT, "ZiyanOS-Downloader/1.0");
-
-        // 跟随重定向
-        curl_easy_setopt(m_curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(m_curl, CURLOPT_MAXREDIRS, 10L);
-
-        // 设置SSL选项（根据用户设置决定是否忽略证书验证）
-        if (m_ignoreSslErrors) {
-            // 忽略SSL证书验证
-            curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYHOST, 0L);
-            qDebug() << "SSL证书验证已禁用";
+    if (data->thread) {
+        data->thread->wait();
+        delete data->thread;
+        data->thread = nullptr;
+    }
+
+    if (data->curl) {
+        curl_easy_cleanup(data->curl);
+        data->curl = nullptr;
+    }
+
+    m_runningCount--;
+
+    if (state == Paused && data->control == ControlCancel) {
+        // 释放连接期间用户取消了任务
+        state = Canceled;
+    }
+
+    if (state == Paused) {
+        // 暂停超时已释放连接，保留任务以便之后续传
+        data->resumable = true;
+        if (data->control == ControlRun) {
+            // 释放连接期间用户已经恢复，直接重新排队
+            setTaskState(data, Queued);
+            m_queue.append(taskId);
         } else {
-            // 启用SSL证书验证（默认）
-            curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, 1L);
-            curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYHOST, 2L);
+            data->state = Paused;
+            m_store->updateTask(taskId, Paused, data->downloadedSize, data->totalSize);
+            emit taskStateChanged(taskId, Paused);
         }
+        scheduleNext();
+        return;
+    }
 
-        // 先获取文件大小（HEAD请求）
-        curl_easy_setopt(m_curl, CURLOPT_NOBODY, 1L);
-        res = curl_easy_perform(m_curl);
+    m_tasks.remove(taskId);
+    setTaskState(data, static_cast<TaskState>(state));
+    delete data;
 
-        if (res == CURLE_OK) {
-            // 获取文件大小
-            curl_off_t fileSize = 0;
-            curl_easy_getinfo(m_curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &fileSize);
-            downloadData->totalSize = static_cast<qint64>(fileSize);
+    scheduleNext();
+}
 
-            // 发出开始信号
-            QFileInfo fileInfo(savePath);
-            QString sizeStr = formatFileSize(static_cast<qint64>(fileSize));
-            emit downloadStarted(fileInfo.fileName(), sizeStr);
+DownloadManager::TaskState DownloadManager::runTask(DownloadData *data)
+{
+    const QString url = data->url;
+    const QString savePath = data->savePath;
+    CURL *curl = data->curl;
+
+    // 解析期望的校验值，旁路文件在打开目标文件之前下载
+    DownloadHasher::Algorithm checksumAlgorithm = DownloadHasher::Sha256;
+    QString expectedHex;
+    if (!data->expectedChecksum.isEmpty()) {
+        if (DownloadHasher::isSidecarUrl(data->expectedChecksum)) {
+            QByteArray sidecar;
+            QString sidecarError;
+            if (!fetchSidecar(data->expectedChecksum, &sidecar, &sidecarError)) {
+                emit downloadError("无法获取校验文件: " + sidecarError);
+                return data->control == ControlCancel ? Canceled : Failed;
+            }
+            // 解包任务的保存路径是目录，按压缩包文件名查找
+            const QString fileName = data->extract ? QUrl(url).fileName() : QFileInfo(savePath).fileName();
+            expectedHex = DownloadHasher::parseSidecar(sidecar, fileName);
+            if (expectedHex.isEmpty()) {
+                emit downloadError("校验文件中没有找到有效的SHA-256值");
+                return Failed;
+            }
         } else {
-            qDebug() << "无法获取文件大小，将继续尝试下载";
+            DownloadHasher::parseChecksum(data->expectedChecksum, &checksumAlgorithm, &expectedHex);
+        }
+        qCDebug(lcDownload) << "下载任务" << data->id << "期望校验值:" << expectedHex;
+    }
+
+    // 内容寻址缓存：按期望的SHA-256命中时直接放到保存路径，不需要任何网络请求
+    const bool useCache = !data->extract && m_cache->isEnabled();
+    if (useCache && checksumAlgorithm == DownloadHasher::Sha256 && !expectedHex.isEmpty()) {
+        DownloadCache::Entry entry;
+        if (m_cache->findByHash(expectedHex, &entry) && finishFromCache(data, entry)) {
+            return Finished;
+        }
+    }
+
+    CURLcode res;
+
+    // 设置CURL选项
+    curl_easy_setopt(curl, CURLOPT_URL, url.toUtf8().constData());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeData);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, data);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, data);
+
+    // 设置超时
+    // 限速时大文件的下载时间无法预估，不再设置总超时，改为检测连接停滞（60秒内低于1字节/秒）
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);
+
+    // 设置用户代理
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "ZiyanOS-Downloader/1.0");
+
+    // 跟随重定向
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 10L);
+
+    // 设置SSL选项（根据用户设置决定是否忽略证书验证）
+    applySslOptions(curl);
+    applyHttpVersion(curl, url);
+
+    // 先获取文件大小（HEAD请求），同一个请求的ETag用于查找下载缓存
+    QByteArray etagHeader;
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, captureETag);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &etagHeader);
+    res = curl_easy_perform(curl);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, nullptr);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, nullptr);
+
+    const bool sizeKnown = (res == CURLE_OK);
+    QString etag;
+    if (sizeKnown) {
+        // 获取文件大小
+        curl_off_t fileSize = 0;
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &fileSize);
+        data->totalSize = static_cast<qint64>(fileSize);
+        if (data->stream && fileSize > 0) {
+            data->stream->setTotalSize(data->totalSize);
+        }
+
+        long headCode = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &headCode);
+        if (headCode >= 200 && headCode < 300) {
+            etag = QString::fromLatin1(etagHeader);
+        }
+    } else {
+        qCDebug(lcDownload) << "无法获取文件大小，将继续尝试下载";
+    }
+
+    // 再按URL + 上面HEAD请求得到的ETag查找缓存，命中时不再下载内容
+    if (useCache) {
+        DownloadCache::Entry entry;
+        bool hit = m_cache->findByUrl(url, etag, &entry);
+
+        // 指定了期望值时，缓存的内容也必须与之一致
+        if (hit && !expectedHex.isEmpty()) {
+            hit = (checksumAlgorithm == DownloadHasher::Sha256 ? entry.sha256 : entry.xxh64) == expectedHex;
+        }
+        if (hit && finishFromCache(data, entry)) {
+            return Finished;
+        }
+        if (data->control == ControlCancel) {
+            return Canceled;
+        }
+        m_cache->recordMiss();
+    }
+
+    if (sizeKnown) {
+        // 发出开始信号
+        QFileInfo fileInfo(savePath);
+        QString sizeStr = formatFileSize(data->totalSize);
+        emit downloadStarted(fileInfo.fileName(), sizeStr);
+    }
+
+    qint64 resumeOffset = 0;
+    data->hasher = new DownloadHasher();
+
+    if (data->extract) {
+        // 解包任务：压缩包不落盘，数据在写入线程中直接解包到目标目录
+        if (!QDir().mkpath(savePath)) {
+            emit downloadError("无法创建目录: " + savePath);
+            releaseTaskResources(data);
+            return Failed;
+        }
+        data->extractor = new DownloadExtractor(savePath);
+    } else {
+        // 续传：从已有的部分文件末尾继续
+        if (data->resumable) {
+            QFileInfo partial(savePath);
+            if (partial.exists()) {
+                resumeOffset = partial.size();
+            }
+        }
+
+        data->file = new QFile(savePath);
+
+        // 尝试打开文件进行写入（写入管线已做大块缓冲，不再使用QFile内部缓冲）
+        QIODevice::OpenMode openMode = QIODevice::ReadWrite | QIODevice::Unbuffered;
+        if (resumeOffset == 0) {
+            openMode |= QIODevice::Truncate;
+        }
+        if (!data->file->open(openMode)) {
+            emit downloadError("无法创建文件: " + savePath);
+            releaseTaskResources(data);
+            return Failed;
+        }
+
+        // 已下载的部分先交给校验器，保证校验值覆盖整个文件
+        if (resumeOffset > 0 && !hashFilePrefix(data, resumeOffset)) {
+            if (data->control == ControlCancel) {
+                releaseTaskResources(data);
+                return Canceled;
+            }
+            qCWarning(lcDownload) << "无法读取已下载的部分，重新下载:" << savePath;
+            data->hasher->reset();
+            data->file->resize(0);
+            resumeOffset = 0;
+        }
+        data->file->seek(resumeOffset);
+    }
+    data->resumeOffset = resumeOffset;
+    data->downloadedSize = resumeOffset;
+
+    // 启动后台写入线程，数据写盘（或解包）时同步计算校验值
+    {
+        std::lock_guard<std::mutex> lock(data->writerMutex);
+        data->writer = new DownloadWriter(data->file);
+    }
+    data->writer->setHasher(data->hasher);
+    data->writer->setExtractor(data->extractor);
+    data->writer->setStreamSource(data->stream.get());
+    data->writer->setStartOffset(resumeOffset);
+    if (!data->writer->start()) {
+        emit downloadError("无法启动写入线程: " + savePath);
+        releaseTaskResources(data);
+        return Failed;
+    }
+    if (data->stream) {
+        data->stream->attachWriter(data->writer);
+    }
+
+
+    // 部分文件不短于远端文件时无法续传，重新下载
+    if (resumeOffset > 0 && data->totalSize > 0 && resumeOffset >= data->totalSize) {
+        qCDebug(lcDownload) << "已下载部分与远端文件大小不符，重新下载:" << savePath;
+        data->hasher->reset();
+        data->file->resize(0);
+        data->file->seek(0);
+        resumeOffset = 0;
+        data->resumeOffset = 0;
+        data->downloadedSize = 0;
+        data->writer->setStartOffset(0);
+    }
+
+    // 重新设置以获取文件内容
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
+    curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(resumeOffset));
+
+    // 文件下载不请求内容编码，也不让CURL解码：保存的必须是服务器上原样的字节，
+    // 否则以gzip传输的.tar.gz/.gz会被解压，校验值、Content-Length和续传偏移都对不上
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, nullptr);
+    if (resumeOffset > 0) {
+        qCDebug(lcDownload) << "从" << formatFileSize(resumeOffset) << "处续传:" << savePath;
+    }
+
+    // 执行下载
+    res = curl_easy_perform(curl);
+
+    if (res == CURLE_RANGE_ERROR && resumeOffset > 0 && data->control == ControlRun) {
+        // 服务器不支持Range请求，此时还没有写入任何数据，从头开始下载
+        qCDebug(lcDownload) << "服务器不支持续传，重新下载:" << savePath;
+        data->hasher->reset();
+        data->file->resize(0);
+        data->file->seek(0);
+        data->resumeOffset = 0;
+        data->downloadedSize = 0;
+        data->writer->setStartOffset(0);
+        curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(0));
+        res = curl_easy_perform(curl);
+    }
+
+    // 连接被重置或中断：与释放连接后恢复一样，从已接收的位置用Range请求续传，
+    // 已写入的数据和校验状态保持不变；暂停、取消或写入失败时不再重试
+    int retries = 0;
+    while (isTransientError(res) && retries < MAX_TRANSFER_RETRIES && data->control == ControlRun
+           && !data->writer->hasError()) {
+        retries++;
+        qCWarning(lcDownload) << "下载中断:" << curl_easy_strerror(res) << "，第" << retries << "次从"
+                   << formatFileSize(data->downloadedSize) << "处续传:" << url;
+        if (!waitBeforeRetry(data, retries)) {
+            break;
+        }
+
+        data->resumeOffset = data->downloadedSize;
+        curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(data->resumeOffset));
+        res = curl_easy_perform(curl);
+
+        // 服务器不再支持Range请求时无法续接，按失败处理
+        if (res == CURLE_RANGE_ERROR) {
+            qCWarning(lcDownload) << "服务器拒绝续传请求:" << url;
+            break;
         }
+    }
+
+    // 暂停时保留已接收的数据以便续传，取消或失败时直接丢弃
+    const int control = data->control.load();
+    const bool pausedRelease = (res != CURLE_OK && control == ControlPause);
 
-        // 重新设置以获取文件内容
-        curl_easy_setopt(m_curl, CURLOPT_NOBODY, 0L);
+    // 等待写入线程把剩余数据写完
+    bool writeOk = false;
+    if (res == CURLE_OK || pausedRelease) {
+        writeOk = data->writer->finish();
+    } else {
+        data->writer->abort();
+    }
+    QString writeError = data->writer->errorString();
+    bool writeFailed = data->writer->hasError();
+
+    // 解包任务：确认压缩包完整
+    if (res == CURLE_OK && writeOk && data->extractor && !data->extractor->finish()) {
+        writeOk = false;
+        writeError = data->extractor->errorString();
+    }
+    const QString writeErrorPrefix = data->extractor ? "解包失败: " : "写入文件失败: ";
+
+    if (pausedRelease && data->file) {
+        // 以实际落盘的长度作为续传起点
+        data->file->flush();
+        data->downloadedSize = data->file->size();
+    }
+
+    // 关闭文件
+    if (data->file) {
+        data->file->close();
+    }
 
-        // 执行下载
-        res = curl_easy_perform(m_curl);
+    TaskState result = Failed;
 
-        // 关闭文件
-        downloadData->file->close();
+    if (control == ControlCancel) {
+        result = Canceled;
+    } else if (pausedRelease && writeOk) {
+        qCDebug(lcDownload) << "下载任务" << data->id << "暂停超时，已释放连接";
+        result = Paused;
+    } else if (pausedRelease) {
+        emit downloadError(writeErrorPrefix + writeError);
+    } else if (res == CURLE_OK && !writeOk) {
+        emit downloadError(writeErrorPrefix + writeError);
+    } else if (res == CURLE_OK) {
+        // 检查HTTP状态码
+        long http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
 
-        if (res == CURLE_OK) {
-            // 检查HTTP状态码
-            long http_code = 0;
-            curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &http_code);
+        if (http_code >= 200 && http_code < 300) {
+            // 校验值在写入过程中已算好，这里直接比对
+            data->hasher->finish();
+            QString actualHex = data->hasher->resultHex(checksumAlgorithm);
+            bool matched = expectedHex.isEmpty() || actualHex == expectedHex;
 
-            if (http_code >= 200 && http_code < 300) {
+            emit taskVerified(data->id, data->hasher->sha256Hex(), data->hasher->xxh64Hex(), matched);
+
+            if (matched) {
+                result = Finished;
+                // 加入缓存只是排队，可能需要的复制在缓存的后台线程中进行，任务不等待
+                if (!data->extractor && m_cache->isEnabled()) {
+                    m_cache->insert(url, etag, savePath, data->hasher->sha256Hex(), data->hasher->xxh64Hex());
+                }
+                if (data->extractor) {
+                    qCInfo(lcDownload) << "下载任务" << data->id << "已解包" << data->extractor->filesExtracted()
+                            << "个文件到" << savePath;
+                }
                 emit downloadFinished(savePath);
             } else {
-                emit downloadError(QString("HTTP错误: %1").arg(http_code));
+                qCWarning(lcDownload) << "文件校验失败:" << savePath << "期望:" << expectedHex << "实际:" << actualHex;
+                emit checksumMismatch(data->id, expectedHex, actualHex);
+                emit downloadError(QString("文件校验失败\n期望: %1\n实际: %2").arg(expectedHex, actualHex));
             }
         } else {
-            QString errorMsg = QString("下载失败: %1").arg(curl_easy_strerror(res));
+            emit downloadError(QString("HTTP错误: %1").arg(http_code));
+        }
+    } else {
+        QString errorMsg = QString("下载失败: %1").arg(curl_easy_strerror(res));
 
-            // 如果是SSL证书错误，提供更详细的提示
-            if (res == CURLE_SSL_CACERT || res == CURLE_SSL_CERTPROBLEM) {
-                errorMsg += "\n可能是SSL证书验证失败，尝试在设置中忽略SSL证书验证";
-            }
+        // 如果是SSL证书错误，提供更详细的提示
+        if (res == CURLE_SSL_CACERT || res == CURLE_SSL_CERTPROBLEM) {
+            errorMsg += "\n可能是SSL证书验证失败，尝试在设置中忽略SSL证书验证";
+        }
 
-            emit downloadError(errorMsg);
+        // 写入失败导致的中止，给出写入错误信息
+        if (res == CURLE_WRITE_ERROR && writeFailed) {
+            errorMsg = writeErrorPrefix + writeError;
         }
 
-        // 清理下载数据
-        delete downloadData->file;
-        delete downloadData;
-        m_currentDownloadData = nullptr;
-        m_isDownloading = false;
-    });
+        emit downloadError(errorMsg);
+    }
 
-    // 线程结束后自动清理
-    connect(downloadThread, &QThread::finished, downloadThread, &QThread::deleteLater);
-    downloadThread->start();
+    // 清理下载数据
+    releaseTaskResources(data);
+
+    return result;
 }
 
-void DownloadManager::cancelDownload()
+void DownloadManager::releaseTaskResources(DownloadData *data)
+{
+    // 先让读取方改为从文件读取，再停止写入线程，最后释放它使用的文件、校验器和解包器
+    if (data->stream) {
+        data->stream->detachWriter();
+    }
+    {
+        std::lock_guard<std::mutex> lock(data->writerMutex);
+        delete data->writer;
+        data->writer = nullptr;
+    }
+
+    if (data->file && data->file->isOpen()) {
+        data->file->close();
+    }
+    delete data->file;
+    delete data->hasher;
+    delete data->extractor;
+    data->file = nullptr;
+    data->hasher = nullptr;
+    data->extractor = nullptr;
+}
+
+bool DownloadManager::hashFilePrefix(DownloadData *data, qint64 length)
+{
+    QByteArray buffer(static_cast<qsizetype>(RESUME_HASH_CHUNK), Qt::Uninitialized);
+    data->file->seek(0);
+
+    qint64 remaining = length;
+    while (remaining > 0) {
+        if (data->control == ControlCancel) {
+            return false;
+        }
+
+        qint64 bytesRead = data->file->read(buffer.data(), qMin(remaining, RESUME_HASH_CHUNK));
+        if (bytesRead <= 0) {
+            return false;
+        }
+        data->hasher->addData(buffer.constData(), bytesRead);
+        remaining -= bytesRead;
+    }
+    return true;
+}
+
+void DownloadManager::applySslOptions(CURL *curl)
+{
+    if (m_ignoreSslErrors) {
+        // 忽略SSL证书验证
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        qCDebug(lcDownload) << "SSL证书验证已禁用";
+    } else {
+        // 启用SSL证书验证（默认）
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+    }
+}
+
+void DownloadManager::applyHttpVersion(CURL *curl, const QString &url)
+{
+    if (m_cleartextHttp2 && url.startsWith("http://", Qt::CaseInsensitive)) {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    }
+}
+
+bool DownloadManager::waitBeforeRetry(DownloadData *data, int attempt)
+{
+    // 分片休眠，等待期间可以暂停或取消
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 delay = RETRY_DELAY_STEP_MS * attempt;
+    while (timer.elapsed() < delay) {
+        if (data->control != ControlRun) {
+            return false;
+        }
+        QThread::msleep(static_cast<unsigned long>(qMin(delay - timer.elapsed() + 1, THROTTLE_SLICE_MS)));
+    }
+    return data->control == ControlRun;
+}
+
+bool DownloadManager::fetchSidecar(const QString &url, QByteArray *content, QString *errorMessage)
+{
+    // 旁路文件很小，使用独立的CURL句柄在当前线程中直接下载到内存
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        *errorMessage = "CURL初始化失败";
+        return false;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.toUtf8().constData());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, appendToByteArray);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, content);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "ZiyanOS-Downloader/1.0");
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 10L);
+    // 旁路文件是文本，一次读入内存，不校验也不续传，可以接受压缩传输并由CURL解码
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    applySslOptions(curl);
+
+    CURLcode res = curl_easy_perform(curl);
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_easy_cleanup(curl);
+
+    if (res != CURLE_OK) {
+        *errorMessage = curl_easy_strerror(res);
+        return false;
+    }
+    if (http_code < 200 || http_code >= 300) {
+        *errorMessage = QString("HTTP错误: %1").arg(http_code);
+        return false;
+    }
+    return true;
+}
+
+size_t DownloadManager::appendToByteArray(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    QByteArray *buffer = static_cast<QByteArray*>(userdata);
+    size_t total = size * nmemb;
+
+    // 超出上限时中止，防止把大文件误当作校验文件读入内存
+    if (buffer->size() + static_cast<qsizetype>(total) > SIDECAR_MAX_SIZE) {
+        return 0;
+    }
+
+    buffer->append(static_cast<const char*>(ptr), static_cast<qsizetype>(total));
+    return total;
+}
+
+size_t DownloadManager::captureETag(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+    const size_t total = size * nitems;
+    QByteArray *etag = static_cast<QByteArray*>(userdata);
+    const QByteArray line = QByteArray(buffer, static_cast<qsizetype>(total)).trimmed();
+
+    if (line.startsWith("HTTP/")) {
+        // 新的响应（重定向后），只保留最终响应的ETag
+        etag->clear();
+    } else if (line.size() > 5 && qstrnicmp(line.constData(), "etag:", 5) == 0) {
+        *etag = line.mid(5).trimmed();
+    }
+    return total;
+}
+
+bool DownloadManager::finishFromCache(DownloadData *data, const DownloadCache::Entry &entry)
 {
-    if (m_curl && m_isDownloading) {
-        // 设置超时以快速中断下载
-        curl_easy_setopt(m_curl, CURLOPT_TIMEOUT_MS, 1L);
+    if (!m_cache->materialize(entry, data->savePath)) {
+        return false;
+    }
+
+    data->totalSize = entry.size;
+    data->downloadedSize = entry.size;
+
+    emit downloadStarted(QFileInfo(data->savePath).fileName(), formatFileSize(entry.size));
+    emit downloadProgress(entry.size, entry.size);
+    emit taskProgress(data->id, entry.size, entry.size);
+    emit taskVerified(data->id, entry.sha256, entry.xxh64, true);
+    emit downloadFinished(data->savePath);
+    return true;
+}
+
+void DownloadManager::throttle(DownloadData *data, qint64 bytes)
+{
+    if (!data->limiter.isLimited() && !m_globalLimiter.isLimited()) {
+        return;
+    }
+
+    data->limiter.consume(bytes);
+    m_globalLimiter.consume(bytes);
+
+    // 休眠到令牌补足为止，分片休眠以便及时响应暂停、取消和速率修改
+    while (data->control == ControlRun) {
+        qint64 delay = qMax(data->limiter.pendingDelay(), m_globalLimiter.pendingDelay());
+        if (delay <= 0) {
+            break;
+        }
+        QThread::msleep(static_cast<unsigned long>(qMin(delay, THROTTLE_SLICE_MS)));
     }
 }
 
 size_t DownloadManager::writeData(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
     DownloadData *data = static_cast<DownloadData*>(userdata);
-    size_t written = 0;
+    size_t total = size * nmemb;
 
-    // 确保文件已打开
-    if (data->file && data->file->isOpen()) {
-        written = data->file->write(static_cast<char*>(ptr), size * nmemb);
-        if (written > 0) {
-            data->downloadedSize += written;
+    // 检查控制字：取消时中止传输，暂停时让CURL保留这块数据稍后重新交付
+    int control = data->control;
+    if (control == ControlCancel) {
+        return 0;
+    }
+    if (control == ControlPause) {
+        if (!data->transferPaused) {
+            data->transferPaused = true;
+            data->pauseTimer.start();
         }
+        return CURL_WRITEFUNC_PAUSE;
+    }
+
+    // 限速：在传输线程中等待，期间CURL不读取套接字
+    data->manager->throttle(data, static_cast<qint64>(total));
+
+    // 交给写入管线，缓冲区全满时这里会阻塞，从而暂停接收
+    if (!data->writer || !data->writer->append(static_cast<char*>(ptr), static_cast<qint64>(total))) {
+        return 0;   // 返回值与数据长度不一致时CURL会中止传输
     }
 
-    return written;
+    data->downloadedSize += total;
+    return total;
 }
 
 int DownloadManager::progressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
@@ -256,13 +1353,46 @@ int DownloadManager::progressCallback(void *clientp, curl_off_t dltotal, curl_of
 
     DownloadData *data = static_cast<DownloadData*>(clientp);
 
-    // 当有下载进度时，发送进度信号
+    // 控制字在每次回调中检查，取消无需等待超时
+    int control = data->control;
+    if (control == ControlCancel) {
+        return 1;
+    }
+
+    if (control == ControlPause) {
+        if (!data->transferPaused) {
+            // 暂停接收，连接保持打开
+            curl_easy_pause(data->curl, CURLPAUSE_RECV);
+            data->transferPaused = true;
+            data->pauseTimer.start();
+        } else if (data->pauseTimer.elapsed() > PAUSE_RELEASE_MS) {
+            // 暂停太久，中止传输释放连接，恢复时续传
+            return 1;
+        }
+        return 0;
+    }
+
+    if (data->transferPaused) {
+        // 已恢复：继续接收
+        data->transferPaused = false;
+        curl_easy_pause(data->curl, CURLPAUSE_CONT);
+    }
+
+    // 当有下载进度时，发送进度信号（续传时加上已下载的部分）
     if (dltotal > 0 && dlnow > 0) {
+        qint64 received = data->resumeOffset + static_cast<qint64>(dlnow);
+        qint64 total = data->resumeOffset + static_cast<qint64>(dltotal);
+
         // 使用Qt的元对象系统在主线程中调用信号
         QMetaObject::invokeMethod(data->manager, "downloadProgress",
                                   Qt::QueuedConnection,
-                                  Q_ARG(qint64, dlnow),
-                                  Q_ARG(qint64, dltotal));
+                                  Q_ARG(qint64, received),
+                                  Q_ARG(qint64, total));
+        QMetaObject::invokeMethod(data->manager, "taskProgress",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(int, data->id),
+                                  Q_ARG(qint64, received),
+                                  Q_ARG(qint64, total));
     }
 
     return 0; // 返回0继续下载，返回非0取消下载
@@ -5,9 +5,32 @@
 #include <QString>
 #include <QFile>
 #include <QThread>
+#include <QTimer>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QAbstractListModel>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <curl/curl.h>
 
+#include "BandwidthLimiter.h"
+#include "DownloadBatch.h"
+#include "DownloadCache.h"
+
+class DownloadWriter;
+class DownloadHasher;
+class DownloadExtractor;
+class DownloadStreamSource;
+class DownloadTaskStore;
+class DownloadTaskModel;
+struct DownloadTaskRecord;
+
+// 下载管理器：应用程序中只有一个实例（instance()），由main.cpp创建并注册为QML单例，
+// 关闭下载管理器窗口不影响正在进行的下载。性能测试程序直接构造独立的实例。
 class DownloadManager : public QObject
 {
     Q_OBJECT
@@ -15,18 +38,130 @@ class DownloadManager : public QObject
     // QML属性：是否忽略SSL证书验证
     Q_PROPERTY(bool ignoreSslErrors READ ignoreSslErrors WRITE setIgnoreSslErrors NOTIFY ignoreSslErrorsChanged)
 
+    // QML属性：全局限速（字节/秒，0表示不限速），下载过程中修改立即生效
+    Q_PROPERTY(qint64 globalRateLimit READ globalRateLimit WRITE setGlobalRateLimit NOTIFY globalRateLimitChanged)
+
+    // QML属性：同时进行的最大下载任务数
+    Q_PROPERTY(int maxConcurrentDownloads READ maxConcurrentDownloads WRITE setMaxConcurrentDownloads NOTIFY maxConcurrentDownloadsChanged)
+
+    // QML属性：下载记录列表模型（包括历史任务，按需分页加载）
+    Q_PROPERTY(QAbstractListModel* taskModel READ taskModel CONSTANT)
+
+    // QML属性：下载缓存上限（字节，0表示禁用），以及缓存占用和命中统计
+    Q_PROPERTY(qint64 cacheSizeLimit READ cacheSizeLimit WRITE setCacheSizeLimit NOTIFY cacheStatsChanged)
+    Q_PROPERTY(qint64 cacheSize READ cacheSize NOTIFY cacheStatsChanged)
+    Q_PROPERTY(qint64 cacheHits READ cacheHits NOTIFY cacheStatsChanged)
+    Q_PROPERTY(qint64 cacheMisses READ cacheMisses NOTIFY cacheStatsChanged)
+    Q_PROPERTY(qint64 cacheBytesSaved READ cacheBytesSaved NOTIFY cacheStatsChanged)
+
 public:
+    // 任务状态
+    enum TaskState {
+        Queued = 0,     // 排队等待
+        Running,        // 正在下载
+        Finished,       // 下载完成
+        Failed,         // 下载失败
+        Canceled,       // 已取消
+        Paused          // 已暂停
+    };
+    Q_ENUM(TaskState)
+
     explicit DownloadManager(QObject *parent = nullptr);
     ~DownloadManager();
 
+    // 单例模式访问（应用程序使用的实例）
+    static DownloadManager* instance();
+
+    // 恢复上次退出时未完成的任务（启动时调用一次）
+    void restoreTasks();
+
+    // 停止所有任务并把进度和状态写回存储（应用程序退出前调用），
+    // 正在下载的任务下次启动时续传，暂停的任务保持暂停
+    void shutdown();
+
     // QML可调用的方法
-    Q_INVOKABLE void startDownload(const QString &url, const QString &savePath);
+    Q_INVOKABLE int startDownload(const QString &url, const QString &savePath);
     Q_INVOKABLE void cancelDownload();
 
+    // 新增：按优先级加入下载队列（数值越大越优先），返回任务ID，失败返回-1
+    // expectedChecksum可以是"sha256:<hex>"、"xxh64:<hex>"、64位十六进制，或.sha256旁路文件的URL
+    Q_INVOKABLE int enqueueDownload(const QString &url, const QString &savePath, int priority = 0,
+                                    const QString &expectedChecksum = QString());
+
+    // 新增：带校验的下载，下载完成时立即报告校验结果
+    Q_INVOKABLE int startVerifiedDownload(const QString &url, const QString &savePath, const QString &expectedChecksum);
+
+    // 新增：下载tar.gz/tar.zst/tar/zip压缩包并在下载过程中直接解包到destinationDir，压缩包本身不保存
+    Q_INVOKABLE int startExtractDownload(const QString &url, const QString &destinationDir,
+                                         const QString &expectedChecksum = QString());
+
+    // 新增：取消指定任务
+    Q_INVOKABLE void cancelTask(int taskId);
+
+    // 新增：暂停指定任务，暂停超过一定时间后释放连接
+    Q_INVOKABLE void pauseTask(int taskId);
+
+    // 新增：恢复暂停的任务，连接已释放时使用Range请求续传
+    Q_INVOKABLE void resumeTask(int taskId);
+
+    // 新增：修改任务优先级（仅影响尚未开始的任务的调度顺序）
+    Q_INVOKABLE void setTaskPriority(int taskId, int priority);
+
+    // 新增：设置单个任务的限速（字节/秒，0表示不限速），下载过程中修改立即生效
+    Q_INVOKABLE void setTaskRateLimit(int taskId, qint64 bytesPerSecond);
+
+    // 新增：添加限速时间窗口，时间格式为"HH:mm"，例如夜间 "00:00" - "06:00" 不限速
+    Q_INVOKABLE bool addScheduleWindow(const QString &start, const QString &end, qint64 bytesPerSecond);
+
+    // 新增：清除所有限速时间窗口
+    Q_INVOKABLE void clearScheduleWindows();
+
+    // 新增：获取任务状态
+    Q_INVOKABLE int taskState(int taskId) const;
+
+    // 新增：删除一条下载记录（不影响已下载的文件，进行中的任务不能删除）
+    Q_INVOKABLE void removeTask(int taskId);
+
+    // 新增：清除所有已结束的下载记录
+    Q_INVOKABLE void clearHistory();
+
+    // 新增：批量下载URL列表到目标目录，同一主机的请求通过HTTP/2多路复用，返回批次ID，失败返回-1
+    Q_INVOKABLE int startBatchDownload(const QStringList &urls, const QString &targetDir);
+
+    // 新增：按清单文件批量下载（每行"<url>"或"<url> <相对路径>"，#开头为注释）
+    Q_INVOKABLE int startManifestDownload(const QString &manifestPath, const QString &targetDir);
+
+    // 新增：取消批量下载
+    Q_INVOKABLE void cancelBatch(int batchId);
+
+    // 新增：清空下载缓存（命中统计保留）
+    Q_INVOKABLE void clearCache();
+
     // SSL错误忽略属性访问器
     bool ignoreSslErrors() const;
     void setIgnoreSslErrors(bool ignore);
 
+    // 限速属性访问器
+    qint64 globalRateLimit() const;
+    void setGlobalRateLimit(qint64 bytesPerSecond);
+
+    int maxConcurrentDownloads() const;
+    void setMaxConcurrentDownloads(int count);
+
+    QAbstractListModel *taskModel() const;
+
+    // 下载缓存属性访问器
+    qint64 cacheSizeLimit() const;
+    void setCacheSizeLimit(qint64 bytes);
+    qint64 cacheSize() const;
+    qint64 cacheHits() const;
+    qint64 cacheMisses() const;
+    qint64 cacheBytesSaved() const;
+
+    // 明文HTTP地址直接使用HTTP/2（h2c，不经过Upgrade协商），只用于确认支持的服务器，例如本地性能测试服务器
+    bool cleartextHttp2() const { return m_cleartextHttp2; }
+    void setCleartextHttp2(bool enabled) { m_cleartextHttp2 = enabled; }
+
 signals:
     // 进度信号：bytesReceived已接收字节数，bytesTotal总字节数
     void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
@@ -43,7 +178,70 @@ signals:
     // SSL错误忽略属性改变信号
     void ignoreSslErrorsChanged(bool ignore);
 
+    // 新增：限速相关属性改变信号
+    void globalRateLimitChanged(qint64 bytesPerSecond);
+    void maxConcurrentDownloadsChanged(int count);
+
+    // 新增：任务状态改变信号
+    void taskStateChanged(int taskId, int state);
+
+    // 新增：任务进度信号
+    void taskProgress(int taskId, qint64 bytesReceived, qint64 bytesTotal);
+
+    // 新增：下载完成时的校验结果（未指定期望值时matched始终为true）
+    void taskVerified(int taskId, const QString &sha256, const QString &xxh64, bool matched);
+
+    // 新增：校验值不匹配
+    void checksumMismatch(int taskId, const QString &expected, const QString &actual);
+
+    // 新增：批量下载汇总进度（completedFiles包括失败的文件）
+    void batchProgress(int batchId, int completedFiles, int totalFiles, qint64 bytesReceived);
+
+    // 新增：批量下载中单个文件失败
+    void batchFileFailed(int batchId, const QString &url, const QString &errorMessage);
+
+    // 新增：批量下载结束
+    void batchFinished(int batchId, int succeeded, int failed, bool canceled);
+
+    // 新增：下载缓存占用或命中统计变化
+    void cacheStatsChanged();
+
 private:
+    // 任务控制字：由主线程写入，下载线程在每次CURL回调中检查
+    enum TaskControl {
+        ControlRun = 0,     // 正常传输
+        ControlPause,       // 暂停
+        ControlCancel       // 取消
+    };
+
+    // 下载数据结构
+    struct DownloadData {
+        int id;                         // 任务ID
+        QString url;                    // 下载地址
+        QString savePath;               // 保存路径（解包任务为目标目录）
+        int priority;                   // 调度优先级
+        TaskState state;                // 任务状态（仅在主线程修改）
+        QFile *file;                    // 要写入的文件对象
+        bool extract;                   // 是否边下载边解包
+        DownloadExtractor *extractor;   // 解包器（仅解包任务）
+        DownloadWriter *writer;         // 后台写入管线
+        std::mutex writerMutex;         // 保护writer的创建和销毁，供取消时唤醒写入管线
+        QString expectedChecksum;       // 期望的校验值或旁路文件URL
+        DownloadHasher *hasher;         // 流式校验器
+        std::shared_ptr<DownloadStreamSource> stream;   // 供查看器和播放器边下边读（解包任务没有）
+        CURL *curl;                     // 任务独立的CURL句柄
+        QThread *thread;                // 执行下载的线程
+        std::atomic<qint64> totalSize;         // 文件总大小（下载线程写入，主线程写入记录时读取）
+        std::atomic<qint64> downloadedSize;    // 已下载大小（同上）
+        std::atomic<int> control;       // 任务控制字（TaskControl）
+        bool resumable;                 // 是否可以从已下载的部分续传
+        qint64 resumeOffset;            // 本次传输的续传起点
+        bool transferPaused;            // CURL传输是否处于暂停状态（仅下载线程访问）
+        QElapsedTimer pauseTimer;       // 暂停计时（仅下载线程访问）
+        BandwidthLimiter limiter;       // 任务级限速
+        DownloadManager *manager;       // 指向DownloadManager的指针
+    };
+
     // 静态回调函数，供CURL库调用
     static size_t writeData(void *ptr, size_t size, size_t nmemb, void *userdata);
     static int progressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
@@ -52,20 +250,89 @@ private:
     // 文件大小格式化辅助函数
     QString formatFileSize(qint64 bytes) const;
 
-    // 下载数据结构
-    struct DownloadData {
-        QFile *file;                    // 要写入的文件对象
-        qint64 totalSize;               // 文件总大小
-        qint64 downloadedSize;          // 已下载大小
-        DownloadManager *manager;       // 指向DownloadManager的指针
-    };
+    // 检查参数、写入持久化记录并加入队列
+    int enqueueTask(const QString &url, const QString &savePath, int priority,
+                    const QString &expectedChecksum, int flags);
+
+    // 根据持久化记录创建任务数据
+    DownloadData *createTaskData(const DownloadTaskRecord &record);
+
+    // 关闭文件并释放写入管线、校验器和解包器（在下载线程中调用）
+    void releaseTaskResources(DownloadData *data);
+
+    // 调度：在有空闲槽位时按优先级启动排队任务
+    void scheduleNext();
+
+    // 启动任务线程
+    void launchTask(DownloadData *data);
+
+    // 在下载线程中执行的任务主体，返回最终状态
+    TaskState runTask(DownloadData *data);
 
-    CURL *m_curl;                       // CURL句柄
-    bool m_isDownloading;               // 下载状态标志
+    // 任务线程结束后在主线程中回收
+    void onTaskThreadFinished(int taskId, int state);
+
+    // 修改任务状态并发出信号（主线程）
+    void setTaskState(DownloadData *data, TaskState state);
+
+    // 根据当前时间应用限速时间窗口
+    void applyScheduleWindows();
+
+    // 按全局和任务限速等待（在下载线程中调用）
+    void throttle(DownloadData *data, qint64 bytes);
+
+    // 续传时把已下载部分交给校验器（在下载线程中调用）
+    bool hashFilePrefix(DownloadData *data, qint64 length);
+
+    // 传输中断后等待一段时间再续传，期间暂停或取消时返回false（在下载线程中调用）
+    bool waitBeforeRetry(DownloadData *data, int attempt);
+
+    // 请求取消任务并唤醒可能阻塞的写入管线
+    void requestCancel(DownloadData *data);
+
+    // 下载.sha256旁路文件内容（在下载线程中调用）
+    bool fetchSidecar(const QString &url, QByteArray *content, QString *errorMessage);
+
+    // 将CURL数据追加到QByteArray的回调
+    static size_t appendToByteArray(void *ptr, size_t size, size_t nmemb, void *userdata);
+
+    // 从响应头中提取ETag的回调
+    static size_t captureETag(char *buffer, size_t size, size_t nitems, void *userdata);
+
+    // 从下载缓存中完成任务（在下载线程中调用）
+    bool finishFromCache(DownloadData *data, const DownloadCache::Entry &entry);
+
+    // 为CURL句柄设置SSL选项
+    void applySslOptions(CURL *curl);
+
+    // 为CURL句柄设置HTTP协议版本
+    void applyHttpVersion(CURL *curl, const QString &url);
+
+    // 启动批量下载
+    int launchBatch(const QList<DownloadBatch::Entry> &entries);
+
+    bool m_curlInitialized;             // CURL全局库是否初始化成功
     bool m_ignoreSslErrors;             // 是否忽略SSL证书验证
-    QString m_currentUrl;               // 当前下载的URL
-    QString m_currentSavePath;          // 当前保存路径
-    DownloadData *m_currentDownloadData; // 当前下载数据
+    bool m_cleartextHttp2;              // 明文HTTP是否直接使用HTTP/2
+    int m_maxConcurrentDownloads;       // 最大并发任务数
+
+    DownloadTaskStore *m_store;         // 任务持久化存储（进程内共享）
+    DownloadTaskModel *m_taskModel;     // 下载记录列表模型
+    DownloadCache *m_cache;             // 内容寻址下载缓存（进程内共享）
+
+    QHash<int, DownloadData*> m_tasks;  // 所有未回收的任务
+    QList<int> m_queue;                 // 排队中的任务ID（按加入顺序）
+    int m_runningCount;                 // 正在运行的任务数
+
+    BandwidthLimiter m_globalLimiter;   // 全局限速
+    qint64 m_globalRateLimit;           // 用户设置的全局速率（时间窗口之外使用）
+    QList<BandwidthScheduleWindow> m_scheduleWindows;
+    QTimer m_scheduleTimer;             // 定期检查时间窗口
+
+    QHash<int, DownloadBatch*> m_batches;   // 进行中的批量下载
+    int m_nextBatchId;
+
+    static DownloadManager *m_instance;
 };
 
 #endif // DOWNLOADMANAGER_H
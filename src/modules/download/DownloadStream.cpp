@@ -0,0 +1,159 @@
+#include "DownloadStream.h"
+#include "LogCategories.h"
+#include "DownloadStreamDevice.h"
+#include <QDebug>
+#include <QImageReader>
+#include <QMediaPlayer>
+#include <QUrl>
+
+// 下载中图片的解码线程数
+static const int IMAGE_DECODE_THREADS = 2;
+
+// 路径编码为图片提供器的id（base64url，避免路径中的冒号、斜杠和非ASCII字符被URL处理改写）
+static QString encodeImageId(const QString &filePath)
+{
+    return QString::fromLatin1(filePath.toUtf8().toBase64(QByteArray::Base64UrlEncoding
+                                                          | QByteArray::OmitTrailingEquals));
+}
+
+static QString decodeImageId(const QString &id)
+{
+    return QString::fromUtf8(QByteArray::fromBase64(id.toLatin1(), QByteArray::Base64UrlEncoding
+                                                                    | QByteArray::OmitTrailingEquals));
+}
+
+DownloadStream::DownloadStream(QObject *parent)
+    : QObject(parent)
+{
+}
+
+bool DownloadStream::isDownloading(const QString &filePath) const
+{
+    std::shared_ptr<DownloadStreamSource> source = DownloadStreamSource::find(filePath);
+    return source && !source->isFinished() && !source->isFailed();
+}
+
+QString DownloadStream::imageSource(const QString &filePath) const
+{
+    return "image://download/" + encodeImageId(filePath);
+}
+
+bool DownloadStream::attachPlayer(QObject *player, const QString &filePath)
+{
+    QMediaPlayer *mediaPlayer = qobject_cast<QMediaPlayer*>(player);
+    std::shared_ptr<DownloadStreamSource> source = DownloadStreamSource::find(filePath);
+    if (!mediaPlayer || !source || source->isFailed()) {
+        return false;
+    }
+
+    detachPlayer(player);
+
+    // 数据流随播放器销毁，播放器换源后释放
+    DownloadStreamDevice *device = new DownloadStreamDevice(source, mediaPlayer);
+    if (!device->open(QIODevice::ReadOnly)) {
+        delete device;
+        return false;
+    }
+    mediaPlayer->setSourceDevice(device, QUrl::fromLocalFile(filePath));
+    connect(mediaPlayer, &QMediaPlayer::sourceChanged, device, [mediaPlayer, device]() {
+        if (mediaPlayer->sourceDevice() != device) {
+            device->abort();
+            device->deleteLater();
+        }
+    });
+
+    qCDebug(lcDownload) << "边下边播:" << filePath << "已到达" << source->availableSize() << "字节";
+    return true;
+}
+
+void DownloadStream::detachPlayer(QObject *player)
+{
+    QMediaPlayer *mediaPlayer = qobject_cast<QMediaPlayer*>(player);
+    if (!mediaPlayer) {
+        return;
+    }
+    DownloadStreamDevice *device = qobject_cast<DownloadStreamDevice*>(mediaPlayer->sourceDevice());
+    if (device) {
+        device->abort();
+    }
+}
+
+// 单张图片的解码任务
+class DownloadImageResponse : public QQuickImageResponse
+{
+public:
+    DownloadImageResponse(std::shared_ptr<DownloadStreamSource> source, const QSize &requestedSize)
+        : m_device(std::move(source))
+        , m_requestedSize(requestedSize)
+    {
+    }
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    QString errorString() const override { return m_errorString; }
+
+    void cancel() override
+    {
+        // 唤醒阻塞在读取中的解码线程，解码失败后照常发出finished
+        m_device.abort();
+    }
+
+    // 在线程池中执行，结束时发出finished（之后引擎会删除本对象）
+    void run()
+    {
+        if (!m_device.open(QIODevice::ReadOnly)) {
+            m_errorString = "无法打开下载中的文件";
+        } else {
+            QImageReader reader(&m_device);
+            if (m_requestedSize.isValid()) {
+                QSize size = reader.size();
+                if (size.isValid()) {
+                    size.scale(m_requestedSize, Qt::KeepAspectRatio);
+                    reader.setScaledSize(size);
+                }
+            }
+            // 阻塞到整张图片的数据到达（或下载结束），一次解码出完整的图片
+            m_image = reader.read();
+            if (m_image.isNull()) {
+                m_errorString = reader.errorString();
+                qCWarning(lcDownload) << "下载中的图片解码失败:" << m_device.filePath() << m_errorString;
+            }
+            m_device.close();
+        }
+        emit finished();
+    }
+
+private:
+    DownloadStreamDevice m_device;
+    QSize m_requestedSize;
+    QImage m_image;
+    QString m_errorString;
+};
+
+DownloadImageProvider::DownloadImageProvider()
+{
+    m_pool.setMaxThreadCount(IMAGE_DECODE_THREADS);
+}
+
+DownloadImageProvider::~DownloadImageProvider()
+{
+    m_pool.waitForDone();
+}
+
+QQuickImageResponse *DownloadImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    const QString filePath = decodeImageId(id);
+
+    // 已经不在下载中的文件（例如刚好下载完成）按普通文件读取
+    std::shared_ptr<DownloadStreamSource> source = DownloadStreamSource::find(filePath);
+    if (!source) {
+        source = DownloadStreamSource::createFinished(filePath);
+    }
+
+    DownloadImageResponse *response = new DownloadImageResponse(source, requestedSize);
+    m_pool.start([response]() { response->run(); });
+    return response;
+}
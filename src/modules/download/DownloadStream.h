@@ -0,0 +1,49 @@
+#ifndef DOWNLOADSTREAM_H
+#define DOWNLOADSTREAM_H
+
+#include <QObject>
+#include <QString>
+#include <QQuickImageProvider>
+#include <QThreadPool>
+
+// 边下边看：
+// 查看器和播放器打开的文件还在下载时，不必等下载完成，直接读取已经到达的数据。
+// 图片通过"image://download/<路径>"交给异步图片提供器，下载过程中就开始读取，数据到齐后显示，
+// 音视频把DownloadStreamDevice设置为MediaPlayer的数据源。
+class DownloadStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DownloadStream(QObject *parent = nullptr);
+
+    // 文件是否正在下载（下载完成、失败或不是下载任务时返回false）
+    Q_INVOKABLE bool isDownloading(const QString &filePath) const;
+
+    // 下载中图片的Image.source
+    Q_INVOKABLE QString imageSource(const QString &filePath) const;
+
+    // 把下载中的文件设置为MediaPlayer的数据源，返回false时应改用文件路径播放
+    Q_INVOKABLE bool attachPlayer(QObject *player, const QString &filePath);
+
+    // 换源或关闭播放器之前调用：中止阻塞在读取中的播放线程
+    Q_INVOKABLE void detachPlayer(QObject *player);
+};
+
+// 下载中图片的异步提供器（注册为"download"）：
+// 解码在独立的线程池中进行，解码器读取到尚未到达的数据时阻塞。
+// QImageReader::read()一次解码出整张图片，不显示只解码了一部分的图片：
+// 好处是不必等下载完成再打开文件，图片的最后一部分数据到达后立即显示
+class DownloadImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    DownloadImageProvider();
+    ~DownloadImageProvider();
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+private:
+    QThreadPool m_pool;
+};
+
+#endif // DOWNLOADSTREAM_H
@@ -0,0 +1,309 @@
+#include "DownloadStreamDevice.h"
+#include "LogCategories.h"
+#include "DownloadWriter.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <chrono>
+
+// 等待数据时单次等待的最长时间，保证中止能及时生效
+static const int STREAM_WAIT_SLICE_MS = 100;
+
+// 进程内的数据源登记表（保存路径 -> 数据源）
+static std::mutex s_registryMutex;
+static QHash<QString, std::weak_ptr<DownloadStreamSource>> s_registry;
+
+DownloadStreamSource::DownloadStreamSource(const QString &filePath, qint64 existingSize)
+    : m_filePath(filePath)
+    , m_waitingReaders(0)
+    , m_writer(nullptr)
+    , m_fileSize(existingSize)
+    , m_totalSize(-1)
+    , m_finished(false)
+    , m_failed(false)
+{
+}
+
+DownloadStreamSource::~DownloadStreamSource()
+{
+    // 只移除已失效的登记，同一路径可能已被新的数据源替换
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    const QString key = registryKey(m_filePath);
+    auto it = s_registry.find(key);
+    if (it != s_registry.end() && it->expired()) {
+        s_registry.erase(it);
+    }
+}
+
+std::shared_ptr<DownloadStreamSource> DownloadStreamSource::create(const QString &filePath, qint64 existingSize)
+{
+    std::shared_ptr<DownloadStreamSource> source(new DownloadStreamSource(filePath, existingSize));
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    s_registry.insert(registryKey(filePath), source);
+    return source;
+}
+
+std::shared_ptr<DownloadStreamSource> DownloadStreamSource::createFinished(const QString &filePath)
+{
+    const qint64 size = QFileInfo(filePath).size();
+    std::shared_ptr<DownloadStreamSource> source(new DownloadStreamSource(filePath, size));
+    source->setFinished(size);
+    return source;
+}
+
+std::shared_ptr<DownloadStreamSource> DownloadStreamSource::find(const QString &filePath)
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    return s_registry.value(registryKey(filePath)).lock();
+}
+
+QString DownloadStreamSource::registryKey(const QString &filePath)
+{
+    QString key = QDir::cleanPath(QFileInfo(filePath).absoluteFilePath());
+#ifdef Q_OS_WIN
+    key = key.toLower();
+#endif
+    return key;
+}
+
+void DownloadStreamSource::attachWriter(DownloadWriter *writer)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_writer = writer;
+    }
+    m_dataCondition.notify_all();
+}
+
+void DownloadStreamSource::detachWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_writer) {
+            return;
+        }
+        // 写入管线结束后缓冲区中的数据不再可读，只保留已经写盘的部分
+        m_fileSize = m_writer->flushedEnd();
+        m_writer = nullptr;
+    }
+    m_dataCondition.notify_all();
+}
+
+qint64 DownloadStreamSource::availableSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_writer ? m_writer->appendedEnd() : m_fileSize;
+}
+
+void DownloadStreamSource::setFinished(qint64 fileSize)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fileSize = fileSize;
+        m_finished = true;
+    }
+    m_totalSize = fileSize;
+    m_dataCondition.notify_all();
+}
+
+void DownloadStreamSource::setFailed()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_finished) {
+            return;
+        }
+        m_failed = true;
+    }
+    m_dataCondition.notify_all();
+}
+
+bool DownloadStreamSource::isFinished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finished;
+}
+
+bool DownloadStreamSource::isFailed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failed;
+}
+
+void DownloadStreamSource::notifyDataAvailable()
+{
+    // 没有读取方时不加锁，不拖慢传输线程
+    if (m_waitingReaders.load() == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_dataCondition.notify_all();
+}
+
+void DownloadStreamSource::wakeReaders()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_dataCondition.notify_all();
+}
+
+qint64 DownloadStreamSource::read(QFile *file, qint64 position, char *data, qint64 maxSize,
+                                  const std::atomic<bool> &aborted)
+{
+    if (maxSize <= 0) {
+        return 0;
+    }
+
+    // 先登记再检查数据，保证写入方追加数据后一定能看到等待者
+    m_waitingReaders++;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    qint64 result = -1;
+    while (true) {
+        if (aborted.load() || m_failed) {
+            break;
+        }
+
+        const qint64 available = m_writer ? m_writer->appendedEnd() : m_fileSize;
+        if (position < available) {
+            // 还在缓冲区里没有写盘的数据直接从缓冲区拷贝
+            const qint64 flushed = m_writer ? m_writer->flushedEnd() : m_fileSize;
+            if (m_writer && position >= flushed) {
+                qint64 copied = m_writer->readBuffered(position, data, maxSize);
+                if (copied > 0) {
+                    result = copied;
+                    break;
+                }
+            }
+
+            // 已写盘的部分从文件读取，读取时不持有锁
+            const qint64 fileEnd = m_writer ? m_writer->flushedEnd() : m_fileSize;
+            if (position < fileEnd) {
+                const qint64 chunk = qMin(maxSize, fileEnd - position);
+                lock.unlock();
+                result = readFile(file, position, data, chunk);
+                lock.lock();
+                break;
+            }
+        } else if (m_finished) {
+            result = 0;
+            break;
+        }
+
+        // 数据还没有到达，等待写入管线通知
+        m_dataCondition.wait_for(lock, std::chrono::milliseconds(STREAM_WAIT_SLICE_MS));
+    }
+
+    lock.unlock();
+    m_waitingReaders--;
+    return result;
+}
+
+qint64 DownloadStreamSource::readFile(QFile *file, qint64 position, char *data, qint64 maxSize)
+{
+    if (!file->isOpen() && !file->open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        qCWarning(lcDownload) << "无法读取下载中的文件:" << file->fileName() << file->errorString();
+        return -1;
+    }
+    if (!file->seek(position)) {
+        return -1;
+    }
+    return file->read(data, maxSize);
+}
+
+DownloadStreamDevice::DownloadStreamDevice(std::shared_ptr<DownloadStreamSource> source, QObject *parent)
+    : QIODevice(parent)
+    , m_source(std::move(source))
+    , m_file(m_source->filePath())
+    , m_position(0)
+    , m_aborted(false)
+{
+}
+
+DownloadStreamDevice::~DownloadStreamDevice()
+{
+    close();
+}
+
+bool DownloadStreamDevice::open(OpenMode mode)
+{
+    if ((mode & QIODevice::WriteOnly) || !(mode & QIODevice::ReadOnly)) {
+        qCWarning(lcDownload) << "下载中的文件只能以只读方式打开:" << m_source->filePath();
+        return false;
+    }
+
+    // 自身不做缓冲，数据直接从写入管线的缓冲区或页缓存拷贝到读取方
+    m_position = 0;
+    m_aborted = false;
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void DownloadStreamDevice::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+    QIODevice::close();
+    m_file.close();
+    m_position = 0;
+}
+
+bool DownloadStreamDevice::seek(qint64 pos)
+{
+    if (pos < 0 || !QIODevice::seek(pos)) {
+        return false;
+    }
+    m_position = pos;
+    return true;
+}
+
+qint64 DownloadStreamDevice::size() const
+{
+    // 总大小未知时返回当前已到达的长度
+    qint64 total = m_source->totalSize();
+    return total >= 0 ? total : m_source->availableSize();
+}
+
+qint64 DownloadStreamDevice::bytesAvailable() const
+{
+    return qMax<qint64>(0, m_source->availableSize() - m_position) + QIODevice::bytesAvailable();
+}
+
+bool DownloadStreamDevice::atEnd() const
+{
+    if (!isOpen()) {
+        return true;
+    }
+    if (m_source->isFailed() || m_aborted.load()) {
+        return true;
+    }
+    return m_source->isFinished() && m_position >= m_source->availableSize();
+}
+
+void DownloadStreamDevice::abort()
+{
+    m_aborted = true;
+    m_source->wakeReaders();
+}
+
+qint64 DownloadStreamDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 read = m_source->read(&m_file, m_position, data, maxSize, m_aborted);
+    if (read > 0) {
+        m_position += read;
+    } else if (read < 0) {
+        setErrorString(m_aborted.load() ? "读取已中止" : "下载失败或已取消");
+    }
+    return read;
+}
+
+qint64 DownloadStreamDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
@@ -0,0 +1,121 @@
+#ifndef DOWNLOADSTREAMDEVICE_H
+#define DOWNLOADSTREAMDEVICE_H
+
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+class DownloadWriter;
+
+// 下载中文件的共享数据源：
+// 由下载任务持有，同时被所有正在读取该文件的数据流共享。
+// 还在写入管线缓冲区里的数据直接从缓冲区读取，已写盘的数据从文件读取（此时在系统页缓存中），
+// 读取方只会为还没有到达的字节阻塞。
+// 数据源按保存路径登记在进程内，查看器和播放器通过路径找到正在下载的文件。
+class DownloadStreamSource
+{
+public:
+    ~DownloadStreamSource();
+
+    // 创建并登记数据源（同一路径的旧数据源会被替换），existingSize为续传前文件中已有的字节数
+    static std::shared_ptr<DownloadStreamSource> create(const QString &filePath, qint64 existingSize = 0);
+
+    // 已经下载完成的普通文件（不登记）
+    static std::shared_ptr<DownloadStreamSource> createFinished(const QString &filePath);
+
+    // 按保存路径查找数据源，没有正在下载或仍被读取的文件时返回空
+    static std::shared_ptr<DownloadStreamSource> find(const QString &filePath);
+
+    QString filePath() const { return m_filePath; }
+
+    // 下载线程调用：挂接/摘除写入管线（摘除须在销毁写入管线之前）
+    void attachWriter(DownloadWriter *writer);
+    void detachWriter();
+
+    // 文件总大小（未知时为-1）
+    void setTotalSize(qint64 size) { m_totalSize = size; }
+    qint64 totalSize() const { return m_totalSize.load(); }
+
+    // 当前可读的字节数
+    qint64 availableSize() const;
+
+    // 下载结束：成功时文件完整可读，失败或取消时读取方收到错误
+    void setFinished(qint64 fileSize);
+    void setFailed();
+    bool isFinished() const;
+    bool isFailed() const;
+
+    // 写入管线追加数据后调用，唤醒等待数据的读取方
+    void notifyDataAvailable();
+
+    // 唤醒所有等待中的读取方（读取方中止时调用）
+    void wakeReaders();
+
+    // 从position处读取最多maxSize字节，数据未到达时阻塞
+    // 返回读到的字节数，0表示已到文件末尾，-1表示下载失败或读取被中止
+    qint64 read(QFile *file, qint64 position, char *data, qint64 maxSize,
+                const std::atomic<bool> &aborted);
+
+private:
+    DownloadStreamSource(const QString &filePath, qint64 existingSize);
+
+    // 路径规范化，作为登记表的键
+    static QString registryKey(const QString &filePath);
+
+    // 从文件读取（不持有锁）
+    static qint64 readFile(QFile *file, qint64 position, char *data, qint64 maxSize);
+
+    QString m_filePath;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_dataCondition;    // 有新数据或状态变化
+    std::atomic<int> m_waitingReaders;          // 正在读取的数量，没有读取方时不做唤醒
+
+    DownloadWriter *m_writer;                   // 当前的写入管线（没有传输时为空）
+    qint64 m_fileSize;                          // 没有写入管线时文件中已有的字节数
+    std::atomic<qint64> m_totalSize;
+    bool m_finished;
+    bool m_failed;
+};
+
+// 读取下载中文件的设备：
+// 可随机访问，读取已到达的数据立即返回，读取尚未到达的数据时阻塞到数据写入为止。
+// 读取会阻塞调用线程，应在解码线程或播放器的读取线程中使用。
+class DownloadStreamDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit DownloadStreamDevice(std::shared_ptr<DownloadStreamSource> source, QObject *parent = nullptr);
+    ~DownloadStreamDevice();
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return false; }
+    bool seek(qint64 pos) override;
+    qint64 pos() const override { return m_position; }
+    qint64 size() const override;
+    qint64 bytesAvailable() const override;
+    bool atEnd() const override;
+
+    // 中止读取：唤醒阻塞中的读取并让之后的读取返回错误（可在任意线程调用）
+    void abort();
+
+    QString filePath() const { return m_source->filePath(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    std::shared_ptr<DownloadStreamSource> m_source;
+    QFile m_file;
+    qint64 m_position;
+    std::atomic<bool> m_aborted;
+};
+
+#endif // DOWNLOADSTREAMDEVICE_H
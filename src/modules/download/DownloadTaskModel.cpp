@@ -0,0 +1,169 @@
+#include "DownloadTaskModel.h"
+#include "DownloadTaskStore.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <algorithm>
+#include <functional>
+
+// 每页加载的行数
+static const int FETCH_PAGE_SIZE = 100;
+
+DownloadTaskModel::DownloadTaskModel(DownloadTaskStore *store, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_store(store)
+    , m_loadedCount(0)
+{
+    m_taskIds = m_store->taskIds();
+    std::reverse(m_taskIds.begin(), m_taskIds.end());
+
+    connect(m_store, &DownloadTaskStore::taskAdded, this, &DownloadTaskModel::onTaskAdded);
+    connect(m_store, &DownloadTaskStore::taskChanged, this, &DownloadTaskModel::onTaskChanged);
+    connect(m_store, &DownloadTaskStore::taskRemoved, this, &DownloadTaskModel::onTaskRemoved);
+}
+
+int DownloadTaskModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_loadedCount;
+}
+
+QVariant DownloadTaskModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_loadedCount) {
+        return QVariant();
+    }
+
+    int taskId = m_taskIds.at(index.row());
+    const DownloadTaskRecord record = m_store->task(taskId);
+
+    switch (role) {
+    case TaskIdRole:
+        return record.id;
+    case UrlRole:
+        return record.url;
+    case SavePathRole:
+        return record.savePath;
+    case FileNameRole:
+    case Qt::DisplayRole:
+        return QFileInfo(record.savePath).fileName();
+    case StateRole:
+        return record.state;
+    case TotalSizeRole:
+        return m_progress.contains(taskId) ? m_progress.value(taskId).second : record.totalSize;
+    case DownloadedSizeRole:
+        return m_progress.contains(taskId) ? m_progress.value(taskId).first : record.downloadedSize;
+    case CreatedAtRole:
+        return QDateTime::fromMSecsSinceEpoch(record.createdAt);
+    case FinishedAtRole:
+        return record.finishedAt > 0 ? QDateTime::fromMSecsSinceEpoch(record.finishedAt) : QVariant();
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> DownloadTaskModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[TaskIdRole] = "taskId";
+    roles[UrlRole] = "url";
+    roles[SavePathRole] = "savePath";
+    roles[FileNameRole] = "fileName";
+    roles[StateRole] = "state";
+    roles[TotalSizeRole] = "totalSize";
+    roles[DownloadedSizeRole] = "downloadedSize";
+    roles[CreatedAtRole] = "createdAt";
+    roles[FinishedAtRole] = "finishedAt";
+    return roles;
+}
+
+bool DownloadTaskModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return false;
+    }
+    return m_loadedCount < m_taskIds.size();
+}
+
+void DownloadTaskModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    int remaining = m_taskIds.size() - m_loadedCount;
+    int count = qMin(FETCH_PAGE_SIZE, remaining);
+    if (count <= 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_loadedCount, m_loadedCount + count - 1);
+    m_loadedCount += count;
+    endInsertRows();
+}
+
+void DownloadTaskModel::setProgress(int taskId, qint64 bytesReceived, qint64 bytesTotal)
+{
+    m_progress[taskId] = qMakePair(bytesReceived, bytesTotal);
+
+    int row = rowForTask(taskId);
+    if (row >= 0) {
+        QModelIndex changed = index(row);
+        emit dataChanged(changed, changed, {TotalSizeRole, DownloadedSizeRole});
+    }
+}
+
+void DownloadTaskModel::onTaskAdded(int taskId)
+{
+    // 新任务ID总是最大的，插入到最前面
+    beginInsertRows(QModelIndex(), 0, 0);
+    m_taskIds.prepend(taskId);
+    m_loadedCount++;
+    endInsertRows();
+    emit totalCountChanged();
+}
+
+void DownloadTaskModel::onTaskChanged(int taskId)
+{
+    // 状态变化后以存储中的进度为准
+    m_progress.remove(taskId);
+
+    int row = rowForTask(taskId);
+    if (row >= 0) {
+        QModelIndex changed = index(row);
+        emit dataChanged(changed, changed);
+    }
+}
+
+void DownloadTaskModel::onTaskRemoved(int taskId)
+{
+    m_progress.remove(taskId);
+
+    int position = m_taskIds.indexOf(taskId);
+    if (position < 0) {
+        return;
+    }
+
+    if (position < m_loadedCount) {
+        beginRemoveRows(QModelIndex(), position, position);
+        m_taskIds.removeAt(position);
+        m_loadedCount--;
+        endRemoveRows();
+    } else {
+        m_taskIds.removeAt(position);
+    }
+    emit totalCountChanged();
+}
+
+int DownloadTaskModel::rowForTask(int taskId) const
+{
+    // 列表按ID倒序排列，二分查找
+    auto it = std::lower_bound(m_taskIds.cbegin(), m_taskIds.cend(), taskId, std::greater<int>());
+    if (it == m_taskIds.cend() || *it != taskId) {
+        return -1;
+    }
+
+    int row = static_cast<int>(it - m_taskIds.cbegin());
+    return row < m_loadedCount ? row : -1;
+}
@@ -0,0 +1,66 @@
+#ifndef DOWNLOADTASKMODEL_H
+#define DOWNLOADTASKMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include <QPair>
+
+class DownloadTaskStore;
+
+// 下载记录列表模型：
+// 按任务ID倒序（最新的在前）展示DownloadTaskStore中的任务，
+// 每次只向视图提供一页数据，滚动到底部时再加载下一页。
+class DownloadTaskModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int totalCount READ totalCount NOTIFY totalCountChanged)
+
+public:
+    enum Roles {
+        TaskIdRole = Qt::UserRole + 1,
+        UrlRole,
+        SavePathRole,
+        FileNameRole,
+        StateRole,
+        TotalSizeRole,
+        DownloadedSizeRole,
+        CreatedAtRole,
+        FinishedAtRole
+    };
+
+    explicit DownloadTaskModel(DownloadTaskStore *store, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // 分页加载
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    // 存储中的任务总数
+    int totalCount() const { return m_taskIds.size(); }
+
+    // 更新运行中任务的实时进度（不写入存储）
+    void setProgress(int taskId, qint64 bytesReceived, qint64 bytesTotal);
+
+signals:
+    void totalCountChanged();
+
+private slots:
+    void onTaskAdded(int taskId);
+    void onTaskChanged(int taskId);
+    void onTaskRemoved(int taskId);
+
+private:
+    // 任务ID在列表中的行号（未加载或不存在返回-1）
+    int rowForTask(int taskId) const;
+
+    DownloadTaskStore *m_store;
+    QList<int> m_taskIds;                           // 倒序排列的全部任务ID
+    int m_loadedCount;                              // 已提供给视图的行数
+    QHash<int, QPair<qint64, qint64>> m_progress;   // 运行中任务的实时进度
+};
+
+#endif // DOWNLOADTASKMODEL_H
@@ -0,0 +1,376 @@
+#include "DownloadTaskStore.h"
+#include "LogCategories.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <algorithm>
+#include <mutex>
+
+// 记录文件头：魔数 + 版本
+static const quint32 STORE_MAGIC = 0x5354445A;     // "ZDTS"
+static const quint32 STORE_VERSION = 1;
+static const int STORE_HEADER_SIZE = 8;
+
+// 无效记录超过该数量时在加载阶段压缩
+static const int COMPACT_MIN_GARBAGE = 256;
+
+DownloadTaskStore* DownloadTaskStore::m_instance = nullptr;
+
+DownloadTaskStore::DownloadTaskStore(QObject *parent)
+    : QObject(parent)
+    , m_loaded(false)
+    , m_restoredTaken(false)
+    , m_nextTaskId(1)
+    , m_recordCount(0)
+{
+}
+
+DownloadTaskStore::~DownloadTaskStore()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+DownloadTaskStore* DownloadTaskStore::instance()
+{
+    static std::mutex instanceMutex;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+
+    if (!m_instance) {
+        m_instance = new DownloadTaskStore();
+    }
+    return m_instance;
+}
+
+QString DownloadTaskStore::storeFilePath() const
+{
+    // 测试模式（性能测试程序）下写入Qt的测试目录，不影响用户的下载记录
+    const QStandardPaths::StandardLocation location = QStandardPaths::isTestModeEnabled()
+        ? QStandardPaths::AppLocalDataLocation : QStandardPaths::DocumentsLocation;
+    return QStandardPaths::writableLocation(location) + "/ZiyanOS/download_tasks.dat";
+}
+
+bool DownloadTaskStore::load()
+{
+    if (m_loaded) {
+        return true;
+    }
+    m_loaded = true;
+
+    QString path = storeFilePath();
+    QDir dir = QFileInfo(path).absoluteDir();
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    // 一次性读入并顺序扫描所有记录
+    qint64 validEnd = 0;
+    bool headerValid = false;
+    QFile input(path);
+    if (input.open(QIODevice::ReadOnly)) {
+        QByteArray content = input.readAll();
+        input.close();
+
+        const uchar *base = reinterpret_cast<const uchar*>(content.constData());
+        if (content.size() >= STORE_HEADER_SIZE
+            && qFromLittleEndian<quint32>(base) == STORE_MAGIC
+            && qFromLittleEndian<quint32>(base + 4) == STORE_VERSION) {
+            headerValid = true;
+            qint64 pos = STORE_HEADER_SIZE;
+
+            while (pos + 4 <= content.size()) {
+                quint32 length = qFromLittleEndian<quint32>(base + pos);
+                if (pos + 4 + static_cast<qint64>(length) > content.size()) {
+                    // 上次写入中断留下的不完整记录
+                    qCWarning(lcDownload) << "下载任务记录文件尾部不完整，已忽略";
+                    break;
+                }
+                applyRecord(content.mid(pos + 4, length));
+                pos += 4 + length;
+                m_recordCount++;
+            }
+            validEnd = pos;
+        } else if (!content.isEmpty()) {
+            qCWarning(lcDownload) << "下载任务记录文件格式无效，将重新创建:" << path;
+        }
+    }
+
+    for (auto it = m_tasks.cbegin(); it != m_tasks.cend(); ++it) {
+        m_nextTaskId = qMax(m_nextTaskId, it.key() + 1);
+    }
+
+    qCDebug(lcDownload) << "已加载下载任务记录:" << m_tasks.size() << "个任务，" << m_recordCount << "条记录";
+
+    // 无效记录过多时压缩重写
+    if (headerValid && m_recordCount > m_tasks.size() * 2 + COMPACT_MIN_GARBAGE) {
+        return compact();
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qCWarning(lcDownload) << "无法打开下载任务记录文件:" << path;
+        return false;
+    }
+
+    if (!headerValid) {
+        // 新建文件或格式无效：写入文件头
+        m_file.resize(0);
+        uchar header[STORE_HEADER_SIZE];
+        qToLittleEndian<quint32>(STORE_MAGIC, header);
+        qToLittleEndian<quint32>(STORE_VERSION, header + 4);
+        m_file.write(reinterpret_cast<const char*>(header), STORE_HEADER_SIZE);
+        m_file.flush();
+    } else if (validEnd < m_file.size()) {
+        // 截掉不完整的尾部记录
+        m_file.resize(validEnd);
+    }
+
+    m_file.seek(m_file.size());
+    return true;
+}
+
+int DownloadTaskStore::allocateTaskId()
+{
+    return m_nextTaskId++;
+}
+
+void DownloadTaskStore::addTask(const DownloadTaskRecord &record)
+{
+    m_tasks.insert(record.id, record);
+    m_urlIndex.insert(record.url, record.id);
+    m_nextTaskId = qMax(m_nextTaskId, record.id + 1);
+
+    appendRecord(serializeCreated(record));
+    emit taskAdded(record.id);
+}
+
+void DownloadTaskStore::updateTask(int taskId, int state, qint64 downloadedSize, qint64 totalSize, bool finished)
+{
+    auto it = m_tasks.find(taskId);
+    if (it == m_tasks.end()) {
+        return;
+    }
+
+    it->state = state;
+    it->downloadedSize = downloadedSize;
+    it->totalSize = totalSize;
+    it->finishedAt = finished ? QDateTime::currentMSecsSinceEpoch() : 0;
+
+    appendRecord(serializeUpdated(*it));
+    emit taskChanged(taskId);
+}
+
+void DownloadTaskStore::removeTask(int taskId)
+{
+    auto it = m_tasks.find(taskId);
+    if (it == m_tasks.end()) {
+        return;
+    }
+
+    m_urlIndex.remove(it->url, taskId);
+    m_tasks.erase(it);
+
+    appendRecord(serializeRemoved(taskId));
+    emit taskRemoved(taskId);
+}
+
+void DownloadTaskStore::clearFinished(const QList<int> &finishedStates)
+{
+    const QList<int> ids = taskIds();
+    for (int taskId : ids) {
+        if (finishedStates.contains(m_tasks.value(taskId).state)) {
+            removeTask(taskId);
+        }
+    }
+}
+
+QList<int> DownloadTaskStore::taskIdsForUrl(const QString &url) const
+{
+    QList<int> ids = m_urlIndex.values(url);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+QList<int> DownloadTaskStore::taskIds() const
+{
+    QList<int> ids = m_tasks.keys();
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+QList<DownloadTaskRecord> DownloadTaskStore::takeRestorableTasks(const QList<int> &restorableStates)
+{
+    QList<DownloadTaskRecord> result;
+    if (m_restoredTaken) {
+        return result;
+    }
+    m_restoredTaken = true;
+
+    const QList<int> ids = taskIds();
+    for (int taskId : ids) {
+        const DownloadTaskRecord &record = m_tasks[taskId];
+        if (restorableStates.contains(record.state)) {
+            result.append(record);
+        }
+    }
+    return result;
+}
+
+void DownloadTaskStore::applyRecord(const QByteArray &payload)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint8 type = 0;
+    in >> type;
+
+    switch (type) {
+    case RecordCreated: {
+        DownloadTaskRecord record;
+        in >> record.id >> record.url >> record.savePath >> record.expectedChecksum
+           >> record.priority >> record.state >> record.totalSize >> record.downloadedSize
+           >> record.createdAt >> record.finishedAt;
+        // 选项标志是后加的字段，旧记录中没有
+        if (!in.atEnd()) {
+            in >> record.flags;
+        }
+        if (in.status() == QDataStream::Ok) {
+            m_tasks.insert(record.id, record);
+            m_urlIndex.insert(record.url, record.id);
+        }
+        break;
+    }
+    case RecordUpdated: {
+        int taskId = 0;
+        int state = 0;
+        qint64 totalSize = 0;
+        qint64 downloadedSize = 0;
+        qint64 finishedAt = 0;
+        in >> taskId >> state >> totalSize >> downloadedSize >> finishedAt;
+        auto it = m_tasks.find(taskId);
+        if (in.status() == QDataStream::Ok && it != m_tasks.end()) {
+            it->state = state;
+            it->totalSize = totalSize;
+            it->downloadedSize = downloadedSize;
+            it->finishedAt = finishedAt;
+        }
+        break;
+    }
+    case RecordRemoved: {
+        int taskId = 0;
+        in >> taskId;
+        auto it = m_tasks.find(taskId);
+        if (it != m_tasks.end()) {
+            m_urlIndex.remove(it->url, taskId);
+            m_tasks.erase(it);
+        }
+        break;
+    }
+    default:
+        qCWarning(lcDownload) << "未知的下载任务记录类型:" << type;
+        break;
+    }
+}
+
+void DownloadTaskStore::appendRecord(const QByteArray &payload)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    uchar length[4];
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), length);
+
+    // 长度和内容一次写入，尾部不完整的记录在下次加载时会被丢弃
+    QByteArray frame;
+    frame.reserve(4 + payload.size());
+    frame.append(reinterpret_cast<const char*>(length), 4);
+    frame.append(payload);
+
+    m_file.write(frame);
+    m_file.flush();
+    m_recordCount++;
+}
+
+bool DownloadTaskStore::compact()
+{
+    QString path = storeFilePath();
+
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    QSaveFile output(path);
+    if (!output.open(QIODevice::WriteOnly)) {
+        qCWarning(lcDownload) << "无法压缩下载任务记录文件:" << path;
+        return false;
+    }
+
+    uchar header[STORE_HEADER_SIZE];
+    qToLittleEndian<quint32>(STORE_MAGIC, header);
+    qToLittleEndian<quint32>(STORE_VERSION, header + 4);
+    output.write(reinterpret_cast<const char*>(header), STORE_HEADER_SIZE);
+
+    const QList<int> ids = taskIds();
+    for (int taskId : ids) {
+        QByteArray payload = serializeCreated(m_tasks.value(taskId));
+        uchar length[4];
+        qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), length);
+        output.write(reinterpret_cast<const char*>(length), 4);
+        output.write(payload);
+    }
+
+    // 原子替换旧文件
+    if (!output.commit()) {
+        qCWarning(lcDownload) << "下载任务记录文件写入失败:" << path;
+        return false;
+    }
+
+    qCDebug(lcDownload) << "下载任务记录已压缩:" << m_recordCount << "->" << ids.size() << "条记录";
+    m_recordCount = ids.size();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qCWarning(lcDownload) << "无法打开下载任务记录文件:" << path;
+        return false;
+    }
+    m_file.seek(m_file.size());
+    return true;
+}
+
+QByteArray DownloadTaskStore::serializeCreated(const DownloadTaskRecord &record)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << static_cast<quint8>(RecordCreated)
+        << record.id << record.url << record.savePath << record.expectedChecksum
+        << record.priority << record.state << record.totalSize << record.downloadedSize
+        << record.createdAt << record.finishedAt << record.flags;
+    return payload;
+}
+
+QByteArray DownloadTaskStore::serializeUpdated(const DownloadTaskRecord &record)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << static_cast<quint8>(RecordUpdated)
+        << record.id << record.state << record.totalSize << record.downloadedSize << record.finishedAt;
+    return payload;
+}
+
+QByteArray DownloadTaskStore::serializeRemoved(int taskId)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << static_cast<quint8>(RecordRemoved) << taskId;
+    return payload;
+}
@@ -0,0 +1,116 @@
+#ifndef DOWNLOADTASKSTORE_H
+#define DOWNLOADTASKSTORE_H
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QMultiHash>
+#include <QList>
+#include <QString>
+
+// 任务选项标志
+enum DownloadTaskFlag {
+    TaskFlagExtract = 0x1           // 边下载边解包到保存路径（目录）
+};
+
+// 持久化的下载任务记录
+struct DownloadTaskRecord {
+    int id = 0;
+    QString url;
+    QString savePath;
+    QString expectedChecksum;
+    int priority = 0;
+    int state = 0;                  // 取值同DownloadManager::TaskState
+    qint64 totalSize = 0;
+    qint64 downloadedSize = 0;
+    qint64 createdAt = 0;           // 创建时间（毫秒时间戳）
+    qint64 finishedAt = 0;          // 结束时间（毫秒时间戳，未结束为0）
+    int flags = 0;                  // DownloadTaskFlag组合
+};
+
+// 下载任务存储（进程内单例）：
+// 采用只追加的记录文件，新建任务写一条完整记录，状态变化只追加一条小记录，
+// 不会因为进度变化而重写整个文件。启动时顺序扫描一遍即可重建内存索引，
+// 支持按任务ID和URL查找。无效记录过多时在加载阶段压缩重写。
+class DownloadTaskStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 单例模式访问
+    static DownloadTaskStore* instance();
+
+    // 加载记录文件（只在第一次调用时执行）
+    bool load();
+
+    // 分配新的任务ID（进程内所有下载管理器共用）
+    int allocateTaskId();
+
+    // 追加新任务
+    void addTask(const DownloadTaskRecord &record);
+
+    // 更新任务状态和进度，finished为true时记录结束时间
+    void updateTask(int taskId, int state, qint64 downloadedSize, qint64 totalSize, bool finished = false);
+
+    // 删除任务记录
+    void removeTask(int taskId);
+
+    // 删除所有已结束的任务（完成、失败、取消）
+    void clearFinished(const QList<int> &finishedStates);
+
+    // 查询
+    bool contains(int taskId) const { return m_tasks.contains(taskId); }
+    DownloadTaskRecord task(int taskId) const { return m_tasks.value(taskId); }
+    QList<int> taskIdsForUrl(const QString &url) const;
+    QList<int> taskIds() const;
+    int count() const { return m_tasks.size(); }
+
+    // 领取上次未完成的任务（每个进程只会领取一次）
+    QList<DownloadTaskRecord> takeRestorableTasks(const QList<int> &restorableStates);
+
+signals:
+    void taskAdded(int taskId);
+    void taskChanged(int taskId);
+    void taskRemoved(int taskId);
+
+private:
+    explicit DownloadTaskStore(QObject *parent = nullptr);
+    ~DownloadTaskStore();
+
+    // 记录类型
+    enum RecordType : quint8 {
+        RecordCreated = 1,      // 完整任务记录
+        RecordUpdated = 2,      // 状态/进度更新
+        RecordRemoved = 3       // 删除
+    };
+
+    // 获取记录文件路径
+    QString storeFilePath() const;
+
+    // 应用一条记录到内存索引
+    void applyRecord(const QByteArray &payload);
+
+    // 追加一条记录到文件
+    void appendRecord(const QByteArray &payload);
+
+    // 把当前内存状态重写为紧凑的记录文件
+    bool compact();
+
+    // 序列化
+    static QByteArray serializeCreated(const DownloadTaskRecord &record);
+    static QByteArray serializeUpdated(const DownloadTaskRecord &record);
+    static QByteArray serializeRemoved(int taskId);
+
+    static DownloadTaskStore *m_instance;
+
+    QFile m_file;
+    bool m_loaded;
+    bool m_restoredTaken;
+    int m_nextTaskId;
+    int m_recordCount;                          // 文件中的记录条数
+
+    QHash<int, DownloadTaskRecord> m_tasks;     // 按ID索引
+    QMultiHash<QString, int> m_urlIndex;        // 按URL索引
+};
+
+#endif // DOWNLOADTASKSTORE_H
@@ -0,0 +1,286 @@
+#include "DownloadWriter.h"
+#include "LogCategories.h"
+#include "DownloadHasher.h"
+#include "DownloadExtractor.h"
+#include "DownloadStreamDevice.h"
+#include <QDebug>
+#include <cstring>
+
+DownloadWriter::DownloadWriter(QFile *file)
+    : m_file(file)
+    , m_hasher(nullptr)
+    , m_extractor(nullptr)
+    , m_streamSource(nullptr)
+    , m_currentBuffer(-1)
+    , m_writingBuffer(-1)
+    , m_finishing(false)
+    , m_aborted(false)
+    , m_error(false)
+    , m_bytesWritten(0)
+    , m_appendedEnd(0)
+    , m_flushedEnd(0)
+    , m_thread(nullptr)
+{
+    // 预先分配整个缓冲池，下载过程中不再为每个数据块分配内存
+    m_buffers.reserve(BufferCount);
+    for (int i = 0; i < BufferCount; ++i) {
+        Buffer buffer;
+        buffer.data = static_cast<char*>(qMallocAligned(BufferSize, BufferAlignment));
+        buffer.size = 0;
+        buffer.offset = 0;
+        if (!buffer.data) {
+            qCWarning(lcDownload) << "下载缓冲区分配失败";
+            continue;
+        }
+        m_buffers.push_back(buffer);
+        m_freeBuffers.push_back(static_cast<int>(m_buffers.size()) - 1);
+    }
+}
+
+DownloadWriter::~DownloadWriter()
+{
+    // 确保写入线程已退出
+    if (m_thread) {
+        abort();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    for (Buffer &buffer : m_buffers) {
+        qFreeAligned(buffer.data);
+    }
+}
+
+void DownloadWriter::setStartOffset(qint64 offset)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_appendedEnd = offset;
+    m_flushedEnd = offset;
+}
+
+bool DownloadWriter::start()
+{
+    if (m_thread || m_buffers.empty()) {
+        return false;
+    }
+    if (!m_extractor && (!m_file || !m_file->isOpen())) {
+        return false;
+    }
+
+    m_thread = QThread::create([this]() { writerLoop(); });
+    m_thread->start();
+    return true;
+}
+
+bool DownloadWriter::append(const char *data, qint64 size)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (size > 0) {
+        if (m_aborted || m_error.load()) {
+            return false;
+        }
+
+        // 需要新的缓冲区：等待写入线程归还（背压）
+        if (m_currentBuffer < 0) {
+            m_freeCondition.wait(lock, [this]() {
+                return !m_freeBuffers.empty() || m_aborted || m_error.load();
+            });
+            if (m_aborted || m_error.load()) {
+                return false;
+            }
+            m_currentBuffer = m_freeBuffers.front();
+            m_freeBuffers.pop_front();
+            m_buffers[m_currentBuffer].size = 0;
+            m_buffers[m_currentBuffer].offset = m_appendedEnd.load();
+        }
+
+        Buffer &buffer = m_buffers[m_currentBuffer];
+        qint64 chunk = qMin(size, BufferSize - buffer.size);
+
+        // 拷贝时不需要持有锁，当前缓冲区只属于传输线程
+        lock.unlock();
+        memcpy(buffer.data + buffer.size, data, static_cast<size_t>(chunk));
+        lock.lock();
+
+        buffer.size += chunk;
+        m_appendedEnd = buffer.offset + buffer.size;
+        data += chunk;
+        size -= chunk;
+
+        // 缓冲区已满，交给写入线程
+        if (buffer.size == BufferSize) {
+            submitCurrentLocked();
+        }
+    }
+
+    // 通知正在等待这部分数据的读取方（在锁外通知，避免与读取方的锁交叉）
+    lock.unlock();
+    if (m_streamSource) {
+        m_streamSource->notifyDataAvailable();
+    }
+    return true;
+}
+
+bool DownloadWriter::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_currentBuffer >= 0 && m_buffers[m_currentBuffer].size > 0) {
+            submitCurrentLocked();
+        }
+        m_finishing = true;
+    }
+    m_pendingCondition.notify_all();
+
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if (!m_error.load() && m_file && m_file->isOpen()) {
+        m_file->flush();
+    }
+
+    return !m_error.load() && !m_aborted;
+}
+
+void DownloadWriter::abort()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_aborted = true;
+        m_pendingBuffers.clear();
+    }
+    m_freeCondition.notify_all();
+    m_pendingCondition.notify_all();
+}
+
+qint64 DownloadWriter::readBuffered(qint64 position, char *data, qint64 maxSize) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // 依次检查正在写盘、等待写盘和正在填充的缓冲区，数据按文件偏移连续排列
+    auto copyFrom = [&](int index) -> qint64 {
+        const Buffer &buffer = m_buffers[index];
+        if (position < buffer.offset || position >= buffer.offset + buffer.size) {
+            return 0;
+        }
+        qint64 chunk = qMin(maxSize, buffer.offset + buffer.size - position);
+        memcpy(data, buffer.data + (position - buffer.offset), static_cast<size_t>(chunk));
+        return chunk;
+    };
+
+    if (m_writingBuffer >= 0) {
+        qint64 copied = copyFrom(m_writingBuffer);
+        if (copied > 0) {
+            return copied;
+        }
+    }
+    for (int index : m_pendingBuffers) {
+        qint64 copied = copyFrom(index);
+        if (copied > 0) {
+            return copied;
+        }
+    }
+    if (m_currentBuffer >= 0) {
+        return copyFrom(m_currentBuffer);
+    }
+    return 0;
+}
+
+QString DownloadWriter::errorString() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_errorString;
+}
+
+void DownloadWriter::submitCurrentLocked()
+{
+    m_pendingBuffers.push_back(m_currentBuffer);
+    m_currentBuffer = -1;
+    m_pendingCondition.notify_one();
+}
+
+void DownloadWriter::writerLoop()
+{
+    while (true) {
+        int index = -1;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pendingCondition.wait(lock, [this]() {
+                return !m_pendingBuffers.empty() || m_finishing || m_aborted;
+            });
+
+            if (m_aborted) {
+                return;
+            }
+            if (m_pendingBuffers.empty()) {
+                // 已请求结束且没有剩余数据
+                return;
+            }
+
+            index = m_pendingBuffers.front();
+            m_pendingBuffers.pop_front();
+            m_writingBuffer = index;
+        }
+
+        // 在锁外执行大块顺序写入
+        Buffer &buffer = m_buffers[index];
+        if (!writeBuffer(buffer)) {
+            return;
+        }
+        m_bytesWritten += buffer.size;
+
+        // 在写入线程中计算校验值，不占用传输线程
+        if (m_hasher) {
+            m_hasher->addData(buffer.data, buffer.size);
+        }
+
+        // 归还缓冲区，唤醒可能被背压阻塞的传输线程
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_flushedEnd = buffer.offset + buffer.size;
+            m_writingBuffer = -1;
+            buffer.size = 0;
+            m_freeBuffers.push_back(index);
+        }
+        m_freeCondition.notify_one();
+    }
+}
+
+bool DownloadWriter::writeBuffer(const Buffer &buffer)
+{
+    // 解包模式：压缩包不落盘，直接解出文件
+    if (m_extractor) {
+        if (!m_extractor->addData(buffer.data, buffer.size)) {
+            setError(m_extractor->errorString());
+            return false;
+        }
+        return true;
+    }
+
+    qint64 offset = 0;
+    while (offset < buffer.size) {
+        qint64 written = m_file->write(buffer.data + offset, buffer.size - offset);
+        if (written <= 0) {
+            setError(m_file->errorString());
+            return false;
+        }
+        offset += written;
+    }
+    return true;
+}
+
+void DownloadWriter::setError(const QString &message)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_errorString = message;
+    }
+    qCWarning(lcDownload) << "下载数据写入失败:" << message;
+    m_error = true;
+    m_freeCondition.notify_all();
+}
@@ -0,0 +1,126 @@
+#ifndef DOWNLOADWRITER_H
+#define DOWNLOADWRITER_H
+
+#include <QFile>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class DownloadHasher;
+class DownloadExtractor;
+class DownloadStreamSource;
+
+// 下载数据写入管线：
+// 传输线程把CURL收到的小块数据拷贝进预分配的大缓冲区，
+// 缓冲区写满后交给独立的写入线程做大块顺序写入。
+// 所有缓冲区都在等待写盘时，append()会阻塞传输线程（背压），
+// 相当于暂停接收，直到写入线程归还空闲缓冲区。
+class DownloadWriter
+{
+public:
+    // 单个缓冲区大小（1 MB）
+    static constexpr qint64 BufferSize = 1024 * 1024;
+
+    // 缓冲池中的缓冲区数量
+    static constexpr int BufferCount = 8;
+
+    // 缓冲区对齐（按磁盘页对齐，便于底层做直接I/O）
+    static constexpr qint64 BufferAlignment = 4096;
+
+    // file为nullptr时必须设置解包器，数据不写入文件而是交给解包器
+    explicit DownloadWriter(QFile *file);
+    ~DownloadWriter();
+
+    // 设置流式校验器（在start()之前调用），数据写盘后按顺序交给校验器
+    void setHasher(DownloadHasher *hasher) { m_hasher = hasher; }
+
+    // 设置解包器（在start()之前调用），数据在写入线程中直接解包到目标目录
+    void setExtractor(DownloadExtractor *extractor) { m_extractor = extractor; }
+
+    // 设置数据流来源（在start()之前调用），追加数据后唤醒等待数据的读取方
+    void setStreamSource(DownloadStreamSource *source) { m_streamSource = source; }
+
+    // 设置第一个追加字节在文件中的偏移（续传时为已下载的长度，在追加数据之前调用）
+    void setStartOffset(qint64 offset);
+
+    // 启动写入线程（文件必须已打开）
+    bool start();
+
+    // 传输线程调用：追加数据，缓冲区不足时阻塞等待
+    // 返回false表示写入已失败或已中止，应终止传输
+    bool append(const char *data, qint64 size);
+
+    // 提交剩余数据并等待全部写入完成，返回是否成功
+    bool finish();
+
+    // 中止写入：丢弃未写入的数据并唤醒所有等待者
+    void abort();
+
+    // 已写入磁盘的字节数
+    qint64 bytesWritten() const { return m_bytesWritten.load(); }
+
+    // 已追加数据的末尾在文件中的偏移（包括还在缓冲区中的数据）
+    qint64 appendedEnd() const { return m_appendedEnd.load(); }
+
+    // 已写入文件的数据的末尾偏移，之前的数据可以直接从文件读取
+    qint64 flushedEnd() const { return m_flushedEnd.load(); }
+
+    // 从还没有写盘的缓冲区中拷贝position处的数据，数据不在缓冲区中时返回0
+    qint64 readBuffered(qint64 position, char *data, qint64 maxSize) const;
+
+    // 是否发生写入错误
+    bool hasError() const { return m_error.load(); }
+
+    // 错误信息
+    QString errorString() const;
+
+private:
+    struct Buffer {
+        char *data;     // 对齐分配的内存
+        qint64 size;    // 已填充字节数
+        qint64 offset;  // 第一个字节在文件中的偏移
+    };
+
+    // 写入线程主循环
+    void writerLoop();
+
+    // 把当前缓冲区放入待写队列（调用方需持有锁）
+    void submitCurrentLocked();
+
+    // 把一个缓冲区写入文件或交给解包器
+    bool writeBuffer(const Buffer &buffer);
+
+    // 记录写入错误并唤醒传输线程
+    void setError(const QString &message);
+
+    QFile *m_file;
+    DownloadHasher *m_hasher;
+    DownloadExtractor *m_extractor;
+    DownloadStreamSource *m_streamSource;
+
+    std::vector<Buffer> m_buffers;      // 缓冲池
+    std::deque<int> m_freeBuffers;      // 空闲缓冲区索引
+    std::deque<int> m_pendingBuffers;   // 等待写盘的缓冲区索引
+    int m_currentBuffer;                // 传输线程正在填充的缓冲区（-1表示无）
+    int m_writingBuffer;                // 写入线程正在写盘的缓冲区（-1表示无）
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_freeCondition;     // 有空闲缓冲区
+    std::condition_variable m_pendingCondition;  // 有待写缓冲区或状态变化
+
+    bool m_finishing;                   // 已请求结束
+    bool m_aborted;                     // 已中止
+    std::atomic<bool> m_error;          // 写入失败
+    std::atomic<qint64> m_bytesWritten; // 已写入字节数
+    std::atomic<qint64> m_appendedEnd;  // 已追加数据的末尾偏移（在锁内修改）
+    std::atomic<qint64> m_flushedEnd;   // 已写盘数据的末尾偏移（在锁内修改）
+    QString m_errorString;
+
+    QThread *m_thread;                  // 写入线程
+};
+
+#endif // DOWNLOADWRITER_H
@@ -0,0 +1,295 @@
+#include "LogBinaryFormat.h"
+#include <cstring>
+
+// 按写入方的字节序追加定长数值
+template<typename T>
+static void appendValue(QByteArray *out, T value)
+{
+    out->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// 从payload的position处读取定长数值，越界时返回false
+template<typename T>
+static bool readValue(const QByteArray &payload, int *position, T *value)
+{
+    if (*position + static_cast<int>(sizeof(T)) > payload.size()) {
+        return false;
+    }
+    memcpy(value, payload.constData() + *position, sizeof(T));
+    *position += sizeof(T);
+    return true;
+}
+
+// 单条消息的最大字节数，留出条目中其他字段的空间，保证写出的条目不超过读取器接受的长度
+static const qsizetype MAX_MESSAGE_BYTES = LogBinaryFormat::MaxEntrySize - 0x20000;
+
+// 追加条目头，返回长度字段的位置（内容写完后回填）
+static int beginEntry(QByteArray *out, quint8 type)
+{
+    appendValue<quint8>(out, type);
+    const int lengthPosition = out->size();
+    appendValue<quint32>(out, 0);
+    return lengthPosition;
+}
+
+static void endEntry(QByteArray *out, int lengthPosition)
+{
+    const quint32 length = static_cast<quint32>(out->size() - lengthPosition - sizeof(quint32));
+    memcpy(out->data() + lengthPosition, &length, sizeof(length));
+}
+
+QByteArray LogBinaryFormat::fileHeader()
+{
+    QByteArray header(Magic, sizeof(Magic));
+    appendValue<quint16>(&header, Version);
+    appendValue<quint16>(&header, ByteOrderMark);
+    return header;
+}
+
+void LogBinaryWriter::reset()
+{
+    m_categoriesWritten.clear();
+    m_formatsWritten.clear();
+}
+
+void LogBinaryWriter::append(const LogRecord &record, QByteArray *out)
+{
+    if (record.kind == LogRecord::Structured) {
+        ensureFormat(record.formatId, out);
+    } else if (record.kind == LogRecord::Text) {
+        ensureCategory(record.categoryId, out);
+    }
+    appendRecordEntry(record, out);
+}
+
+void LogBinaryWriter::appendRecordEntry(const LogRecord &record, QByteArray *out)
+{
+    switch (record.kind) {
+    case LogRecord::Structured: {
+        const int lengthPosition = beginEntry(out, LogBinaryFormat::EntryRecord);
+        appendValue<qint64>(out, record.timestamp);
+        appendValue<quint32>(out, record.threadId);
+        appendValue<quint16>(out, record.formatId);
+        out->append(record.arguments, record.argumentSize);
+        endEntry(out, lengthPosition);
+        break;
+    }
+    case LogRecord::Text: {
+        const QByteArray label = record.label.toUtf8();
+        const int lengthPosition = beginEntry(out, LogBinaryFormat::EntryText);
+        appendValue<qint64>(out, record.timestamp);
+        appendValue<quint32>(out, record.threadId);
+        appendValue<quint8>(out, record.level);
+        appendValue<quint16>(out, record.categoryId);
+        appendValue<quint16>(out, static_cast<quint16>(qMin<qsizetype>(label.size(), 0xFFFF)));
+        out->append(label.constData(), qMin<qsizetype>(label.size(), 0xFFFF));
+        out->append(record.message.toUtf8().left(MAX_MESSAGE_BYTES));
+        endEntry(out, lengthPosition);
+        break;
+    }
+    default: {
+        const int lengthPosition = beginEntry(out, LogBinaryFormat::EntryRaw);
+        out->append(record.message.toUtf8().left(MAX_MESSAGE_BYTES));
+        endEntry(out, lengthPosition);
+        break;
+    }
+    }
+}
+
+void LogBinaryWriter::ensureCategory(quint16 id, QByteArray *out)
+{
+    if (id < m_categoriesWritten.size() && m_categoriesWritten[id]) {
+        return;
+    }
+    if (id >= m_categoriesWritten.size()) {
+        m_categoriesWritten.resize(id + 1, false);
+    }
+    m_categoriesWritten[id] = true;
+
+    appendCategoryEntry(id, out);
+}
+
+void LogBinaryWriter::appendCategoryEntry(quint16 id, QByteArray *out)
+{
+    const int lengthPosition = beginEntry(out, LogBinaryFormat::EntryCategory);
+    appendValue<quint16>(out, id);
+    out->append(LogFormatRegistry::categoryName(id).toUtf8());
+    endEntry(out, lengthPosition);
+}
+
+void LogBinaryWriter::ensureFormat(quint16 id, QByteArray *out)
+{
+    if (id < m_formatsWritten.size() && m_formatsWritten[id]) {
+        return;
+    }
+    if (id >= m_formatsWritten.size()) {
+        m_formatsWritten.resize(id + 1, false);
+    }
+    m_formatsWritten[id] = true;
+
+    // 未注册的ID也写入一个空格式，解码时能显示参数
+    LogFormatRegistry::Format format;
+    LogFormatRegistry::format(id, &format);
+    ensureCategory(format.categoryId, out);
+    appendFormatEntry(id, format, out);
+}
+
+void LogBinaryWriter::appendFormatEntry(quint16 id, const LogFormatRegistry::Format &format, QByteArray *out)
+{
+    const int lengthPosition = beginEntry(out, LogBinaryFormat::EntryFormat);
+    appendValue<quint16>(out, id);
+    appendValue<quint8>(out, format.level);
+    appendValue<quint16>(out, format.categoryId);
+    appendValue<qint32>(out, format.line);
+    appendValue<quint16>(out, static_cast<quint16>(qMin<qsizetype>(format.file.size(), 0xFFFF)));
+    out->append(format.file.constData(), qMin<qsizetype>(format.file.size(), 0xFFFF));
+    out->append(format.format.toUtf8());
+    endEntry(out, lengthPosition);
+}
+
+LogBinaryReader::LogBinaryReader(QIODevice *device)
+    : m_device(device)
+{
+}
+
+bool LogBinaryReader::open()
+{
+    const QByteArray header = m_device->read(LogBinaryFormat::HeaderSize);
+    if (header.size() < LogBinaryFormat::HeaderSize
+        || memcmp(header.constData(), LogBinaryFormat::Magic, sizeof(LogBinaryFormat::Magic)) != 0) {
+        m_errorString = "不是二进制日志文件";
+        return false;
+    }
+
+    int position = sizeof(LogBinaryFormat::Magic);
+    quint16 version = 0;
+    quint16 byteOrder = 0;
+    readValue(header, &position, &version);
+    readValue(header, &position, &byteOrder);
+    if (version != LogBinaryFormat::Version) {
+        m_errorString = QString("不支持的日志文件版本: %1").arg(version);
+        return false;
+    }
+    if (byteOrder != LogBinaryFormat::ByteOrderMark) {
+        m_errorString = "日志文件由字节序不同的系统写入";
+        return false;
+    }
+    return true;
+}
+
+bool LogBinaryReader::readEntry(quint8 *type, QByteArray *payload)
+{
+    const QByteArray header = m_device->read(LogBinaryFormat::EntryHeaderSize);
+    if (header.isEmpty()) {
+        return false;
+    }
+    if (header.size() < LogBinaryFormat::EntryHeaderSize) {
+        m_errorString = "文件末尾的条目不完整";
+        return false;
+    }
+
+    int position = 0;
+    quint32 length = 0;
+    readValue(header, &position, type);
+    readValue(header, &position, &length);
+
+    // 长度来自文件，损坏或截断的文件不能让读取器分配超出文件本身的内存
+    const qint64 remaining = m_device->isSequential() ? qint64(LogBinaryFormat::MaxEntrySize)
+                                                      : m_device->size() - m_device->pos();
+    if (length > LogBinaryFormat::MaxEntrySize || qint64(length) > remaining) {
+        m_errorString = QString("日志条目长度无效: %1").arg(length);
+        return false;
+    }
+
+    *payload = m_device->read(length);
+    if (payload->size() != static_cast<qsizetype>(length)) {
+        m_errorString = "文件末尾的条目不完整";
+        return false;
+    }
+    return true;
+}
+
+bool LogBinaryReader::next(Entry *entry)
+{
+    quint8 type = 0;
+    QByteArray payload;
+
+    while (readEntry(&type, &payload)) {
+        int position = 0;
+
+        switch (type) {
+        case LogBinaryFormat::EntryCategory: {
+            quint16 id = 0;
+            if (readValue(payload, &position, &id)) {
+                m_categories.insert(id, QString::fromUtf8(payload.mid(position)));
+            }
+            break;
+        }
+        case LogBinaryFormat::EntryFormat: {
+            quint16 id = 0;
+            quint8 level = 0;
+            qint32 line = 0;
+            quint16 fileLength = 0;
+            FormatInfo format;
+            if (readValue(payload, &position, &id) && readValue(payload, &position, &level)
+                && readValue(payload, &position, &format.categoryId) && readValue(payload, &position, &line)
+                && readValue(payload, &position, &fileLength) && position + fileLength <= payload.size()) {
+                format.level = level;
+                format.line = line;
+                format.file = QString::fromUtf8(payload.constData() + position, fileLength);
+                format.format = QString::fromUtf8(payload.mid(position + fileLength));
+                m_formats.insert(id, format);
+            }
+            break;
+        }
+        case LogBinaryFormat::EntryRecord: {
+            quint16 formatId = 0;
+            *entry = Entry();
+            entry->kind = LogRecord::Structured;
+            if (!readValue(payload, &position, &entry->timestamp) || !readValue(payload, &position, &entry->threadId)
+                || !readValue(payload, &position, &formatId)) {
+                m_errorString = "结构化日志条目无效";
+                return false;
+            }
+
+            const FormatInfo format = m_formats.value(formatId);
+            entry->level = format.level;
+            entry->category = m_categories.value(format.categoryId);
+            entry->format = format.format;
+            entry->file = format.file;
+            entry->line = format.line;
+            entry->arguments = decodeLogArguments(payload.constData() + position, payload.size() - position);
+            entry->message = formatLogMessage(format.format, entry->arguments);
+            return true;
+        }
+        case LogBinaryFormat::EntryText: {
+            quint8 level = 0;
+            quint16 categoryId = 0;
+            quint16 labelLength = 0;
+            *entry = Entry();
+            entry->kind = LogRecord::Text;
+            if (!readValue(payload, &position, &entry->timestamp) || !readValue(payload, &position, &entry->threadId)
+                || !readValue(payload, &position, &level) || !readValue(payload, &position, &categoryId)
+                || !readValue(payload, &position, &labelLength) || position + labelLength > payload.size()) {
+                m_errorString = "文本日志条目无效";
+                return false;
+            }
+
+            entry->level = level;
+            entry->category = m_categories.value(categoryId);
+            entry->label = QString::fromUtf8(payload.constData() + position, labelLength);
+            entry->message = QString::fromUtf8(payload.mid(position + labelLength));
+            return true;
+        }
+        case LogBinaryFormat::EntryRaw:
+            *entry = Entry();
+            entry->kind = LogRecord::Raw;
+            entry->message = QString::fromUtf8(payload);
+            return true;
+        default:
+            // 新版本增加的条目类型，跳过
+            break;
+        }
+    }
+    return false;
+}
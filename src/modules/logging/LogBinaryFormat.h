@@ -0,0 +1,112 @@
+#ifndef LOGBINARYFORMAT_H
+#define LOGBINARYFORMAT_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QIODevice>
+#include <QString>
+#include <QVariantList>
+#include <vector>
+
+#include "LogFormat.h"
+
+// 二进制结构化日志文件（.zlog）：
+// 文件头为魔数"ZLOG"、版本（quint16）和字节序标记（quint16，0x0102按写入方的字节序保存），
+// 之后是连续的条目，每个条目以类型（quint8）和内容长度（quint32）开头，未知类型可以整体跳过。
+//   Category  quint16分类ID、名称（UTF-8）
+//   Format    quint16格式ID、quint8等级、quint16分类ID、qint32行号、quint16文件名长度、文件名、格式字符串（UTF-8）
+//   Record    qint64时间戳（纳秒）、quint32线程ID、quint16格式ID、原始参数（LogArgumentEncoder编码）
+//   Text      qint64时间戳（纳秒）、quint32线程ID、quint8等级、quint16分类ID、quint16标签长度、标签、消息（UTF-8）
+//   Raw       消息（UTF-8）
+// 格式和分类在文件中第一次用到时写入，每个文件都可以单独解码。
+namespace LogBinaryFormat {
+    static const char Magic[4] = { 'Z', 'L', 'O', 'G' };
+    static const quint16 Version = 1;
+    static const quint16 ByteOrderMark = 0x0102;
+    static const int HeaderSize = 8;
+    static const int EntryHeaderSize = 5;
+    static const quint32 MaxEntrySize = 64 * 1024 * 1024;  // 读取时超过该长度的条目视为文件损坏
+
+    enum EntryType : quint8 {
+        EntryCategory = 1,
+        EntryFormat = 2,
+        EntryRecord = 3,
+        EntryText = 4,
+        EntryRaw = 5
+    };
+
+    // 文件头
+    QByteArray fileHeader();
+}
+
+// 把日志记录编码为二进制条目（日志写入线程使用，每个新文件调用reset()）
+class LogBinaryWriter
+{
+public:
+    // 开始新文件：之前写过的格式和分类需要重新写入
+    void reset();
+
+    // 追加一条记录，需要时先追加它用到的格式和分类
+    void append(const LogRecord &record, QByteArray *out);
+
+    // 只追加记录本身、分类或格式条目（调用方负责在之前写入用到的格式和分类）
+    static void appendRecordEntry(const LogRecord &record, QByteArray *out);
+    static void appendCategoryEntry(quint16 id, QByteArray *out);
+    static void appendFormatEntry(quint16 id, const LogFormatRegistry::Format &format, QByteArray *out);
+
+private:
+    void ensureCategory(quint16 id, QByteArray *out);
+    void ensureFormat(quint16 id, QByteArray *out);
+
+    std::vector<bool> m_categoriesWritten;
+    std::vector<bool> m_formatsWritten;
+};
+
+// 读取二进制日志文件（解码工具使用）
+class LogBinaryReader
+{
+public:
+    // 一条日志
+    struct Entry {
+        quint8 kind = LogRecord::Raw;   // LogRecord::Kind
+        qint64 timestamp = 0;           // 纳秒，Raw条目为0
+        quint32 threadId = 0;
+        int level = 0;                  // QtMsgType
+        QString category;
+        QString label;
+        QString message;                // 结构化日志为格式化后的消息
+        QString format;                 // 结构化日志的格式字符串
+        QString file;                   // 结构化日志的源文件和行号
+        int line = 0;
+        QVariantList arguments;         // 结构化日志的参数
+    };
+
+    explicit LogBinaryReader(QIODevice *device);
+
+    // 读取并检查文件头
+    bool open();
+
+    // 读取下一条日志（格式和分类条目在内部处理），到达末尾或出错时返回false
+    bool next(Entry *entry);
+
+    // 出错时的错误信息，正常结束时为空
+    QString errorString() const { return m_errorString; }
+
+private:
+    struct FormatInfo {
+        int level = 0;
+        quint16 categoryId = 0;
+        int line = 0;
+        QString file;
+        QString format;
+    };
+
+    bool readEntry(quint8 *type, QByteArray *payload);
+
+    QIODevice *m_device;
+    QHash<quint16, QString> m_categories;
+    QHash<quint16, FormatInfo> m_formats;
+    QString m_errorString;
+};
+
+#endif // LOGBINARYFORMAT_H
@@ -0,0 +1,9 @@
+#include "LogCategories.h"
+
+// 分类名称统一使用ziyanos.前缀，过滤规则可以用"ziyanos.*"匹配全部模块
+Q_LOGGING_CATEGORY(lcFilesystem, "ziyanos.filesystem")
+Q_LOGGING_CATEGORY(lcDownload, "ziyanos.download")
+Q_LOGGING_CATEGORY(lcSettings, "ziyanos.settings")
+Q_LOGGING_CATEGORY(lcWallpaper, "ziyanos.wallpaper")
+Q_LOGGING_CATEGORY(lcSystem, "ziyanos.system")
+Q_LOGGING_CATEGORY(lcQml, "ziyanos.qml")
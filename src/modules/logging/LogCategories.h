@@ -0,0 +1,16 @@
+#ifndef LOGCATEGORIES_H
+#define LOGCATEGORIES_H
+
+#include <QLoggingCategory>
+
+// 各模块的日志分类。模块中使用qCDebug(lcDownload) << ...代替qDebug()，
+// 被过滤掉的等级在构造任何字符串之前就会跳过（只检查一次分类中的标志）。
+// 过滤规则由LogFilter设置，例如"ziyanos.download.debug=false"
+Q_DECLARE_LOGGING_CATEGORY(lcFilesystem)
+Q_DECLARE_LOGGING_CATEGORY(lcDownload)
+Q_DECLARE_LOGGING_CATEGORY(lcSettings)
+Q_DECLARE_LOGGING_CATEGORY(lcWallpaper)
+Q_DECLARE_LOGGING_CATEGORY(lcSystem)
+Q_DECLARE_LOGGING_CATEGORY(lcQml)
+
+#endif // LOGCATEGORIES_H
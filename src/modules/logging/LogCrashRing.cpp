@@ -0,0 +1,398 @@
+#include "LogCrashRing.h"
+#include "LogBinaryFormat.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// 文件头魔数和版本
+static const char CRASH_RING_MAGIC[4] = { 'Z', 'C', 'R', 'B' };
+static const quint16 CRASH_RING_VERSION = 1;
+
+// 每个槽位的字节数（其中32字节是槽位头）
+static const int CRASH_SLOT_SIZE = 512;
+
+// 格式和分类表的大小
+static const quint32 CRASH_TABLE_SIZE = 256 * 1024;
+
+// 文件头占用的字节数（之后是格式和分类表）
+static const int CRASH_HEADER_SIZE = 64;
+
+// 最少的槽位数
+static const qint64 CRASH_MIN_SLOTS = 64;
+
+// 格式ID和分类ID的取值范围
+static const int CRASH_ID_COUNT = 0x10000;
+
+// 槽位正在写入时的序号
+static const quint64 CRASH_SLOT_BUSY = ~quint64(0);
+
+struct LogCrashRing::Header {
+    char magic[4];
+    quint16 version;
+    quint16 reserved;
+    quint32 slotSize;
+    quint32 slotCount;
+    quint32 tableCapacity;
+    std::atomic<quint32> tableUsed;     // 表中已写入的字节数
+    std::atomic<quint64> head;          // 已分配的槽位总数（下一条记录的序号）
+    qint64 sessionStart;                // 本次运行开始的时间（纳秒）
+    qint64 processId;
+    std::atomic<quint32> clean;         // 1表示正常退出
+};
+
+struct LogCrashRing::Slot {
+    std::atomic<quint64> sequence;      // 记录序号+1，其他字段写完后最后写入；0表示空槽位，CRASH_SLOT_BUSY表示正在写入
+    qint64 timestamp;
+    quint32 threadId;
+    quint8 kind;                        // LogRecord::Kind
+    quint8 level;
+    quint16 id;                         // Text为分类ID，Structured为格式ID
+    quint16 labelLength;                // 标签的UTF-16字符数（Text）
+    quint16 payloadSize;                // payload中的字节数
+    quint8 truncated;                   // 消息被截断
+    char reserved[3];
+    char payload[CRASH_SLOT_SIZE - 32];
+};
+
+LogCrashRing::LogCrashRing()
+    : m_map(nullptr)
+    , m_header(nullptr)
+    , m_table(nullptr)
+    , m_slots(nullptr)
+    , m_slotCount(0)
+    , m_enabled(false)
+    , m_categoriesWritten(new std::atomic<bool>[CRASH_ID_COUNT]())
+    , m_formatsWritten(new std::atomic<bool>[CRASH_ID_COUNT]())
+{
+    // 映射内存中的原子变量必须与普通整数布局相同，提取时其他进程才能读取
+    static_assert(sizeof(std::atomic<quint64>) == sizeof(quint64) && std::atomic<quint64>::is_always_lock_free,
+                  "崩溃日志环需要无锁的64位原子变量");
+    static_assert(sizeof(Slot) == CRASH_SLOT_SIZE, "槽位大小不正确");
+    static_assert(sizeof(Header) <= CRASH_HEADER_SIZE, "文件头超过预留大小");
+}
+
+LogCrashRing::~LogCrashRing()
+{
+    m_enabled.store(false);
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_file.close();
+    }
+}
+
+bool LogCrashRing::open(const QString &path, qint64 bytes)
+{
+    if (m_enabled.load()) {
+        return false;
+    }
+
+    // 重新初始化日志系统：之前的环已经干净关闭
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_file.close();
+        m_map = nullptr;
+        m_header = nullptr;
+    }
+    for (int i = 0; i < CRASH_ID_COUNT; ++i) {
+        m_categoriesWritten[i].store(false, std::memory_order_relaxed);
+        m_formatsWritten[i].store(false, std::memory_order_relaxed);
+    }
+
+    const qint64 slotCount = qBound<qint64>(CRASH_MIN_SLOTS, bytes / CRASH_SLOT_SIZE, 0x7FFFFFFF / CRASH_SLOT_SIZE);
+    const qint64 totalSize = CRASH_HEADER_SIZE + CRASH_TABLE_SIZE + slotCount * CRASH_SLOT_SIZE;
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite) || !m_file.resize(totalSize)) {
+        m_file.close();
+        return false;
+    }
+
+    // 共享映射：写入的页面属于文件，进程崩溃后由系统写回
+    m_map = m_file.map(0, totalSize);
+    if (!m_map) {
+        m_file.close();
+        return false;
+    }
+
+    // 清空上次运行留下的内容（上次崩溃的报告需要在这之前提取）
+    memset(m_map, 0, static_cast<size_t>(totalSize));
+
+    m_header = new (m_map) Header();
+    memcpy(m_header->magic, CRASH_RING_MAGIC, sizeof(CRASH_RING_MAGIC));
+    m_header->version = CRASH_RING_VERSION;
+    m_header->slotSize = CRASH_SLOT_SIZE;
+    m_header->slotCount = static_cast<quint32>(slotCount);
+    m_header->tableCapacity = CRASH_TABLE_SIZE;
+    m_header->sessionStart = LogFormatRegistry::currentTimestamp();
+    m_header->processId = QCoreApplication::applicationPid();
+
+    m_table = reinterpret_cast<char *>(m_map) + CRASH_HEADER_SIZE;
+    m_slots = reinterpret_cast<Slot *>(m_table + CRASH_TABLE_SIZE);
+    m_slotCount = static_cast<quint32>(slotCount);
+    for (quint32 i = 0; i < m_slotCount; ++i) {
+        new (&m_slots[i].sequence) std::atomic<quint64>(0);
+    }
+
+    m_enabled.store(true);
+    return true;
+}
+
+void LogCrashRing::markClean()
+{
+    if (!m_enabled.exchange(false)) {
+        return;
+    }
+    m_header->clean.store(1);
+}
+
+void LogCrashRing::append(const LogRecord &record)
+{
+    if (!m_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    if (record.kind == LogRecord::Structured) {
+        ensureFormat(record.formatId);
+    } else if (record.kind == LogRecord::Text) {
+        ensureCategory(record.categoryId);
+    }
+
+    const quint64 sequence = m_header->head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = m_slots[sequence % m_slotCount];
+
+    // 先把序号换成CRASH_SLOT_BUSY占用槽位：写到一半时进程崩溃，这个槽位在提取时被忽略。
+    // 槽位正被另一个线程写入（绕环一圈后又分到同一槽位），或已经是更新的记录时，丢弃这条记录
+    quint64 current = slot.sequence.load(std::memory_order_relaxed);
+    do {
+        if (current == CRASH_SLOT_BUSY || current > sequence) {
+            return;
+        }
+    } while (!slot.sequence.compare_exchange_weak(current, CRASH_SLOT_BUSY,
+                                                  std::memory_order_acquire, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timestamp = record.timestamp;
+    slot.threadId = record.threadId;
+    slot.kind = record.kind;
+    slot.level = record.level;
+    slot.id = record.kind == LogRecord::Structured ? record.formatId : record.categoryId;
+    slot.labelLength = 0;
+    slot.truncated = 0;
+
+    const int capacity = static_cast<int>(sizeof(slot.payload));
+    int used = 0;
+    if (record.kind == LogRecord::Structured) {
+        used = qMin<int>(record.argumentSize, capacity);
+        memcpy(slot.payload, record.arguments, static_cast<size_t>(used));
+    } else {
+        // 标签和消息按UTF-16原样复制，不做编码转换
+        const int unit = static_cast<int>(sizeof(QChar));
+        if (record.kind == LogRecord::Text && !record.label.isEmpty()) {
+            const int labelLength = qMin<int>(static_cast<int>(record.label.size()), capacity / unit / 4);
+            memcpy(slot.payload, record.label.constData(), static_cast<size_t>(labelLength) * unit);
+            slot.labelLength = static_cast<quint16>(labelLength);
+            used = labelLength * unit;
+        }
+
+        const qsizetype messageLength = record.message.size();
+        const int available = (capacity - used) / unit;
+        int copyLength = static_cast<int>(qMin<qsizetype>(messageLength, available));
+        if (copyLength < messageLength) {
+            slot.truncated = 1;
+            // 不在代理对中间截断
+            if (copyLength > 0 && record.message.at(copyLength - 1).isHighSurrogate()) {
+                --copyLength;
+            }
+        }
+        memcpy(slot.payload + used, record.message.constData(), static_cast<size_t>(copyLength) * unit);
+        used += copyLength * unit;
+    }
+    slot.payloadSize = static_cast<quint16>(used);
+
+    slot.sequence.store(sequence + 1, std::memory_order_release);
+}
+
+void LogCrashRing::ensureCategory(quint16 id)
+{
+    if (m_categoriesWritten[id].load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_tableMutex);
+    ensureCategoryLocked(id);
+}
+
+void LogCrashRing::ensureCategoryLocked(quint16 id)
+{
+    if (m_categoriesWritten[id].load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    QByteArray entry;
+    LogBinaryWriter::appendCategoryEntry(id, &entry);
+    appendTable(entry);
+
+    // 表已满时也不再重试，提取时只缺少分类名称
+    m_categoriesWritten[id].store(true, std::memory_order_release);
+}
+
+void LogCrashRing::ensureFormat(quint16 id)
+{
+    if (m_formatsWritten[id].load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_tableMutex);
+    if (m_formatsWritten[id].load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    LogFormatRegistry::Format format;
+    LogFormatRegistry::format(id, &format);
+    ensureCategoryLocked(format.categoryId);
+
+    QByteArray entry;
+    LogBinaryWriter::appendFormatEntry(id, format, &entry);
+    appendTable(entry);
+    m_formatsWritten[id].store(true, std::memory_order_release);
+}
+
+bool LogCrashRing::appendTable(const QByteArray &entry)
+{
+    const quint32 used = m_header->tableUsed.load(std::memory_order_relaxed);
+    if (used + entry.size() > m_header->tableCapacity) {
+        return false;
+    }
+
+    memcpy(m_table + used, entry.constData(), static_cast<size_t>(entry.size()));
+    m_header->tableUsed.store(used + static_cast<quint32>(entry.size()), std::memory_order_release);
+    return true;
+}
+
+bool LogCrashRing::extractReport(const QString &ringPath, const QString &reportPath, int *recordCount)
+{
+    if (recordCount) {
+        *recordCount = 0;
+    }
+
+    QFile file(ringPath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < CRASH_HEADER_SIZE + CRASH_TABLE_SIZE) {
+        return false;
+    }
+
+    const qint64 fileSize = file.size();
+    uchar *map = file.map(0, fileSize);
+    if (!map) {
+        return false;
+    }
+
+    const Header *header = reinterpret_cast<const Header *>(map);
+    const quint64 head = header->head.load();
+    if (memcmp(header->magic, CRASH_RING_MAGIC, sizeof(CRASH_RING_MAGIC)) != 0
+        || header->version != CRASH_RING_VERSION || header->slotSize != CRASH_SLOT_SIZE
+        || header->tableCapacity != CRASH_TABLE_SIZE
+        || CRASH_HEADER_SIZE + CRASH_TABLE_SIZE + qint64(header->slotCount) * CRASH_SLOT_SIZE > fileSize
+        || header->clean.load() != 0 || head == 0) {
+        file.unmap(map);
+        return false;
+    }
+
+    const char *table = reinterpret_cast<const char *>(map) + CRASH_HEADER_SIZE;
+    const Slot *slots = reinterpret_cast<const Slot *>(table + CRASH_TABLE_SIZE);
+    const quint32 slotCount = header->slotCount;
+
+    // 只保留最近一圈内已完整写入的槽位，按序号排序
+    const quint64 oldest = head > slotCount ? head - slotCount : 0;
+    std::vector<std::pair<quint64, quint32>> order;
+    order.reserve(slotCount);
+    for (quint32 i = 0; i < slotCount; ++i) {
+        const quint64 sequence = slots[i].sequence.load(std::memory_order_acquire);
+        if (sequence == 0 || sequence == CRASH_SLOT_BUSY || sequence - 1 < oldest || sequence - 1 >= head) {
+            continue;
+        }
+        order.emplace_back(sequence - 1, i);
+    }
+    std::sort(order.begin(), order.end());
+
+    // 转换为.zlog格式的数据，用二进制日志的读取器解码
+    QByteArray data = LogBinaryFormat::fileHeader();
+    data.append(table, qMin<quint32>(header->tableUsed.load(), CRASH_TABLE_SIZE));
+
+    for (const auto &item : order) {
+        const Slot &slot = slots[item.second];
+        const int payloadSize = qMin<int>(slot.payloadSize, static_cast<int>(sizeof(slot.payload)));
+
+        LogRecord record;
+        record.kind = slot.kind;
+        record.timestamp = slot.timestamp;
+        record.threadId = slot.threadId;
+        record.level = slot.level;
+        if (record.kind == LogRecord::Structured) {
+            record.formatId = slot.id;
+            record.argumentSize = static_cast<quint8>(qMin<int>(payloadSize, LOG_ARGUMENT_CAPACITY));
+            memcpy(record.arguments, slot.payload, record.argumentSize);
+        } else {
+            const int unit = static_cast<int>(sizeof(QChar));
+            const int labelLength = qMin<int>(slot.labelLength, payloadSize / unit);
+            record.categoryId = slot.id;
+            record.label = QString(reinterpret_cast<const QChar *>(slot.payload), labelLength);
+            record.message = QString(reinterpret_cast<const QChar *>(slot.payload) + labelLength,
+                                     payloadSize / unit - labelLength);
+            if (slot.truncated) {
+                record.message += QChar(0x2026);
+            }
+        }
+        LogBinaryWriter::appendRecordEntry(record, &data);
+    }
+
+    const qint64 sessionStart = header->sessionStart;
+    const qint64 processId = header->processId;
+    file.unmap(map);
+    file.close();
+
+    QFile report(reportPath);
+    if (!report.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+
+    LogLineFormatter formatter;
+    QString text;
+    text.append("========== 崩溃报告（上次运行的最后日志）==========\n");
+    text.append(QString("进程ID: %1\n").arg(processId));
+    text.append(QString("启动时间: %1\n").arg(formatter.formatTimestamp(sessionStart)));
+    text.append(QString("记录数: %1（本次运行共%2条，保留最近%3条）\n")
+                    .arg(static_cast<qulonglong>(order.size()))
+                    .arg(static_cast<qulonglong>(head))
+                    .arg(slotCount));
+    text.append("==================================================\n");
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    LogBinaryReader reader(&buffer);
+    int count = 0;
+    if (reader.open()) {
+        LogBinaryReader::Entry entry;
+        while (reader.next(&entry)) {
+            if (entry.kind == LogRecord::Raw) {
+                text.append(entry.message);
+                text.append(QLatin1Char('\n'));
+            } else {
+                formatter.append(&text, entry.timestamp, entry.level, entry.label, entry.category, entry.message);
+            }
+            count++;
+        }
+    }
+    text.append("========== 崩溃报告结束 ==========\n");
+
+    report.write(text.toUtf8());
+    report.close();
+
+    if (recordCount) {
+        *recordCount = count;
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef LOGCRASHRING_H
+#define LOGCRASHRING_H
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "LogRingBuffer.h"
+
+// 崩溃日志环：最近的日志记录保存在内存映射文件的固定大小槽位中。
+// 写入只是对映射内存的普通写入（没有系统调用，不加锁），进程崩溃后这些页面仍由系统写回文件，
+// 下次以--restart-after-crash启动时用extractReport()转换为文本崩溃报告。
+// 文件结构：文件头、格式和分类表（与.zlog相同的条目编码，第一次用到时写入）、槽位数组。
+// 每个槽位的序号最后写入，写到一半的槽位在提取时被忽略。
+// 写入前用CAS占用槽位：写得快的线程绕环一圈回到仍在写入的槽位时，丢弃自己的记录，不与其他线程同时写同一槽位。
+class LogCrashRing
+{
+public:
+    LogCrashRing();
+    ~LogCrashRing();
+
+    // 创建（或清空）环文件并映射到内存，bytes为槽位区域的大小。不能在记录期间重新打开
+    bool open(const QString &path, qint64 bytes);
+
+    // 正常退出：标记为干净关闭，之后不再记录（映射保留到对象析构，避免其他线程写入已解除的映射）
+    void markClean();
+
+    bool isOpen() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // 记录一条日志（任何线程），超出槽位大小的内容被截断
+    void append(const LogRecord &record);
+
+    // 把异常退出后留下的环文件转换为文本报告。文件不存在、已干净关闭或没有记录时返回false，
+    // recordCount返回提取的记录数
+    static bool extractReport(const QString &ringPath, const QString &reportPath, int *recordCount = nullptr);
+
+private:
+    struct Header;
+    struct Slot;
+
+    // 第一次用到的格式和分类写入表中（只在第一次时加锁）
+    void ensureCategory(quint16 id);
+    void ensureFormat(quint16 id);
+    void ensureCategoryLocked(quint16 id);
+    bool appendTable(const QByteArray &entry);
+
+    QFile m_file;
+    uchar *m_map;
+    Header *m_header;
+    char *m_table;
+    Slot *m_slots;
+    quint32 m_slotCount;
+    std::atomic<bool> m_enabled;
+
+    std::mutex m_tableMutex;
+    std::unique_ptr<std::atomic<bool>[]> m_categoriesWritten;
+    std::unique_ptr<std::atomic<bool>[]> m_formatsWritten;
+};
+
+#endif // LOGCRASHRING_H
@@ -0,0 +1,186 @@
+#include "LogFilter.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include <mutex>
+
+// 可以设置的等级，按严重程度排列
+static const char *const FILTER_LEVELS[] = { "debug", "info", "warning", "critical" };
+
+LogFilter* LogFilter::m_instance = nullptr;
+
+LogFilter::LogFilter(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &LogFilter::onFileChanged);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &LogFilter::onFileChanged);
+}
+
+LogFilter* LogFilter::instance()
+{
+    static std::mutex instanceMutex;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+
+    if (!m_instance) {
+        m_instance = new LogFilter();
+    }
+    return m_instance;
+}
+
+void LogFilter::load(const QString &configPath)
+{
+    if (!m_watcher.files().isEmpty()) {
+        m_watcher.removePaths(m_watcher.files());
+    }
+    if (!m_watcher.directories().isEmpty()) {
+        m_watcher.removePaths(m_watcher.directories());
+    }
+
+    m_configPath = configPath;
+    emit configPathChanged();
+
+    // 同时监视所在目录：文件不存在或被编辑器替换时也能发现
+    const QFileInfo info(configPath);
+    if (info.absoluteDir().exists()) {
+        m_watcher.addPath(info.absolutePath());
+    }
+    if (info.exists()) {
+        m_watcher.addPath(info.absoluteFilePath());
+    }
+
+    reload();
+}
+
+void LogFilter::setRules(const QString &rules)
+{
+    if (m_rules == rules) {
+        return;
+    }
+    m_rules = rules;
+    emit rulesChanged();
+    apply();
+}
+
+bool LogFilter::setCategoryLevel(const QString &category, const QString &level)
+{
+    const QString name = category.trimmed();
+    const QString value = level.trimmed().toLower();
+    if (name.isEmpty()) {
+        return false;
+    }
+
+    if (value.isEmpty()) {
+        m_categoryLevels.remove(name);
+    } else {
+        bool valid = value == "off";
+        for (const char *filterLevel : FILTER_LEVELS) {
+            valid = valid || value == QLatin1String(filterLevel);
+        }
+        if (!valid) {
+            qWarning() << "无效的日志等级:" << level;
+            return false;
+        }
+        m_categoryLevels.insert(name, value);
+    }
+
+    apply();
+    return true;
+}
+
+QString LogFilter::categoryLevel(const QString &category) const
+{
+    return m_categoryLevels.value(category.trimmed());
+}
+
+QStringList LogFilter::categories() const
+{
+    return {
+        "ziyanos.filesystem",
+        "ziyanos.download",
+        "ziyanos.settings",
+        "ziyanos.wallpaper",
+        "ziyanos.system",
+        "ziyanos.qml"
+    };
+}
+
+void LogFilter::reload()
+{
+    const QString configRules = m_configPath.isEmpty() ? QString() : readConfigRules(m_configPath);
+    if (configRules == m_configRules && !m_effectiveRules.isEmpty()) {
+        return;
+    }
+    m_configRules = configRules;
+    apply();
+}
+
+void LogFilter::onFileChanged()
+{
+    // 编辑器保存时可能替换文件，监视会失效
+    const QFileInfo info(m_configPath);
+    if (info.exists() && !m_watcher.files().contains(info.absoluteFilePath())) {
+        m_watcher.addPath(info.absoluteFilePath());
+    }
+    reload();
+}
+
+QString LogFilter::readConfigRules(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QString();
+    }
+
+    // 只读取[Rules]段，其他段和注释忽略
+    QStringList rules;
+    bool inRules = false;
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(';') || line.startsWith('#')) {
+            continue;
+        }
+        if (line.startsWith('[')) {
+            inRules = line.compare("[Rules]", Qt::CaseInsensitive) == 0;
+            continue;
+        }
+        if (inRules && line.contains('=')) {
+            rules.append(line);
+        }
+    }
+    return rules.join('\n');
+}
+
+void LogFilter::apply()
+{
+    QStringList rules;
+    if (!m_configRules.isEmpty()) {
+        rules.append(m_configRules);
+    }
+    if (!m_rules.trimmed().isEmpty()) {
+        rules.append(m_rules.trimmed());
+    }
+
+    // 分类等级展开为每个等级一条规则，低于最低等级的关闭
+    for (auto it = m_categoryLevels.constBegin(); it != m_categoryLevels.constEnd(); ++it) {
+        bool enabled = false;
+        for (const char *filterLevel : FILTER_LEVELS) {
+            enabled = enabled || it.value() == QLatin1String(filterLevel);
+            rules.append(QString("%1.%2=%3").arg(it.key(), filterLevel, enabled ? "true" : "false"));
+        }
+    }
+
+    const QString effectiveRules = rules.join('\n');
+
+    // 规则为空时也要设置，覆盖之前的规则；QLoggingCategory会立即更新所有分类的开关
+    QLoggingCategory::setFilterRules(effectiveRules);
+
+    if (effectiveRules != m_effectiveRules) {
+        m_effectiveRules = effectiveRules;
+        emit effectiveRulesChanged();
+        qInfo() << "日志过滤规则已更新:" << (effectiveRules.isEmpty() ? "（无）" : QString(effectiveRules).replace('\n', "; "));
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef LOGFILTER_H
+#define LOGFILTER_H
+
+#include <QFileSystemWatcher>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+// 运行时日志过滤：组合配置文件（logging.ini的[Rules]段，格式与qtlogging.ini相同）、
+// QML设置的规则和按分类设置的最低等级，交给QLoggingCategory::setFilterRules。
+// 配置文件修改后自动重新加载，不需要重启。后面的规则覆盖前面的：配置文件 < rules < 分类等级
+class LogFilter : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString rules READ rules WRITE setRules NOTIFY rulesChanged)
+    Q_PROPERTY(QString configPath READ configPath NOTIFY configPathChanged)
+    Q_PROPERTY(QString effectiveRules READ effectiveRules NOTIFY effectiveRulesChanged)
+
+public:
+    explicit LogFilter(QObject *parent = nullptr);
+
+    // 单例模式访问（QML中注册为单例）
+    static LogFilter* instance();
+
+    // 加载配置文件并监视修改，文件不存在时在创建后加载
+    void load(const QString &configPath);
+
+    QString configPath() const { return m_configPath; }
+
+    // 额外的过滤规则（每行一条，例如"ziyanos.download.debug=true"）
+    QString rules() const { return m_rules; }
+    void setRules(const QString &rules);
+
+    // 当前生效的全部规则
+    QString effectiveRules() const { return m_effectiveRules; }
+
+    // 设置一个分类的最低等级：debug、info、warning、critical或off；空字符串取消设置
+    Q_INVOKABLE bool setCategoryLevel(const QString &category, const QString &level);
+    Q_INVOKABLE QString categoryLevel(const QString &category) const;
+
+    // 各模块的日志分类名称
+    Q_INVOKABLE QStringList categories() const;
+
+    // 重新读取配置文件
+    Q_INVOKABLE void reload();
+
+signals:
+    void rulesChanged();
+    void configPathChanged();
+    void effectiveRulesChanged();
+
+private:
+    // 配置文件改变（编辑器保存时可能先删除再创建，需要重新添加监视）
+    void onFileChanged();
+
+    // 读取配置文件中的[Rules]段
+    static QString readConfigRules(const QString &path);
+
+    // 组合全部规则并应用
+    void apply();
+
+    static LogFilter* m_instance;
+
+    QString m_configPath;
+    QString m_configRules;
+    QString m_rules;
+    QMap<QString, QString> m_categoryLevels;
+    QString m_effectiveRules;
+    QFileSystemWatcher m_watcher;
+};
+
+#endif // LOGFILTER_H
@@ -0,0 +1,349 @@
+#include "LogFormat.h"
+#include <QDateTime>
+#include <QHash>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+#include <pthread.h>
+#endif
+
+// 格式注册表的全部数据（ID从1开始，下标0不使用）
+namespace {
+struct RegistryData {
+    std::mutex mutex;
+    std::vector<LogFormatRegistry::Format> formats = std::vector<LogFormatRegistry::Format>(1);
+    std::vector<QString> categories = { QStringLiteral("default") };
+    QHash<QByteArray, quint16> categoryIds = { { QByteArray("default"), 0 } };
+};
+
+RegistryData &registry()
+{
+    static RegistryData data;
+    return data;
+}
+}
+
+quint16 LogFormatRegistry::registerFormat(QtMsgType level, const char *category, const char *file, int line,
+                                          const char *format)
+{
+    const quint16 categoryIndex = categoryId(category);
+
+    RegistryData &data = registry();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    if (data.formats.size() > 0xFFFF) {
+        return 0;
+    }
+
+    Format entry;
+    entry.level = static_cast<quint8>(level);
+    entry.categoryId = categoryIndex;
+    entry.line = line;
+    entry.file = QByteArray(file ? file : "");
+    entry.format = QString::fromUtf8(format ? format : "");
+    data.formats.push_back(entry);
+    return static_cast<quint16>(data.formats.size() - 1);
+}
+
+bool LogFormatRegistry::format(quint16 id, Format *format)
+{
+    RegistryData &data = registry();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    if (id == 0 || id >= data.formats.size()) {
+        return false;
+    }
+    *format = data.formats[id];
+    return true;
+}
+
+quint16 LogFormatRegistry::categoryId(const char *name)
+{
+    if (!name || !*name) {
+        return 0;
+    }
+    return categoryId(QByteArray::fromRawData(name, static_cast<qsizetype>(strlen(name))));
+}
+
+quint16 LogFormatRegistry::categoryId(const QByteArray &name)
+{
+    if (name.isEmpty()) {
+        return 0;
+    }
+
+    RegistryData &data = registry();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    auto it = data.categoryIds.constFind(name);
+    if (it != data.categoryIds.constEnd()) {
+        return it.value();
+    }
+    if (data.categories.size() > 0xFFFF) {
+        return 0;
+    }
+
+    // 复制一份，调用方可能传入临时数据
+    const QByteArray key(name.constData(), name.size());
+    const quint16 id = static_cast<quint16>(data.categories.size());
+    data.categories.push_back(QString::fromUtf8(key));
+    data.categoryIds.insert(key, id);
+    return id;
+}
+
+QString LogFormatRegistry::categoryName(quint16 id)
+{
+    RegistryData &data = registry();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    return id < data.categories.size() ? data.categories[id] : QString();
+}
+
+quint32 LogFormatRegistry::currentThreadId()
+{
+    thread_local quint32 threadId = 0;
+    if (threadId == 0) {
+#ifdef Q_OS_WIN
+        threadId = static_cast<quint32>(GetCurrentThreadId());
+#elif defined(Q_OS_LINUX)
+        threadId = static_cast<quint32>(syscall(SYS_gettid));
+#elif defined(Q_OS_MACOS)
+        uint64_t id = 0;
+        pthread_threadid_np(nullptr, &id);
+        threadId = static_cast<quint32>(id);
+#else
+        static std::atomic<quint32> nextId(1);
+        threadId = nextId.fetch_add(1);
+#endif
+    }
+    return threadId;
+}
+
+qint64 LogFormatRegistry::currentTimestamp()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void LogArgumentEncoder::addFixed(quint8 type, const void *data, int size)
+{
+    const int used = m_record->argumentSize;
+    if (used + 1 + size > LOG_ARGUMENT_CAPACITY) {
+        return;
+    }
+
+    char *out = m_record->arguments + used;
+    out[0] = static_cast<char>(type);
+    memcpy(out + 1, data, static_cast<size_t>(size));
+    m_record->argumentSize = static_cast<quint8>(used + 1 + size);
+}
+
+void LogArgumentEncoder::addString(quint8 type, const void *data, qsizetype length, int unitSize)
+{
+    const int used = m_record->argumentSize;
+    const int headerSize = 1 + static_cast<int>(sizeof(quint16));
+    const int available = (LOG_ARGUMENT_CAPACITY - used - headerSize) / unitSize;
+    if (available < 0) {
+        return;
+    }
+
+    // 放不下时截断，并用另一个类型标记，解码时加上省略号
+    quint16 count = static_cast<quint16>(qMin<qsizetype>(length, qMin(available, 0xFFFF)));
+    if (count < length) {
+        type = type == LogArgumentString ? LogArgumentStringTruncated : LogArgumentUtf8Truncated;
+
+        // 不在多字节字符（UTF-8后续字节、UTF-16代理对）中间截断
+        if (unitSize == 1) {
+            const unsigned char *bytes = static_cast<const unsigned char *>(data);
+            while (count > 0 && (bytes[count] & 0xC0) == 0x80) {
+                --count;
+            }
+        } else if (count > 0 && QChar::isHighSurrogate(static_cast<const QChar *>(data)[count - 1].unicode())) {
+            --count;
+        }
+    }
+
+    char *out = m_record->arguments + used;
+    out[0] = static_cast<char>(type);
+    memcpy(out + 1, &count, sizeof(count));
+    if (count > 0) {
+        memcpy(out + headerSize, data, static_cast<size_t>(count) * unitSize);
+    }
+    m_record->argumentSize = static_cast<quint8>(used + headerSize + count * unitSize);
+}
+
+QVariantList decodeLogArguments(const char *data, int size)
+{
+    QVariantList arguments;
+    int position = 0;
+
+    while (position < size) {
+        const quint8 type = static_cast<quint8>(data[position++]);
+        switch (type) {
+        case LogArgumentInt:
+        case LogArgumentUInt:
+        case LogArgumentDouble: {
+            if (position + 8 > size) {
+                return arguments;
+            }
+            if (type == LogArgumentInt) {
+                qint64 value;
+                memcpy(&value, data + position, sizeof(value));
+                arguments.append(value);
+            } else if (type == LogArgumentUInt) {
+                quint64 value;
+                memcpy(&value, data + position, sizeof(value));
+                arguments.append(value);
+            } else {
+                double value;
+                memcpy(&value, data + position, sizeof(value));
+                arguments.append(value);
+            }
+            position += 8;
+            break;
+        }
+        case LogArgumentBool:
+            if (position + 1 > size) {
+                return arguments;
+            }
+            arguments.append(data[position] != 0);
+            position += 1;
+            break;
+        case LogArgumentString:
+        case LogArgumentStringTruncated:
+        case LogArgumentUtf8:
+        case LogArgumentUtf8Truncated: {
+            quint16 count;
+            if (position + static_cast<int>(sizeof(count)) > size) {
+                return arguments;
+            }
+            memcpy(&count, data + position, sizeof(count));
+            position += sizeof(count);
+
+            const bool utf16 = type == LogArgumentString || type == LogArgumentStringTruncated;
+            const int bytes = count * (utf16 ? static_cast<int>(sizeof(char16_t)) : 1);
+            if (position + bytes > size) {
+                return arguments;
+            }
+
+            QString value;
+            if (utf16) {
+                value.resize(count);
+                memcpy(value.data(), data + position, static_cast<size_t>(bytes));
+            } else {
+                value = QString::fromUtf8(data + position, bytes);
+            }
+            if (type == LogArgumentStringTruncated || type == LogArgumentUtf8Truncated) {
+                value += QChar(0x2026);
+            }
+            arguments.append(value);
+            position += bytes;
+            break;
+        }
+        default:
+            // 未知类型，后面的数据无法解析
+            return arguments;
+        }
+    }
+    return arguments;
+}
+
+QString formatLogMessage(const QString &format, const QVariantList &arguments)
+{
+    QString result;
+    result.reserve(format.size() + arguments.size() * 8);
+
+    const int length = format.size();
+    int i = 0;
+    while (i < length) {
+        const QChar ch = format.at(i);
+        if (ch != QLatin1Char('%') || i + 1 >= length || !format.at(i + 1).isDigit()) {
+            result.append(ch);
+            ++i;
+            continue;
+        }
+
+        // 最多两位数字：%1 ~ %99
+        int number = format.at(i + 1).digitValue();
+        int end = i + 2;
+        if (end < length && format.at(end).isDigit()) {
+            number = number * 10 + format.at(end).digitValue();
+            ++end;
+        }
+
+        if (number >= 1 && number <= arguments.size()) {
+            const QVariant &argument = arguments.at(number - 1);
+            if (argument.typeId() == QMetaType::Double) {
+                result.append(QString::number(argument.toDouble()));
+            } else {
+                result.append(argument.toString());
+            }
+        } else {
+            result.append(QStringView(format).mid(i, end - i));
+        }
+        i = end;
+    }
+    return result;
+}
+
+void LogLineFormatter::append(QString *text, qint64 timestamp, int level, const QString &label,
+                              const QString &category, const QString &message)
+{
+    text->append(QLatin1Char('['));
+    appendTimestamp(text, timestamp);
+    text->append(QLatin1String("] ["));
+    text->append(label.isEmpty() ? levelName(level) : label);
+    text->append(QLatin1String("] "));
+    if (!category.isEmpty() && category != QLatin1String("default")) {
+        text->append(QLatin1Char('['));
+        text->append(category);
+        text->append(QLatin1String("] "));
+    }
+    text->append(message);
+    text->append(QLatin1Char('\n'));
+}
+
+QString LogLineFormatter::formatTimestamp(qint64 timestamp)
+{
+    QString result;
+    appendTimestamp(&result, timestamp);
+    return result;
+}
+
+void LogLineFormatter::appendTimestamp(QString *text, qint64 timestamp)
+{
+    // 日期和时间只在秒数变化时重新格式化
+    const qint64 nanosecondsPerSecond = 1000000000;
+    qint64 second = timestamp / nanosecondsPerSecond;
+    qint64 remainder = timestamp % nanosecondsPerSecond;
+    if (remainder < 0) {
+        second -= 1;
+        remainder += nanosecondsPerSecond;
+    }
+
+    if (second != m_cachedSecond) {
+        m_cachedSecond = second;
+        m_cachedPrefix = QDateTime::fromSecsSinceEpoch(second).toString("yyyy-MM-dd HH:mm:ss.");
+    }
+
+    const int milliseconds = static_cast<int>(remainder / 1000000);
+    text->append(m_cachedPrefix);
+    text->append(QLatin1Char(static_cast<char>('0' + milliseconds / 100)));
+    text->append(QLatin1Char(static_cast<char>('0' + milliseconds / 10 % 10)));
+    text->append(QLatin1Char(static_cast<char>('0' + milliseconds % 10)));
+}
+
+QString LogLineFormatter::levelName(int level)
+{
+    switch (level) {
+    case QtDebugMsg:    return QStringLiteral("DEBUG");
+    case QtInfoMsg:     return QStringLiteral("INFO");
+    case QtWarningMsg:  return QStringLiteral("WARNING");
+    case QtCriticalMsg: return QStringLiteral("CRITICAL");
+    case QtFatalMsg:    return QStringLiteral("FATAL");
+    default:            return QStringLiteral("UNKNOWN");
+    }
+}
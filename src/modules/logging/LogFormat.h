@@ -0,0 +1,149 @@
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariantList>
+#include <QtGlobal>
+#include <cstring>
+#include <type_traits>
+
+#include "LogRingBuffer.h"
+
+// 结构化日志参数的类型标记（每个参数以一个字节的标记开头）
+enum LogArgumentType : quint8 {
+    LogArgumentInt = 'i',               // qint64
+    LogArgumentUInt = 'u',              // quint64
+    LogArgumentDouble = 'd',            // double
+    LogArgumentBool = 'b',              // quint8
+    LogArgumentString = 's',            // quint16字符数 + UTF-16数据（QString）
+    LogArgumentUtf8 = 'c',              // quint16字节数 + UTF-8数据（const char*、QByteArray）
+    LogArgumentStringTruncated = 'S',   // 同上，缓冲区不足被截断
+    LogArgumentUtf8Truncated = 'C'
+};
+
+// 结构化日志的格式注册表：每个调用位置的格式字符串只注册一次，之后日志中只保存格式ID。
+// 分类名称同样登记为ID，文本日志和二进制文件中只保存ID
+class LogFormatRegistry
+{
+public:
+    // 注册的格式
+    struct Format {
+        quint8 level = 0;               // QtMsgType
+        quint16 categoryId = 0;
+        int line = 0;
+        QByteArray file;
+        QString format;                 // 占位符与QString::arg相同：%1、%2…
+    };
+
+    // 注册格式，返回格式ID（从1开始），注册表已满时返回0
+    static quint16 registerFormat(QtMsgType level, const char *category, const char *file, int line,
+                                  const char *format);
+
+    // 查询格式，ID无效时返回false
+    static bool format(quint16 id, Format *format);
+
+    // 登记分类名称，返回分类ID（0为默认分类"default"）
+    static quint16 categoryId(const char *name);
+    static quint16 categoryId(const QByteArray &name);
+
+    // 分类名称，ID无效时返回空字符串
+    static QString categoryName(quint16 id);
+
+    // 当前系统线程ID（每个线程只查询一次）
+    static quint32 currentThreadId();
+
+    // 当前时间（自纪元起的纳秒数）
+    static qint64 currentTimestamp();
+};
+
+// 把参数按类型编码到LogRecord的内联缓冲区中（产生日志的线程调用，不分配内存）
+class LogArgumentEncoder
+{
+public:
+    explicit LogArgumentEncoder(LogRecord *record) : m_record(record) { m_record->argumentSize = 0; }
+
+    void add(bool value)
+    {
+        const quint8 byte = value ? 1 : 0;
+        addFixed(LogArgumentBool, &byte, sizeof(byte));
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type add(T value)
+    {
+        const qint64 number = value;
+        addFixed(LogArgumentInt, &number, sizeof(number));
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type add(T value)
+    {
+        const quint64 number = value;
+        addFixed(LogArgumentUInt, &number, sizeof(number));
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type add(T value)
+    {
+        add(static_cast<typename std::underlying_type<T>::type>(value));
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type add(T value)
+    {
+        const double number = value;
+        addFixed(LogArgumentDouble, &number, sizeof(number));
+    }
+
+    void add(const QString &value)
+    {
+        addString(LogArgumentString, value.constData(), value.size(), sizeof(QChar));
+    }
+
+    void add(const QByteArray &value)
+    {
+        addString(LogArgumentUtf8, value.constData(), value.size(), 1);
+    }
+
+    void add(const char *value)
+    {
+        addString(LogArgumentUtf8, value, value ? static_cast<qsizetype>(strlen(value)) : 0, 1);
+    }
+
+private:
+    void addFixed(quint8 type, const void *data, int size);
+    void addString(quint8 type, const void *data, qsizetype length, int unitSize);
+
+    LogRecord *m_record;
+};
+
+// 解码参数，字符串参数被截断时以"…"结尾
+QVariantList decodeLogArguments(const char *data, int size);
+
+// 用参数替换格式中的%1、%2…，没有对应参数的占位符保持原样
+QString formatLogMessage(const QString &format, const QVariantList &arguments);
+
+// 格式化文本日志行："[时间] [等级] [分类] 消息"，默认分类不显示。
+// 同一秒内的日志复用已格式化的日期和时间（文本日志写入线程和解码工具共用）
+class LogLineFormatter
+{
+public:
+    // 追加一行（包括换行符），label不为空时代替等级显示
+    void append(QString *text, qint64 timestamp, int level, const QString &label, const QString &category,
+                const QString &message);
+
+    // 时间戳格式化为"yyyy-MM-dd HH:mm:ss.zzz"
+    QString formatTimestamp(qint64 timestamp);
+
+    // 日志等级名称（静态字符串，不分配内存）
+    static QString levelName(int level);
+
+private:
+    void appendTimestamp(QString *text, qint64 timestamp);
+
+    qint64 m_cachedSecond = -1;
+    QString m_cachedPrefix;
+};
+
+#endif // LOGFORMAT_H
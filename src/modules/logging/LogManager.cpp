@@ -1,6 +1,45 @@
 #include "LogManager.h"
+#include "LogCategories.h"
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QMutexLocker>
+#include <chrono>
+
+// 异步队列容量（条）
+static const int LOG_QUEUE_CAPACITY = 8192;
+
+// 写入线程每批最多处理的日志数
+static const int WRITE_BATCH_RECORDS = 1024;
+
+// 写入线程把数据刷新到系统的最长间隔（毫秒）
+static const int FLUSH_INTERVAL_MS = 100;
+
+// flush()等待写入线程的最长时间（毫秒），避免写入线程异常时卡住调用方
+static const int FLUSH_TIMEOUT_MS = 3000;
+
+// 崩溃日志环的默认大小
+static const qint64 CRASH_RING_SIZE = 4LL * 1024 * 1024;
+
+// 崩溃日志环的文件名
+static const char CRASH_RING_FILENAME[] = "crash.ring";
+
+// logMessage信号的发出间隔（毫秒）和每批最多的条数，界面的刷新不随日志量增加
+static const int UI_EMIT_INTERVAL_MS = 100;
+static const size_t UI_BATCH_LIMIT = 50;
+
+// 日志等级的严重程度（QtMsgType的数值不是按严重程度排列的）
+static int logSeverity(int level)
+{
+    switch (level) {
+    case QtDebugMsg:    return 0;
+    case QtInfoMsg:     return 1;
+    case QtWarningMsg:  return 2;
+    case QtCriticalMsg: return 3;
+    case QtFatalMsg:    return 4;
+    default:            return 0;
+    }
+}
 
 // 静态成员初始化
 LogManager* LogManager::m_instance = nullptr;
@@ -10,20 +49,30 @@ QtMessageHandler LogManager::s_originalMessageHandler = nullptr;
 LogManager::LogManager(QObject *parent)
     : QObject(parent)
     , m_initialized(false)
+    , m_asynchronous(true)
+    , m_binaryFormat(false)
+    , m_crashRingSize(CRASH_RING_SIZE)
+    , m_fileLevel(QtDebugMsg)
+    , m_segmentBytes(0)
+    , m_uiOmitted(0)
+    , m_uiTimerActive(false)
+    , m_ring(LOG_QUEUE_CAPACITY)
+    , m_writerThread(nullptr)
+    , m_writerState(WriterRunning)
+    , m_stopping(false)
+    , m_flushRequested(false)
+    , m_droppedCount(0)
+    , m_flushTarget(0)
+    , m_flushedPosition(0)
     , m_qmlEngine(nullptr)
 {
+    m_uiTimer.setInterval(UI_EMIT_INTERVAL_MS);
+    connect(&m_uiTimer, &QTimer::timeout, this, &LogManager::emitUiMessages);
 }
 
 LogManager::~LogManager()
 {
-    uninstallMessageHandler();
-
-    // 关闭日志文件
-    if (m_logFile.isOpen()) {
-        writeToFile("========== 应用程序结束 ==========");
-        m_logStream.flush();
-        m_logFile.close();
-    }
+    shutdown();
 
     m_instance = nullptr;
 }
@@ -41,7 +90,7 @@ LogManager* LogManager::instance()
 
 void LogManager::initialize()
 {
-    if (m_initialized) {
+    if (m_initialized.load()) {
         return;
     }
 
@@ -59,46 +108,86 @@ void LogManager::initialize()
         return;
     }
 
-    // 3. 写入启动日志
+    // 崩溃日志环（打开失败不影响日志文件）
+    if (m_crashRingSize > 0 && !m_crashRing.open(logDirectory() + "/" + CRASH_RING_FILENAME, m_crashRingSize)) {
+        qWarning() << "无法创建崩溃日志环";
+    }
+
+    // 3. 启动分段压缩和清理线程（处理上次运行留下的分段）
+    m_rotator.setActiveFile(m_logFilePath);
+    m_rotator.start(logDirectory(), m_rotationPolicy);
+
+    // 4. 启动写入线程（异步模式，二进制日志也由写入线程编码）
+    if (m_asynchronous || m_binaryFormat) {
+        startWriter();
+    }
+    m_initialized.store(true);
+
+    // 5. 写入启动日志
     writeToFile("========== 应用程序启动 ==========");
     writeToFile("应用程序: " + QCoreApplication::applicationName());
     writeToFile("版本: " + QCoreApplication::applicationVersion());
     writeToFile("启动时间: " + getCurrentTimestamp());
-    writeToFile("日志文件: " + m_logFilePath);
-
-    // 4. 安装消息处理器（捕获qDebug等）
+    writeToFile("日志文件: " + logFilePath());
+    writeToFile(QString("写入模式: %1").arg(m_writerThread.load() ? "异步" : "同步"));
+    writeToFile(QString("崩溃日志环: %1").arg(m_crashRing.isOpen() ? QString("%1KB").arg(m_crashRingSize / 1024) : "关闭"));
+    writeToFile(QString("日志分段: 最大%1KB，总预算%2KB，保留%3天，压缩: %4")
+                    .arg(m_rotationPolicy.maxSegmentSize / 1024)
+                    .arg(m_rotationPolicy.totalBudget / 1024)
+                    .arg(m_rotationPolicy.retentionDays)
+                    .arg(m_rotationPolicy.compress && LogRotator::compressionSupported() ? "zstd" : "无"));
+    const LogStormGuard::Policy stormPolicy = m_stormGuard.policy();
+    writeToFile(QString("风暴抑制: 重复日志折叠%1，分类限速%2")
+                    .arg(stormPolicy.foldWindowMs > 0 ? QString("%1毫秒").arg(stormPolicy.foldWindowMs) : QString("关闭"))
+                    .arg(stormPolicy.categoryRate > 0 ? QString("每秒%1条").arg(stormPolicy.categoryRate) : QString("关闭")));
+
+    // 6. 安装消息处理器（捕获qDebug等）
     installMessageHandler();
 
-    m_initialized = true;
+    // 应用程序退出时写完队列中的日志（单例不会被析构）
+    static bool postRoutineAdded = false;
+    if (!postRoutineAdded) {
+        postRoutineAdded = true;
+        qAddPostRoutine([]() {
+            if (m_instance) {
+                m_instance->shutdown();
+            }
+        });
+    }
 
-    qDebug() << "日志系统初始化完成，日志文件:" << m_logFilePath;
+    qDebug() << "日志系统初始化完成，日志文件:" << logFilePath();
 
     emit initialized();
 }
 
 void LogManager::writeLog(const QString &message, const QString &category)
 {
-    if (!m_initialized) {
+    if (!m_initialized.load()) {
         // 如果日志系统未初始化，使用qDebug输出
         qDebug() << "[" << category << "]" << message;
         return;
     }
 
     QString timestamp = getCurrentTimestamp();
-    QString logEntry = QString("[%1] [%2] %3")
-                           .arg(timestamp)
-                           .arg(category)
-                           .arg(message);
-
-    // 写入文件
-    writeToFile(logEntry);
 
-    // 发出信号（可选，用于UI显示）
-    emit logMessage(message, category, timestamp);
+    // 写入文件，分类显示在等级的位置
+    LogRecord record;
+    record.kind = LogRecord::Text;
+    record.timestamp = LogFormatRegistry::currentTimestamp();
+    record.threadId = LogFormatRegistry::currentThreadId();
+    record.level = QtInfoMsg;
+    record.label = category;
+    record.message = message;
+    writeRecord(record, false);
+
+    // 发出信号（可选，用于UI显示），按固定间隔成批发出
+    queueUiMessage(message, category, timestamp);
 }
 
 QString LogManager::logFilePath() const
 {
+    // 分段切换时会改变
+    std::lock_guard<std::mutex> lock(m_fileMutex);
     return m_logFilePath;
 }
 
@@ -113,11 +202,97 @@ void LogManager::setQmlEngine(QQmlEngine *engine)
     }
 }
 
-bool LogManager::initLogDirectory()
+void LogManager::flush()
+{
+    if (!m_initialized.load()) {
+        return;
+    }
+
+    QThread *writerThread = m_writerThread.load();
+    if (!writerThread) {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        m_logStream.flush();
+        return;
+    }
+
+    // 写入线程自身产生的日志（例如写入失败的警告）不能等待自己
+    if (QThread::currentThread() == writerThread) {
+        return;
+    }
+
+    // 等待写入线程处理到当前位置并刷新文件
+    const quint64 target = m_ring.pushedCount();
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_flushTarget = qMax(m_flushTarget, target);
+    m_flushRequested.store(true);
+    m_wakeCondition.notify_one();
+
+    const bool flushed = m_flushedCondition.wait_for(lock, std::chrono::milliseconds(FLUSH_TIMEOUT_MS), [this, target]() {
+        return m_flushedPosition >= target || m_stopping.load();
+    });
+    if (!flushed) {
+        fprintf(stderr, "警告: 等待日志写入超时\n");
+    }
+}
+
+void LogManager::shutdown()
+{
+    if (!m_initialized.load()) {
+        return;
+    }
+
+    // 之后的消息只输出到原始处理器
+    uninstallMessageHandler();
+
+    // 写入线程退出前会写完队列中的全部日志
+    writeToFile("========== 应用程序结束 ==========");
+    stopWriter();
+    m_initialized.store(false);
+
+    if (m_logFile.isOpen()) {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        m_logStream.flush();
+        m_logFile.close();
+    }
+
+    // 正在压缩的分段保留原文件，下次启动时重新压缩
+    m_rotator.stop();
+
+    // 正常退出，下次启动时不生成崩溃报告
+    m_crashRing.markClean();
+}
+
+QString LogManager::extractCrashReport()
 {
+    const QString logDir = logDirectory();
+    if (!QDir(logDir).exists()) {
+        return QString();
+    }
+
+    const QString reportPath = logDir + "/crash_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".log";
+    int recordCount = 0;
+    if (!LogCrashRing::extractReport(logDir + "/" + CRASH_RING_FILENAME, reportPath, &recordCount)) {
+        return QString();
+    }
+
+    qInfo() << "已从崩溃日志环提取" << recordCount << "条日志:" << reportPath;
+    return reportPath;
+}
+
+QString LogManager::logDirectory() const
+{
+    if (!m_logDirectory.isEmpty()) {
+        return m_logDirectory;
+    }
+
     // 获取应用程序目录
     QString appDir = QCoreApplication::applicationDirPath();
-    QString logDir = appDir + "/logs";
+    return appDir + "/logs";
+}
+
+bool LogManager::initLogDirectory()
+{
+    QString logDir = logDirectory();
 
     QDir dir(logDir);
     if (!dir.exists()) {
@@ -133,28 +308,112 @@ bool LogManager::initLogDirectory()
 
 bool LogManager::initLogFile()
 {
-    // 获取应用程序目录
-    QString appDir = QCoreApplication::applicationDirPath();
-    QString logDir = appDir + "/logs";
+    if (!openSegment()) {
+        qWarning() << "无法打开日志文件:" << m_logFilePath;
+        return false;
+    }
+
+    qDebug() << "日志文件已创建:" << m_logFilePath;
+    return true;
+}
 
-    // 使用当前日期时间作为日志文件名
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
-    m_logFilePath = logDir + "/ziyanos_" + timestamp + ".log";
+bool LogManager::openSegment()
+{
+    QString logDir = logDirectory();
+
+    // 使用当前日期时间作为日志文件名，二进制日志使用.zlog扩展名。
+    // 同一秒内切换分段时加上序号，压缩后的文件（.zst）也不能重名
+    const QString extension = m_binaryFormat ? ".zlog" : ".log";
+    const QString baseName = logDir + "/" + LogRotator::segmentPrefix()
+                             + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    QString path = baseName + extension;
+    for (int index = 1; QFile::exists(path) || QFile::exists(path + ".zst"); ++index) {
+        path = QString("%1_%2%3").arg(baseName).arg(index).arg(extension);
+    }
+    m_logFilePath = path;
 
     // 打开日志文件
+    QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Append;
+    if (!m_binaryFormat) {
+        mode |= QIODevice::Text;
+    }
     m_logFile.setFileName(m_logFilePath);
-    if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        qWarning() << "无法打开日志文件:" << m_logFilePath;
+    if (!m_logFile.open(mode)) {
         return false;
     }
 
+    // 二进制日志：写入文件头，格式和分类在新文件中重新写入
+    if (m_binaryFormat) {
+        m_binaryWriter.reset();
+        if (m_logFile.size() == 0) {
+            m_logFile.write(LogBinaryFormat::fileHeader());
+        }
+    }
+
     // 设置日志流
     m_logStream.setDevice(&m_logFile);
 
-    qDebug() << "日志文件已创建:" << m_logFilePath;
+    m_segmentBytes = m_logFile.size();
+    m_segmentTimer.start();
     return true;
 }
 
+bool LogManager::rotationDue() const
+{
+    if (m_rotationPolicy.maxSegmentSize > 0 && m_segmentBytes >= m_rotationPolicy.maxSegmentSize) {
+        return true;
+    }
+    return m_rotationPolicy.maxSegmentAgeSeconds > 0
+           && m_segmentTimer.elapsed() >= m_rotationPolicy.maxSegmentAgeSeconds * 1000;
+}
+
+void LogManager::rotateSegment()
+{
+    // 这里不能使用qDebug：同步模式下调用方已持有m_fileMutex，消息处理器会再次加锁
+    const QString previousPath = m_logFilePath;
+
+    LogRecord note;
+    note.kind = LogRecord::Raw;
+    note.message = "========== 日志分段结束 ==========";
+    writeRecordDirect(note);
+    m_logStream.flush();
+    m_logFile.close();
+
+    if (!openSegment()) {
+        // 无法创建新分段时继续写入原文件，写满下一个分段大小后再试
+        fprintf(stderr, "警告: 无法创建新的日志分段，继续写入 %s\n", qPrintable(previousPath));
+        m_logFilePath = previousPath;
+        m_logFile.setFileName(previousPath);
+        m_logFile.open(m_binaryFormat ? QIODevice::WriteOnly | QIODevice::Append
+                                      : QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+        m_logStream.setDevice(&m_logFile);
+        m_segmentBytes = 0;
+        m_segmentTimer.restart();
+        return;
+    }
+
+    note.message = "接续日志分段: " + QFileInfo(previousPath).fileName();
+    writeRecordDirect(note);
+
+    // 先更新活动文件，清理时不会删除新分段
+    m_rotator.setActiveFile(m_logFilePath);
+    m_rotator.segmentClosed(previousPath);
+}
+
+void LogManager::writeRecordDirect(const LogRecord &record)
+{
+    QByteArray data;
+    if (m_binaryFormat) {
+        m_binaryWriter.append(record, &data);
+    } else {
+        QString text;
+        formatRecord(record, &m_lineFormatter, &text);
+        data = text.toUtf8();
+    }
+    m_logFile.write(data);
+    m_segmentBytes += data.size();
+}
+
 void LogManager::installMessageHandler()
 {
     // 保存原始的消息处理器
@@ -174,15 +433,8 @@ void LogManager::uninstallMessageHandler()
 void LogManager::qtMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
     // 首先，将消息写入日志文件
-    if (m_instance && m_instance->m_initialized) {
-        QString levelStr = getLogLevelString(type);
-        QString timestamp = getCurrentTimestamp();
-
-        // 构建完整的日志条目
-        QString logEntry = QString("[%1] [%2] %3")
-                               .arg(timestamp)
-                               .arg(levelStr)
-                               .arg(msg);
+    if (m_instance && m_instance->m_initialized.load()) {
+        QString message = msg;
 
 // 添加上下文信息（在调试模式下）
 #ifdef QT_DEBUG
@@ -191,11 +443,35 @@ void LogManager::qtMessageHandler(QtMsgType type, const QMessageLogContext &cont
                                       .arg(context.file)
                                       .arg(context.line)
                                       .arg(context.function);
-            logEntry += contextInfo;
+            message += contextInfo;
         }
 #endif
 
-        m_instance->writeToFile(logEntry);
+        // 只记录时间和内容，异步模式下格式化和写文件都在写入线程中完成
+        LogRecord record;
+        record.kind = LogRecord::Text;
+        record.timestamp = LogFormatRegistry::currentTimestamp();
+        record.threadId = LogFormatRegistry::currentThreadId();
+        record.level = static_cast<quint8>(type);
+        record.message = std::move(message);
+
+        // 分类名称来自QLoggingCategory，指针在程序运行期间不变，每个线程缓存最近一次的查询结果
+        thread_local const char *cachedCategory = nullptr;
+        thread_local quint16 cachedCategoryId = 0;
+        if (context.category != cachedCategory) {
+            cachedCategory = context.category;
+            cachedCategoryId = LogFormatRegistry::categoryId(context.category);
+        }
+        record.categoryId = cachedCategoryId;
+
+        // 调试和信息日志在写入线程产生时可以丢弃，警告以上的日志等待队列空出位置
+        const bool important = type == QtWarningMsg || type == QtCriticalMsg || type == QtFatalMsg;
+        m_instance->writeRecord(record, !important);
+
+        // 致命错误之后进程会立即终止，先把队列中的日志全部写入文件
+        if (type == QtFatalMsg) {
+            m_instance->flush();
+        }
     }
 
     // 然后，将消息传递给原始处理器（输出到控制台）
@@ -252,29 +528,335 @@ void LogManager::handleQmlWarnings(const QList<QQmlError> &warnings)
                       error.line());
 
         // 同时输出到控制台
-        qWarning() << "QML错误:" << errorMessage;
+        qCWarning(lcQml) << "QML错误:" << errorMessage;
     }
 }
 
 void LogManager::writeToFile(const QString &message)
+{
+    LogRecord record;
+    record.kind = LogRecord::Raw;
+    record.message = message;
+    writeRecord(record, false);
+}
+
+void LogManager::writeRecord(LogRecord &record, bool mayDrop)
+{
+    // 先写入崩溃日志环（放入队列会移走记录的内容）
+    m_crashRing.append(record);
+
+    // 低于文件等级的Qt日志只保留在崩溃日志环中（writeLog手动写入的日志不受影响）
+    if (record.kind == LogRecord::Text && record.label.isEmpty()
+        && logSeverity(record.level) < logSeverity(m_fileLevel)) {
+        return;
+    }
+
+    // 只与当前线程比较，不解引用：stopWriter()可能同时在删除写入线程
+    QThread *writerThread = m_writerThread.load();
+    if (!writerThread) {
+        writeRecordSync(record);
+        return;
+    }
+
+    if (m_ring.tryPush(record)) {
+        wakeWriter(false);
+        return;
+    }
+
+    // 队列已满。写入线程自己产生的日志不能等待自己，只能丢弃
+    const bool onWriterThread = QThread::currentThread() == writerThread;
+    if (mayDrop && onWriterThread) {
+        m_droppedCount.fetch_add(1);
+        return;
+    }
+
+    // 其他线程等待写入线程空出位置（背压），不丢失日志
+    while (!m_ring.tryPush(record)) {
+        if (m_stopping.load() || onWriterThread) {
+            m_droppedCount.fetch_add(1);
+            return;
+        }
+        wakeWriter(true);
+        QThread::yieldCurrentThread();
+    }
+    wakeWriter(false);
+}
+
+void LogManager::writeRecordSync(const LogRecord &record)
 {
     std::lock_guard<std::mutex> lock(m_fileMutex);
 
     if (m_logFile.isOpen()) {
-        m_logStream << message << "\n";
+        QString text;
+        QByteArray binary;
+        m_stormGuard.expire(LogFormatRegistry::currentTimestamp(), &m_stormNotices);
+        appendAdmitted(record, &text, &binary);
+        if (text.isEmpty()) {
+            return;
+        }
+        m_logStream << text;
         m_logStream.flush();
+
+        m_segmentBytes = m_logFile.size();
+        if (rotationDue()) {
+            rotateSegment();
+        }
+    }
+}
+
+void LogManager::formatRecord(const LogRecord &record, LogLineFormatter *formatter, QString *text)
+{
+    switch (record.kind) {
+    case LogRecord::Structured: {
+        LogFormatRegistry::Format format;
+        LogFormatRegistry::format(record.formatId, &format);
+        const QVariantList arguments = decodeLogArguments(record.arguments, record.argumentSize);
+        formatter->append(text, record.timestamp, format.level, QString(),
+                          LogFormatRegistry::categoryName(format.categoryId),
+                          formatLogMessage(format.format, arguments));
+        break;
+    }
+    case LogRecord::Text:
+        formatter->append(text, record.timestamp, record.level, record.label,
+                          LogFormatRegistry::categoryName(record.categoryId), record.message);
+        break;
+    default:
+        text->append(record.message);
+        text->append(QLatin1Char('\n'));
+        break;
+    }
+}
+
+void LogManager::startWriter()
+{
+    if (m_writerThread.load()) {
+        return;
+    }
+
+    m_stopping.store(false);
+    m_flushRequested.store(false);
+    m_flushTarget = 0;
+    m_flushedPosition = m_ring.poppedCount();
+
+    QThread *thread = QThread::create([this]() { writerLoop(); });
+    thread->setObjectName("LogWriter");
+    m_writerThread.store(thread);
+    thread->start();
+}
+
+void LogManager::stopWriter()
+{
+    QThread *thread = m_writerThread.load();
+    if (!thread) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopping.store(true);
+        m_wakeCondition.notify_one();
     }
+
+    // 先清空指针再删除：之后其他线程的日志改为同步写入，不会再拿到已删除的线程
+    thread->wait();
+    m_writerThread.store(nullptr);
+    delete thread;
+
+    // 唤醒可能还在等待刷新的线程
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_flushedCondition.notify_all();
 }
 
-QString LogManager::getLogLevelString(QtMsgType type)
+void LogManager::wakeWriter(bool urgent)
 {
-    switch (type) {
-    case QtDebugMsg:    return "DEBUG";
-    case QtInfoMsg:     return "INFO";
-    case QtWarningMsg:  return "WARNING";
-    case QtCriticalMsg: return "CRITICAL";
-    case QtFatalMsg:    return "FATAL";
-    default:            return "UNKNOWN";
+    // 与写入线程设置状态后再检查队列的顺序配对，保证不会漏掉唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int state = m_writerState.load(std::memory_order_relaxed);
+    if (state == WriterRunning) {
+        return;
+    }
+
+    // 写入线程等待定时刷新时，队列积压到四分之一才提前唤醒，减少唤醒次数
+    if (state == WriterTimedWait && !urgent && m_ring.size() < m_ring.capacity() / 4) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_wakeCondition.notify_one();
+}
+
+void LogManager::writerLoop()
+{
+    QString text;
+    QByteArray binary;
+    QElapsedTimer flushTimer;
+    flushTimer.start();
+    bool dirty = false;     // 有写入但还没有刷新的数据
+
+    for (;;) {
+        // 1. 取出一批日志并格式化
+        LogRecord record;
+        int count = 0;
+        while (count < WRITE_BATCH_RECORDS && m_ring.tryPop(&record)) {
+            appendAdmitted(record, &text, &binary);
+            ++count;
+        }
+
+        // 没有新日志时也要报告已结束的折叠窗口和被限速丢弃的条数
+        m_stormGuard.expire(LogFormatRegistry::currentTimestamp(), &m_stormNotices);
+
+        const quint64 dropped = m_droppedCount.exchange(0);
+        if (dropped > 0) {
+            LogRecord notice;
+            notice.kind = LogRecord::Text;
+            notice.timestamp = LogFormatRegistry::currentTimestamp();
+            notice.threadId = LogFormatRegistry::currentThreadId();
+            notice.level = QtWarningMsg;
+            notice.message = QString("日志队列已满，丢弃了%1条日志").arg(dropped);
+            m_stormNotices.push_back(notice);
+        }
+
+        // 退出前报告全部汇总
+        const bool idle = count < WRITE_BATCH_RECORDS;
+        const bool stopping = m_stopping.load();
+        if (idle && stopping) {
+            m_stormGuard.finish(&m_stormNotices);
+        }
+        for (const LogRecord &notice : m_stormNotices) {
+            appendRecord(notice, &text, &binary);
+        }
+        m_stormNotices.clear();
+
+        // 2. 整批写入文件
+        if (!text.isEmpty()) {
+            const QByteArray data = text.toUtf8();
+            m_logFile.write(data);
+            m_segmentBytes += data.size();
+            text.clear();
+            dirty = true;
+        }
+        if (!binary.isEmpty()) {
+            m_logFile.write(binary);
+            m_segmentBytes += binary.size();
+            binary.clear();
+            dirty = true;
+        }
+
+        // 分段切换只关闭和打开文件，压缩和清理由m_rotator在后台完成
+        if (rotationDue()) {
+            std::lock_guard<std::mutex> lock(m_fileMutex);
+            rotateSegment();
+        }
+
+        // 3. 定时刷新，或者有线程在等待刷新
+        if (m_flushRequested.load() || flushTimer.elapsed() >= FLUSH_INTERVAL_MS || (idle && stopping)) {
+            if (dirty) {
+                m_logFile.flush();
+                dirty = false;
+            }
+            flushTimer.restart();
+
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_flushedPosition = m_ring.poppedCount();
+            if (m_flushedPosition >= m_flushTarget) {
+                m_flushRequested.store(false);
+            }
+            m_flushedCondition.notify_all();
+        }
+
+        if (!idle) {
+            continue;
+        }
+
+        // 4. 队列已空：退出，或者等待新日志
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        if (stopping && m_ring.isEmpty()) {
+            break;
+        }
+
+        m_writerState.store(dirty ? WriterTimedWait : WriterParked);
+        if (m_ring.isEmpty() && !m_flushRequested.load() && !m_stopping.load()) {
+            if (dirty) {
+                const qint64 remaining = qMax<qint64>(1, FLUSH_INTERVAL_MS - flushTimer.elapsed());
+                m_wakeCondition.wait_for(lock, std::chrono::milliseconds(remaining));
+            } else if (m_stormGuard.hasPending()) {
+                // 有未报告的重复次数或丢弃条数：新日志仍立即唤醒，否则定时醒来报告
+                m_wakeCondition.wait_for(lock, std::chrono::milliseconds(LogStormGuard::ReportIntervalMs));
+            } else {
+                m_wakeCondition.wait(lock);
+            }
+        }
+        m_writerState.store(WriterRunning);
+    }
+}
+
+void LogManager::appendAdmitted(const LogRecord &record, QString *text, QByteArray *binary)
+{
+    const bool admitted = m_stormGuard.admit(record, &m_stormNotices);
+    for (const LogRecord &notice : m_stormNotices) {
+        appendRecord(notice, text, binary);
+    }
+    m_stormNotices.clear();
+
+    if (admitted) {
+        appendRecord(record, text, binary);
+    }
+}
+
+void LogManager::appendRecord(const LogRecord &record, QString *text, QByteArray *binary)
+{
+    if (m_binaryFormat) {
+        m_binaryWriter.append(record, binary);
+    } else {
+        formatRecord(record, &m_lineFormatter, text);
+    }
+}
+
+void LogManager::queueUiMessage(const QString &message, const QString &category, const QString &timestamp)
+{
+    bool startTimer = false;
+    {
+        std::lock_guard<std::mutex> lock(m_uiMutex);
+        // 只保留最新的一批
+        if (m_uiPending.size() >= UI_BATCH_LIMIT) {
+            m_uiPending.pop_front();
+            ++m_uiOmitted;
+        }
+        m_uiPending.push_back({ message, category, timestamp });
+        if (!m_uiTimerActive) {
+            m_uiTimerActive = true;
+            startTimer = true;
+        }
+    }
+
+    // 定时器属于LogManager所在的线程，其他线程调用时排队启动
+    if (startTimer) {
+        QMetaObject::invokeMethod(this, [this]() { m_uiTimer.start(); });
+    }
+}
+
+void LogManager::emitUiMessages()
+{
+    std::deque<UiMessage> messages;
+    quint64 omitted = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_uiMutex);
+        if (m_uiPending.empty()) {
+            // 没有新日志时停止定时器，下一条日志再启动
+            m_uiTimerActive = false;
+            m_uiTimer.stop();
+            return;
+        }
+        messages.swap(m_uiPending);
+        omitted = m_uiOmitted;
+        m_uiOmitted = 0;
+    }
+
+    if (omitted > 0) {
+        emit logMessage(QString("日志过多，省略了%1条").arg(omitted), "LOG", getCurrentTimestamp());
+    }
+    for (const UiMessage &uiMessage : messages) {
+        emit logMessage(uiMessage.message, uiMessage.category, uiMessage.timestamp);
     }
 }
 
@@ -7,11 +7,44 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
 #include <QMutex>
 #include <QQmlEngine>
 #include <QQmlError>
-#include <iostream>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <vector>
+
+#include "LogRingBuffer.h"
+#include "LogFormat.h"
+#include "LogBinaryFormat.h"
+#include "LogRotator.h"
+#include "LogCrashRing.h"
+#include "LogStormGuard.h"
+
+// 结构化日志：格式字符串在每个调用位置只注册一次，记录中只保存格式ID、时间戳、线程ID和原始参数，
+// 格式化推迟到写入线程（文本日志）或解码工具（二进制日志）。占位符与QString::arg相同（%1、%2…），
+// 参数支持整数、浮点数、bool、QString、QByteArray和const char*。例如：
+//   ZLOG_DEBUG("download", "任务%1已下载%2字节", taskId, bytes);
+// 分类同样受LogFilter的过滤规则控制，被过滤的等级不会编码参数
+#define ZLOG_RECORD(level, category, format, ...) \
+    do { \
+        static const QLoggingCategory zlogCategory(category); \
+        if (zlogCategory.isEnabled(level)) { \
+            static const quint16 zlogFormatId = LogFormatRegistry::registerFormat(level, category, __FILE__, __LINE__, format); \
+            LogManager::logStructured(zlogFormatId, ##__VA_ARGS__); \
+        } \
+    } while (false)
+
+#define ZLOG_DEBUG(category, format, ...) ZLOG_RECORD(QtDebugMsg, category, format, ##__VA_ARGS__)
+#define ZLOG_INFO(category, format, ...) ZLOG_RECORD(QtInfoMsg, category, format, ##__VA_ARGS__)
+#define ZLOG_WARNING(category, format, ...) ZLOG_RECORD(QtWarningMsg, category, format, ##__VA_ARGS__)
+#define ZLOG_CRITICAL(category, format, ...) ZLOG_RECORD(QtCriticalMsg, category, format, ##__VA_ARGS__)
 
 class LogManager : public QObject
 {
@@ -29,7 +62,7 @@ public:
     Q_INVOKABLE void initialize();
 
     // 获取是否已初始化
-    bool isInitialized() const { return m_initialized; }
+    bool isInitialized() const { return m_initialized.load(); }
 
     // 手动写入日志
     Q_INVOKABLE void writeLog(const QString &message, const QString &category = "INFO");
@@ -40,8 +73,71 @@ public:
     // 设置 QML 引擎以捕获 QML 错误
     Q_INVOKABLE void setQmlEngine(QQmlEngine *engine);
 
+    // 把已产生的日志全部写入文件后返回（异步模式下等待写入线程）
+    Q_INVOKABLE void flush();
+
+    // 停止写入线程、写入结束标记并关闭日志文件（应用程序退出时自动调用）
+    void shutdown();
+
+    // 异步模式（默认）：产生日志的线程只把记录放入无锁队列，由写入线程批量格式化和写入；
+    // 关闭时每条日志都在调用线程中加锁写入并刷新。需要在initialize()之前设置
+    bool isAsynchronous() const { return m_asynchronous; }
+    void setAsynchronous(bool asynchronous) { m_asynchronous = asynchronous; }
+
+    // 日志目录，默认是程序目录下的logs（需要在initialize()之前设置）
+    QString logDirectory() const;
+    void setLogDirectory(const QString &directory) { m_logDirectory = directory; }
+
+    // 二进制结构化日志（.zlog，用ZiyanLogDecoder转换为文本或JSON），需要在initialize()之前设置。
+    // 二进制日志总是由写入线程写入
+    bool isBinaryFormat() const { return m_binaryFormat; }
+    void setBinaryFormat(bool binary) { m_binaryFormat = binary; }
+
+    // 日志分段策略：当前分段超过大小或写入时间后切换到新文件，旧分段在后台线程压缩，
+    // 并按总大小预算和保留天数清理。需要在initialize()之前设置
+    LogRotator::Policy rotationPolicy() const { return m_rotationPolicy; }
+    void setRotationPolicy(const LogRotator::Policy &policy) { m_rotationPolicy = policy; }
+
+    // 崩溃日志环的大小（字节）：最近的日志同时写入内存映射文件logs/crash.ring，只是内存写入，
+    // 进程异常退出后仍保留在文件中。0表示关闭，需要在initialize()之前设置
+    qint64 crashRingSize() const { return m_crashRingSize; }
+    void setCrashRingSize(qint64 bytes) { m_crashRingSize = bytes; }
+
+    // 写入日志文件的最低等级：更低等级的Qt日志只进入崩溃日志环，异常退出后才会出现在崩溃报告中
+    QtMsgType fileLevel() const { return m_fileLevel; }
+    void setFileLevel(QtMsgType level) { m_fileLevel = level; }
+
+    // 日志风暴抑制：折叠窗口内的重复日志只写入一次并补记重复次数，每个分类按令牌桶限速。
+    // 只影响日志文件（崩溃日志环仍记录全部日志），需要在initialize()之前设置
+    LogStormGuard::Policy stormPolicy() const { return m_stormGuard.policy(); }
+    void setStormPolicy(const LogStormGuard::Policy &policy) { m_stormGuard.setPolicy(policy); }
+
+    // 提取上次异常退出时崩溃日志环中的日志，生成logs/crash_时间.log，返回报告路径（没有可提取的内容时为空）。
+    // 需要在initialize()之前调用，初始化会清空崩溃日志环
+    QString extractCrashReport();
+
+    // 写入一条结构化日志（由ZLOG_*宏调用），只编码参数并放入队列
+    template<typename... Args>
+    static void logStructured(quint16 formatId, const Args &...args)
+    {
+        LogManager *manager = m_instance;
+        if (!manager || !manager->m_initialized.load()) {
+            return;
+        }
+
+        LogRecord record;
+        record.kind = LogRecord::Structured;
+        record.timestamp = LogFormatRegistry::currentTimestamp();
+        record.threadId = LogFormatRegistry::currentThreadId();
+        record.formatId = formatId;
+        LogArgumentEncoder encoder(&record);
+        (encoder.add(args), ...);
+        manager->writeRecord(record, false);
+    }
+
 signals:
     void initialized();
+    // writeLog写入的日志，按固定间隔成批发出，日志过多时只发出每批最新的一部分
     void logMessage(const QString &message, const QString &category, const QString &timestamp);
     void qmlError(const QString &errorMessage, const QString &url, int line);
 
@@ -52,6 +148,18 @@ private:
     // 初始化日志文件
     bool initLogFile();
 
+    // 打开一个新的日志分段（调用方持有日志文件：写入线程，或者m_fileMutex）
+    bool openSegment();
+
+    // 当前分段是否已超过大小或写入时间
+    bool rotationDue() const;
+
+    // 关闭当前分段并切换到新分段，旧分段交给m_rotator压缩和清理（调用方持有m_fileMutex）
+    void rotateSegment();
+
+    // 把一条记录直接写入当前分段（调用方持有日志文件）
+    void writeRecordDirect(const LogRecord &record);
+
     // 安装消息处理器
     void installMessageHandler();
 
@@ -64,11 +172,36 @@ private:
     // QML警告处理器
     void handleQmlWarnings(const QList<QQmlError> &warnings);
 
-    // 写入日志到文件（线程安全）
+    // 写入日志到文件（线程安全），message按原样写入一行
     void writeToFile(const QString &message);
 
-    // 获取日志等级字符串
-    static QString getLogLevelString(QtMsgType type);
+    // 写入一条记录：异步模式下放入队列，mayDrop表示写入线程自身产生的这条日志在队列满时可以丢弃；
+    // 同步模式下在调用线程中格式化、写入并刷新
+    void writeRecord(LogRecord &record, bool mayDrop);
+    void writeRecordSync(const LogRecord &record);
+
+    // 格式化一条日志，追加到text末尾（写入线程调用，同步模式下在调用线程中加锁调用）
+    void formatRecord(const LogRecord &record, LogLineFormatter *formatter, QString *text);
+
+    // 启动和停止写入线程
+    void startWriter();
+    void stopWriter();
+
+    // 写入线程主循环
+    void writerLoop();
+
+    // 经过风暴抑制后把一条记录追加到text（二进制日志为binary），需要先写入的汇总记录一起追加（调用方持有日志文件）
+    void appendAdmitted(const LogRecord &record, QString *text, QByteArray *binary);
+    void appendRecord(const LogRecord &record, QString *text, QByteArray *binary);
+
+    // 把一条writeLog日志放入界面队列
+    void queueUiMessage(const QString &message, const QString &category, const QString &timestamp);
+
+    // 定时发出界面队列中的日志
+    void emitUiMessages();
+
+    // 队列中有新日志时唤醒写入线程，urgent为true时不等待定时刷新
+    void wakeWriter(bool urgent);
 
     // 获取当前时间字符串
     static QString getCurrentTimestamp();
@@ -80,7 +213,61 @@ private:
     QFile m_logFile;
     QTextStream m_logStream;
     QString m_logFilePath;
-    bool m_initialized;
+    QString m_logDirectory;
+    std::atomic<bool> m_initialized;    // 其他线程中的日志调用也会读取
+    bool m_asynchronous;
+    bool m_binaryFormat;
+
+    // 崩溃日志环
+    LogCrashRing m_crashRing;
+    qint64 m_crashRingSize;
+    QtMsgType m_fileLevel;
+
+    // 日志分段
+    LogRotator::Policy m_rotationPolicy;
+    LogRotator m_rotator;
+    qint64 m_segmentBytes;              // 当前分段已写入的字节数
+    QElapsedTimer m_segmentTimer;       // 当前分段的写入时间
+
+    // 日志风暴抑制（写入线程使用，同步模式下在m_fileMutex内使用）
+    LogStormGuard m_stormGuard;
+    std::vector<LogRecord> m_stormNotices;
+
+    // 发往界面的日志（logMessage信号）
+    struct UiMessage {
+        QString message;
+        QString category;
+        QString timestamp;
+    };
+    std::mutex m_uiMutex;
+    std::deque<UiMessage> m_uiPending;
+    quint64 m_uiOmitted;                // 队列满时省略的条数
+    bool m_uiTimerActive;
+    QTimer m_uiTimer;
+
+    // 写入线程的状态
+    enum WriterState {
+        WriterRunning,      // 正在处理队列
+        WriterTimedWait,    // 有未刷新的数据，等待定时刷新（队列积压较多时才需要唤醒）
+        WriterParked        // 没有待处理的数据，等待新日志
+    };
+
+    // 异步写入
+    LogRingBuffer m_ring;
+    std::atomic<QThread *> m_writerThread;  // 其他线程只比较是否为写入线程，不解引用
+    std::atomic<int> m_writerState;
+    std::atomic<bool> m_stopping;
+    std::atomic<bool> m_flushRequested;
+    std::atomic<quint64> m_droppedCount;    // 队列满时丢弃的日志数（只在写入线程自身产生日志时发生）
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;    // 唤醒写入线程
+    std::condition_variable m_flushedCondition; // 写入线程完成一次刷新
+    quint64 m_flushTarget;              // 等待刷新的最大队列位置（在m_wakeMutex内访问）
+    quint64 m_flushedPosition;          // 已写入并刷新的队列位置（在m_wakeMutex内访问）
+
+    // 写入线程使用的格式化和编码状态
+    LogLineFormatter m_lineFormatter;
+    LogBinaryWriter m_binaryWriter;
 
     // QML引擎指针
     QQmlEngine *m_qmlEngine;
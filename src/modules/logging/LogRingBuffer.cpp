@@ -0,0 +1,78 @@
+#include "LogRingBuffer.h"
+#include <utility>
+
+LogRingBuffer::LogRingBuffer(int capacity)
+    : m_mask(0)
+    , m_enqueuePosition(0)
+    , m_dequeuePosition(0)
+{
+    quint64 size = 2;
+    while (size < static_cast<quint64>(qMax(capacity, 2))) {
+        size <<= 1;
+    }
+    m_mask = size - 1;
+
+    // 槽位的初始序号等于它第一次被写入时的位置
+    m_slots.reset(new Slot[size]);
+    for (quint64 i = 0; i < size; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+LogRingBuffer::~LogRingBuffer()
+{
+}
+
+bool LogRingBuffer::tryPush(LogRecord &record)
+{
+    quint64 position = m_enqueuePosition.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+
+    for (;;) {
+        slot = &m_slots[position & m_mask];
+        const quint64 sequence = slot->sequence.load(std::memory_order_acquire);
+        const qint64 difference = static_cast<qint64>(sequence - position);
+
+        if (difference == 0) {
+            // 槽位空闲，尝试占用这个位置
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // 槽位还没被消费者取走：队列已满
+            return false;
+        } else {
+            // 其他生产者已占用，重新读取位置
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->record = std::move(record);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRingBuffer::tryPop(LogRecord *record)
+{
+    const quint64 position = m_dequeuePosition.load(std::memory_order_relaxed);
+    Slot &slot = m_slots[position & m_mask];
+    const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+
+    // 生产者还没有发布这个位置
+    if (static_cast<qint64>(sequence - (position + 1)) < 0) {
+        return false;
+    }
+
+    // 取出后清空槽位，不让已写出的字符串一直占用内存
+    *record = std::exchange(slot.record, LogRecord());
+    slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+    m_dequeuePosition.store(position + 1, std::memory_order_seq_cst);
+    return true;
+}
+
+int LogRingBuffer::size() const
+{
+    const quint64 dequeue = m_dequeuePosition.load(std::memory_order_seq_cst);
+    const quint64 enqueue = m_enqueuePosition.load(std::memory_order_seq_cst);
+    return enqueue > dequeue ? static_cast<int>(enqueue - dequeue) : 0;
+}
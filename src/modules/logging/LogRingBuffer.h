@@ -0,0 +1,76 @@
+#ifndef LOGRINGBUFFER_H
+#define LOGRINGBUFFER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// 结构化日志参数的内联缓冲区大小（字节），放不下的字符串参数会被截断
+static const int LOG_ARGUMENT_CAPACITY = 112;
+
+// 一条待写入的日志（由产生日志的线程填写，写入线程格式化）
+struct LogRecord {
+    // 记录类型
+    enum Kind : quint8 {
+        Raw,                    // message按原样写入一行（启动和结束标记）
+        Text,                   // Qt消息或writeLog的文本日志
+        Structured              // 预注册的格式ID + 原始参数，格式化推迟到写入线程或解码工具
+    };
+
+    qint64 timestamp = 0;       // 产生时间（自纪元起的纳秒数），格式化在写入线程中完成
+    quint32 threadId = 0;       // 产生日志的系统线程ID
+    quint16 formatId = 0;       // 结构化日志的格式ID（LogFormatRegistry）
+    quint16 categoryId = 0;     // 文本日志的分类ID（LogFormatRegistry），0为默认分类
+    quint8 kind = Raw;
+    quint8 level = 0;           // QtMsgType
+    quint8 argumentSize = 0;    // arguments中已使用的字节数
+    QString label;              // 文本日志中代替等级显示的名称（writeLog的分类）
+    QString message;
+    char arguments[LOG_ARGUMENT_CAPACITY];  // 结构化日志的参数（LogArgumentEncoder编码）
+};
+
+// 多生产者、单消费者的无锁环形队列（固定容量）：
+// 每个槽位带一个序号，生产者用CAS占用写入位置后填充槽位，再发布序号；
+// 消费者（日志写入线程）按顺序取出，不需要任何锁。
+class LogRingBuffer
+{
+public:
+    // capacity会向上取整到2的幂
+    explicit LogRingBuffer(int capacity);
+    ~LogRingBuffer();
+
+    // 生产者调用：放入一条日志，队列已满时返回false（record保持不变）
+    bool tryPush(LogRecord &record);
+
+    // 消费者调用：取出一条日志，没有已发布的日志时返回false
+    bool tryPop(LogRecord *record);
+
+    // 已占用的写入位置总数（包括正在填充的槽位），用于等待刷新
+    quint64 pushedCount() const { return m_enqueuePosition.load(std::memory_order_seq_cst); }
+
+    // 已取出的日志总数
+    quint64 poppedCount() const { return m_dequeuePosition.load(std::memory_order_seq_cst); }
+
+    // 队列中的日志数（近似值）
+    int size() const;
+
+    bool isEmpty() const { return size() == 0; }
+
+    int capacity() const { return static_cast<int>(m_mask + 1); }
+
+private:
+    struct Slot {
+        std::atomic<quint64> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    quint64 m_mask;
+
+    // 生产者和消费者的位置放在不同的缓存行上，避免伪共享
+    alignas(64) std::atomic<quint64> m_enqueuePosition;
+    alignas(64) std::atomic<quint64> m_dequeuePosition;
+};
+
+#endif // LOGRINGBUFFER_H
@@ -0,0 +1,286 @@
+#include "LogRotator.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+
+#ifdef ZIYANOS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// 压缩时每次读取的字节数
+static const qint64 COMPRESS_CHUNK_SIZE = 256 * 1024;
+
+// zstd压缩级别（日志文本压缩率已经很高，优先速度）
+static const int COMPRESS_LEVEL = 3;
+
+// 压缩中的临时文件后缀
+static const char COMPRESS_TEMP_SUFFIX[] = ".tmp";
+
+LogRotator::LogRotator()
+    : m_pruneRequested(false)
+    , m_stopping(false)
+    , m_thread(nullptr)
+{
+}
+
+LogRotator::~LogRotator()
+{
+    stop();
+}
+
+void LogRotator::start(const QString &directory, const Policy &policy)
+{
+    if (m_thread) {
+        return;
+    }
+
+    m_directory = directory;
+    m_policy = policy;
+    m_stopping.store(false);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.clear();
+
+        // 上次运行留下的未压缩分段（包括上次的活动文件）
+        if (m_policy.compress && compressionSupported()) {
+            const QStringList filters = {
+                QString(segmentPrefix()) + "*.log",
+                QString(segmentPrefix()) + "*.zlog"
+            };
+            const QFileInfoList files = QDir(m_directory).entryInfoList(filters, QDir::Files, QDir::Time | QDir::Reversed);
+            for (const QFileInfo &info : files) {
+                if (info.absoluteFilePath() != QFileInfo(m_activeFile).absoluteFilePath()) {
+                    m_pending.push_back(info.absoluteFilePath());
+                }
+            }
+        }
+        m_pruneRequested = true;
+    }
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("LogRotator");
+    m_thread->start(QThread::LowestPriority);
+}
+
+void LogRotator::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping.store(true);
+    }
+    m_condition.notify_all();
+
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+void LogRotator::setActiveFile(const QString &path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_activeFile = path;
+}
+
+void LogRotator::segmentClosed(const QString &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_policy.compress && compressionSupported()) {
+            m_pending.push_back(path);
+        }
+        m_pruneRequested = true;
+    }
+    m_condition.notify_one();
+}
+
+bool LogRotator::compressionSupported()
+{
+#ifdef ZIYANOS_HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+void LogRotator::run()
+{
+    for (;;) {
+        QString path;
+        bool prune = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() {
+                return m_stopping.load() || !m_pending.empty() || m_pruneRequested;
+            });
+            if (m_stopping.load()) {
+                return;
+            }
+
+            if (!m_pending.empty()) {
+                path = m_pending.front();
+                m_pending.pop_front();
+            } else {
+                // 压缩队列处理完后再清理，按压缩后的大小计算预算
+                prune = m_pruneRequested;
+                m_pruneRequested = false;
+            }
+        }
+
+        if (!path.isEmpty()) {
+            compressSegment(path);
+        } else if (prune) {
+            this->prune();
+        }
+    }
+}
+
+bool LogRotator::compressSegment(const QString &path)
+{
+#ifdef ZIYANOS_HAVE_ZSTD
+    QFile source(path);
+    if (!source.exists()) {
+        // 已被清理
+        return false;
+    }
+    if (!source.open(QIODevice::ReadOnly)) {
+        qWarning() << "无法打开日志分段进行压缩:" << path;
+        return false;
+    }
+
+    const QString targetPath = path + ".zst";
+    const QString tempPath = targetPath + COMPRESS_TEMP_SUFFIX;
+    QFile target(tempPath);
+    if (!target.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "无法创建压缩文件:" << tempPath;
+        return false;
+    }
+
+    ZSTD_CCtx *context = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, COMPRESS_LEVEL);
+    ZSTD_CCtx_setParameter(context, ZSTD_c_checksumFlag, 1);
+    ZSTD_CCtx_setPledgedSrcSize(context, static_cast<unsigned long long>(source.size()));
+
+    QByteArray output(static_cast<qsizetype>(ZSTD_CStreamOutSize()), Qt::Uninitialized);
+    bool ok = true;
+    bool finished = false;
+
+    while (ok && !finished) {
+        // 退出时放弃压缩，保留原文件
+        if (m_stopping.load()) {
+            ok = false;
+            break;
+        }
+
+        const QByteArray chunk = source.read(COMPRESS_CHUNK_SIZE);
+        const bool last = source.atEnd() || chunk.isEmpty();
+        ZSTD_inBuffer input = { chunk.constData(), static_cast<size_t>(chunk.size()), 0 };
+
+        // 最后一块需要一直调用到返回0（帧已完整输出）
+        for (;;) {
+            ZSTD_outBuffer out = { output.data(), static_cast<size_t>(output.size()), 0 };
+            const size_t remaining = ZSTD_compressStream2(context, &out, &input, last ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError(remaining)) {
+                qWarning() << "压缩日志分段失败:" << path << ZSTD_getErrorName(remaining);
+                ok = false;
+                break;
+            }
+            if (out.pos > 0 && target.write(output.constData(), static_cast<qint64>(out.pos)) != static_cast<qint64>(out.pos)) {
+                qWarning() << "写入压缩文件失败:" << tempPath;
+                ok = false;
+                break;
+            }
+            if (last ? remaining == 0 : input.pos == input.size) {
+                break;
+            }
+        }
+        finished = last;
+    }
+
+    ZSTD_freeCCtx(context);
+    source.close();
+    target.close();
+
+    if (!ok) {
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    // 压缩文件保留原分段的修改时间，清理时按时间排序仍然正确
+    const QDateTime modified = QFileInfo(path).lastModified();
+    QFile::remove(targetPath);
+    if (!QFile::rename(tempPath, targetPath)) {
+        QFile::remove(tempPath);
+        return false;
+    }
+    QFile compressed(targetPath);
+    if (compressed.open(QIODevice::ReadWrite)) {
+        compressed.setFileTime(modified, QFileDevice::FileModificationTime);
+    }
+    QFile::remove(path);
+    return true;
+#else
+    Q_UNUSED(path);
+    return false;
+#endif
+}
+
+void LogRotator::prune()
+{
+    QString activeFile;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        activeFile = QFileInfo(m_activeFile).absoluteFilePath();
+    }
+
+    QDir dir(m_directory);
+
+    // 上次压缩中断留下的临时文件
+    const QFileInfoList staleFiles = dir.entryInfoList({ QString(segmentPrefix()) + "*" + COMPRESS_TEMP_SUFFIX }, QDir::Files);
+    for (const QFileInfo &info : staleFiles) {
+        QFile::remove(info.absoluteFilePath());
+    }
+
+    // 按修改时间从旧到新
+    const QStringList filters = {
+        QString(segmentPrefix()) + "*.log",
+        QString(segmentPrefix()) + "*.zlog",
+        QString(segmentPrefix()) + "*.zst"
+    };
+    QFileInfoList files = dir.entryInfoList(filters, QDir::Files, QDir::Time | QDir::Reversed);
+
+    const QDateTime expireTime = QDateTime::currentDateTime().addDays(-m_policy.retentionDays);
+    qint64 totalSize = 0;
+    for (const QFileInfo &info : files) {
+        totalSize += info.size();
+    }
+
+    int removed = 0;
+    for (const QFileInfo &info : files) {
+        if (info.absoluteFilePath() == activeFile) {
+            continue;
+        }
+
+        const bool expired = m_policy.retentionDays > 0 && info.lastModified() < expireTime;
+        const bool overBudget = m_policy.totalBudget > 0 && totalSize > m_policy.totalBudget;
+        if (!expired && !overBudget) {
+            continue;
+        }
+
+        if (QFile::remove(info.absoluteFilePath())) {
+            totalSize -= info.size();
+            removed++;
+        }
+    }
+
+    if (removed > 0) {
+        qDebug() << "已清理旧日志分段:" << removed << "个，日志目录当前大小:" << totalSize;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef LOGROTATOR_H
+#define LOGROTATOR_H
+
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// 日志分段的后台维护：在低优先级线程中压缩已关闭的分段（zstd，编译时找到时）并清理旧分段，
+// 使日志目录的总大小不超过预算。写入线程只负责切换分段，从不等待压缩和删除。
+class LogRotator
+{
+public:
+    // 分段和清理策略（数值为0时不限制）
+    struct Policy {
+        qint64 maxSegmentSize = 8LL * 1024 * 1024;  // 单个分段的最大字节数
+        qint64 maxSegmentAgeSeconds = 24 * 3600;    // 单个分段最长写入时间
+        qint64 totalBudget = 64LL * 1024 * 1024;    // 日志目录中全部分段的总大小上限
+        int retentionDays = 14;                     // 超过这个天数的分段直接删除
+        bool compress = true;                       // 压缩已关闭的分段
+    };
+
+    LogRotator();
+    ~LogRotator();
+
+    // 启动后台线程，同时处理上次运行留下的未压缩分段
+    void start(const QString &directory, const Policy &policy);
+
+    // 停止后台线程：正在压缩的分段保留原文件，下次启动时重新处理
+    void stop();
+
+    // 当前正在写入的分段（不会被压缩和删除）
+    void setActiveFile(const QString &path);
+
+    // 一个分段已关闭：压缩后按预算清理（只放入队列，立即返回）
+    void segmentClosed(const QString &path);
+
+    // 是否支持压缩（编译时找到zstd）
+    static bool compressionSupported();
+
+    // 日志分段文件名前缀
+    static const char *segmentPrefix() { return "ziyanos_"; }
+
+private:
+    // 后台线程主循环
+    void run();
+
+    // 压缩一个分段，成功后删除原文件
+    bool compressSegment(const QString &path);
+
+    // 删除过期分段，并从最旧的分段开始删除直到总大小不超过预算
+    void prune();
+
+    QString m_directory;
+    Policy m_policy;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<QString> m_pending;      // 等待压缩的分段
+    bool m_pruneRequested;
+    QString m_activeFile;
+    std::atomic<bool> m_stopping;
+
+    QThread *m_thread;
+};
+
+#endif // LOGROTATOR_H
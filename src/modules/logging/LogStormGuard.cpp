@@ -0,0 +1,261 @@
+#include "LogStormGuard.h"
+#include "LogFormat.h"
+
+// 折叠表的项数（2的幂）
+static const int FOLD_SLOT_COUNT = 256;
+
+// 汇总中引用的原日志内容的最大长度
+static const int NOTICE_PREVIEW_LENGTH = 200;
+
+static const qint64 NANOSECONDS_PER_MILLISECOND = 1000000;
+
+// FNV-1a
+static quint64 hashBytes(quint64 hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+LogStormGuard::LogStormGuard()
+    : m_slots(FOLD_SLOT_COUNT)
+    , m_pendingCount(0)
+    , m_lastExpire(0)
+{
+}
+
+void LogStormGuard::setPolicy(const Policy &policy)
+{
+    m_policy = policy;
+}
+
+bool LogStormGuard::admit(const LogRecord &record, std::vector<LogRecord> *notices)
+{
+    // 标记行（启动、结束）之前先报告全部汇总，汇总不会出现在结束标记之后
+    if (record.kind == LogRecord::Raw) {
+        if (m_pendingCount > 0) {
+            finish(notices);
+        }
+        return true;
+    }
+
+    quint8 level = 0;
+    quint16 categoryId = 0;
+    resolve(record, &level, &categoryId);
+    if (level == QtFatalMsg) {
+        return true;
+    }
+
+    const qint64 now = record.timestamp;
+
+    // 1. 折叠窗口内的重复日志只计数
+    FoldSlot *slot = nullptr;
+    quint64 hash = 0;
+    if (m_policy.foldWindowMs > 0) {
+        hash = hashRecord(record);
+        slot = &m_slots[hash & (FOLD_SLOT_COUNT - 1)];
+        if (slot->used && slot->hash == hash
+            && now - slot->windowStart < m_policy.foldWindowMs * NANOSECONDS_PER_MILLISECOND) {
+            if (slot->count == 0) {
+                ++m_pendingCount;
+            }
+            ++slot->count;
+            slot->lastSeen = now;
+            return false;
+        }
+    }
+
+    // 2. 分类限速（严重日志不限速）
+    if (m_policy.categoryRate > 0 && level != QtCriticalMsg) {
+        if (categoryId >= m_buckets.size()) {
+            m_buckets.resize(static_cast<size_t>(categoryId) + 1);
+        }
+        Bucket &bucket = m_buckets[categoryId];
+        const double burst = qMax(m_policy.categoryBurst, 1);
+        if (!bucket.started) {
+            bucket.started = true;
+            bucket.tokens = burst;
+            bucket.lastRefill = now;
+        }
+        // 不同线程的时间戳可能略有先后
+        const qint64 elapsed = qMax<qint64>(0, now - bucket.lastRefill);
+        bucket.tokens = qMin(burst, bucket.tokens + elapsed * 1e-9 * m_policy.categoryRate);
+        bucket.lastRefill = qMax(bucket.lastRefill, now);
+
+        if (bucket.tokens < 1.0) {
+            if (bucket.dropped == 0) {
+                ++m_pendingCount;
+                bucket.firstDrop = now;
+            }
+            ++bucket.dropped;
+            return false;
+        }
+        bucket.tokens -= 1.0;
+
+        // 恢复写入：先报告之前丢弃的条数
+        if (bucket.dropped > 0) {
+            reportBucket(categoryId, bucket, now, notices);
+        }
+    }
+
+    // 3. 新的日志（或上一个窗口已结束）开始新的折叠窗口，旧窗口的重复次数先报告
+    if (slot) {
+        if (slot->used && slot->count > 0) {
+            reportSlot(*slot, notices);
+        }
+        slot->hash = hash;
+        slot->windowStart = now;
+        slot->lastSeen = now;
+        slot->count = 0;
+        slot->used = true;
+        slot->first = record;
+    }
+    return true;
+}
+
+void LogStormGuard::expire(qint64 now, std::vector<LogRecord> *notices)
+{
+    if (m_pendingCount == 0 || now - m_lastExpire < ReportIntervalMs * NANOSECONDS_PER_MILLISECOND) {
+        return;
+    }
+    m_lastExpire = now;
+
+    const qint64 window = m_policy.foldWindowMs * NANOSECONDS_PER_MILLISECOND;
+    for (FoldSlot &slot : m_slots) {
+        if (slot.used && slot.count > 0 && now - slot.windowStart >= window) {
+            reportSlot(slot, notices);
+            // 下一次出现时作为新日志写入
+            slot.used = false;
+        }
+    }
+
+    // 丢弃的条数每个报告间隔报告一次
+    for (size_t id = 0; id < m_buckets.size(); ++id) {
+        if (m_buckets[id].dropped > 0) {
+            reportBucket(static_cast<quint16>(id), m_buckets[id], now, notices);
+        }
+    }
+}
+
+void LogStormGuard::finish(std::vector<LogRecord> *notices)
+{
+    const qint64 now = LogFormatRegistry::currentTimestamp();
+    for (FoldSlot &slot : m_slots) {
+        if (slot.used && slot.count > 0) {
+            reportSlot(slot, notices);
+        }
+        slot.used = false;
+    }
+    for (size_t id = 0; id < m_buckets.size(); ++id) {
+        if (m_buckets[id].dropped > 0) {
+            reportBucket(static_cast<quint16>(id), m_buckets[id], now, notices);
+        }
+    }
+    m_pendingCount = 0;
+}
+
+void LogStormGuard::resolve(const LogRecord &record, quint8 *level, quint16 *categoryId)
+{
+    if (record.kind != LogRecord::Structured) {
+        *level = record.level;
+        *categoryId = record.categoryId;
+        return;
+    }
+
+    // 格式注册表需要加锁并复制格式，每个格式只查询一次
+    if (record.formatId >= m_formatInfo.size()) {
+        m_formatInfo.resize(static_cast<size_t>(record.formatId) + 1, 0);
+    }
+    quint32 &info = m_formatInfo[record.formatId];
+    if (info == 0) {
+        LogFormatRegistry::Format format;
+        LogFormatRegistry::format(record.formatId, &format);
+        info = 0x1000000u | (static_cast<quint32>(format.level) << 16) | format.categoryId;
+    }
+    *level = static_cast<quint8>((info >> 16) & 0xFF);
+    *categoryId = static_cast<quint16>(info & 0xFFFF);
+}
+
+quint64 LogStormGuard::hashRecord(const LogRecord &record)
+{
+    quint64 hash = 14695981039346656037ULL;
+    hash = hashBytes(hash, &record.kind, sizeof(record.kind));
+
+    // 结构化日志的格式ID对应唯一的调用位置
+    if (record.kind == LogRecord::Structured) {
+        hash = hashBytes(hash, &record.formatId, sizeof(record.formatId));
+        return hashBytes(hash, record.arguments, record.argumentSize);
+    }
+
+    hash = hashBytes(hash, &record.level, sizeof(record.level));
+    hash = hashBytes(hash, &record.categoryId, sizeof(record.categoryId));
+    hash = hashBytes(hash, record.label.constData(), static_cast<size_t>(record.label.size()) * sizeof(QChar));
+    hash = hashBytes(hash, "\0", 1);
+    return hashBytes(hash, record.message.constData(), static_cast<size_t>(record.message.size()) * sizeof(QChar));
+}
+
+LogRecord LogStormGuard::repeatedNotice(const FoldSlot &slot) const
+{
+    const LogRecord &first = slot.first;
+
+    LogRecord notice;
+    notice.kind = LogRecord::Text;
+    notice.timestamp = slot.lastSeen;
+    notice.threadId = first.threadId;
+    notice.label = first.label;
+
+    QString message;
+    if (first.kind == LogRecord::Structured) {
+        LogFormatRegistry::Format format;
+        LogFormatRegistry::format(first.formatId, &format);
+        notice.level = format.level;
+        notice.categoryId = format.categoryId;
+        message = formatLogMessage(format.format, decodeLogArguments(first.arguments, first.argumentSize));
+    } else {
+        notice.level = first.level;
+        notice.categoryId = first.categoryId;
+        message = first.message;
+    }
+    if (message.size() > NOTICE_PREVIEW_LENGTH) {
+        message = message.left(NOTICE_PREVIEW_LENGTH) + "…";
+    }
+
+    const double seconds = (slot.lastSeen - slot.windowStart) / 1e9;
+    notice.message = QString("（%1秒内又重复了%2次）%3")
+                         .arg(seconds, 0, 'f', 1)
+                         .arg(slot.count)
+                         .arg(message);
+    return notice;
+}
+
+LogRecord LogStormGuard::droppedNotice(quint16 categoryId, const Bucket &bucket, qint64 now) const
+{
+    LogRecord notice;
+    notice.kind = LogRecord::Text;
+    notice.timestamp = now;
+    notice.threadId = LogFormatRegistry::currentThreadId();
+    notice.level = QtWarningMsg;
+    notice.categoryId = categoryId;
+    notice.message = QString("日志超出分类速率限制（每秒%1条），%2秒内丢弃了%3条")
+                         .arg(m_policy.categoryRate)
+                         .arg(qMax<qint64>(0, now - bucket.firstDrop) / 1e9, 0, 'f', 1)
+                         .arg(bucket.dropped);
+    return notice;
+}
+
+void LogStormGuard::reportSlot(FoldSlot &slot, std::vector<LogRecord> *notices)
+{
+    notices->push_back(repeatedNotice(slot));
+    slot.count = 0;
+    --m_pendingCount;
+}
+
+void LogStormGuard::reportBucket(quint16 categoryId, Bucket &bucket, qint64 now, std::vector<LogRecord> *notices)
+{
+    notices->push_back(droppedNotice(categoryId, bucket, now));
+    bucket.dropped = 0;
+    --m_pendingCount;
+}
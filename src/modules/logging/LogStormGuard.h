@@ -0,0 +1,85 @@
+#ifndef LOGSTORMGUARD_H
+#define LOGSTORMGUARD_H
+
+#include <QtGlobal>
+#include <vector>
+
+#include "LogRingBuffer.h"
+
+// 日志风暴抑制（由日志写入线程调用，同步模式下在m_fileMutex内调用，本身不加锁）：
+// 1. 折叠重复日志：相同的日志（结构化日志按格式ID即调用位置和参数，文本日志按分类、等级和内容）
+//    在折叠窗口内只写入第一条，窗口结束后补写一条"又重复了N次"；
+// 2. 分类限速：每个分类一个令牌桶，超出速率的日志被丢弃并计数，之后补写丢弃的条数。
+// 严重和致命日志不限速，致命日志也不折叠。原样写入的标记行（Raw）不受影响，写入前先报告全部汇总
+class LogStormGuard
+{
+public:
+    // 抑制策略（数值为0时关闭对应功能）
+    struct Policy {
+        int foldWindowMs = 2000;        // 相同日志的折叠窗口
+        int categoryRate = 500;         // 每个分类每秒允许写入的日志数
+        int categoryBurst = 2000;       // 令牌桶容量（允许的突发条数）
+    };
+
+    LogStormGuard();
+
+    Policy policy() const { return m_policy; }
+    void setPolicy(const Policy &policy);
+
+    // 判断一条日志是否写入。notices中追加需要在它之前写入的汇总记录（重复次数、丢弃条数）
+    bool admit(const LogRecord &record, std::vector<LogRecord> *notices);
+
+    // 报告已结束的折叠窗口和限速丢弃的条数（写入线程定期调用，内部按间隔节流）
+    void expire(qint64 now, std::vector<LogRecord> *notices);
+
+    // 报告全部还没有报告的汇总（关闭日志前调用）
+    void finish(std::vector<LogRecord> *notices);
+
+    // 是否有等待报告的汇总（写入线程空闲时需要定时醒来报告）
+    bool hasPending() const { return m_pendingCount > 0; }
+
+    // 汇总的报告间隔（毫秒）
+    static constexpr int ReportIntervalMs = 1000;
+
+private:
+    // 折叠表的一项（按哈希直接映射）
+    struct FoldSlot {
+        quint64 hash = 0;
+        qint64 windowStart = 0;         // 第一次写入的时间
+        qint64 lastSeen = 0;            // 最后一次被折叠的时间
+        quint64 count = 0;              // 被折叠的次数
+        bool used = false;
+        LogRecord first;                // 第一次写入的日志（用于汇总中的内容）
+    };
+
+    // 一个分类的令牌桶
+    struct Bucket {
+        double tokens = 0;
+        qint64 lastRefill = 0;
+        qint64 firstDrop = 0;
+        quint64 dropped = 0;
+        bool started = false;
+    };
+
+    // 日志的等级和分类（结构化日志从格式注册表查询并缓存）
+    void resolve(const LogRecord &record, quint8 *level, quint16 *categoryId);
+
+    static quint64 hashRecord(const LogRecord &record);
+
+    // 生成汇总记录
+    LogRecord repeatedNotice(const FoldSlot &slot) const;
+    LogRecord droppedNotice(quint16 categoryId, const Bucket &bucket, qint64 now) const;
+
+    // 报告一个折叠项或令牌桶并清零
+    void reportSlot(FoldSlot &slot, std::vector<LogRecord> *notices);
+    void reportBucket(quint16 categoryId, Bucket &bucket, qint64 now, std::vector<LogRecord> *notices);
+
+    Policy m_policy;
+    std::vector<FoldSlot> m_slots;
+    std::vector<Bucket> m_buckets;      // 按分类ID
+    std::vector<quint32> m_formatInfo;  // 按格式ID缓存：有效标记 | 等级 << 16 | 分类ID
+    int m_pendingCount;                 // 有未报告计数的折叠项和令牌桶数
+    qint64 m_lastExpire;
+};
+
+#endif // LOGSTORMGUARD_H
@@ -0,0 +1,492 @@
+#include "LogIndexer.h"
+#include "LogCategories.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+// 不区分大小写搜索时每次转换为小写的块大小
+static const qint64 LOWER_BLOCK_SIZE = 1024 * 1024;
+
+// 行头中分类名称的最大长度
+static const int MAX_CATEGORY_LENGTH = 64;
+
+// 公历日期到1970-01-01的天数
+static qint64 daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2 ? 1 : 0;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = year - era * 400;
+    const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return static_cast<qint64>(era) * 146097 + dayOfEra - 719468;
+}
+
+// 读取count位十进制数字，遇到非数字返回-1
+static int parseDigits(const char *text, int count)
+{
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        const unsigned digit = static_cast<unsigned char>(text[i]) - '0';
+        if (digit > 9) {
+            return -1;
+        }
+        value = value * 10 + static_cast<int>(digit);
+    }
+    return value;
+}
+
+// 等级名称对应的等级。writeLog的自定义标签按名称归类，无法识别的算作INFO
+static quint8 levelFromName(const char *name, int length)
+{
+    const auto is = [name, length](const char *text) {
+        return length == static_cast<int>(strlen(text)) && memcmp(name, text, static_cast<size_t>(length)) == 0;
+    };
+    if (is("DEBUG")) {
+        return LogIndexer::LevelDebug;
+    }
+    if (is("WARNING") || is("WARN")) {
+        return LogIndexer::LevelWarning;
+    }
+    if (is("CRITICAL") || is("ERROR")) {
+        return LogIndexer::LevelCritical;
+    }
+    if (is("FATAL")) {
+        return LogIndexer::LevelFatal;
+    }
+    return LogIndexer::LevelInfo;
+}
+
+static bool isCategoryChar(char ch)
+{
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9')
+        || ch == '.' || ch == '_' || ch == '-';
+}
+
+// ASCII转换为小写（没有分支，编译器可以向量化）
+static void toLowerAscii(const char *source, char *target, qint64 size)
+{
+    for (qint64 i = 0; i < size; ++i) {
+        const unsigned char ch = static_cast<unsigned char>(source[i]);
+        target[i] = static_cast<char>(ch + ((static_cast<unsigned char>(ch - 'A') < 26u) << 5));
+    }
+}
+
+// 在data中查找needle，只报告起始位置在limit之前的匹配，每行只报告第一个。
+// 用memchr定位首字节、memcmp比较其余字节（都由C库按SIMD实现）
+static void findMatches(const char *data, qint64 size, qint64 limit, const QByteArray &needle,
+                        qint64 base, std::vector<qint64> *matches)
+{
+    const char first = needle.at(0);
+    const qint64 needleSize = needle.size();
+    const char *position = data;
+    const char *end = data + limit;
+    const char *dataEnd = data + size;
+
+    while (position < end) {
+        position = static_cast<const char*>(memchr(position, first, static_cast<size_t>(end - position)));
+        if (!position) {
+            break;
+        }
+        if (dataEnd - position >= needleSize
+            && memcmp(position + 1, needle.constData() + 1, static_cast<size_t>(needleSize - 1)) == 0) {
+            matches->push_back(base + (position - data));
+            // 跳到下一行
+            const char *newline = static_cast<const char*>(
+                memchr(position, '\n', static_cast<size_t>(dataEnd - position)));
+            position = newline ? newline + 1 : end;
+        } else {
+            ++position;
+        }
+    }
+}
+
+LogIndexer::LogIndexer(ChunkHandler chunkHandler, SearchHandler searchHandler)
+    : m_chunkHandler(std::move(chunkHandler))
+    , m_searchHandler(std::move(searchHandler))
+    , m_stopping(false)
+    , m_requestedGeneration(0)
+    , m_reopen(false)
+    , m_indexTarget(0)
+    , m_searchPending(false)
+    , m_requestedSearchId(0)
+    , m_requestedCaseSensitive(false)
+    , m_requestedFrom(0)
+    , m_requestedTo(0)
+    , m_latestSearch(0)
+    , m_generation(0)
+    , m_indexedEnd(0)
+    , m_lineCount(0)
+    , m_currentLevel(LevelInfo)
+    , m_currentCategory(0)
+    , m_currentTime(0)
+    , m_searchActive(false)
+    , m_searchId(0)
+    , m_caseSensitive(false)
+    , m_searchPosition(0)
+    , m_searchEnd(0)
+    , m_thread(nullptr)
+{
+}
+
+LogIndexer::~LogIndexer()
+{
+    if (m_thread) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_latestSearch = 0;
+        m_condition.notify_all();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+}
+
+void LogIndexer::open(const QString &path, quint64 generation)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requestedPath = path;
+        m_requestedGeneration = generation;
+        m_reopen = true;
+        m_indexTarget = 0;
+        m_searchPending = false;
+    }
+    m_latestSearch = 0;
+
+    if (!m_thread) {
+        m_thread = QThread::create([this]() { indexerLoop(); });
+        m_thread->start(QThread::LowPriority);
+    }
+    m_condition.notify_all();
+}
+
+void LogIndexer::indexTo(qint64 size)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (size <= m_indexTarget) {
+            return;
+        }
+        m_indexTarget = size;
+    }
+    m_condition.notify_all();
+}
+
+void LogIndexer::search(int searchId, const QByteArray &needle, bool caseSensitive, qint64 from, qint64 to)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_searchPending = true;
+        m_requestedSearchId = searchId;
+        m_requestedNeedle = caseSensitive ? needle : needle.toLower();
+        m_requestedCaseSensitive = caseSensitive;
+        m_requestedFrom = from;
+        m_requestedTo = to;
+    }
+    m_latestSearch = searchId;
+    m_condition.notify_all();
+}
+
+void LogIndexer::cancelSearch()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_searchPending = false;
+    }
+    m_latestSearch = 0;
+}
+
+bool LogIndexer::parseHeader(const char *line, qint64 length, LineHeader *header)
+{
+    // "[yyyy-MM-dd HH:mm:ss.zzz] [等级] "，时间固定23个字符
+    if (length < 29 || line[0] != '[' || line[5] != '-' || line[8] != '-' || line[11] != ' '
+        || line[14] != ':' || line[17] != ':' || line[20] != '.' || line[24] != ']'
+        || line[25] != ' ' || line[26] != '[') {
+        return false;
+    }
+
+    const int year = parseDigits(line + 1, 4);
+    const int month = parseDigits(line + 6, 2);
+    const int day = parseDigits(line + 9, 2);
+    const int hour = parseDigits(line + 12, 2);
+    const int minute = parseDigits(line + 15, 2);
+    const int second = parseDigits(line + 18, 2);
+    if (year < 1970 || month < 1 || month > 12 || day < 1 || day > 31
+        || hour < 0 || minute < 0 || second < 0 || parseDigits(line + 21, 3) < 0) {
+        return false;
+    }
+
+    const qint64 levelStart = 27;
+    const char *levelEnd = static_cast<const char*>(
+        memchr(line + levelStart, ']', static_cast<size_t>(qMin<qint64>(length - levelStart, 32))));
+    if (!levelEnd || levelEnd == line + levelStart) {
+        return false;
+    }
+
+    header->time = packTime(year, month, day, hour, minute, second);
+    header->level = levelFromName(line + levelStart, static_cast<int>(levelEnd - line - levelStart));
+    header->category = nullptr;
+    header->categoryLength = 0;
+
+    // 可选的"[分类] "：只接受分类名称允许的字符，避免把以"["开头的消息当作分类
+    const qint64 categoryStart = levelEnd - line + 3;
+    if (categoryStart < length && line[categoryStart - 2] == ' ' && line[categoryStart - 1] == '[') {
+        qint64 end = categoryStart;
+        const qint64 limit = qMin<qint64>(length, categoryStart + MAX_CATEGORY_LENGTH);
+        while (end < limit && isCategoryChar(line[end])) {
+            ++end;
+        }
+        if (end > categoryStart && end < length && line[end] == ']'
+            && (end + 1 == length || line[end + 1] == ' ' || line[end + 1] == '\r')) {
+            header->category = line + categoryStart;
+            header->categoryLength = static_cast<int>(end - categoryStart);
+        }
+    }
+    return true;
+}
+
+quint32 LogIndexer::packTime(int year, int month, int day, int hour, int minute, int second)
+{
+    const qint64 seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    return static_cast<quint32>(qBound<qint64>(0, seconds, 0xFFFFFFFFLL));
+}
+
+quint32 LogIndexer::packTime(const QDateTime &time)
+{
+    const QDateTime local = time.toLocalTime();
+    const QDate date = local.date();
+    const QTime clock = local.time();
+    return packTime(date.year(), date.month(), date.day(), clock.hour(), clock.minute(), clock.second());
+}
+
+void LogIndexer::indexerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        m_condition.wait(lock, [this]() {
+            return m_stopping || m_reopen || m_searchPending || m_searchActive
+                || (m_file.isOpen() && m_indexTarget > m_indexedEnd);
+        });
+        if (m_stopping) {
+            break;
+        }
+
+        if (m_reopen) {
+            m_reopen = false;
+            const QString path = m_requestedPath;
+            m_generation = m_requestedGeneration;
+            lock.unlock();
+
+            // 重置全部状态，分类ID也重新分配
+            m_file.close();
+            m_file.setFileName(path);
+            m_indexedEnd = 0;
+            m_lineCount = 0;
+            m_currentLevel = LevelInfo;
+            m_currentCategory = 0;
+            m_currentTime = 0;
+            m_categoryIds.clear();
+            m_searchActive = false;
+            if (!path.isEmpty() && !m_file.open(QIODevice::ReadOnly)) {
+                qCWarning(lcSystem) << "无法打开日志文件:" << path << m_file.errorString();
+            }
+
+            lock.lock();
+            continue;
+        }
+
+        if (m_searchPending) {
+            m_searchPending = false;
+            m_searchActive = true;
+            m_searchId = m_requestedSearchId;
+            m_needle = m_requestedNeedle;
+            m_caseSensitive = m_requestedCaseSensitive;
+            m_searchPosition = m_requestedFrom;
+            m_searchEnd = m_requestedTo;
+        }
+
+        // 索引优先，搜索在两个索引窗口之间进行
+        const qint64 target = m_indexTarget;
+        lock.unlock();
+
+        if (m_file.isOpen() && target > m_indexedEnd) {
+            indexWindow(target);
+        } else if (m_searchActive) {
+            searchWindow();
+        }
+
+        lock.lock();
+    }
+}
+
+void LogIndexer::indexWindow(qint64 target)
+{
+    const qint64 start = m_indexedEnd;
+    const qint64 length = qMin(WindowSize, qMin(target, m_file.size()) - start);
+
+    m_chunk = std::make_shared<Chunk>();
+    m_chunk->generation = m_generation;
+
+    bool reachedEnd = true;
+    if (length > 0) {
+        // 映射失败时（例如32位系统地址空间不足）退回到读取
+        QByteArray buffer;
+        const char *data = reinterpret_cast<const char*>(m_file.map(start, length));
+        const bool mapped = data != nullptr;
+        if (!mapped) {
+            if (m_file.seek(start)) {
+                buffer = m_file.read(length);
+            }
+            data = buffer.constData();
+        }
+        const qint64 available = mapped ? length : buffer.size();
+
+        m_chunk->offsets.reserve(static_cast<size_t>(available / 64));
+        m_chunk->levels.reserve(static_cast<size_t>(available / 64));
+        m_chunk->categories.reserve(static_cast<size_t>(available / 64));
+
+        qint64 consumed = 0;
+        while (consumed < available) {
+            const char *newline = static_cast<const char*>(
+                memchr(data + consumed, '\n', static_cast<size_t>(available - consumed)));
+            if (!newline) {
+                break;
+            }
+            const qint64 lineLength = newline - data - consumed;
+            addLine(data + consumed, lineLength, start + consumed);
+            consumed += lineLength + 1;
+        }
+
+        // 整个窗口都没有换行：超长的行按窗口大小切开
+        if (consumed == 0 && available == WindowSize) {
+            addLine(data, available, start);
+            consumed = available;
+        }
+
+        if (mapped) {
+            m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+        }
+
+        m_indexedEnd = start + consumed;
+        reachedEnd = available < WindowSize || m_indexedEnd >= target;
+    }
+
+    // 剩下的只是还没写完的一行：等文件再次增长再继续
+    if (reachedEnd) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_indexTarget == target && !m_reopen) {
+            m_indexTarget = m_indexedEnd;
+        }
+    }
+
+    m_chunk->end = m_indexedEnd;
+    m_chunk->caughtUp = reachedEnd;
+    if ((!m_chunk->offsets.empty() || reachedEnd) && m_chunkHandler) {
+        m_chunkHandler(std::move(m_chunk));
+    }
+    m_chunk.reset();
+}
+
+void LogIndexer::addLine(const char *line, qint64 length, qint64 offset)
+{
+    LineHeader header;
+    if (parseHeader(line, length, &header)) {
+        m_currentLevel = header.level;
+        m_currentCategory = header.category ? categoryId(header.category, header.categoryLength) : 0;
+        m_currentTime = header.time;
+    }
+
+    if (m_lineCount % TimeBlockLines == 0) {
+        m_chunk->blockTimes.push_back(m_currentTime);
+    }
+    m_chunk->offsets.push_back(offset);
+    m_chunk->levels.push_back(m_currentLevel);
+    m_chunk->categories.push_back(m_currentCategory);
+    ++m_lineCount;
+}
+
+quint8 LogIndexer::categoryId(const char *name, int length)
+{
+    const QByteArray key = QByteArray::fromRawData(name, length);
+    auto it = m_categoryIds.constFind(key);
+    if (it != m_categoryIds.constEnd()) {
+        return it.value();
+    }
+
+    // ID 0保留给默认分类
+    const int id = m_categoryIds.size() + 1;
+    if (id >= MaxCategories) {
+        return MaxCategories - 1;
+    }
+    m_categoryIds.insert(QByteArray(name, length), static_cast<quint8>(id));
+    m_chunk->newCategories.append(QString::fromUtf8(name, length));
+    return static_cast<quint8>(id);
+}
+
+void LogIndexer::searchWindow()
+{
+    auto result = std::make_shared<SearchResult>();
+    result->generation = m_generation;
+    result->searchId = m_searchId;
+
+    const qint64 needleSize = m_needle.size();
+    const qint64 limit = qMin(WindowSize, m_searchEnd - m_searchPosition);
+
+    if (needleSize > 0 && limit > 0 && m_file.isOpen()) {
+        // 多映射needle长度-1个字节，跨窗口的匹配也能找到
+        const qint64 size = qMin(limit + needleSize - 1, m_searchEnd - m_searchPosition);
+        QByteArray buffer;
+        const char *data = reinterpret_cast<const char*>(m_file.map(m_searchPosition, size));
+        const bool mapped = data != nullptr;
+        if (!mapped) {
+            if (m_file.seek(m_searchPosition)) {
+                buffer = m_file.read(size);
+            }
+            data = buffer.constData();
+        }
+        const qint64 available = mapped ? size : buffer.size();
+        const qint64 searchLimit = qMin(limit, available);
+
+        if (m_caseSensitive) {
+            findMatches(data, available, searchLimit, m_needle, m_searchPosition, &result->matches);
+        } else {
+            // 分块转换为小写后再查找
+            m_lowerBuffer.resize(static_cast<size_t>(LOWER_BLOCK_SIZE + needleSize));
+            for (qint64 block = 0; block < searchLimit; block += LOWER_BLOCK_SIZE) {
+                if (m_latestSearch.load(std::memory_order_relaxed) != m_searchId) {
+                    break;
+                }
+                const qint64 blockLimit = qMin(LOWER_BLOCK_SIZE, searchLimit - block);
+                const qint64 blockSize = qMin(blockLimit + needleSize - 1, available - block);
+                toLowerAscii(data + block, m_lowerBuffer.data(), blockSize);
+                findMatches(m_lowerBuffer.data(), blockSize, blockLimit, m_needle,
+                            m_searchPosition + block, &result->matches);
+            }
+        }
+
+        if (mapped) {
+            m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+        }
+        m_searchPosition += limit;
+    } else {
+        m_searchPosition = m_searchEnd;
+    }
+
+    // 已被新的搜索替换或取消，不再报告
+    if (m_latestSearch.load(std::memory_order_relaxed) != m_searchId) {
+        m_searchActive = false;
+        return;
+    }
+
+    result->searchedEnd = m_searchPosition;
+    result->finished = m_searchPosition >= m_searchEnd;
+    if (result->finished) {
+        m_searchActive = false;
+    }
+    if (m_searchHandler) {
+        m_searchHandler(std::move(result));
+    }
+}
@@ -0,0 +1,157 @@
+#ifndef LOGINDEXER_H
+#define LOGINDEXER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 日志文件索引线程：
+// 按窗口把文本日志映射到内存（QFile::map），用memchr找出每一行，
+// 解析"[时间] [等级] [分类]"行头，得到行偏移、等级和分类ID，分批交给查看器模型。
+// 没有行头的行（多行消息的后续行）沿用上一行的等级和分类，过滤时与首行一起显示。
+// 文件增长时只索引新增部分；同一线程还负责在已索引的范围内做文本搜索。
+class LogIndexer
+{
+public:
+    // 行的等级，按严重程度排列
+    enum Level : quint8 {
+        LevelDebug = 0,
+        LevelInfo,
+        LevelWarning,
+        LevelCritical,
+        LevelFatal
+    };
+
+    // 每次映射的窗口大小
+    static constexpr qint64 WindowSize = 16 * 1024 * 1024;
+
+    // 时间索引的间隔：每隔多少行记录一次时间，按时间定位时再在块内逐行解析
+    static constexpr int TimeBlockLines = 1024;
+
+    // 分类ID上限，超出的分类共用最后一个ID
+    static constexpr int MaxCategories = 256;
+
+    // 一批新索引的行
+    struct Chunk {
+        quint64 generation = 0;
+        qint64 end = 0;                     // 已索引到的偏移（最后一个完整行之后）
+        std::vector<qint64> offsets;        // 每行的起始偏移
+        std::vector<quint8> levels;         // 每行的等级
+        std::vector<quint8> categories;     // 每行的分类ID（0为默认分类）
+        std::vector<quint32> blockTimes;    // 新增时间块的起始时间
+        QStringList newCategories;          // 新出现的分类名称，ID依次递增
+        bool caughtUp = false;              // 已索引到请求的位置（剩下的最多是一行未写完的内容）
+    };
+
+    // 一批搜索结果
+    struct SearchResult {
+        quint64 generation = 0;
+        int searchId = 0;
+        std::vector<qint64> matches;        // 匹配位置（每行只报告第一个）
+        qint64 searchedEnd = 0;             // 已搜索到的偏移
+        bool finished = false;
+    };
+
+    // 解析出的行头
+    struct LineHeader {
+        quint32 time = 0;                   // 见packTime()
+        quint8 level = LevelInfo;
+        const char *category = nullptr;     // 没有分类时为nullptr
+        int categoryLength = 0;
+    };
+
+    // 回调在索引线程中调用
+    using ChunkHandler = std::function<void(std::shared_ptr<Chunk> chunk)>;
+    using SearchHandler = std::function<void(std::shared_ptr<SearchResult> result)>;
+
+    LogIndexer(ChunkHandler chunkHandler, SearchHandler searchHandler);
+    ~LogIndexer();
+
+    // 切换到新文件并从头索引（第一次调用时启动线程），generation随结果返回，用于丢弃旧文件的结果
+    void open(const QString &path, quint64 generation);
+
+    // 请求索引到size（文件增长时调用）
+    void indexTo(qint64 size);
+
+    // 在[from, to)范围内搜索，替换正在进行的搜索（searchId从1开始）。caseSensitive为false时ASCII字母不区分大小写
+    void search(int searchId, const QByteArray &needle, bool caseSensitive, qint64 from, qint64 to);
+
+    // 取消正在进行的搜索
+    void cancelSearch();
+
+    // 解析行头，不是"[yyyy-MM-dd HH:mm:ss.zzz] [等级] "开头的行返回false
+    static bool parseHeader(const char *line, qint64 length, LineHeader *header);
+
+    // 本地日期和时间换算成紧凑的秒数（按UTC计算，不受时区和夏令时影响，只用于比较先后）
+    static quint32 packTime(int year, int month, int day, int hour, int minute, int second);
+    static quint32 packTime(const QDateTime &time);
+
+private:
+    // 索引线程主循环
+    void indexerLoop();
+
+    // 索引一个窗口
+    void indexWindow(qint64 target);
+
+    // 搜索一个窗口
+    void searchWindow();
+
+    // 登记一行
+    void addLine(const char *line, qint64 length, qint64 offset);
+
+    // 分类名称对应的ID，新分类加入当前批次
+    quint8 categoryId(const char *name, int length);
+
+    ChunkHandler m_chunkHandler;
+    SearchHandler m_searchHandler;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping;
+
+    // 请求（在锁内修改）
+    QString m_requestedPath;
+    quint64 m_requestedGeneration;
+    bool m_reopen;
+    qint64 m_indexTarget;
+    bool m_searchPending;
+    int m_requestedSearchId;
+    QByteArray m_requestedNeedle;
+    bool m_requestedCaseSensitive;
+    qint64 m_requestedFrom;
+    qint64 m_requestedTo;
+    std::atomic<int> m_latestSearch;        // 最新请求的搜索ID，0表示已取消
+
+    // 以下只在索引线程中使用（等待条件除外，它也在索引线程中求值）
+    QFile m_file;
+    quint64 m_generation;
+    qint64 m_indexedEnd;
+    quint64 m_lineCount;
+    quint8 m_currentLevel;
+    quint8 m_currentCategory;
+    quint32 m_currentTime;
+    QHash<QByteArray, quint8> m_categoryIds;
+    std::shared_ptr<Chunk> m_chunk;
+
+    bool m_searchActive;
+    int m_searchId;
+    QByteArray m_needle;
+    bool m_caseSensitive;
+    qint64 m_searchPosition;
+    qint64 m_searchEnd;
+    std::vector<char> m_lowerBuffer;
+
+    QThread *m_thread;
+};
+
+#endif // LOGINDEXER_H
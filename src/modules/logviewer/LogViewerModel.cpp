@@ -0,0 +1,646 @@
+#include "LogViewerModel.h"
+#include "LogCategories.h"
+#include "LogManager.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QUrl>
+#include <algorithm>
+
+// 检查文件增长的间隔（文件监视在部分平台上不报告追加写入）
+static const int POLL_INTERVAL = 500;
+
+// 一行最多显示的字节数，更长的行截断
+static const qint64 MAX_LINE_BYTES = 4096;
+
+LogViewerModel::LogViewerModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_generation(0)
+    , m_followCurrentLog(false)
+    , m_fileMissing(false)
+    , m_map(nullptr)
+    , m_mappedSize(0)
+    , m_categories({ QStringLiteral("default") })
+    , m_indexedEnd(0)
+    , m_fileSize(0)
+    , m_indexing(false)
+    , m_minimumLevel(LogIndexer::LevelDebug)
+    , m_categoryId(-1)
+    , m_matchesOnly(false)
+    , m_filtered(false)
+    , m_caseSensitive(false)
+    , m_searchId(0)
+    , m_searching(false)
+    , m_searchedEnd(0)
+{
+    // 索引线程的结果转到主线程处理
+    m_indexer.reset(new LogIndexer(
+        [this](std::shared_ptr<LogIndexer::Chunk> chunk) {
+            QMetaObject::invokeMethod(this, [this, chunk]() { onChunk(chunk); }, Qt::QueuedConnection);
+        },
+        [this](std::shared_ptr<LogIndexer::SearchResult> result) {
+            QMetaObject::invokeMethod(this, [this, result]() { onSearchResult(result); }, Qt::QueuedConnection);
+        }));
+
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &LogViewerModel::checkFile);
+    connect(&m_pollTimer, &QTimer::timeout, this, &LogViewerModel::checkFile);
+    m_pollTimer.setInterval(POLL_INTERVAL);
+    m_pollTimer.start();
+}
+
+LogViewerModel::~LogViewerModel()
+{
+    // 先停止索引线程，之后不会再有结果投递过来
+    m_indexer.reset();
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+}
+
+int LogViewerModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_filtered ? static_cast<int>(m_rows.size()) : static_cast<int>(m_offsets.size());
+}
+
+QVariant LogViewerModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= rowCount()) {
+        return QVariant();
+    }
+
+    const int line = lineOfRow(index.row());
+
+    switch (role) {
+    case LineNumberRole:
+        return line + 1;
+    case TextRole:
+    case Qt::DisplayRole:
+        return QString::fromUtf8(lineBytes(line));
+    case LevelRole:
+        return static_cast<int>(m_levels[static_cast<size_t>(line)]);
+    case CategoryRole: {
+        const int id = m_lineCategories[static_cast<size_t>(line)];
+        return id < m_categories.size() ? m_categories.at(id) : QString();
+    }
+    case MatchedRole:
+        return isMatch(line);
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> LogViewerModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[LineNumberRole] = "lineNumber";
+    roles[TextRole] = "text";
+    roles[LevelRole] = "level";
+    roles[CategoryRole] = "category";
+    roles[MatchedRole] = "matched";
+    return roles;
+}
+
+void LogViewerModel::setSource(const QString &source)
+{
+    const QString path = source.startsWith("file:") ? QUrl(source).toLocalFile() : source;
+    if (path == m_source) {
+        return;
+    }
+
+    // 打开其他文件时不再跟随当前日志
+    if (m_followCurrentLog && path != LogManager::instance()->logFilePath()) {
+        m_followCurrentLog = false;
+        emit followCurrentLogChanged();
+    }
+
+    m_source = path;
+    emit sourceChanged();
+    openSource();
+}
+
+void LogViewerModel::setFollowCurrentLog(bool follow)
+{
+    if (m_followCurrentLog == follow) {
+        return;
+    }
+    m_followCurrentLog = follow;
+    emit followCurrentLogChanged();
+
+    if (follow) {
+        checkFile();
+    }
+}
+
+qreal LogViewerModel::progress() const
+{
+    if (m_fileSize <= 0) {
+        return 1.0;
+    }
+    return qMin<qreal>(1.0, static_cast<qreal>(m_indexedEnd) / m_fileSize);
+}
+
+void LogViewerModel::setMinimumLevel(int level)
+{
+    level = qBound<int>(LogIndexer::LevelDebug, level, LogIndexer::LevelFatal);
+    if (m_minimumLevel == level) {
+        return;
+    }
+    m_minimumLevel = level;
+    rebuildRows();
+    emit filterChanged();
+}
+
+void LogViewerModel::setCategory(const QString &category)
+{
+    if (m_category == category) {
+        return;
+    }
+    m_category = category;
+    rebuildRows();
+    emit filterChanged();
+}
+
+void LogViewerModel::setMatchesOnly(bool matchesOnly)
+{
+    if (m_matchesOnly == matchesOnly) {
+        return;
+    }
+    m_matchesOnly = matchesOnly;
+    rebuildRows();
+    emit filterChanged();
+}
+
+void LogViewerModel::setSearchText(const QString &text)
+{
+    if (m_searchText == text) {
+        return;
+    }
+    m_searchText = text;
+    restartSearch();
+    emit searchChanged();
+}
+
+void LogViewerModel::setCaseSensitive(bool caseSensitive)
+{
+    if (m_caseSensitive == caseSensitive) {
+        return;
+    }
+    m_caseSensitive = caseSensitive;
+    restartSearch();
+    emit searchChanged();
+}
+
+int LogViewerModel::rowForLine(int lineNumber) const
+{
+    return rowAtOrAfter(qMax(0, lineNumber - 1));
+}
+
+int LogViewerModel::rowForTime(const QDateTime &time) const
+{
+    const int lines = lineCount();
+    if (lines == 0 || !time.isValid()) {
+        return -1;
+    }
+
+    // 先在时间块中找到第一个起始时间不早于目标的块，结果在它和前一块之间
+    const quint32 target = LogIndexer::packTime(time);
+    const auto block = std::lower_bound(m_blockTimes.begin(), m_blockTimes.end(), target) - m_blockTimes.begin();
+    const qint64 first = qMax<qint64>(0, block - 1) * LogIndexer::TimeBlockLines;
+    const qint64 last = qMin<qint64>(lines, static_cast<qint64>(block) * LogIndexer::TimeBlockLines);
+
+    // 块内逐行解析时间（多行消息的后续行没有时间，跳过）
+    for (qint64 line = first; line < last; ++line) {
+        const QByteArray bytes = lineBytes(static_cast<int>(line));
+        LogIndexer::LineHeader header;
+        if (LogIndexer::parseHeader(bytes.constData(), bytes.size(), &header) && header.time >= target) {
+            return rowAtOrAfter(static_cast<int>(line));
+        }
+    }
+    return rowAtOrAfter(static_cast<int>(qMin<qint64>(last, lines - 1)));
+}
+
+int LogViewerModel::nextMatch(int row) const
+{
+    const int line = row < 0 || row >= rowCount() ? -1 : lineOfRow(row);
+    for (auto it = std::upper_bound(m_matchLines.begin(), m_matchLines.end(), line); it != m_matchLines.end(); ++it) {
+        const int matchRow = rowOfLine(*it);
+        if (matchRow >= 0) {
+            return matchRow;
+        }
+    }
+    return -1;
+}
+
+int LogViewerModel::previousMatch(int row) const
+{
+    const int line = row < 0 || row >= rowCount() ? lineCount() : lineOfRow(row);
+    auto it = std::lower_bound(m_matchLines.begin(), m_matchLines.end(), line);
+    while (it != m_matchLines.begin()) {
+        --it;
+        const int matchRow = rowOfLine(*it);
+        if (matchRow >= 0) {
+            return matchRow;
+        }
+    }
+    return -1;
+}
+
+void LogViewerModel::reload()
+{
+    openSource();
+}
+
+void LogViewerModel::onChunk(const std::shared_ptr<LogIndexer::Chunk> &chunk)
+{
+    // 已切换到其他文件
+    if (chunk->generation != m_generation) {
+        return;
+    }
+
+    if (!chunk->newCategories.isEmpty()) {
+        m_categories.append(chunk->newCategories);
+        if (m_categoryId == -2) {
+            m_categoryId = static_cast<int>(m_categories.indexOf(m_category));
+            m_categoryId = m_categoryId < 0 ? -2 : m_categoryId;
+        }
+        emit categoriesChanged();
+    }
+
+    const int firstLine = lineCount();
+    const int count = static_cast<int>(chunk->offsets.size());
+    bool rowsAdded = false;
+
+    const auto appendLines = [this, &chunk]() {
+        m_offsets.insert(m_offsets.end(), chunk->offsets.begin(), chunk->offsets.end());
+        m_levels.insert(m_levels.end(), chunk->levels.begin(), chunk->levels.end());
+        m_lineCategories.insert(m_lineCategories.end(), chunk->categories.begin(), chunk->categories.end());
+        m_blockTimes.insert(m_blockTimes.end(), chunk->blockTimes.begin(), chunk->blockTimes.end());
+        m_indexedEnd = chunk->end;
+    };
+
+    if (count > 0 && !m_filtered) {
+        beginInsertRows(QModelIndex(), firstLine, firstLine + count - 1);
+        appendLines();
+        endInsertRows();
+        rowsAdded = true;
+    } else {
+        appendLines();
+
+        // 过滤时只插入通过过滤的新行
+        std::vector<int> visible;
+        for (int line = firstLine; line < firstLine + count; ++line) {
+            if (isLineVisible(line)) {
+                visible.push_back(line);
+            }
+        }
+        if (!visible.empty()) {
+            const int firstRow = static_cast<int>(m_rows.size());
+            beginInsertRows(QModelIndex(), firstRow, firstRow + static_cast<int>(visible.size()) - 1);
+            m_rows.insert(m_rows.end(), visible.begin(), visible.end());
+            endInsertRows();
+            rowsAdded = true;
+        }
+    }
+
+    if (chunk->caughtUp) {
+        m_indexing = false;
+    }
+
+    if (rowsAdded) {
+        emit countChanged();
+    }
+    if (count > 0) {
+        emit lineCountChanged();
+    }
+    emit progressChanged();
+
+    // 新索引的部分也要搜索
+    continueSearch();
+}
+
+void LogViewerModel::onSearchResult(const std::shared_ptr<LogIndexer::SearchResult> &result)
+{
+    if (result->generation != m_generation || result->searchId != m_searchId) {
+        return;
+    }
+
+    // 匹配位置换算成行号（结果按位置升序，跨窗口时同一行可能报告两次）
+    std::vector<int> added;
+    for (const qint64 offset : result->matches) {
+        const int line = static_cast<int>(std::upper_bound(m_offsets.begin(), m_offsets.end(), offset)
+                                          - m_offsets.begin()) - 1;
+        if (line < 0 || (!m_matchLines.empty() && m_matchLines.back() >= line)) {
+            continue;
+        }
+        m_matchLines.push_back(line);
+        added.push_back(line);
+    }
+
+    m_searchedEnd = result->searchedEnd;
+    if (result->finished) {
+        m_searching = false;
+    }
+
+    if (!added.empty()) {
+        if (m_filtered && m_matchesOnly) {
+            // 只显示匹配行：新的匹配都在已显示的行之后
+            std::vector<int> visible;
+            for (const int line : added) {
+                if (isLineVisible(line)) {
+                    visible.push_back(line);
+                }
+            }
+            if (!visible.empty()) {
+                const int firstRow = static_cast<int>(m_rows.size());
+                beginInsertRows(QModelIndex(), firstRow, firstRow + static_cast<int>(visible.size()) - 1);
+                m_rows.insert(m_rows.end(), visible.begin(), visible.end());
+                endInsertRows();
+                emit countChanged();
+            }
+        } else if (rowCount() > 0) {
+            emit dataChanged(index(rowAtOrAfter(added.front())), index(rowAtOrAfter(added.back())), { MatchedRole });
+        }
+    }
+
+    emit matchesChanged();
+
+    if (result->finished) {
+        continueSearch();
+    }
+}
+
+void LogViewerModel::checkFile()
+{
+    // 当前日志切换了分段
+    if (m_followCurrentLog) {
+        const QString current = LogManager::instance()->logFilePath();
+        if (!current.isEmpty() && current != m_source) {
+            m_source = current;
+            emit sourceChanged();
+            openSource();
+            return;
+        }
+    }
+
+    if (m_source.isEmpty()) {
+        return;
+    }
+
+    // 文件被删除或正在被替换，重新出现后再打开
+    const QFileInfo info(m_source);
+    if (!info.exists()) {
+        m_fileMissing = true;
+        return;
+    }
+    if (m_fileMissing) {
+        qCInfo(lcSystem) << "日志文件已重新创建，重新加载:" << m_source;
+        openSource();
+        return;
+    }
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    const qint64 size = info.size();
+    if (size < m_indexedEnd) {
+        qCInfo(lcSystem) << "日志文件被截断，重新加载:" << m_source;
+        openSource();
+        return;
+    }
+    if (size != m_fileSize) {
+        m_fileSize = size;
+        m_indexing = true;
+        m_indexer->indexTo(size);
+        emit progressChanged();
+    }
+}
+
+void LogViewerModel::openSource()
+{
+    const QString previousError = m_errorString;
+
+    beginResetModel();
+    clearIndex();
+    ++m_generation;
+    ++m_searchId;
+    m_errorString.clear();
+
+    if (!m_source.isEmpty()) {
+        const QFileInfo info(m_source);
+        const QString suffix = info.suffix().toLower();
+        if (suffix == "zlog" || suffix == "zst") {
+            m_errorString = "二进制或压缩的日志需要先用ZiyanLogDecoder转换为文本";
+        } else {
+            m_file.setFileName(m_source);
+            if (m_file.open(QIODevice::ReadOnly)) {
+                m_fileSize = m_file.size();
+                m_watcher.addPath(m_source);
+            } else {
+                m_errorString = "无法打开日志文件: " + m_file.errorString();
+                m_fileMissing = !info.exists();
+            }
+        }
+    }
+
+    // 新文件的分类还没有出现
+    m_categoryId = m_category.isEmpty() ? -1 : (m_category == m_categories.first() ? 0 : -2);
+    m_filtered = m_minimumLevel > LogIndexer::LevelDebug || m_categoryId != -1
+        || (m_matchesOnly && !m_searchText.isEmpty());
+    endResetModel();
+
+    m_indexer->open(m_file.isOpen() ? m_source : QString(), m_generation);
+    if (m_file.isOpen()) {
+        m_indexing = true;
+        m_indexer->indexTo(m_fileSize);
+        qCDebug(lcSystem) << "开始索引日志文件:" << m_source << "大小:" << m_fileSize;
+    }
+
+    emit countChanged();
+    emit lineCountChanged();
+    emit progressChanged();
+    emit categoriesChanged();
+    emit matchesChanged();
+    if (m_errorString != previousError) {
+        emit errorStringChanged();
+    }
+}
+
+void LogViewerModel::clearIndex()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mappedSize = 0;
+    m_file.close();
+    if (!m_watcher.files().isEmpty()) {
+        m_watcher.removePaths(m_watcher.files());
+    }
+    m_fileMissing = false;
+
+    // 交换释放内存（大文件的索引可能有几百MB）
+    std::vector<qint64>().swap(m_offsets);
+    std::vector<quint8>().swap(m_levels);
+    std::vector<quint8>().swap(m_lineCategories);
+    std::vector<quint32>().swap(m_blockTimes);
+    std::vector<int>().swap(m_rows);
+    std::vector<int>().swap(m_matchLines);
+    m_categories = QStringList({ QStringLiteral("default") });
+    m_indexedEnd = 0;
+    m_fileSize = 0;
+    m_indexing = false;
+    m_searching = false;
+    m_searchedEnd = 0;
+}
+
+void LogViewerModel::restartSearch()
+{
+    ++m_searchId;
+    m_indexer->cancelSearch();
+    m_matchLines.clear();
+    m_searchedEnd = 0;
+    m_searching = false;
+
+    if (m_matchesOnly) {
+        rebuildRows();
+    } else if (rowCount() > 0) {
+        emit dataChanged(index(0), index(rowCount() - 1), { MatchedRole });
+    }
+
+    continueSearch();
+    emit matchesChanged();
+}
+
+void LogViewerModel::continueSearch()
+{
+    if (m_searchText.isEmpty() || m_searching || m_searchedEnd >= m_indexedEnd) {
+        return;
+    }
+    m_searching = true;
+    m_indexer->search(m_searchId, m_searchText.toUtf8(), m_caseSensitive, m_searchedEnd, m_indexedEnd);
+    emit matchesChanged();
+}
+
+void LogViewerModel::rebuildRows()
+{
+    beginResetModel();
+
+    if (m_category.isEmpty()) {
+        m_categoryId = -1;
+    } else {
+        m_categoryId = static_cast<int>(m_categories.indexOf(m_category));
+        m_categoryId = m_categoryId < 0 ? -2 : m_categoryId;
+    }
+    m_filtered = m_minimumLevel > LogIndexer::LevelDebug || m_categoryId != -1
+        || (m_matchesOnly && !m_searchText.isEmpty());
+
+    m_rows.clear();
+    if (m_filtered) {
+        // 只显示匹配行时只需要检查匹配的行
+        if (m_matchesOnly && !m_searchText.isEmpty()) {
+            for (const int line : m_matchLines) {
+                if (isLineVisible(line)) {
+                    m_rows.push_back(line);
+                }
+            }
+        } else {
+            const int lines = lineCount();
+            for (int line = 0; line < lines; ++line) {
+                if (isLineVisible(line)) {
+                    m_rows.push_back(line);
+                }
+            }
+        }
+    }
+
+    endResetModel();
+    emit countChanged();
+}
+
+bool LogViewerModel::isLineVisible(int line) const
+{
+    const size_t index = static_cast<size_t>(line);
+    if (m_levels[index] < m_minimumLevel) {
+        return false;
+    }
+    if (m_categoryId != -1 && m_lineCategories[index] != m_categoryId) {
+        return false;
+    }
+    if (m_matchesOnly && !m_searchText.isEmpty() && !isMatch(line)) {
+        return false;
+    }
+    return true;
+}
+
+bool LogViewerModel::isMatch(int line) const
+{
+    return std::binary_search(m_matchLines.begin(), m_matchLines.end(), line);
+}
+
+int LogViewerModel::rowOfLine(int line) const
+{
+    if (line < 0 || line >= lineCount()) {
+        return -1;
+    }
+    if (!m_filtered) {
+        return line;
+    }
+    const auto it = std::lower_bound(m_rows.begin(), m_rows.end(), line);
+    return it != m_rows.end() && *it == line ? static_cast<int>(it - m_rows.begin()) : -1;
+}
+
+int LogViewerModel::rowAtOrAfter(int line) const
+{
+    const int rows = rowCount();
+    if (rows == 0) {
+        return -1;
+    }
+    if (!m_filtered) {
+        return qMin(line, rows - 1);
+    }
+    const auto it = std::lower_bound(m_rows.begin(), m_rows.end(), line);
+    return qMin(static_cast<int>(it - m_rows.begin()), rows - 1);
+}
+
+QByteArray LogViewerModel::lineBytes(int line) const
+{
+    if (line < 0 || line >= lineCount()) {
+        return QByteArray();
+    }
+
+    const qint64 begin = m_offsets[static_cast<size_t>(line)];
+    const qint64 end = line + 1 < lineCount() ? m_offsets[static_cast<size_t>(line) + 1] : m_indexedEnd;
+    const qint64 length = qMin(end - begin, MAX_LINE_BYTES);
+
+    // 文件增长后扩大映射（日志只会追加，映射范围内的内容不会改变）
+    if (end > m_mappedSize && m_file.isOpen()) {
+        if (m_map) {
+            m_file.unmap(m_map);
+            m_map = nullptr;
+            m_mappedSize = 0;
+        }
+        const qint64 size = qMax(m_fileSize, m_indexedEnd);
+        m_map = m_file.map(0, size);
+        if (m_map) {
+            m_mappedSize = size;
+        }
+    }
+
+    QByteArray bytes;
+    if (m_map && end <= m_mappedSize) {
+        bytes = QByteArray(reinterpret_cast<const char*>(m_map + begin), length);
+    } else if (m_file.seek(begin)) {
+        bytes = m_file.read(length);
+    }
+
+    while (bytes.endsWith('\n') || bytes.endsWith('\r')) {
+        bytes.chop(1);
+    }
+    if (end - begin > MAX_LINE_BYTES) {
+        bytes.append("…");
+    }
+    return bytes;
+}
@@ -0,0 +1,203 @@
+#ifndef LOGVIEWERMODEL_H
+#define LOGVIEWERMODEL_H
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QStringList>
+#include <QTimer>
+#include <memory>
+#include <vector>
+
+#include "LogIndexer.h"
+
+// 日志查看器模型：
+// 文本日志由LogIndexer在后台建立行索引（偏移、等级、分类），模型只保存索引，
+// 视图需要哪一行时才从映射的文件中取出该行的文字，几GB的日志也能流畅滚动。
+// 等级、分类过滤直接扫描索引；搜索在索引线程中进行，结果按行号保存。
+// 文件追加内容后只索引新增部分（跟随LogManager正在写入的日志）。
+class LogViewerModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QString source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(bool followCurrentLog READ followCurrentLog WRITE setFollowCurrentLog NOTIFY followCurrentLogChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(int lineCount READ lineCount NOTIFY lineCountChanged)
+    Q_PROPERTY(qint64 fileSize READ fileSize NOTIFY progressChanged)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(bool indexing READ indexing NOTIFY progressChanged)
+    Q_PROPERTY(int minimumLevel READ minimumLevel WRITE setMinimumLevel NOTIFY filterChanged)
+    Q_PROPERTY(QString category READ category WRITE setCategory NOTIFY filterChanged)
+    Q_PROPERTY(bool matchesOnly READ matchesOnly WRITE setMatchesOnly NOTIFY filterChanged)
+    Q_PROPERTY(QStringList categories READ categories NOTIFY categoriesChanged)
+    Q_PROPERTY(QString searchText READ searchText WRITE setSearchText NOTIFY searchChanged)
+    Q_PROPERTY(bool caseSensitive READ caseSensitive WRITE setCaseSensitive NOTIFY searchChanged)
+    Q_PROPERTY(int matchCount READ matchCount NOTIFY matchesChanged)
+    Q_PROPERTY(bool searching READ searching NOTIFY matchesChanged)
+    Q_PROPERTY(QString errorString READ errorString NOTIFY errorStringChanged)
+
+public:
+    enum Roles {
+        LineNumberRole = Qt::UserRole + 1,
+        TextRole,
+        LevelRole,
+        CategoryRole,
+        MatchedRole
+    };
+
+    explicit LogViewerModel(QObject *parent = nullptr);
+    ~LogViewerModel() override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // 查看的日志文件，设置为其他文件时不再跟随当前日志
+    QString source() const { return m_source; }
+    void setSource(const QString &source);
+
+    // 跟随LogManager正在写入的日志文件（分段切换后自动打开新文件）
+    bool followCurrentLog() const { return m_followCurrentLog; }
+    void setFollowCurrentLog(bool follow);
+
+    // 过滤后的行数和文件总行数
+    int count() const { return rowCount(); }
+    int lineCount() const { return static_cast<int>(m_offsets.size()); }
+
+    qint64 fileSize() const { return m_fileSize; }
+    qreal progress() const;
+    bool indexing() const { return m_indexing; }
+
+    // 最低等级（LogIndexer::Level：0调试、1信息、2警告、3严重、4致命）
+    int minimumLevel() const { return m_minimumLevel; }
+    void setMinimumLevel(int level);
+
+    // 只显示一个分类，空字符串显示全部，"default"为默认分类
+    QString category() const { return m_category; }
+    void setCategory(const QString &category);
+
+    // 只显示匹配搜索的行
+    bool matchesOnly() const { return m_matchesOnly; }
+    void setMatchesOnly(bool matchesOnly);
+
+    // 文件中出现过的分类（第一个是"default"）
+    QStringList categories() const { return m_categories; }
+
+    QString searchText() const { return m_searchText; }
+    void setSearchText(const QString &text);
+
+    bool caseSensitive() const { return m_caseSensitive; }
+    void setCaseSensitive(bool caseSensitive);
+
+    int matchCount() const { return static_cast<int>(m_matchLines.size()); }
+    bool searching() const { return m_searching; }
+
+    QString errorString() const { return m_errorString; }
+
+    // 行号（从1开始）对应的行，该行被过滤掉时返回其后第一个显示的行
+    Q_INVOKABLE int rowForLine(int lineNumber) const;
+
+    // 第一条时间不早于time的日志所在的行
+    Q_INVOKABLE int rowForTime(const QDateTime &time) const;
+
+    // row之后（之前）第一个匹配搜索的行，没有时返回-1
+    Q_INVOKABLE int nextMatch(int row) const;
+    Q_INVOKABLE int previousMatch(int row) const;
+
+    // 重新打开并索引文件
+    Q_INVOKABLE void reload();
+
+signals:
+    void sourceChanged();
+    void followCurrentLogChanged();
+    void countChanged();
+    void lineCountChanged();
+    void progressChanged();
+    void filterChanged();
+    void categoriesChanged();
+    void searchChanged();
+    void matchesChanged();
+    void errorStringChanged();
+
+private:
+    // 索引线程的结果（在主线程中处理）
+    void onChunk(const std::shared_ptr<LogIndexer::Chunk> &chunk);
+    void onSearchResult(const std::shared_ptr<LogIndexer::SearchResult> &result);
+
+    // 检查文件是否增长、被截断或替换；跟随当前日志时检查是否已切换分段
+    void checkFile();
+
+    // 打开m_source并从头索引
+    void openSource();
+
+    // 关闭文件并清空索引（在beginResetModel/endResetModel之间调用）
+    void clearIndex();
+
+    // 搜索条件改变，清空结果后重新搜索
+    void restartSearch();
+
+    // 从已索引但还没搜索的位置继续搜索
+    void continueSearch();
+
+    // 重新计算显示的行
+    void rebuildRows();
+
+    // 行是否通过过滤
+    bool isLineVisible(int line) const;
+    bool isMatch(int line) const;
+
+    // 行对应的显示行号，被过滤时返回-1
+    int rowOfLine(int line) const;
+    int lineOfRow(int row) const { return m_filtered ? m_rows[static_cast<size_t>(row)] : row; }
+
+    // 第一个行号不小于line的显示行，没有时返回最后一行
+    int rowAtOrAfter(int line) const;
+
+    // 一行的内容（不含换行符）
+    QByteArray lineBytes(int line) const;
+
+    std::unique_ptr<LogIndexer> m_indexer;
+    quint64 m_generation;
+
+    QString m_source;
+    bool m_followCurrentLog;
+    bool m_fileMissing;
+    QString m_errorString;
+
+    // 主线程读取行内容用的映射（按需扩大）
+    mutable QFile m_file;
+    mutable uchar *m_map;
+    mutable qint64 m_mappedSize;
+
+    // 行索引
+    std::vector<qint64> m_offsets;
+    std::vector<quint8> m_levels;
+    std::vector<quint8> m_lineCategories;
+    std::vector<quint32> m_blockTimes;
+    QStringList m_categories;
+    qint64 m_indexedEnd;
+    qint64 m_fileSize;
+    bool m_indexing;
+
+    // 过滤
+    int m_minimumLevel;
+    QString m_category;
+    int m_categoryId;                   // -1为全部，-2为文件中还没有出现的分类
+    bool m_matchesOnly;
+    bool m_filtered;
+    std::vector<int> m_rows;            // 过滤时显示的行号
+
+    // 搜索
+    QString m_searchText;
+    bool m_caseSensitive;
+    int m_searchId;
+    bool m_searching;
+    qint64 m_searchedEnd;
+    std::vector<int> m_matchLines;      // 匹配的行号（升序）
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_pollTimer;
+};
+
+#endif // LOGVIEWERMODEL_H
@@ -1,185 +1,225 @@
 #include "SettingsManager.h"
-#include <QRegularExpression>
+#include "SettingsStore.h"
+#include "WallpaperCache.h"
+#include "LogCategories.h"
 
 // 固定壁纸文件名
 const QString SettingsManager::WALLPAPER_FILENAME = "wallpaper";
 
 SettingsManager::SettingsManager(QObject *parent)
     : QObject(parent)
+    , m_settingsMap(new QQmlPropertyMap(this))
 {
-    // 设置文件路径
-    QString configPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/ZiyanOS/config.ini";
-    QFileInfo configFile(configPath);
-    QDir configDir = configFile.absoluteDir();
-
-    // 确保配置目录存在
-    if (!configDir.exists()) {
-        configDir.mkpath(".");
+    // 所有实例共用同一份设置，配置文件只在第一次使用时加载
+    SettingsStore *store = SettingsStore::instance();
+    store->load();
+    connect(store, &SettingsStore::settingChanged, this, &SettingsManager::onSettingChanged);
+
+    // 属性表由声明表生成
+    for (int id = 0; id < SettingsSchema::Count; ++id) {
+        m_settingsMap->insert(QString::fromLatin1(SettingsSchema::Definitions[id].property),
+                              store->value(static_cast<SettingsSchema::Id>(id)));
     }
-
-    m_settings = new QSettings(configPath, QSettings::IniFormat, this);
+    connect(m_settingsMap, &QQmlPropertyMap::valueChanged, this, &SettingsManager::onSettingsMapChanged);
 
     // 初始化壁纸目录
     initializeWallpaperDir();
-
-    // 加载设置
-    loadSettings();
 }
 
 QString SettingsManager::desktopBackground() const
 {
-    return m_desktopBackground;
+    return SettingsStore::instance()->value(SettingsSchema::DesktopBackground).toString();
 }
 
 void SettingsManager::setDesktopBackground(const QString &background)
 {
-    if (m_desktopBackground != background) {
-        m_desktopBackground = background;
-        emit desktopBackgroundChanged(background);
-    }
+    SettingsStore::instance()->setValue(SettingsSchema::DesktopBackground, background);
 }
 
 QString SettingsManager::desktopWallpaper() const
 {
-    return m_desktopWallpaper;
+    return SettingsStore::instance()->value(SettingsSchema::DesktopWallpaper).toString();
 }
 
 void SettingsManager::setDesktopWallpaper(const QString &wallpaper)
 {
-    if (m_desktopWallpaper != wallpaper) {
-        m_desktopWallpaper = wallpaper;
-        emit desktopWallpaperChanged(wallpaper);
-    }
+    SettingsStore::instance()->setValue(SettingsSchema::DesktopWallpaper, wallpaper);
 }
 
 // 新增：窗口标题栏模式
 QString SettingsManager::windowTitleBarMode() const
 {
-    return m_windowTitleBarMode;
+    return SettingsStore::instance()->value(SettingsSchema::WindowTitleBarMode).toString();
 }
 
 void SettingsManager::setWindowTitleBarMode(const QString &mode)
 {
-    if (m_windowTitleBarMode != mode) {
-        m_windowTitleBarMode = mode;
-        emit windowTitleBarModeChanged(mode);
-    }
+    SettingsStore::instance()->setValue(SettingsSchema::WindowTitleBarMode, mode);
 }
 
 // 新增：窗口标题栏颜色
 QString SettingsManager::windowTitleBarColor() const
 {
-    return m_windowTitleBarColor;
+    return SettingsStore::instance()->value(SettingsSchema::WindowTitleBarColor).toString();
 }
 
 void SettingsManager::setWindowTitleBarColor(const QString &color)
 {
-    if (m_windowTitleBarColor != color) {
-        m_windowTitleBarColor = color;
-        emit windowTitleBarColorChanged(color);
-    }
+    SettingsStore::instance()->setValue(SettingsSchema::WindowTitleBarColor, color);
+}
+
+QVariant SettingsManager::value(const QString &key) const
+{
+    return SettingsStore::instance()->value(key);
+}
+
+bool SettingsManager::setValue(const QString &key, const QVariant &value)
+{
+    return SettingsStore::instance()->setValue(key, value);
 }
 
 void SettingsManager::saveSettings()
 {
-    m_settings->setValue("Desktop/Background", m_desktopBackground);
-    m_settings->setValue("Desktop/Wallpaper", m_desktopWallpaper);
-    m_settings->setValue("Window/TitleBarMode", m_windowTitleBarMode);
-    m_settings->setValue("Window/TitleBarColor", m_windowTitleBarColor);
-    m_settings->setValue("Desktop/WallpaperName", m_currentWallpaperName);
-    m_settings->setValue("Desktop/WallpaperDescription", m_currentWallpaperDescription);
-    m_settings->sync();
-
-    qDebug() << "设置已保存 - 背景:" << m_desktopBackground
-             << "壁纸:" << m_desktopWallpaper
-             << "窗口模式:" << m_windowTitleBarMode
-             << "窗口颜色:" << m_windowTitleBarColor;
+    // 不在界面线程中写文件，短时间内的多次保存合并为一次写入
+    SettingsStore::instance()->save();
+
+    qCDebug(lcSettings) << "设置已保存 - 背景:" << desktopBackground()
+             << "壁纸:" << desktopWallpaper()
+             << "窗口模式:" << windowTitleBarMode()
+             << "窗口颜色:" << windowTitleBarColor();
 }
 
 void SettingsManager::setWallpaperInfo(const QString &name, const QString &description)
 {
-    if (m_currentWallpaperName != name || m_currentWallpaperDescription != description) {
-        m_currentWallpaperName = name;
-        m_currentWallpaperDescription = description;
-        emit wallpaperInfoChanged(name, description);
+    SettingsStore *store = SettingsStore::instance();
+    if (store->value(SettingsSchema::WallpaperName).toString() != name
+        || store->value(SettingsSchema::WallpaperDescription).toString() != description) {
+        store->setValues({ { SettingsSchema::Definitions[SettingsSchema::WallpaperName].key, name },
+                           { SettingsSchema::Definitions[SettingsSchema::WallpaperDescription].key, description } });
         saveSettings();
     }
 }
 
 QVariantMap SettingsManager::getWallpaperInfo() const
 {
+    SettingsStore *store = SettingsStore::instance();
     QVariantMap info;
-    info["name"] = m_currentWallpaperName;
-    info["description"] = m_currentWallpaperDescription;
+    info["name"] = store->value(SettingsSchema::WallpaperName).toString();
+    info["description"] = store->value(SettingsSchema::WallpaperDescription).toString();
     return info;
 }
 
 void SettingsManager::loadSettings()
 {
-    m_desktopBackground = m_settings->value("Desktop/Background", "#1a1a1a").toString();
-    m_desktopWallpaper = m_settings->value("Desktop/Wallpaper", "").toString();
-    m_windowTitleBarMode = m_settings->value("Window/TitleBarMode", "auto").toString();
-    m_windowTitleBarColor = m_settings->value("Window/TitleBarColor", "#3498db").toString();
-    m_currentWallpaperName = m_settings->value("Desktop/WallpaperName", "").toString();
-    m_currentWallpaperDescription = m_settings->value("Desktop/WallpaperDescription", "").toString();
-
-    qDebug() << "设置已加载 - 背景:" << m_desktopBackground
-             << "壁纸:" << m_desktopWallpaper
-             << "窗口模式:" << m_windowTitleBarMode
-             << "窗口颜色:" << m_windowTitleBarColor;
+    // 设置在启动时已加载，配置文件被外部修改时自动更新，这里只通知当前的值
+    qCDebug(lcSettings) << "设置已加载 - 背景:" << desktopBackground()
+             << "壁纸:" << desktopWallpaper()
+             << "窗口模式:" << windowTitleBarMode()
+             << "窗口颜色:" << windowTitleBarColor();
 
     // 发出信号通知属性已加载
-    emit desktopBackgroundChanged(m_desktopBackground);
-    emit desktopWallpaperChanged(m_desktopWallpaper);
-    emit windowTitleBarModeChanged(m_windowTitleBarMode);
-    emit windowTitleBarColorChanged(m_windowTitleBarColor);
+    emit desktopBackgroundChanged(desktopBackground());
+    emit desktopWallpaperChanged(desktopWallpaper());
+    emit windowTitleBarModeChanged(windowTitleBarMode());
+    emit windowTitleBarColorChanged(windowTitleBarColor());
+}
+
+void SettingsManager::onSettingChanged(SettingsSchema::Id id, const QVariant &value)
+{
+    m_settingsMap->insert(QString::fromLatin1(SettingsSchema::Definitions[id].property), value);
+
+    // 只通知变化的属性
+    switch (id) {
+    case SettingsSchema::DesktopBackground:
+        emit desktopBackgroundChanged(value.toString());
+        break;
+    case SettingsSchema::DesktopWallpaper:
+        emit desktopWallpaperChanged(value.toString());
+        break;
+    case SettingsSchema::WindowTitleBarMode:
+        emit windowTitleBarModeChanged(value.toString());
+        break;
+    case SettingsSchema::WindowTitleBarColor:
+        emit windowTitleBarColorChanged(value.toString());
+        break;
+    case SettingsSchema::WallpaperName:
+    case SettingsSchema::WallpaperDescription: {
+        const QVariantMap info = getWallpaperInfo();
+        emit wallpaperInfoChanged(info["name"].toString(), info["description"].toString());
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void SettingsManager::onSettingsMapChanged(const QString &property, const QVariant &value)
+{
+    const int id = SettingsSchema::findProperty(property);
+    if (id < 0) {
+        return;
+    }
+
+    // 无效的值不保存，属性表恢复为当前的值
+    SettingsStore *store = SettingsStore::instance();
+    if (!store->setValue(static_cast<SettingsSchema::Id>(id), value)) {
+        m_settingsMap->insert(property, store->value(static_cast<SettingsSchema::Id>(id)));
+    }
 }
 
 // 新增：初始化壁纸目录
 void SettingsManager::initializeWallpaperDir()
 {
     QString wallpaperDir = getWallpaperDir();
+
+    // 构建壁纸文件路径（不包含扩展名）
+    m_wallpaperPath = wallpaperDir + "/" + WALLPAPER_FILENAME;
+
+    // 目录只需要在进程中检查一次
+    static bool checked = false;
+    if (checked) {
+        return;
+    }
+    checked = true;
+
     QDir dir(wallpaperDir);
     if (!dir.exists()) {
         if (dir.mkpath(".")) {
-            qDebug() << "创建壁纸目录:" << wallpaperDir;
+            qCDebug(lcSettings) << "创建壁纸目录:" << wallpaperDir;
         } else {
-            qWarning() << "无法创建壁纸目录:" << wallpaperDir;
+            qCWarning(lcSettings) << "无法创建壁纸目录:" << wallpaperDir;
         }
     }
 
-    // 构建壁纸文件路径（不包含扩展名）
-    m_wallpaperPath = wallpaperDir + "/" + WALLPAPER_FILENAME;
-
-    qDebug() << "壁纸文件路径:" << m_wallpaperPath;
+    qCDebug(lcSettings) << "壁纸文件路径:" << m_wallpaperPath;
 }
 
 // 新增：保存壁纸图片到本地（覆盖式）
 QString SettingsManager::saveWallpaperImage(const QString &sourcePath)
 {
     if (sourcePath.isEmpty()) {
-        qWarning() << "壁纸源路径为空";
+        qCWarning(lcSettings) << "壁纸源路径为空";
         return "";
     }
 
     // 检查源文件是否存在
     QFileInfo sourceFile(sourcePath);
     if (!sourceFile.exists()) {
-        qWarning() << "壁纸源文件不存在:" << sourcePath;
+        qCWarning(lcSettings) << "壁纸源文件不存在:" << sourcePath;
         return "";
     }
 
     // 获取支持的图片扩展名
     QString extension = getImageExtension(sourcePath);
     if (extension.isEmpty()) {
-        qWarning() << "不支持的图片格式:" << sourcePath;
+        qCWarning(lcSettings) << "不支持的图片格式:" << sourcePath;
         return "";
     }
 
     // 构建完整的壁纸文件路径（包含扩展名）
     QString fullWallpaperPath = m_wallpaperPath + extension;
 
-    qDebug() << "保存壁纸到:" << fullWallpaperPath;
+    qCDebug(lcSettings) << "保存壁纸到:" << fullWallpaperPath;
 
     // 先尝试删除旧的壁纸文件（所有可能的扩展名）
     QStringList extensions = {".jpg", ".jpeg", ".png", ".bmp", ".gif"};
@@ -187,28 +227,31 @@ QString SettingsManager::saveWallpaperImage(const QString &sourcePath)
         QString oldPath = m_wallpaperPath + ext;
         if (QFile::exists(oldPath)) {
             QFile::remove(oldPath);
-            qDebug() << "删除旧的壁纸文件:" << oldPath;
+            qCDebug(lcSettings) << "删除旧的壁纸文件:" << oldPath;
         }
     }
 
     // 复制图片文件（覆盖式）
     if (QFile::copy(sourcePath, fullWallpaperPath)) {
-        qDebug() << "壁纸图片已保存（覆盖式）:" << fullWallpaperPath;
+        qCDebug(lcSettings) << "壁纸图片已保存（覆盖式）:" << fullWallpaperPath;
 
         // 转换为 file:// URL 格式
         QString fileUrl = "file:///" + fullWallpaperPath.replace("\\", "/");
+        // 在后台为各个屏幕生成缩小后的壁纸
+        WallpaperCache::instance()->prepare(fileUrl);
         return fileUrl;
     } else {
-        qWarning() << "无法保存壁纸图片:" << sourcePath << "到:" << fullWallpaperPath;
+        qCWarning(lcSettings) << "无法保存壁纸图片:" << sourcePath << "到:" << fullWallpaperPath;
 
         // 尝试使用QImage保存
         QImage image(sourcePath);
         if (!image.isNull() && image.save(fullWallpaperPath)) {
-            qDebug() << "壁纸通过QImage保存成功:" << fullWallpaperPath;
+            qCDebug(lcSettings) << "壁纸通过QImage保存成功:" << fullWallpaperPath;
             QString fileUrl = "file:///" + fullWallpaperPath.replace("\\", "/");
+            WallpaperCache::instance()->prepare(fileUrl);
             return fileUrl;
         } else {
-            qWarning() << "壁纸保存失败:" << sourcePath;
+            qCWarning(lcSettings) << "壁纸保存失败:" << sourcePath;
             return "";
         }
     }
@@ -224,10 +267,10 @@ bool SettingsManager::removeWallpaperFile()
         QString wallpaperPath = m_wallpaperPath + ext;
         if (QFile::exists(wallpaperPath)) {
             if (QFile::remove(wallpaperPath)) {
-                qDebug() << "壁纸文件已删除:" << wallpaperPath;
+                qCDebug(lcSettings) << "壁纸文件已删除:" << wallpaperPath;
                 removed = true;
             } else {
-                qWarning() << "无法删除壁纸文件:" << wallpaperPath;
+                qCWarning(lcSettings) << "无法删除壁纸文件:" << wallpaperPath;
             }
         }
     }
@@ -279,9 +322,6 @@ QString SettingsManager::getWallpaperDir() const
 // 新增：验证颜色字符串
 bool SettingsManager::isValidColor(const QString &color)
 {
-    if (color.isEmpty()) return false;
-
-    // 检查是否为有效的十六进制颜色
-    QRegularExpression hexRegex("^#([A-Fa-f0-9]{6}|[A-Fa-f0-9]{3})$");
-    return hexRegex.match(color).hasMatch();
+    // 与声明表中颜色设置的校验相同
+    return SettingsSchema::isValidColor(color);
 }
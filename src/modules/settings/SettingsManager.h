@@ -10,7 +10,14 @@
 #include <QImage>
 #include <QDebug>
 #include <QColor>
+#include <QQmlPropertyMap>
 
+#include "SettingsSchema.h"
+
+// 设置管理器（供QML使用）：每个窗口可以创建自己的实例，
+// 但所有实例读写同一个SettingsStore，一个窗口的修改其他窗口立即可见。
+// SettingsSchema中声明的全部设置都通过settings属性表暴露（例如settings.windowTitleBarColor），
+// 新增设置不需要在这里添加属性；下面的属性为已有的QML保留
 class SettingsManager : public QObject
 {
     Q_OBJECT
@@ -22,6 +29,9 @@ class SettingsManager : public QObject
     Q_PROPERTY(QString windowTitleBarMode READ windowTitleBarMode WRITE setWindowTitleBarMode NOTIFY windowTitleBarModeChanged)
     Q_PROPERTY(QString windowTitleBarColor READ windowTitleBarColor WRITE setWindowTitleBarColor NOTIFY windowTitleBarColorChanged)
 
+    // 声明表中的全部设置（按QML属性名），写入无效值时恢复原值
+    Q_PROPERTY(QQmlPropertyMap* settings READ settings CONSTANT)
+
 public:
     explicit SettingsManager(QObject *parent = nullptr);
 
@@ -38,7 +48,16 @@ public:
     QString windowTitleBarColor() const;
     void setWindowTitleBarColor(const QString &color);
 
+    QQmlPropertyMap* settings() const { return m_settingsMap; }
+
+    // 按配置文件中的键读写设置（例如"Window/TitleBarColor"），值无效时返回false
+    Q_INVOKABLE QVariant value(const QString &key) const;
+    Q_INVOKABLE bool setValue(const QString &key, const QVariant &value);
+
+    // 保存修改过的设置：只提交修改过的键，由SettingsWriter合并后在后台线程写入
     Q_INVOKABLE void saveSettings();
+
+    // 通知当前的设置（配置文件只在启动时解析一次）
     Q_INVOKABLE void loadSettings();
 
     // 新增：保存壁纸图片到本地（覆盖式）
@@ -66,13 +85,13 @@ signals:
     void wallpaperInfoChanged(const QString &name, const QString &description);
 
 private:
-    QSettings *m_settings;
-    QString m_desktopBackground;
-    QString m_desktopWallpaper;
+    // 声明表中的设置变化，更新属性表并发出对应属性的信号
+    void onSettingChanged(SettingsSchema::Id id, const QVariant &value);
 
-    // 新增：窗口标题栏颜色设置
-    QString m_windowTitleBarMode;
-    QString m_windowTitleBarColor;
+    // QML修改了属性表中的值
+    void onSettingsMapChanged(const QString &property, const QVariant &value);
+
+    QQmlPropertyMap *m_settingsMap;
 
     // 新增：壁纸文件路径
     QString m_wallpaperPath;
@@ -88,9 +107,6 @@ private:
 
     // 新增：获取壁纸目录
     QString getWallpaperDir() const;
-
-    QString m_currentWallpaperName;
-    QString m_currentWallpaperDescription;
 };
 
 #endif // SETTINGSMANAGER_H
@@ -0,0 +1,107 @@
+#include "SettingsSchema.h"
+#include <QHash>
+#include <QRegularExpression>
+
+// 按文本查找编号的表（第一次使用时由声明表生成）
+static QHash<QString, int> buildIndex(bool byProperty)
+{
+    QHash<QString, int> index;
+    for (int id = 0; id < SettingsSchema::Count; ++id) {
+        const SettingsSchema::Definition &definition = SettingsSchema::Definitions[id];
+        index.insert(QString::fromLatin1(byProperty ? definition.property : definition.key), id);
+    }
+    return index;
+}
+
+bool SettingsSchema::isValidColor(const QString &value)
+{
+    if (value.isEmpty()) return false;
+
+    // 检查是否为有效的十六进制颜色
+    static const QRegularExpression hexRegex("^#([A-Fa-f0-9]{6}|[A-Fa-f0-9]{3})$");
+    return hexRegex.match(value).hasMatch();
+}
+
+bool SettingsSchema::isValidTitleBarMode(const QString &value)
+{
+    return value == "auto" || value == "custom";
+}
+
+bool SettingsSchema::isValidSlideshowInterval(const QString &value)
+{
+    bool ok = false;
+    const int seconds = value.toInt(&ok);
+    return ok && seconds >= 5 && seconds <= 86400;
+}
+
+bool SettingsSchema::isValidSlideshowOrder(const QString &value)
+{
+    return value == "sequential" || value == "random";
+}
+
+bool SettingsSchema::isValidDownloadCacheLimit(const QString &value)
+{
+    bool ok = false;
+    const int megabytes = value.toInt(&ok);
+    return ok && megabytes >= 0 && megabytes <= 1024 * 1024;
+}
+
+int SettingsSchema::find(const QString &key)
+{
+    static const QHash<QString, int> index = buildIndex(false);
+    return index.value(key, -1);
+}
+
+int SettingsSchema::findProperty(const QString &property)
+{
+    static const QHash<QString, int> index = buildIndex(true);
+    return index.value(property, -1);
+}
+
+QVariant SettingsSchema::defaultValue(Id id)
+{
+    QVariant value;
+    normalize(id, QString::fromUtf8(Definitions[id].defaultValue), &value);
+    return value;
+}
+
+bool SettingsSchema::normalize(Id id, const QVariant &value, QVariant *result)
+{
+    const Definition &definition = Definitions[id];
+
+    // 配置文件中读出的值都是文本
+    const QString text = value.toString();
+    if (definition.validator && !definition.validator(text)) {
+        return false;
+    }
+
+    switch (definition.type) {
+    case TypeString:
+    case TypeColor:
+        *result = text;
+        return true;
+    case TypeBool:
+        if (value.typeId() == QMetaType::Bool) {
+            *result = value;
+            return true;
+        }
+        if (text == "true" || text == "1") {
+            *result = true;
+            return true;
+        }
+        if (text == "false" || text == "0") {
+            *result = false;
+            return true;
+        }
+        return false;
+    case TypeInt: {
+        bool ok = false;
+        const int number = text.toInt(&ok);
+        if (ok) {
+            *result = number;
+        }
+        return ok;
+    }
+    }
+    return false;
+}
@@ -0,0 +1,131 @@
+#ifndef SETTINGSSCHEMA_H
+#define SETTINGSSCHEMA_H
+
+#include <QString>
+#include <QVariant>
+
+// 设置声明表：每个设置只在这里声明一次，编号、键表、QML属性表和快照的顺序都由它生成。
+// 新增设置只需要加一行：X(编号, QML属性名, 配置文件中的键, 类型, 默认值, 校验函数或nullptr)
+#define ZIYANOS_SETTINGS(X) \
+    X(DesktopBackground,    "desktopBackground",    "Desktop/Background",           TypeColor,  "#1a1a1a", isValidColor) \
+    X(DesktopWallpaper,     "desktopWallpaper",     "Desktop/Wallpaper",            TypeString, "",        nullptr) \
+    X(WindowTitleBarMode,   "windowTitleBarMode",   "Window/TitleBarMode",          TypeString, "auto",    isValidTitleBarMode) \
+    X(WindowTitleBarColor,  "windowTitleBarColor",  "Window/TitleBarColor",         TypeColor,  "#3498db", isValidColor) \
+    X(WallpaperName,        "wallpaperName",        "Desktop/WallpaperName",        TypeString, "",        nullptr) \
+    X(WallpaperDescription, "wallpaperDescription", "Desktop/WallpaperDescription", TypeString, "",        nullptr) \
+    X(SlideshowEnabled,     "slideshowEnabled",     "Desktop/SlideshowEnabled",     TypeBool,   "false",   nullptr) \
+    X(SlideshowInterval,    "slideshowInterval",    "Desktop/SlideshowInterval",    TypeInt,    "300",     isValidSlideshowInterval) \
+    X(SlideshowOrder,       "slideshowOrder",       "Desktop/SlideshowOrder",       TypeString, "sequential", isValidSlideshowOrder) \
+    X(DownloadCacheLimit,   "downloadCacheLimit",   "Download/CacheLimitMB",        TypeInt,    "0",       isValidDownloadCacheLimit)
+
+// 设置的类型和声明表（全部在编译期确定，按编号直接索引）
+class SettingsSchema
+{
+public:
+    enum Id : int {
+#define ZIYANOS_SETTING_ID(id, property, key, type, defaultValue, validator) id,
+        ZIYANOS_SETTINGS(ZIYANOS_SETTING_ID)
+#undef ZIYANOS_SETTING_ID
+        Count
+    };
+
+    enum Type : quint8 {
+        TypeString,
+        TypeColor,      // "#rgb"或"#rrggbb"
+        TypeBool,
+        TypeInt
+    };
+
+    // 校验函数：值（已转换为文本）是否有效
+    typedef bool (*Validator)(const QString &value);
+
+    struct Definition {
+        const char *property;
+        const char *key;
+        Type type;
+        const char *defaultValue;
+        Validator validator;
+    };
+
+    // 校验函数（声明表中使用）
+    static bool isValidColor(const QString &value);
+    static bool isValidTitleBarMode(const QString &value);
+    static bool isValidSlideshowInterval(const QString &value);     // 秒，5秒到1天
+    static bool isValidSlideshowOrder(const QString &value);        // "sequential"或"random"
+    static bool isValidDownloadCacheLimit(const QString &value);    // MB，0（关闭）到1TB
+
+    static constexpr Definition Definitions[Count] = {
+#define ZIYANOS_SETTING_DEFINITION(id, property, key, type, defaultValue, validator) \
+        { property, key, type, defaultValue, validator },
+        ZIYANOS_SETTINGS(ZIYANOS_SETTING_DEFINITION)
+#undef ZIYANOS_SETTING_DEFINITION
+    };
+
+    // 编译期按键查找编号，没有时返回-1（例如 static_assert(SettingsSchema::idOf("Desktop/Background") >= 0)）
+    static constexpr int idOf(const char *key)
+    {
+        for (int id = 0; id < Count; ++id) {
+            if (equals(Definitions[id].key, key)) {
+                return id;
+            }
+        }
+        return -1;
+    }
+
+    // 编译期检查：键和属性名都不重复
+    static constexpr bool isUnique()
+    {
+        for (int a = 0; a < Count; ++a) {
+            for (int b = a + 1; b < Count; ++b) {
+                if (equals(Definitions[a].key, Definitions[b].key)
+                    || equals(Definitions[a].property, Definitions[b].property)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // 声明表的指纹（FNV-1a），声明表变化后旧的快照失效
+    static constexpr quint64 fingerprint()
+    {
+        quint64 hash = 14695981039346656037ULL;
+        for (int id = 0; id < Count; ++id) {
+            hash = hashText(hash, Definitions[id].key);
+            hash = (hash ^ Definitions[id].type) * 1099511628211ULL;
+            hash = hashText(hash, Definitions[id].defaultValue);
+        }
+        return hash;
+    }
+
+    // 运行时按键（配置文件中的键）或QML属性名查找编号，没有时返回-1
+    static int find(const QString &key);
+    static int findProperty(const QString &property);
+
+    static QVariant defaultValue(Id id);
+
+    // 把配置文件或QML中的值转换为设置的类型并校验，无效时返回false
+    static bool normalize(Id id, const QVariant &value, QVariant *result);
+
+private:
+    static constexpr bool equals(const char *a, const char *b)
+    {
+        while (*a && *a == *b) {
+            ++a;
+            ++b;
+        }
+        return *a == *b;
+    }
+
+    static constexpr quint64 hashText(quint64 hash, const char *text)
+    {
+        while (*text) {
+            hash = (hash ^ static_cast<unsigned char>(*text++)) * 1099511628211ULL;
+        }
+        return (hash ^ 0xFF) * 1099511628211ULL;
+    }
+};
+
+static_assert(SettingsSchema::isUnique(), "设置声明表中有重复的键或属性名");
+
+#endif // SETTINGSSCHEMA_H
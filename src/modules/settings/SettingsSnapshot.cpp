@@ -0,0 +1,105 @@
+#include "SettingsSnapshot.h"
+#include "LogCategories.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// 快照文件头：魔数 + 版本
+static const quint32 SNAPSHOT_MAGIC = 0x5353455A;   // "ZESS"
+static const quint32 SNAPSHOT_VERSION = 1;
+
+QString SettingsSnapshot::snapshotPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/settings/config.snapshot";
+}
+
+SettingsSnapshot::FileStamp SettingsSnapshot::stamp(const QString &iniPath)
+{
+    FileStamp result;
+    const QFileInfo info(iniPath);
+    if (info.exists()) {
+        result.size = info.size();
+        result.modified = info.lastModified().toMSecsSinceEpoch();
+    }
+    return result;
+}
+
+bool SettingsSnapshot::read(const QString &iniPath, Content *content)
+{
+    const FileStamp current = stamp(iniPath);
+    if (current.size < 0) {
+        return false;
+    }
+
+    QFile file(snapshotPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint64 fingerprint = 0;
+    qint64 size = 0;
+    qint64 modified = 0;
+    in >> magic >> version >> fingerprint >> size >> modified;
+    if (in.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION
+        || fingerprint != SettingsSchema::fingerprint()) {
+        return false;
+    }
+    if (size != current.size || modified != current.modified) {
+        qCDebug(lcSettings) << "配置文件已修改，设置快照失效";
+        return false;
+    }
+
+    for (int id = 0; id < SettingsSchema::Count; ++id) {
+        in >> content->values[id];
+    }
+    in >> content->extraValues;
+    return in.status() == QDataStream::Ok;
+}
+
+bool SettingsSnapshot::write(const QString &iniPath, const FileStamp &iniStamp, const QHash<QString, QVariant> &values)
+{
+    if (iniStamp.size < 0) {
+        return false;
+    }
+
+    // 声明表中的设置按编号顺序写入，其余的键另存
+    QHash<QString, QVariant> extraValues = values;
+    QVariant schemaValues[SettingsSchema::Count];
+    for (int id = 0; id < SettingsSchema::Count; ++id) {
+        const QString key = QString::fromLatin1(SettingsSchema::Definitions[id].key);
+        schemaValues[id] = extraValues.take(key);
+    }
+
+    const QString path = snapshotPath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcSettings) << "无法写入设置快照:" << file.fileName();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << SettingsSchema::fingerprint()
+        << iniStamp.size << iniStamp.modified;
+    for (const QVariant &value : schemaValues) {
+        out << value;
+    }
+    out << extraValues;
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qCWarning(lcSettings) << "设置快照写入失败:" << file.fileName();
+        return false;
+    }
+    return true;
+}
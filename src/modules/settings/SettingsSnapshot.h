@@ -0,0 +1,41 @@
+#ifndef SETTINGSSNAPSHOT_H
+#define SETTINGSSNAPSHOT_H
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+
+#include "SettingsSchema.h"
+
+// 设置的二进制快照（缓存目录/settings/config.snapshot）：
+// 声明表中的设置按编号顺序保存，启动时直接读入数组，不需要解析INI文本。
+// 快照记录了对应的config.ini的大小和修改时间，配置文件被修改过（或声明表变化）时快照失效，
+// 改为解析INI。快照只是缓存，config.ini始终是完整的设置。
+// 快照不放在配置目录中：SettingsStore监视配置目录，写入快照会被当成外部修改而重新读取配置文件。
+class SettingsSnapshot
+{
+public:
+    // 配置文件的大小和修改时间
+    struct FileStamp {
+        qint64 size = -1;
+        qint64 modified = 0;
+    };
+
+    // 快照中的内容：声明表中的设置（文件中没有的为无效值）和其他的键
+    struct Content {
+        QVariant values[SettingsSchema::Count];
+        QHash<QString, QVariant> extraValues;
+    };
+
+    static QString snapshotPath();
+
+    static FileStamp stamp(const QString &iniPath);
+
+    // 读取与配置文件当前内容一致的快照，没有或已失效时返回false
+    static bool read(const QString &iniPath, Content *content);
+
+    // 保存配置文件的全部键值（iniStamp为读取这些键值之前的文件状态），通过临时文件原子替换
+    static bool write(const QString &iniPath, const FileStamp &iniStamp, const QHash<QString, QVariant> &values);
+};
+
+#endif // SETTINGSSNAPSHOT_H
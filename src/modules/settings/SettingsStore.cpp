@@ -0,0 +1,265 @@
+#include "SettingsStore.h"
+#include "SettingsSnapshot.h"
+#include "SettingsWriter.h"
+#include "LogCategories.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <mutex>
+
+// 文件变化后等待的时间（毫秒），外部编辑器可能分几次写入
+static const int RELOAD_DELAY_MS = 200;
+
+SettingsStore* SettingsStore::m_instance = nullptr;
+
+// INI文件中的值读出来都是字符串，与内存中的值按文本比较
+static bool sameFileValue(const QVariant &memoryValue, const QVariant &fileValue)
+{
+    return memoryValue == fileValue || memoryValue.toString() == fileValue.toString();
+}
+
+SettingsStore::SettingsStore(QObject *parent)
+    : QObject(parent)
+    , m_path(SettingsWriter::configFilePath())
+    , m_loaded(false)
+{
+    for (int id = 0; id < SettingsSchema::Count; ++id) {
+        m_values[id] = SettingsSchema::defaultValue(static_cast<SettingsSchema::Id>(id));
+    }
+
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(RELOAD_DELAY_MS);
+    connect(&m_reloadTimer, &QTimer::timeout, this, &SettingsStore::reloadChangedKeys);
+
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, [this]() { m_reloadTimer.start(); });
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, [this]() { m_reloadTimer.start(); });
+}
+
+SettingsStore* SettingsStore::instance()
+{
+    static std::mutex instanceMutex;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+
+    if (!m_instance) {
+        m_instance = new SettingsStore();
+    }
+    return m_instance;
+}
+
+void SettingsStore::load()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    // 确保配置目录存在
+    QDir configDir = QFileInfo(m_path).absoluteDir();
+    if (!configDir.exists()) {
+        configDir.mkpath(".");
+    }
+
+    SettingsSnapshot::Content snapshot;
+    if (SettingsSnapshot::read(m_path, &snapshot)) {
+        // 快照中的设置已按编号排列
+        for (int id = 0; id < SettingsSchema::Count; ++id) {
+            assignFileValue(static_cast<SettingsSchema::Id>(id), snapshot.values[id]);
+        }
+        m_extraValues = snapshot.extraValues;
+        qCDebug(lcSettings) << "设置已从快照加载";
+    } else {
+        // 快照不存在或已失效：解析INI并重新生成快照
+        const SettingsSnapshot::FileStamp stamp = SettingsSnapshot::stamp(m_path);
+        const QHash<QString, QVariant> fileValues = parseConfigFile();
+        applyFileValues(fileValues, false);
+        SettingsSnapshot::write(m_path, stamp, fileValues);
+        qCDebug(lcSettings) << "设置已从配置文件加载:" << fileValues.size() << "个键";
+    }
+
+    watchConfigFile();
+}
+
+QVariant SettingsStore::value(const QString &key, const QVariant &defaultValue) const
+{
+    const int id = SettingsSchema::find(key);
+    if (id >= 0) {
+        return m_values[id];
+    }
+
+    auto it = m_extraValues.constFind(key);
+    return it != m_extraValues.cend() ? it.value() : defaultValue;
+}
+
+bool SettingsStore::setValue(SettingsSchema::Id id, const QVariant &value)
+{
+    return setValues({ { QString::fromLatin1(SettingsSchema::Definitions[id].key), value } });
+}
+
+bool SettingsStore::setValue(const QString &key, const QVariant &value)
+{
+    return setValues({ { key, value } });
+}
+
+bool SettingsStore::setValues(const QVariantHash &values)
+{
+    load();
+
+    bool allValid = true;
+    QStringList changedKeys;
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        const int id = SettingsSchema::find(it.key());
+        if (id >= 0) {
+            QVariant normalized;
+            if (!SettingsSchema::normalize(static_cast<SettingsSchema::Id>(id), it.value(), &normalized)) {
+                qCWarning(lcSettings) << "设置值无效，已忽略:" << it.key() << it.value();
+                allValid = false;
+                continue;
+            }
+            if (m_values[id] == normalized) {
+                continue;
+            }
+            m_values[id] = normalized;
+        } else {
+            auto current = m_extraValues.constFind(it.key());
+            if (current != m_extraValues.cend() && current.value() == it.value()) {
+                continue;
+            }
+            m_extraValues.insert(it.key(), it.value());
+        }
+        m_unsaved.insert(it.key());
+        changedKeys.append(it.key());
+    }
+
+    for (const QString &key : changedKeys) {
+        notifyChanged(key);
+    }
+    return allValid;
+}
+
+void SettingsStore::save()
+{
+    if (m_unsaved.isEmpty()) {
+        return;
+    }
+
+    QVariantHash values;
+    for (const QString &key : m_unsaved) {
+        values.insert(key, value(key));
+    }
+    m_unsaved.clear();
+
+    SettingsWriter::instance()->setValues(values);
+}
+
+QHash<QString, QVariant> SettingsStore::parseConfigFile() const
+{
+    // 新的QSettings会检查文件的修改时间，文件变化时重新读取
+    QSettings settings(m_path, QSettings::IniFormat);
+    QHash<QString, QVariant> fileValues;
+    const QStringList keys = settings.allKeys();
+    for (const QString &key : keys) {
+        fileValues.insert(key, settings.value(key));
+    }
+    return fileValues;
+}
+
+bool SettingsStore::assignFileValue(SettingsSchema::Id id, const QVariant &fileValue)
+{
+    QVariant value = SettingsSchema::defaultValue(id);
+    if (fileValue.isValid() && !SettingsSchema::normalize(id, fileValue, &value)) {
+        qCWarning(lcSettings) << "配置文件中的设置值无效，使用默认值:" << SettingsSchema::Definitions[id].key << fileValue;
+        value = SettingsSchema::defaultValue(id);
+    }
+
+    if (m_values[id] == value) {
+        return false;
+    }
+    m_values[id] = value;
+    return true;
+}
+
+QStringList SettingsStore::applyFileValues(const QHash<QString, QVariant> &fileValues, bool skipLocal)
+{
+    QStringList changedKeys;
+
+    // 声明表中的设置：文件中没有时恢复默认值
+    for (int id = 0; id < SettingsSchema::Count; ++id) {
+        const QString key = QString::fromLatin1(SettingsSchema::Definitions[id].key);
+        if (skipLocal && isLocallyModified(key)) {
+            continue;
+        }
+        if (assignFileValue(static_cast<SettingsSchema::Id>(id), fileValues.value(key))) {
+            changedKeys.append(key);
+        }
+    }
+
+    // 其他的键
+    for (auto it = fileValues.cbegin(); it != fileValues.cend(); ++it) {
+        if (SettingsSchema::find(it.key()) >= 0 || (skipLocal && isLocallyModified(it.key()))) {
+            continue;
+        }
+        auto current = m_extraValues.constFind(it.key());
+        if (current != m_extraValues.cend() && sameFileValue(current.value(), it.value())) {
+            continue;
+        }
+        m_extraValues.insert(it.key(), it.value());
+        changedKeys.append(it.key());
+    }
+
+    QStringList removedKeys;
+    for (auto it = m_extraValues.cbegin(); it != m_extraValues.cend(); ++it) {
+        if (!fileValues.contains(it.key()) && !(skipLocal && isLocallyModified(it.key()))) {
+            removedKeys.append(it.key());
+        }
+    }
+    for (const QString &key : removedKeys) {
+        m_extraValues.remove(key);
+    }
+
+    return changedKeys + removedKeys;
+}
+
+void SettingsStore::reloadChangedKeys()
+{
+    watchConfigFile();
+
+    const QStringList changedKeys = applyFileValues(parseConfigFile(), true);
+
+    // 自己写入文件引起的通知不会有变化的键
+    if (changedKeys.isEmpty()) {
+        return;
+    }
+
+    qCInfo(lcSettings) << "配置文件被外部修改，更新的键:" << changedKeys;
+    for (const QString &key : changedKeys) {
+        notifyChanged(key);
+    }
+}
+
+void SettingsStore::notifyChanged(const QString &key)
+{
+    const int id = SettingsSchema::find(key);
+    if (id >= 0) {
+        emit settingChanged(static_cast<SettingsSchema::Id>(id), m_values[id]);
+    }
+    emit valueChanged(key, value(key));
+}
+
+bool SettingsStore::isLocallyModified(const QString &key) const
+{
+    // 本进程还没有保存或还没有写入的修改比文件中的内容新
+    QVariant pending;
+    return m_unsaved.contains(key) || SettingsWriter::instance()->pendingValue(key, &pending);
+}
+
+void SettingsStore::watchConfigFile()
+{
+    // 原子替换后旧文件的监视会失效；文件不存在时监视目录，等待文件被创建
+    if (QFileInfo::exists(m_path) && !m_watcher.files().contains(m_path)) {
+        m_watcher.addPath(m_path);
+    }
+    const QString dirPath = QFileInfo(m_path).absolutePath();
+    if (!m_watcher.directories().contains(dirPath)) {
+        m_watcher.addPath(dirPath);
+    }
+}
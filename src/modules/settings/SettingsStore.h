@@ -0,0 +1,90 @@
+#ifndef SETTINGSSTORE_H
+#define SETTINGSSTORE_H
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+#include <QVariant>
+
+#include "SettingsSchema.h"
+
+// 设置存储（进程内单例，在主线程中使用）：
+// 启动时加载一次设置（优先读取二进制快照，失效时解析config.ini），
+// 所有SettingsManager共用同一份内存中的设置，一个窗口修改后其他窗口通过信号立即得到新值。
+// SettingsSchema中声明的设置按编号保存在数组中，读取时直接索引；其他键按文本保存。
+// 保存时把修改过的键交给SettingsWriter在后台写入。
+// 监视配置文件，被外部修改时只更新内容变化的键。
+class SettingsStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static SettingsStore* instance();
+
+    // 加载设置（只在第一次调用时执行）
+    void load();
+
+    // 读取声明表中的设置
+    QVariant value(SettingsSchema::Id id) const { return m_values[id]; }
+
+    // 按键读取任意设置，没有该键时返回defaultValue
+    QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+
+    // 修改设置（只修改内存，save()时写入），值无效时返回false；值变化时发出信号
+    bool setValue(SettingsSchema::Id id, const QVariant &value);
+    bool setValue(const QString &key, const QVariant &value);
+
+    // 同时修改多个设置，全部修改后再逐个发出信号
+    bool setValues(const QVariantHash &values);
+
+    // 把修改过的键交给SettingsWriter写入
+    void save();
+
+signals:
+    // 声明表中的设置变化
+    void settingChanged(SettingsSchema::Id id, const QVariant &value);
+
+    // 任意键的值变化（本进程修改或配置文件被外部修改），键被删除时value无效
+    void valueChanged(const QString &key, const QVariant &value);
+
+private:
+    explicit SettingsStore(QObject *parent = nullptr);
+
+    // 读取配置文件的全部键值
+    QHash<QString, QVariant> parseConfigFile() const;
+
+    // 把配置文件中的值（文件中没有时为无效值）转换后保存为声明表中的设置，无效时使用默认值，返回是否变化
+    bool assignFileValue(SettingsSchema::Id id, const QVariant &fileValue);
+
+    // 用配置文件中的键值替换内存中的设置，返回变化的键（跳过本进程还没有写入的修改）
+    QStringList applyFileValues(const QHash<QString, QVariant> &fileValues, bool skipLocal);
+
+    // 配置文件变化后重新解析，只更新内容变化的键
+    void reloadChangedKeys();
+
+    // 发出一个键变化的信号
+    void notifyChanged(const QString &key);
+
+    // 本进程修改后还没有写入文件的键
+    bool isLocallyModified(const QString &key) const;
+
+    // 监视配置文件（原子替换后需要重新添加）
+    void watchConfigFile();
+
+    static SettingsStore *m_instance;
+
+    QString m_path;
+    bool m_loaded;
+
+    QVariant m_values[SettingsSchema::Count];   // 声明表中的设置（按编号）
+    QHash<QString, QVariant> m_extraValues;     // 其他的键
+    QSet<QString> m_unsaved;                    // 修改后还没有保存的键
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_reloadTimer;                       // 合并连续的文件变化通知
+};
+
+#endif // SETTINGSSTORE_H
@@ -0,0 +1,243 @@
+#include "SettingsWriter.h"
+#include "SettingsSnapshot.h"
+#include "LogCategories.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+
+SettingsWriter* SettingsWriter::m_instance = nullptr;
+
+SettingsWriter::SettingsWriter(QObject *parent)
+    : QObject(parent)
+    , m_path(configFilePath())
+    , m_committedSerial(0)
+    , m_writtenSerial(0)
+    , m_failedSerial(0)
+    , m_stopping(false)
+    , m_thread(nullptr)
+{
+    m_debounceTimer.setSingleShot(true);
+    connect(&m_debounceTimer, &QTimer::timeout, this, [this]() { commit(); });
+}
+
+SettingsWriter::~SettingsWriter()
+{
+    shutdown();
+}
+
+SettingsWriter* SettingsWriter::instance()
+{
+    static std::mutex instanceMutex;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+
+    if (!m_instance) {
+        m_instance = new SettingsWriter();
+    }
+    return m_instance;
+}
+
+QString SettingsWriter::configFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/ZiyanOS/config.ini";
+}
+
+void SettingsWriter::setValues(const QVariantHash &values)
+{
+    if (values.isEmpty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = values.cbegin(); it != values.cend(); ++it) {
+            m_dirty.insert(it.key(), it.value());
+        }
+    }
+
+    // 每次修改重新计时，但从这一轮第一次修改算起不超过MaxDelayMs
+    if (!m_debounceTimer.isActive()) {
+        m_firstDirty.start();
+    }
+    const qint64 remaining = MaxDelayMs - m_firstDirty.elapsed();
+    m_debounceTimer.start(static_cast<int>(qBound<qint64>(0, remaining, DebounceMs)));
+}
+
+bool SettingsWriter::pendingValue(const QString &key, QVariant *value) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // 从新到旧查找
+    for (const QVariantHash *values : { &m_dirty, &m_queued, &m_writing }) {
+        auto it = values->constFind(key);
+        if (it != values->cend()) {
+            *value = it.value();
+            return true;
+        }
+    }
+    return false;
+}
+
+quint64 SettingsWriter::commit()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_dirty.isEmpty()) {
+        return m_committedSerial;
+    }
+
+    const quint64 serial = ++m_committedSerial;
+
+    // 写入线程已停止（退出过程中还有修改）：在当前线程中直接写入
+    if (m_stopping) {
+        m_writing = m_dirty;
+        m_dirty.clear();
+        const QVariantHash batch = m_writing;
+        lock.unlock();
+
+        const bool written = writeBatch(batch);
+
+        lock.lock();
+        finishBatch(serial, written);
+        return serial;
+    }
+
+    for (auto it = m_dirty.cbegin(); it != m_dirty.cend(); ++it) {
+        m_queued.insert(it.key(), it.value());
+    }
+    m_dirty.clear();
+
+    if (!m_thread) {
+        m_thread = QThread::create([this]() { writerLoop(); });
+        m_thread->start(QThread::LowPriority);
+    }
+    m_queuedCondition.notify_one();
+    return serial;
+}
+
+bool SettingsWriter::flush()
+{
+    m_debounceTimer.stop();
+    const quint64 serial = commit();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_writtenCondition.wait(lock, [this, serial]() {
+        return m_writtenSerial >= serial || m_failedSerial >= serial;
+    });
+    return serial == 0 || m_failedSerial < serial;
+}
+
+bool SettingsWriter::shutdown()
+{
+    // 写入失败的修改已放回m_dirty，再写一次（例如文件被其他程序暂时占用）
+    const bool written = flush() || flush();
+    if (!written) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        qCWarning(lcSettings) << "退出前设置写入失败，以下修改没有保存:" << m_dirty.keys();
+    }
+
+    QThread *thread = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        thread = m_thread;
+        m_thread = nullptr;
+    }
+    m_queuedCondition.notify_all();
+
+    // 写入线程写完已提交的修改后退出
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+    return written;
+}
+
+void SettingsWriter::recoverAfterCrash()
+{
+    // QSettings原子同步时的临时文件为"config.ini.XXXXXX"（快照为缓存目录中的"config.snapshot.XXXXXX"），
+    // 重命名之前崩溃会留下来。配置文件本身要么是旧内容要么是新内容，不需要修复。
+    // 这时新进程还没有任何修改，没有需要写入的内容（上次运行中还没写入的修改只在内存中，已随进程丢失）
+    for (const QFileInfo &file : { QFileInfo(m_path), QFileInfo(SettingsSnapshot::snapshotPath()) }) {
+        QDir dir = file.absoluteDir();
+        const QStringList leftovers = dir.entryList({ file.fileName() + ".??????" }, QDir::Files | QDir::Hidden);
+        for (const QString &name : leftovers) {
+            if (dir.remove(name)) {
+                qCInfo(lcSettings) << "已删除上次写入设置时中断留下的临时文件:" << name;
+            } else {
+                qCWarning(lcSettings) << "无法删除设置临时文件:" << name;
+            }
+        }
+    }
+}
+
+void SettingsWriter::writerLoop()
+{
+    for (;;) {
+        QVariantHash batch;
+        quint64 serial = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queuedCondition.wait(lock, [this]() { return !m_queued.isEmpty() || m_stopping; });
+            if (m_queued.isEmpty()) {
+                return;
+            }
+            m_writing = m_queued;
+            m_queued.clear();
+            batch = m_writing;
+            serial = m_committedSerial;
+        }
+
+        const bool written = writeBatch(batch);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            finishBatch(serial, written);
+        }
+        m_writtenCondition.notify_all();
+    }
+}
+
+void SettingsWriter::finishBatch(quint64 serial, bool written)
+{
+    if (written) {
+        m_writtenSerial = serial;
+    } else {
+        // 写入期间又修改过的键以新的值为准
+        for (auto it = m_writing.cbegin(); it != m_writing.cend(); ++it) {
+            if (!m_dirty.contains(it.key()) && !m_queued.contains(it.key())) {
+                m_dirty.insert(it.key(), it.value());
+            }
+        }
+        m_failedSerial = serial;
+        qCWarning(lcSettings) << "设置写入失败，下次保存时重新写入:" << m_writing.keys();
+    }
+    m_writing.clear();
+}
+
+bool SettingsWriter::writeBatch(const QVariantHash &batch)
+{
+    // 每批使用独立的QSettings，sync()会合并文件中其他键的当前内容，
+    // 再通过临时文件+重命名整体替换配置文件
+    QSettings settings(m_path, QSettings::IniFormat);
+    settings.setAtomicSyncRequired(true);
+    for (auto it = batch.cbegin(); it != batch.cend(); ++it) {
+        settings.setValue(it.key(), it.value());
+    }
+    settings.sync();
+
+    if (settings.status() != QSettings::NoError) {
+        qCWarning(lcSettings) << "设置写入失败:" << m_path << "状态:" << settings.status();
+        return false;
+    }
+
+    // 同时更新二进制快照，下次启动时不需要解析INI
+    QHash<QString, QVariant> values;
+    const QStringList keys = settings.allKeys();
+    for (const QString &key : keys) {
+        values.insert(key, settings.value(key));
+    }
+    SettingsSnapshot::write(m_path, SettingsSnapshot::stamp(m_path), values);
+
+    qCDebug(lcSettings) << "设置已写入:" << batch.keys();
+    return true;
+}
@@ -0,0 +1,90 @@
+#ifndef SETTINGSWRITER_H
+#define SETTINGSWRITER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <QVariant>
+#include <condition_variable>
+#include <mutex>
+
+// 设置的延迟写入（进程内单例）：
+// SettingsManager::saveSettings()只把修改过的键交给这里，短时间内的多次修改合并为一次写入
+// （拖动颜色滑块时不会每次都重写配置文件），在后台线程中写入。
+// 写入使用QSettings的原子同步（先写临时文件再重命名替换），中途退出不会留下写了一半的配置文件。
+// 应用程序退出前必须调用shutdown()写入剩余的修改。
+class SettingsWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 最后一次修改后等待的时间（毫秒）
+    static constexpr int DebounceMs = 300;
+
+    // 连续修改时最长的写入延迟（毫秒）
+    static constexpr int MaxDelayMs = 2000;
+
+    static SettingsWriter* instance();
+
+    // 配置文件路径（文档/ZiyanOS/config.ini）
+    static QString configFilePath();
+
+    // 标记修改的键，等待合并后写入（在主线程中调用）
+    void setValues(const QVariantHash &values);
+
+    // 还没有写入文件的值（加载设置时优先使用），没有时返回false
+    bool pendingValue(const QString &key, QVariant *value) const;
+
+    // 立即写入全部修改并等待写入完成，写入失败时返回false
+    // （写入失败的修改重新放回等待合并的修改中，下一次提交时重新写入）
+    bool flush();
+
+    // 写入全部修改并停止写入线程（应用程序退出前调用，可以重复调用），
+    // 写入失败时重试一次，仍然失败时返回false
+    bool shutdown();
+
+    // 异常重启后清理上次写入中断留下的临时文件（在加载设置之前调用）
+    void recoverAfterCrash();
+
+private:
+    explicit SettingsWriter(QObject *parent = nullptr);
+    ~SettingsWriter();
+
+    // 把等待合并的修改交给写入线程，返回这批修改的序号（没有修改时返回已提交的序号）
+    quint64 commit();
+
+    // 写入线程主循环
+    void writerLoop();
+
+    // 写入一批修改并更新设置快照（在写入线程中调用）
+    bool writeBatch(const QVariantHash &batch);
+
+    // 一批修改写入结束：成功时更新已写入的序号，失败时把修改放回m_dirty（调用时必须持有m_mutex）
+    void finishBatch(quint64 serial, bool written);
+
+    static SettingsWriter *m_instance;
+
+    QString m_path;
+
+    // m_dirty：等待合并；m_queued：已提交但写入线程还没取走；m_writing：正在写入
+    mutable std::mutex m_mutex;
+    std::condition_variable m_queuedCondition;  // 有新的修改或停止
+    std::condition_variable m_writtenCondition; // 一批修改写入完成
+    QVariantHash m_dirty;
+    QVariantHash m_queued;
+    QVariantHash m_writing;
+    quint64 m_committedSerial;          // 已提交的最后一批修改的序号
+    quint64 m_writtenSerial;            // 已写入的最后一批修改的序号
+    quint64 m_failedSerial;             // 写入失败的最后一批修改的序号
+    bool m_stopping;
+
+    QThread *m_thread;
+
+    QTimer m_debounceTimer;
+    QElapsedTimer m_firstDirty;         // 这一轮第一次修改的时间
+};
+
+#endif // SETTINGSWRITER_H
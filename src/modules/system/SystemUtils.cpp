@@ -1,4 +1,5 @@
 #include "SystemUtils.h"
+#include "LogCategories.h"
 
 SystemUtils::SystemUtils(QObject *parent) : QObject(parent)
 {
@@ -10,7 +11,7 @@ bool SystemUtils::hasPecmdIni()
 #ifdef Q_OS_WINDOWS
     QString windowsPath = getWindowsPath();
     if (windowsPath.isEmpty()) {
-        qDebug() << "无法获取Windows目录路径";
+        qCDebug(lcSystem) << "无法获取Windows目录路径";
         return false;
     }
 
@@ -18,12 +19,12 @@ bool SystemUtils::hasPecmdIni()
     QFileInfo pecmdFile(pecmdIniPath);
 
     bool exists = pecmdFile.exists() && pecmdFile.isFile();
-    qDebug() << "检测pecmd.ini文件:" << pecmdIniPath << "存在:" << exists;
+    qCDebug(lcSystem) << "检测pecmd.ini文件:" << pecmdIniPath << "存在:" << exists;
 
     return exists;
 #else
     // 非Windows系统直接返回false（视为实体机）
-    qDebug() << "非Windows系统，视为实体机";
+    qCDebug(lcSystem) << "非Windows系统，视为实体机";
     return false;
 #endif
 }
@@ -38,7 +39,7 @@ bool SystemUtils::enableShutdownPrivilege()
     if (!OpenProcessToken(GetCurrentProcess(),
                           TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY,
                           &hToken)) {
-        qWarning() << "无法打开进程令牌，错误码:" << GetLastError();
+        qCWarning(lcSystem) << "无法打开进程令牌，错误码:" << GetLastError();
         return false;
     }
 
@@ -50,13 +51,13 @@ bool SystemUtils::enableShutdownPrivilege()
 
     // 调整令牌权限
     if (!AdjustTokenPrivileges(hToken, FALSE, &tkp, 0, NULL, NULL)) {
-        qWarning() << "无法调整令牌权限，错误码:" << GetLastError();
+        qCWarning(lcSystem) << "无法调整令牌权限，错误码:" << GetLastError();
         CloseHandle(hToken);
         return false;
     }
 
     CloseHandle(hToken);
-    qDebug() << "已成功启用关机权限";
+    qCDebug(lcSystem) << "已成功启用关机权限";
     return true;
 #else
     return false;
@@ -71,7 +72,7 @@ bool SystemUtils::setResolution(int width, int height)
 
     // 获取当前显示设置
     if (!EnumDisplaySettingsW(NULL, ENUM_CURRENT_SETTINGS, &devMode)) {
-        qWarning() << "无法获取当前显示设置";
+        qCWarning(lcSystem) << "无法获取当前显示设置";
         return false;
     }
 
@@ -80,7 +81,7 @@ bool SystemUtils::setResolution(int width, int height)
         originalWidth = devMode.dmPelsWidth;
         originalHeight = devMode.dmPelsHeight;
         hasOriginalResolution = true;
-        qDebug() << "保存原始分辨率:" << originalWidth << "x" << originalHeight;
+        qCDebug(lcSystem) << "保存原始分辨率:" << originalWidth << "x" << originalHeight;
     }
 
     // 设置新分辨率
@@ -92,7 +93,7 @@ bool SystemUtils::setResolution(int width, int height)
     LONG result = ChangeDisplaySettingsW(&devMode, CDS_TEST);
 
     if (result != DISP_CHANGE_SUCCESSFUL) {
-        qWarning() << "测试分辨率失败:" << width << "x" << height << "错误码:" << result;
+        qCWarning(lcSystem) << "测试分辨率失败:" << width << "x" << height << "错误码:" << result;
         return false;
     }
 
@@ -100,11 +101,11 @@ bool SystemUtils::setResolution(int width, int height)
     result = ChangeDisplaySettingsW(&devMode, 0);
 
     if (result != DISP_CHANGE_SUCCESSFUL) {
-        qWarning() << "应用分辨率失败:" << width << "x" << height << "错误码:" << result;
+        qCWarning(lcSystem) << "应用分辨率失败:" << width << "x" << height << "错误码:" << result;
         return false;
     }
 
-    qDebug() << "分辨率设置成功:" << width << "x" << height;
+    qCDebug(lcSystem) << "分辨率设置成功:" << width << "x" << height;
     return true;
 #else
     return false;
@@ -114,7 +115,7 @@ bool SystemUtils::setResolution(int width, int height)
 bool SystemUtils::restoreOriginalResolution()
 {
     if (!hasOriginalResolution) {
-        qWarning() << "没有保存原始分辨率";
+        qCWarning(lcSystem) << "没有保存原始分辨率";
         return false;
     }
 
@@ -139,24 +140,24 @@ bool SystemUtils::executeCommand(const QString& command, const QStringList& argu
 
     // 等待命令执行完成
     if (!process.waitForStarted(3000)) {
-        qWarning() << "命令启动失败:" << command << arguments;
+        qCWarning(lcSystem) << "命令启动失败:" << command << arguments;
         return false;
     }
 
     // 等待命令执行完成（最多30秒）
     if (!process.waitForFinished(30000)) {
-        qWarning() << "命令执行超时:" << command << arguments;
+        qCWarning(lcSystem) << "命令执行超时:" << command << arguments;
         process.kill();
         return false;
     }
 
     int exitCode = process.exitCode();
     if (exitCode != 0) {
-        qWarning() << "命令执行失败，退出码:" << exitCode << "错误输出:" << process.readAllStandardError();
+        qCWarning(lcSystem) << "命令执行失败，退出码:" << exitCode << "错误输出:" << process.readAllStandardError();
         return false;
     }
 
-    qDebug() << "命令执行成功:" << command << arguments;
+    qCDebug(lcSystem) << "命令执行成功:" << command << arguments;
     return true;
 #else
     // 非Windows平台，使用系统命令
@@ -176,7 +177,7 @@ bool SystemUtils::executeShutdownCommand(const QString& arguments)
 
     // 如果需要管理员权限，先尝试提权
     if (!enableShutdownPrivilege()) {
-        qWarning() << "提权失败，可能无法执行关机操作";
+        qCWarning(lcSystem) << "提权失败，可能无法执行关机操作";
     }
 
     return executeCommand("shutdown", args);
@@ -198,7 +199,7 @@ bool SystemUtils::executeRebootCommand()
 
     // 如果需要管理员权限，先尝试提权
     if (!enableShutdownPrivilege()) {
-        qWarning() << "提权失败，可能无法执行重启操作";
+        qCWarning(lcSystem) << "提权失败，可能无法执行重启操作";
     }
 
     return executeCommand("shutdown", args);
@@ -215,7 +216,7 @@ void SystemUtils::shutdownWithCommand()
 #ifdef Q_OS_WINDOWS
     QString windowsPath = getWindowsPath();
     if (windowsPath.isEmpty()) {
-        qWarning() << "无法获取Windows目录，使用正常退出";
+        qCWarning(lcSystem) << "无法获取Windows目录，使用正常退出";
         emit shutdownFailed("无法获取Windows目录");
         QCoreApplication::quit();
         return;
@@ -225,7 +226,7 @@ void SystemUtils::shutdownWithCommand()
     QFileInfo pecmdFile(pecmdIniPath);
 
     if (pecmdFile.exists() && pecmdFile.isFile()) {
-        qDebug() << "检测到pecmd.ini，使用命令行执行关机";
+        qCDebug(lcSystem) << "检测到pecmd.ini，使用命令行执行关机";
 
         emit shutdownStarted();
 
@@ -233,36 +234,36 @@ void SystemUtils::shutdownWithCommand()
         bool success = executeShutdownCommand("/s");
 
         if (success) {
-            qDebug() << "关机命令已发送成功";
+            qCDebug(lcSystem) << "关机命令已发送成功";
 
             // 等待3秒后退出应用，给系统处理关机的时间
             QTimer::singleShot(3000, []() {
                 QCoreApplication::quit();
             });
         } else {
-            qWarning() << "关机命令执行失败";
+            qCWarning(lcSystem) << "关机命令执行失败";
             emit shutdownFailed("关机命令执行失败");
 
             // 如果命令执行失败，尝试使用Windows API作为备选方案
-            qDebug() << "尝试使用Windows API作为备选方案";
+            qCDebug(lcSystem) << "尝试使用Windows API作为备选方案";
 
             // 提升权限
             if (!enableShutdownPrivilege()) {
-                qWarning() << "权限提升失败，关机操作可能被拒绝";
+                qCWarning(lcSystem) << "权限提升失败，关机操作可能被拒绝";
             }
 
             // 执行关机操作
             BOOL result = ExitWindowsEx(EWX_SHUTDOWN | EWX_FORCE | EWX_POWEROFF, 0);
 
             if (result) {
-                qDebug() << "Windows API关机命令已发送成功";
+                qCDebug(lcSystem) << "Windows API关机命令已发送成功";
                 QTimer::singleShot(3000, []() {
                     QCoreApplication::quit();
                 });
             } else {
                 DWORD error = GetLastError();
                 QString errorMsg = QString("关机失败，错误码: %1").arg(error);
-                qWarning() << errorMsg;
+                qCWarning(lcSystem) << errorMsg;
                 emit shutdownFailed(errorMsg);
 
                 // 如果关机失败，正常退出应用
@@ -271,24 +272,24 @@ void SystemUtils::shutdownWithCommand()
         }
     } else {
         // 没有检测到pecmd.ini，视为实体机，正常退出
-        qDebug() << "未检测到pecmd.ini，使用正常退出应用";
+        qCDebug(lcSystem) << "未检测到pecmd.ini，使用正常退出应用";
         QCoreApplication::quit();
     }
 #else
     // 非Windows系统尝试执行关机命令
-    qDebug() << "非Windows系统，尝试执行关机命令";
+    qCDebug(lcSystem) << "非Windows系统，尝试执行关机命令";
 
     emit shutdownStarted();
 
     bool success = executeShutdownCommand("");
 
     if (success) {
-        qDebug() << "关机命令已发送成功";
+        qCDebug(lcSystem) << "关机命令已发送成功";
         QTimer::singleShot(3000, []() {
             QCoreApplication::quit();
         });
     } else {
-        qWarning() << "关机命令执行失败";
+        qCWarning(lcSystem) << "关机命令执行失败";
         emit shutdownFailed("关机命令执行失败");
         QCoreApplication::quit();
     }
@@ -300,7 +301,7 @@ void SystemUtils::rebootWithCommand()
 #ifdef Q_OS_WINDOWS
     QString windowsPath = getWindowsPath();
     if (windowsPath.isEmpty()) {
-        qWarning() << "无法获取Windows目录，使用正常退出";
+        qCWarning(lcSystem) << "无法获取Windows目录，使用正常退出";
         emit rebootFailed("无法获取Windows目录");
         QCoreApplication::exit(0);
         return;
@@ -310,7 +311,7 @@ void SystemUtils::rebootWithCommand()
     QFileInfo pecmdFile(pecmdIniPath);
 
     if (pecmdFile.exists() && pecmdFile.isFile()) {
-        qDebug() << "检测到pecmd.ini，使用命令行执行重启";
+        qCDebug(lcSystem) << "检测到pecmd.ini，使用命令行执行重启";
 
         emit rebootStarted();
 
@@ -318,36 +319,36 @@ void SystemUtils::rebootWithCommand()
         bool success = executeRebootCommand();
 
         if (success) {
-            qDebug() << "重启命令已发送成功";
+            qCDebug(lcSystem) << "重启命令已发送成功";
 
             // 等待3秒后退出应用，给系统处理重启的时间
             QTimer::singleShot(3000, []() {
                 QCoreApplication::exit(1);
             });
         } else {
-            qWarning() << "重启命令执行失败";
+            qCWarning(lcSystem) << "重启命令执行失败";
             emit rebootFailed("重启命令执行失败");
 
             // 如果命令执行失败，尝试使用Windows API作为备选方案
-            qDebug() << "尝试使用Windows API作为备选方案";
+            qCDebug(lcSystem) << "尝试使用Windows API作为备选方案";
 
             // 提升权限
             if (!enableShutdownPrivilege()) {
-                qWarning() << "权限提升失败，重启操作可能被拒绝";
+                qCWarning(lcSystem) << "权限提升失败，重启操作可能被拒绝";
             }
 
             // 执行重启操作
             BOOL result = ExitWindowsEx(EWX_REBOOT | EWX_FORCE, 0);
 
             if (result) {
-                qDebug() << "Windows API重启命令已发送成功";
+                qCDebug(lcSystem) << "Windows API重启命令已发送成功";
                 QTimer::singleShot(3000, []() {
                     QCoreApplication::exit(1);
                 });
             } else {
                 DWORD error = GetLastError();
                 QString errorMsg = QString("重启失败，错误码: %1").arg(error);
-                qWarning() << errorMsg;
+                qCWarning(lcSystem) << errorMsg;
                 emit rebootFailed(errorMsg);
 
                 // 如果重启失败，正常退出应用
@@ -356,24 +357,24 @@ void SystemUtils::rebootWithCommand()
         }
     } else {
         // 没有检测到pecmd.ini，视为实体机，正常退出
-        qDebug() << "未检测到pecmd.ini，使用正常退出应用";
+        qCDebug(lcSystem) << "未检测到pecmd.ini，使用正常退出应用";
         QCoreApplication::exit(0);
     }
 #else
     // 非Windows系统尝试执行重启命令
-    qDebug() << "非Windows系统，尝试执行重启命令";
+    qCDebug(lcSystem) << "非Windows系统，尝试执行重启命令";
 
     emit rebootStarted();
 
     bool success = executeRebootCommand();
 
     if (success) {
-        qDebug() << "重启命令已发送成功";
+        qCDebug(lcSystem) << "重启命令已发送成功";
         QTimer::singleShot(3000, []() {
             QCoreApplication::exit(1);
         });
     } else {
-        qWarning() << "重启命令执行失败";
+        qCWarning(lcSystem) << "重启命令执行失败";
         emit rebootFailed("重启命令执行失败");
         QCoreApplication::exit(0);
     }
@@ -382,7 +383,7 @@ void SystemUtils::rebootWithCommand()
 
 void SystemUtils::normalQuit()
 {
-    qDebug() << "正常退出应用，返回码: 0";
+    qCDebug(lcSystem) << "正常退出应用，返回码: 0";
 
     // 正常退出，返回码0
     QCoreApplication::exit(0);
@@ -478,7 +479,7 @@ bool SystemUtils::startApplicationWindows(const QString& filePath, const QString
     QFileInfo fileInfo(filePath);
     if (!fileInfo.exists()) {
         QString error = "文件不存在: " + filePath;
-        qWarning() << error;
+        qCWarning(lcSystem) << error;
         emit applicationStartFailed(appName, error);
         return false;
     }
@@ -488,7 +489,7 @@ bool SystemUtils::startApplicationWindows(const QString& filePath, const QString
     QStringList executableSuffixes = {"exe", "com", "bat", "cmd", "msi"};
     if (!executableSuffixes.contains(suffix)) {
         QString error = "文件不是可执行文件: " + filePath;
-        qWarning() << error;
+        qCWarning(lcSystem) << error;
         emit applicationStartFailed(appName, error);
         return false;
     }
@@ -540,7 +541,7 @@ bool SystemUtils::startApplicationWindows(const QString& filePath, const QString
     delete[] cmdLine;
 
     if (success) {
-        qDebug() << "应用程序启动成功:" << filePath;
+        qCDebug(lcSystem) << "应用程序启动成功:" << filePath;
 
         // 关闭不需要的句柄
         CloseHandle(processInfo.hProcess);
@@ -551,7 +552,7 @@ bool SystemUtils::startApplicationWindows(const QString& filePath, const QString
     } else {
         DWORD errorCode = GetLastError();
         QString error = getLastErrorMessage();
-        qWarning() << "应用程序启动失败:" << filePath << "错误码:" << errorCode << "错误信息:" << error;
+        qCWarning(lcSystem) << "应用程序启动失败:" << filePath << "错误码:" << errorCode << "错误信息:" << error;
         emit applicationStartFailed(appName, error);
         return false;
     }
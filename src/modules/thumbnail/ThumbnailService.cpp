@@ -0,0 +1,318 @@
+#include "ThumbnailService.h"
+#include "LogCategories.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <algorithm>
+#include <iterator>
+
+// 缩略图尺寸的档位（长边），请求的大小向上取整到档位
+static const int THUMBNAIL_SIZES[] = { 64, 128, 256, 512 };
+
+// 没有指定sourceSize时的缩略图尺寸
+static const int DEFAULT_THUMBNAIL_SIZE = 128;
+
+// 缩略图的JPEG质量
+static const int THUMBNAIL_JPEG_QUALITY = 85;
+
+// 最多的解码线程数（解码主要受磁盘读取限制，线程太多反而互相拖慢）
+static const int MAX_THUMBNAIL_THREADS = 4;
+
+// 缓存目录的大小上限，超过后删除到上限的80%
+static const qint64 MAX_CACHE_BYTES = 256LL * 1024 * 1024;
+
+ThumbnailService* ThumbnailService::m_instance = nullptr;
+
+// 路径编码为图片提供器的id（base64url，避免路径中的冒号、斜杠和非ASCII字符被URL处理改写）
+static QString encodeImageId(const QString &filePath)
+{
+    return QString::fromLatin1(filePath.toUtf8().toBase64(QByteArray::Base64UrlEncoding
+                                                          | QByteArray::OmitTrailingEquals));
+}
+
+static QString decodeImageId(const QString &id)
+{
+    return QString::fromUtf8(QByteArray::fromBase64(id.toLatin1(), QByteArray::Base64UrlEncoding
+                                                                    | QByteArray::OmitTrailingEquals));
+}
+
+static QString cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+}
+
+// 单个缩略图请求：在ThumbnailService的队列中等待解码
+class ThumbnailResponse : public QQuickImageResponse
+{
+public:
+    ThumbnailResponse(const QString &filePath, int size)
+        : m_filePath(filePath)
+        , m_size(size)
+    {
+    }
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    QString errorString() const override { return m_errorString; }
+
+    void cancel() override
+    {
+        // 还在排队时直接结束；已经在解码时解码完成后照常结束
+        if (ThumbnailService::instance()->cancel(this)) {
+            finish(QImage(), "已取消");
+        }
+    }
+
+    QString filePath() const { return m_filePath; }
+    int size() const { return m_size; }
+
+    // 结束请求，之后引擎会删除本对象
+    void finish(const QImage &image, const QString &errorString)
+    {
+        m_image = image;
+        m_errorString = errorString;
+        emit finished();
+    }
+
+private:
+    QString m_filePath;
+    int m_size;
+    QImage m_image;
+    QString m_errorString;
+};
+
+ThumbnailService::ThumbnailService(QObject *parent)
+    : QObject(parent)
+    , m_stopping(false)
+{
+}
+
+ThumbnailService* ThumbnailService::instance()
+{
+    static std::mutex instanceMutex;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+
+    if (!m_instance) {
+        m_instance = new ThumbnailService();
+    }
+    return m_instance;
+}
+
+bool ThumbnailService::isSupported(const QString &filePath) const
+{
+    static const QSet<QString> formats = []() {
+        QSet<QString> result;
+        const QList<QByteArray> supported = QImageReader::supportedImageFormats();
+        for (const QByteArray &format : supported) {
+            result.insert(QString::fromLatin1(format).toLower());
+        }
+        return result;
+    }();
+
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    return !suffix.isEmpty() && formats.contains(suffix);
+}
+
+QString ThumbnailService::source(const QString &filePath) const
+{
+    if (filePath.isEmpty() || !isSupported(filePath)) {
+        return QString();
+    }
+    return "image://thumbnail/" + encodeImageId(filePath);
+}
+
+int ThumbnailService::sizeFor(const QSize &requestedSize)
+{
+    const int requested = std::max(requestedSize.width(), requestedSize.height());
+    if (requested <= 0) {
+        return DEFAULT_THUMBNAIL_SIZE;
+    }
+    for (int size : THUMBNAIL_SIZES) {
+        if (requested <= size) {
+            return size;
+        }
+    }
+    return THUMBNAIL_SIZES[std::size(THUMBNAIL_SIZES) - 1];
+}
+
+QString ThumbnailService::cacheBase(const QFileInfo &info, int size)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    return cacheDirectory() + QString("/%1_%2").arg(QString::fromLatin1(hash.result().toHex().left(20))).arg(size);
+}
+
+QImage ThumbnailService::thumbnail(const QString &filePath, int size, QString *errorString)
+{
+    const QFileInfo info(filePath);
+    if (!info.isFile()) {
+        *errorString = "文件不存在";
+        return QImage();
+    }
+
+    // 磁盘缓存（有透明通道的保存为PNG）
+    const QString base = cacheBase(info, size);
+    for (const char *extension : { ".jpg", ".png" }) {
+        const QString cached = base + extension;
+        if (QFileInfo::exists(cached)) {
+            QImage image(cached);
+            if (!image.isNull()) {
+                return image;
+            }
+        }
+    }
+
+    QImageReader reader(filePath);
+    reader.setAutoTransform(true);
+
+    // 缩小到正方形范围内，旋转前后都适用；JPEG在解码时直接缩小，不需要解码整张原图
+    const QSize sourceSize = reader.size();
+    if (sourceSize.isValid() && (sourceSize.width() > size || sourceSize.height() > size)) {
+        reader.setScaledSize(sourceSize.scaled(size, size, Qt::KeepAspectRatio));
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        *errorString = reader.errorString();
+        qCDebug(lcFilesystem) << "无法生成缩略图:" << filePath << *errorString;
+        return QImage();
+    }
+
+    // 读不出原图大小的格式在解码后缩小
+    if (image.width() > size || image.height() > size) {
+        image = image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    const bool hasAlpha = image.hasAlphaChannel();
+    QDir().mkpath(cacheDirectory());
+    QSaveFile file(base + (hasAlpha ? ".png" : ".jpg"));
+    if (!file.open(QIODevice::WriteOnly)
+        || !image.save(&file, hasAlpha ? "PNG" : "JPG", hasAlpha ? -1 : THUMBNAIL_JPEG_QUALITY)
+        || !file.commit()) {
+        // 只是不能缓存，缩略图照常显示
+        qCWarning(lcFilesystem) << "无法保存缩略图缓存:" << file.fileName();
+    }
+    return image;
+}
+
+void ThumbnailService::request(ThumbnailResponse *response)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_stopping) {
+            m_queue.push_back(response);
+
+            if (m_threads.isEmpty()) {
+                const int threadCount = std::clamp(QThread::idealThreadCount() / 2, 1, MAX_THUMBNAIL_THREADS);
+                for (int i = 0; i < threadCount; ++i) {
+                    QThread *thread = QThread::create([this, i]() {
+                        if (i == 0) {
+                            pruneCache();
+                        }
+                        run();
+                    });
+                    thread->start(QThread::LowPriority);
+                    m_threads.append(thread);
+                }
+            }
+            m_condition.notify_one();
+            return;
+        }
+    }
+
+    response->finish(QImage(), "缩略图服务已停止");
+}
+
+bool ThumbnailService::cancel(ThumbnailResponse *response)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find(m_queue.begin(), m_queue.end(), response);
+    if (it == m_queue.end()) {
+        return false;
+    }
+    m_queue.erase(it);
+    return true;
+}
+
+void ThumbnailService::stop()
+{
+    QVector<QThread*> threads;
+    std::deque<ThumbnailResponse*> queued;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        threads.swap(m_threads);
+        queued.swap(m_queue);
+    }
+    m_condition.notify_all();
+
+    for (ThumbnailResponse *response : queued) {
+        response->finish(QImage(), "缩略图服务已停止");
+    }
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void ThumbnailService::run()
+{
+    for (;;) {
+        ThumbnailResponse *response = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+            if (m_stopping) {
+                return;
+            }
+            // 最新的请求最先处理：刚滚动到可见区域的项目先显示
+            response = m_queue.back();
+            m_queue.pop_back();
+        }
+
+        QString errorString;
+        const QImage image = thumbnail(response->filePath(), response->size(), &errorString);
+        response->finish(image, errorString);
+    }
+}
+
+void ThumbnailService::pruneCache()
+{
+    QDir dir(cacheDirectory());
+    const QFileInfoList files = dir.entryInfoList(QDir::Files, QDir::Time);
+
+    qint64 total = 0;
+    for (const QFileInfo &file : files) {
+        total += file.size();
+    }
+    if (total <= MAX_CACHE_BYTES) {
+        return;
+    }
+
+    // 按修改时间从新到旧排列，从末尾（最旧的）开始删除
+    const qint64 target = MAX_CACHE_BYTES * 8 / 10;
+    int removed = 0;
+    for (int i = files.size() - 1; i >= 0 && total > target; --i) {
+        if (QFile::remove(files[i].absoluteFilePath())) {
+            total -= files[i].size();
+            ++removed;
+        }
+    }
+    qCDebug(lcFilesystem) << "清理缩略图缓存，删除了" << removed << "个文件";
+}
+
+QQuickImageResponse *ThumbnailImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    ThumbnailResponse *response = new ThumbnailResponse(decodeImageId(id), ThumbnailService::sizeFor(requestedSize));
+    ThumbnailService::instance()->request(response);
+    return response;
+}
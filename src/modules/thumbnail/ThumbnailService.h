@@ -0,0 +1,81 @@
+#ifndef THUMBNAILSERVICE_H
+#define THUMBNAILSERVICE_H
+
+#include <QFileInfo>
+#include <QImage>
+#include <QObject>
+#include <QQuickImageProvider>
+#include <QSize>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+class ThumbnailResponse;
+
+// 缩略图服务（进程内单例）：
+// 文件浏览器、文件选择器、壁纸设置和图片查看器通过"image://thumbnail/"请求图片文件的缩略图。
+// 缩略图在固定数量的后台线程中用QImageReader::setScaledSize解码（JPEG在DCT阶段直接缩小），
+// 保存在缓存目录的thumbnails/中，按文件路径、大小和修改时间区分，文件改变后自动重新生成。
+// 后到的请求先处理（刚滚动到可见区域的项目优先），项目滚出可见区域时引擎取消请求，
+// 还没有开始解码的请求直接丢弃。
+class ThumbnailService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ThumbnailService* instance();
+
+    // 文件的缩略图Image.source，不是支持的图片格式时返回空字符串
+    Q_INVOKABLE QString source(const QString &filePath) const;
+
+    // 文件是否是能生成缩略图的图片格式（按扩展名判断）
+    Q_INVOKABLE bool isSupported(const QString &filePath) const;
+
+    // 在调用线程中取得缩略图（长边不超过size）：磁盘缓存中有时直接读取，否则解码原图并写入缓存
+    static QImage thumbnail(const QString &filePath, int size, QString *errorString);
+
+    // 请求的大小对应的缩略图尺寸（长边，按档位取整，同一档位共用缓存）
+    static int sizeFor(const QSize &requestedSize);
+
+    // 放入解码队列（图片提供器调用）
+    void request(ThumbnailResponse *response);
+
+    // 取消还在排队的请求，已经开始解码时返回false（ThumbnailResponse::cancel调用）
+    bool cancel(ThumbnailResponse *response);
+
+    // 停止解码线程（应用程序退出前调用），之后的请求直接失败
+    void stop();
+
+private:
+    explicit ThumbnailService(QObject *parent = nullptr);
+
+    // 缓存文件路径（不含扩展名）
+    static QString cacheBase(const QFileInfo &info, int size);
+
+    // 解码线程主循环
+    void run();
+
+    // 缓存目录超过上限时从最旧的开始删除（第一个解码线程启动时执行一次）
+    static void pruneCache();
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<ThumbnailResponse*> m_queue;
+    bool m_stopping;
+
+    QVector<QThread*> m_threads;
+
+    static ThumbnailService *m_instance;
+};
+
+// 缩略图的异步图片提供器（注册为"thumbnail"），解码由ThumbnailService的线程完成
+class ThumbnailImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+};
+
+#endif // THUMBNAILSERVICE_H
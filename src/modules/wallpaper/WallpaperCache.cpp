@@ -0,0 +1,271 @@
+#include "WallpaperCache.h"
+#include "LogCategories.h"
+#include "WallpaperImageProvider.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QScreen>
+#include <QStandardPaths>
+#include <QUrl>
+
+// 缓存目录中保留的缓存文件数（多个屏幕和最近用过的几张壁纸）
+static const int MAX_CACHED_VARIANTS = 8;
+
+// 缓存版本的JPEG质量
+static const int VARIANT_JPEG_QUALITY = 92;
+
+WallpaperCache* WallpaperCache::m_instance = nullptr;
+
+WallpaperCache::WallpaperCache(QObject *parent)
+    : QObject(parent)
+    , m_directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/wallpapers")
+    , m_stopping(false)
+    , m_thread(nullptr)
+{
+}
+
+WallpaperCache* WallpaperCache::instance()
+{
+    static std::mutex instanceMutex;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+
+    if (!m_instance) {
+        m_instance = new WallpaperCache();
+    }
+    return m_instance;
+}
+
+// 壁纸URL对应的本地文件，不是本地文件时返回空字符串
+static QString localPath(const QString &source)
+{
+    const QUrl url(source);
+    return url.isLocalFile() ? url.toLocalFile() : QString();
+}
+
+QString WallpaperCache::variantBase(const QString &sourcePath, const QSize &size) const
+{
+    const QFileInfo info(sourcePath);
+    if (!info.exists()) {
+        return QString();
+    }
+
+    // 原图被替换（同名文件）后大小或修改时间会变化，对应新的缓存文件
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    const QString key = QString::fromLatin1(hash.result().toHex().left(16));
+
+    return m_directory + QString("/%1_%2x%3").arg(key).arg(size.width()).arg(size.height());
+}
+
+QString WallpaperCache::existingVariant(const QString &base)
+{
+    for (const char *extension : { ".jpg", ".png" }) {
+        const QString path = base + extension;
+        if (QFileInfo::exists(path)) {
+            return path;
+        }
+    }
+    return QString();
+}
+
+QSize WallpaperCache::physicalSize(const QSize &logicalSize, qreal devicePixelRatio)
+{
+    // QSize * qreal按分量四舍五入，与QQuickImage计算请求大小的方式相同
+    return logicalSize * devicePixelRatio;
+}
+
+QString WallpaperCache::variantFor(const QString &source, int width, int height, qreal devicePixelRatio)
+{
+    const QString sourcePath = localPath(source);
+    const QSize size = physicalSize(QSize(width, height), devicePixelRatio);
+    if (sourcePath.isEmpty() || size.isEmpty()) {
+        return QString();
+    }
+
+    const QString base = variantBase(sourcePath, size);
+    if (base.isEmpty()) {
+        return QString();
+    }
+
+    const QString variant = existingVariant(base);
+    if (!variant.isEmpty()) {
+        return QUrl::fromLocalFile(variant).toString();
+    }
+
+    enqueue({ source, sourcePath, size, base });
+    return QString();
+}
+
+QString WallpaperCache::existingVariantFor(const QString &source, const QSize &size) const
+{
+    const QString sourcePath = localPath(source);
+    if (sourcePath.isEmpty() || size.isEmpty()) {
+        return QString();
+    }
+
+    const QString base = variantBase(sourcePath, size);
+    const QString variant = base.isEmpty() ? QString() : existingVariant(base);
+    return variant.isEmpty() ? QString() : QUrl::fromLocalFile(variant).toString();
+}
+
+void WallpaperCache::prepare(const QString &source)
+{
+    const QString sourcePath = localPath(source);
+    if (sourcePath.isEmpty()) {
+        return;
+    }
+
+    // 每个已连接屏幕的物理分辨率
+    const QList<QScreen*> screens = QGuiApplication::screens();
+    for (QScreen *screen : screens) {
+        const QSize size = physicalSize(screen->size(), screen->devicePixelRatio());
+        const QString base = variantBase(sourcePath, size);
+        if (!base.isEmpty() && existingVariant(base).isEmpty()) {
+            enqueue({ source, sourcePath, size, base });
+        }
+    }
+}
+
+QString WallpaperCache::imageSource(const QString &source) const
+{
+    return WallpaperImageProvider::imageSource(source);
+}
+
+void WallpaperCache::enqueue(const Job &job)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping || m_queued.contains(job.variantBase)) {
+        return;
+    }
+    m_queued.insert(job.variantBase);
+    m_jobs.push_back(job);
+
+    if (!m_thread) {
+        m_thread = QThread::create([this]() { run(); });
+        m_thread->start(QThread::LowPriority);
+    }
+    m_condition.notify_one();
+}
+
+void WallpaperCache::stop()
+{
+    QThread *thread = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_jobs.clear();
+        thread = m_thread;
+        m_thread = nullptr;
+    }
+    m_condition.notify_all();
+
+    // 正在生成的缓存文件通过临时文件写入，中止后不会留下不完整的文件
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void WallpaperCache::run()
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return !m_jobs.empty() || m_stopping; });
+            if (m_stopping) {
+                return;
+            }
+            job = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        const bool generated = generate(job);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queued.remove(job.variantBase);
+        }
+
+        if (generated) {
+            prune();
+            const QString source = job.source;
+            QMetaObject::invokeMethod(this, [this, source]() { emit variantReady(source); }, Qt::QueuedConnection);
+        }
+    }
+}
+
+bool WallpaperCache::generate(const Job &job)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QImageReader reader(job.sourcePath);
+    reader.setAutoTransform(true);
+
+    // 缩放在旋转之前进行，EXIF旋转90度的照片宽高互换
+    QSize target = job.size;
+    if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+        target.transpose();
+    }
+
+    // 原图比目标大很多时让解码器直接输出较小的图像（JPEG在DCT阶段缩小），
+    // 保留两倍目标分辨率留给后面的高质量缩放
+    const QSize sourceSize = reader.size();
+    if (sourceSize.isValid()) {
+        const QSize decodeSize = sourceSize.scaled(target * 2, Qt::KeepAspectRatioByExpanding);
+        if (decodeSize.width() < sourceSize.width() && decodeSize.height() < sourceSize.height()) {
+            reader.setScaledSize(decodeSize);
+        }
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qCWarning(lcWallpaper) << "无法解码壁纸:" << job.sourcePath << reader.errorString();
+        return false;
+    }
+
+    // 铺满屏幕（与界面中的PreserveAspectCrop一致），比屏幕小的图片不放大
+    const QSize covered = image.size().scaled(job.size, Qt::KeepAspectRatioByExpanding);
+    if (covered.width() < image.width() && covered.height() < image.height()) {
+        image = image.scaled(covered, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    if (!QDir().mkpath(m_directory)) {
+        qCWarning(lcWallpaper) << "无法创建壁纸缓存目录:" << m_directory;
+        return false;
+    }
+
+    // 不透明的壁纸保存为JPEG（解码快、文件小），有透明通道时保存为PNG
+    const bool hasAlpha = image.hasAlphaChannel();
+    QSaveFile file(job.variantBase + (hasAlpha ? ".png" : ".jpg"));
+    if (!file.open(QIODevice::WriteOnly)
+        || !image.save(&file, hasAlpha ? "PNG" : "JPG", hasAlpha ? -1 : VARIANT_JPEG_QUALITY)
+        || !file.commit()) {
+        qCWarning(lcWallpaper) << "无法保存壁纸缓存:" << file.fileName();
+        return false;
+    }
+
+    qCDebug(lcWallpaper) << "已生成壁纸缓存:" << job.sourcePath << sourceSize << "->" << image.size()
+                         << "耗时" << timer.elapsed() << "毫秒";
+    return true;
+}
+
+void WallpaperCache::prune()
+{
+    QDir dir(m_directory);
+    QFileInfoList files = dir.entryInfoList({ "*.jpg", "*.png" }, QDir::Files, QDir::Time);
+    // 按修改时间从新到旧排列，保留最近生成的几个
+    for (int i = MAX_CACHED_VARIANTS; i < files.size(); ++i) {
+        if (QFile::remove(files[i].absoluteFilePath())) {
+            qCDebug(lcWallpaper) << "删除旧的壁纸缓存:" << files[i].fileName();
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef WALLPAPERCACHE_H
+#define WALLPAPERCACHE_H
+
+#include <QObject>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QThread>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// 按屏幕分辨率预先缩放的壁纸缓存（进程内单例）：
+// 壁纸原图常常是几千万像素的JPEG，桌面和锁屏每次启动都完整解码会占用几百MB内存和几秒时间。
+// 这里在后台线程中把原图按每个屏幕的物理分辨率缩小（铺满屏幕，高质量滤波），保存到缓存目录，
+// 启动时只加载缩小后的版本。缓存文件名包含原图的路径、大小、修改时间和目标分辨率，
+// 原图被替换或屏幕分辨率变化后自动生成新的版本。
+class WallpaperCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static WallpaperCache* instance();
+
+    // 壁纸source（file:// URL）在屏幕上的缓存版本的URL。width×height是屏幕的逻辑大小，
+    // 按devicePixelRatio换算为物理像素（与prepare()相同），两边得到同一个缓存文件。
+    // 还没有生成时返回空字符串并在后台生成，生成后发出variantReady
+    Q_INVOKABLE QString variantFor(const QString &source, int width, int height, qreal devicePixelRatio);
+
+    // 已经生成的物理像素size的缓存版本的URL，没有时返回空字符串（不排队生成）
+    QString existingVariantFor(const QString &source, const QSize &size) const;
+
+    // 为所有已连接的屏幕生成缓存版本（设置新壁纸后调用）
+    Q_INVOKABLE void prepare(const QString &source);
+
+    // 壁纸的Image.source：本地文件交给"image://wallpaper/"提供器，锁屏和桌面共用一次解码
+    Q_INVOKABLE QString imageSource(const QString &source) const;
+
+    // 停止后台线程（应用程序退出前调用）
+    void stop();
+
+    // 逻辑大小对应的物理像素大小，与Image按sourceSize向图片提供器请求的大小一致
+    static QSize physicalSize(const QSize &logicalSize, qreal devicePixelRatio);
+
+signals:
+    // source的缓存版本已生成，界面可以重新调用variantFor
+    void variantReady(const QString &source);
+
+private:
+    explicit WallpaperCache(QObject *parent = nullptr);
+
+    struct Job {
+        QString source;         // 界面使用的URL
+        QString sourcePath;     // 原图的本地路径
+        QSize size;             // 目标分辨率
+        QString variantBase;    // 缓存文件路径（不含扩展名）
+    };
+
+    // 缓存文件路径（不含扩展名），原图不存在时返回空字符串
+    QString variantBase(const QString &sourcePath, const QSize &size) const;
+
+    // 已生成的缓存文件（.jpg或有透明通道时的.png），没有时返回空字符串
+    static QString existingVariant(const QString &base);
+
+    // 放入后台队列（同一个缓存文件只排队一次）
+    void enqueue(const Job &job);
+
+    // 后台线程主循环
+    void run();
+
+    // 解码、缩放并保存一个缓存版本
+    bool generate(const Job &job);
+
+    // 删除最旧的缓存文件，只保留最近的几个
+    void prune();
+
+    QString m_directory;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<Job> m_jobs;
+    QSet<QString> m_queued;             // 排队或正在生成的缓存文件
+    bool m_stopping;
+
+    QThread *m_thread;
+
+    static WallpaperCache *m_instance;
+};
+
+#endif // WALLPAPERCACHE_H
@@ -0,0 +1,288 @@
+#include "WallpaperImageProvider.h"
+#include "LogCategories.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QHash>
+#include <QImageReader>
+#include <QQuickWindow>
+#include <QTimer>
+#include <QUrl>
+#include <mutex>
+
+// 壁纸的解码线程数（锁屏和桌面通常请求同一张，不需要更多）
+static const int WALLPAPER_DECODE_THREADS = 1;
+
+// 最近一次解码结果在没有界面引用后继续保留的时间（毫秒）
+static const int RECENT_KEEP_MS = 3000;
+
+// 解码后共用的壁纸图像
+typedef std::shared_ptr<const QImage> SharedImage;
+
+// 路径编码为图片提供器的id（base64url，避免路径中的冒号、斜杠和非ASCII字符被URL处理改写）
+static QString encodeImageId(const QString &filePath)
+{
+    return QString::fromLatin1(filePath.toUtf8().toBase64(QByteArray::Base64UrlEncoding
+                                                          | QByteArray::OmitTrailingEquals));
+}
+
+static QString decodeImageId(const QString &id)
+{
+    return QString::fromUtf8(QByteArray::fromBase64(id.toLatin1(), QByteArray::Base64UrlEncoding
+                                                                    | QByteArray::OmitTrailingEquals));
+}
+
+// 共用表中的key：路径、请求的大小和修改时间
+// （同名文件被替换，例如保存新的自定义壁纸后，修改时间变化，不再共用旧的图像）
+static QString imageKey(const QString &filePath, const QSize &size)
+{
+    const qint64 modified = QFileInfo(filePath).lastModified().toMSecsSinceEpoch();
+    return QString("%1@%2x%3@%4").arg(filePath).arg(size.width()).arg(size.height()).arg(modified);
+}
+
+// 按请求的大小铺满（与PreserveAspectCrop一致）直接解码为较小的图像，不放大
+static SharedImage decodeWallpaper(const QString &filePath, const QSize &size, QString *errorString)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QImageReader reader(filePath);
+    reader.setAutoTransform(true);
+
+    const QSize sourceSize = reader.size();
+    if (size.isValid() && sourceSize.isValid()) {
+        QSize target = size;
+        if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+            target.transpose();
+        }
+        const QSize decodeSize = sourceSize.scaled(target, Qt::KeepAspectRatioByExpanding);
+        if (decodeSize.width() < sourceSize.width() && decodeSize.height() < sourceSize.height()) {
+            reader.setScaledSize(decodeSize);
+        }
+    }
+
+    QImage decoded = reader.read();
+    if (decoded.isNull()) {
+        *errorString = reader.errorString();
+        qCWarning(lcWallpaper) << "壁纸解码失败:" << filePath << *errorString;
+        return SharedImage();
+    }
+
+    qCDebug(lcWallpaper) << "已解码壁纸:" << filePath << decoded.size() << "耗时" << timer.elapsed() << "毫秒";
+    return std::make_shared<const QImage>(std::move(decoded));
+}
+
+// 共用解码图像的纹理工厂：每个界面的纹理工厂持有同一份图像的引用，
+// 最后一个纹理工厂释放（没有界面再显示这张壁纸）时图像随之释放
+class WallpaperTextureFactory : public QQuickTextureFactory
+{
+public:
+    explicit WallpaperTextureFactory(SharedImage image)
+        : m_image(std::move(image))
+    {
+    }
+
+    QSGTexture *createTexture(QQuickWindow *window) const override
+    {
+        return window->createTextureFromImage(*m_image);
+    }
+
+    QSize textureSize() const override { return m_image->size(); }
+
+    int textureByteCount() const override { return int(m_image->sizeInBytes()); }
+
+    QImage image() const override { return *m_image; }
+
+private:
+    SharedImage m_image;
+};
+
+// 单个请求：等待（可能由其他请求发起的）解码完成
+class WallpaperImageResponse : public QQuickImageResponse
+{
+public:
+    QQuickTextureFactory *textureFactory() const override
+    {
+        return m_image ? new WallpaperTextureFactory(m_image) : nullptr;
+    }
+
+    QString errorString() const override { return m_errorString; }
+
+    // 解码结束（在解码线程中调用），之后引擎会删除本对象
+    void finish(SharedImage image, const QString &errorString)
+    {
+        m_image = std::move(image);
+        m_errorString = errorString;
+        emit finished();
+    }
+
+private:
+    SharedImage m_image;
+    QString m_errorString;
+};
+
+// 解码结果的共享表（进程内只有一个），解码任务和延迟释放持有它的引用，提供器先于任务销毁时也能安全使用
+class WallpaperImageStore : public std::enable_shared_from_this<WallpaperImageStore>
+{
+public:
+    static std::shared_ptr<WallpaperImageStore> instance()
+    {
+        static const std::shared_ptr<WallpaperImageStore> store = std::make_shared<WallpaperImageStore>();
+        return store;
+    }
+
+    // 同步解码并放入表中（表中已有时直接返回），不占用最近一次的保留
+    SharedImage preload(const QString &key, const QString &filePath, const QSize &size)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (SharedImage image = m_images.value(key).lock()) {
+                return image;
+            }
+        }
+
+        QString errorString;
+        SharedImage image = decodeWallpaper(filePath, size, &errorString);
+        if (image) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            insert(key, image);
+        }
+        return image;
+    }
+
+    // 同一个key的图像还被引用时直接完成，正在解码时等待同一次解码，否则开始解码
+    void request(const QString &key, const QString &filePath, const QSize &size,
+                 WallpaperImageResponse *response, QThreadPool *pool)
+    {
+        std::shared_ptr<WallpaperImageStore> self = shared_from_this();
+        SharedImage image;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            image = m_images.value(key).lock();
+            if (!image) {
+                QList<WallpaperImageResponse*> &waiting = m_waiting[key];
+                waiting.append(response);
+                if (waiting.size() > 1) {
+                    qCDebug(lcWallpaper) << "等待正在进行的壁纸解码:" << filePath;
+                    return;
+                }
+            }
+        }
+
+        if (image) {
+            qCDebug(lcWallpaper) << "共用已解码的壁纸:" << filePath << image->size();
+            keepRecent(image);
+            pool->start([response, image]() { response->finish(image, QString()); });
+            return;
+        }
+
+        pool->start([self, key, filePath, size]() { self->decode(key, filePath, size); });
+    }
+
+private:
+    void decode(const QString &key, const QString &filePath, const QSize &size)
+    {
+        QString errorString;
+        SharedImage image = decodeWallpaper(filePath, size, &errorString);
+
+        QList<WallpaperImageResponse*> waiting;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            waiting = m_waiting.take(key);
+            if (image) {
+                insert(key, image);
+            }
+        }
+
+        if (image) {
+            keepRecent(image);
+        }
+        for (WallpaperImageResponse *response : waiting) {
+            response->finish(image, errorString);
+        }
+    }
+
+    // 放入表中（调用时已加锁），顺便清理已经没有引用的条目
+    void insert(const QString &key, const SharedImage &image)
+    {
+        for (auto it = m_images.begin(); it != m_images.end();) {
+            it = it.value().expired() ? m_images.erase(it) : std::next(it);
+        }
+        m_images.insert(key, image);
+    }
+
+    // 保留最近一次的图像一段时间（切换窗口时旧窗口先销毁），之后只由界面引用
+    void keepRecent(const SharedImage &image)
+    {
+        quint64 generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_recent = image;
+            generation = ++m_recentGeneration;
+        }
+
+        std::weak_ptr<WallpaperImageStore> weak = shared_from_this();
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [weak, generation]() {
+            QTimer::singleShot(RECENT_KEEP_MS, QCoreApplication::instance(), [weak, generation]() {
+                if (std::shared_ptr<WallpaperImageStore> store = weak.lock()) {
+                    store->releaseRecent(generation);
+                }
+            });
+        }, Qt::QueuedConnection);
+    }
+
+    void releaseRecent(quint64 generation)
+    {
+        SharedImage released;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (generation == m_recentGeneration) {
+            released = std::move(m_recent);
+        }
+    }
+
+    std::mutex m_mutex;
+    QHash<QString, std::weak_ptr<const QImage>> m_images;
+    QHash<QString, QList<WallpaperImageResponse*>> m_waiting;
+    SharedImage m_recent;
+    quint64 m_recentGeneration = 0;
+};
+
+WallpaperImageProvider::WallpaperImageProvider()
+    : m_store(WallpaperImageStore::instance())
+{
+    m_pool.setMaxThreadCount(WALLPAPER_DECODE_THREADS);
+}
+
+WallpaperImageProvider::~WallpaperImageProvider()
+{
+    m_pool.waitForDone();
+}
+
+QString WallpaperImageProvider::imageSource(const QString &source)
+{
+    const QUrl url(source);
+    if (!url.isLocalFile()) {
+        // qrc等其他来源不经过提供器
+        return source;
+    }
+    return "image://wallpaper/" + encodeImageId(url.toLocalFile());
+}
+
+std::shared_ptr<const QImage> WallpaperImageProvider::preload(const QString &source, const QSize &size)
+{
+    const QUrl url(source);
+    if (!url.isLocalFile()) {
+        return SharedImage();
+    }
+    const QString filePath = url.toLocalFile();
+    return WallpaperImageStore::instance()->preload(imageKey(filePath, size), filePath, size);
+}
+
+QQuickImageResponse *WallpaperImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    const QString filePath = decodeImageId(id);
+    WallpaperImageResponse *response = new WallpaperImageResponse();
+    m_store->request(imageKey(filePath, requestedSize), filePath, requestedSize, response, &m_pool);
+    return response;
+}
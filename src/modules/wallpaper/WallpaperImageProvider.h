@@ -0,0 +1,36 @@
+#ifndef WALLPAPERIMAGEPROVIDER_H
+#define WALLPAPERIMAGEPROVIDER_H
+
+#include <QString>
+#include <QQuickImageProvider>
+#include <QThreadPool>
+#include <memory>
+
+class WallpaperImageStore;
+
+// 壁纸的异步图片提供器（注册为"wallpaper"）：
+// 锁屏和桌面显示同一张壁纸，按相同的路径和大小请求时只在后台解码一次，
+// 两个窗口的纹理工厂共用同一份解码后的图像（正在解码时后来的请求等待同一次解码）。
+// 提供器只保存弱引用，没有界面再引用时图像随最后一个纹理工厂释放；
+// 最近一次的结果额外保留几秒，切换窗口（先销毁旧窗口再加载新窗口）时不需要重新解码。
+class WallpaperImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    WallpaperImageProvider();
+    ~WallpaperImageProvider();
+
+    // 壁纸文件（file:// URL）的Image.source，不是本地文件时原样返回
+    static QString imageSource(const QString &source);
+
+    // 在调用线程中按size解码壁纸（file:// URL）并放入共用的表，返回的引用保持图像不被释放；
+    // 之后界面以相同的sourceSize请求时直接使用，不再解码（幻灯片用来提前解码下一张）
+    static std::shared_ptr<const QImage> preload(const QString &source, const QSize &size);
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+private:
+    QThreadPool m_pool;
+    std::shared_ptr<WallpaperImageStore> m_store;
+};
+
+#endif // WALLPAPERIMAGEPROVIDER_H
@@ -1,11 +1,88 @@
 // WallpaperManager.cpp
 #include "WallpaperManager.h"
+#include "LogCategories.h"
+#include "WallpaperCache.h"
+#include "WallpaperImageProvider.h"
+#include "ThumbnailService.h"
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QThread>
+#include <algorithm>
+#include <numeric>
+
+// 每个检查任务至少处理的壁纸数（太少时分组的开销比检查文件还大）
+static const int MIN_ENTRIES_PER_TASK = 16;
+
+// 幻灯片切换间隔的范围（秒）
+static const int MIN_SLIDESHOW_INTERVAL = 5;
+static const int MAX_SLIDESHOW_INTERVAL = 86400;
 
 WallpaperManager::WallpaperManager(QObject *parent)
-    : QObject(parent)
+    : QAbstractListModel(parent)
+    , m_loading(false)
+    , m_generation(std::make_shared<std::atomic<quint64>>(0))
+    , m_slideshowRunning(false)
+    , m_slideshowRandom(false)
+    , m_slideshowGeneration(0)
+    , m_slideshowPosition(0)
+    , m_slideshowFailures(0)
+    , m_slideshowDecoding(false)
+    , m_slideshowAdvancePending(false)
 {
     // 构造函数中不加载壁纸，延迟到需要时加载
+    m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+
+    m_slideshowTimer.setSingleShot(true);
+    connect(&m_slideshowTimer, &QTimer::timeout, this, &WallpaperManager::advanceSlideshow);
+}
+
+WallpaperManager::~WallpaperManager()
+{
+    // 还没开始的任务直接丢弃，正在执行的任务看到编号变化后尽快结束
+    m_generation->store(0);
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+int WallpaperManager::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant WallpaperManager::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+
+    const Entry &entry = m_entries[index.row()];
+    switch (role) {
+    case IdRole:
+        return entry.id;
+    case Qt::DisplayRole:
+    case NameRole:
+        return entry.name;
+    case DescriptionRole:
+        return entry.description;
+    case ImagePathRole:
+        return entry.imagePath;
+    case ThumbnailRole:
+        return ThumbnailService::instance()->source(entry.filePath);
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> WallpaperManager::roleNames() const
+{
+    return {
+        { IdRole, "id" },
+        { NameRole, "name" },
+        { DescriptionRole, "description" },
+        { ImagePathRole, "imagePath" },
+        { ThumbnailRole, "thumbnail" }
+    };
 }
 
 QString WallpaperManager::getWallpapersDir() const
@@ -22,106 +99,192 @@ QString WallpaperManager::getJsonFilePath() const
 
 bool WallpaperManager::loadWallpapers()
 {
-    // 清空现有壁纸列表
-    qDeleteAll(m_wallpapers);
-    m_wallpapers.clear();
+    const quint64 generation = m_generation->load() + 1;
+    m_generation->store(generation);
 
-    // 获取壁纸文件夹路径
-    QString wallpapersDir = getWallpapersDir();
-    QDir dir(wallpapersDir);
+    if (!m_loading) {
+        m_loading = true;
+        emit loadingChanged();
+    }
 
-    // 如果壁纸文件夹不存在，创建它
-    if (!dir.exists()) {
-        if (!dir.mkpath(".")) {
-            qWarning() << "无法创建壁纸文件夹:" << wallpapersDir;
-            emit wallpapersLoaded(false, "无法创建壁纸文件夹");
-            return false;
+    std::shared_ptr<std::atomic<quint64>> current = m_generation;
+    m_pool.start([this, generation, current]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        auto fail = [this, generation](const QString &errorMessage) {
+            QMetaObject::invokeMethod(this, [this, generation, errorMessage]() {
+                finishLoading(generation, QVector<Entry>(), errorMessage);
+            }, Qt::QueuedConnection);
+        };
+
+        // 获取壁纸文件夹路径
+        QString wallpapersDir = getWallpapersDir();
+        QDir dir(wallpapersDir);
+
+        // 如果壁纸文件夹不存在，创建它
+        if (!dir.exists()) {
+            if (!dir.mkpath(".")) {
+                qCWarning(lcWallpaper) << "无法创建壁纸文件夹:" << wallpapersDir;
+                fail("无法创建壁纸文件夹");
+                return;
+            }
+            qCDebug(lcWallpaper) << "已创建壁纸文件夹:" << wallpapersDir;
         }
-        qDebug() << "已创建壁纸文件夹:" << wallpapersDir;
-    }
 
-    // 获取JSON文件路径
-    QString jsonPath = getJsonFilePath();
-    QFile jsonFile(jsonPath);
+        // 获取JSON文件路径
+        QString jsonPath = getJsonFilePath();
+        QFile jsonFile(jsonPath);
 
-    // 如果JSON文件不存在，创建默认的
-    if (!jsonFile.exists()) {
-        qDebug() << "JSON文件不存在，创建默认配置";
-        if (!createDefaultJsonFile()) {
-            emit wallpapersLoaded(false, "无法创建默认壁纸配置文件");
-            return false;
+        // 如果JSON文件不存在，创建默认的
+        if (!jsonFile.exists()) {
+            qCDebug(lcWallpaper) << "JSON文件不存在，创建默认配置";
+            if (!createDefaultJsonFile()) {
+                fail("无法创建默认壁纸配置文件");
+                return;
+            }
         }
-    }
 
-    // 读取JSON文件
-    if (!jsonFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning() << "无法打开JSON文件:" << jsonPath;
-        emit wallpapersLoaded(false, "无法打开壁纸配置文件");
-        return false;
-    }
+        // 读取JSON文件
+        if (!jsonFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qCWarning(lcWallpaper) << "无法打开JSON文件:" << jsonPath;
+            fail("无法打开壁纸配置文件");
+            return;
+        }
 
-    QByteArray jsonData = jsonFile.readAll();
-    jsonFile.close();
+        QByteArray jsonData = jsonFile.readAll();
+        jsonFile.close();
 
-    // 解析JSON
-    QJsonParseError parseError;
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData, &parseError);
+        // 解析JSON
+        QJsonParseError parseError;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData, &parseError);
 
-    if (parseError.error != QJsonParseError::NoError) {
-        qWarning() << "JSON解析错误:" << parseError.errorString();
-        emit wallpapersLoaded(false, "壁纸配置文件格式错误");
-        return false;
-    }
+        if (parseError.error != QJsonParseError::NoError) {
+            qCWarning(lcWallpaper) << "JSON解析错误:" << parseError.errorString();
+            fail("壁纸配置文件格式错误");
+            return;
+        }
 
-    if (!jsonDoc.isArray()) {
-        qWarning() << "JSON根元素不是数组";
-        emit wallpapersLoaded(false, "壁纸配置文件格式错误");
-        return false;
-    }
+        if (!jsonDoc.isArray()) {
+            qCWarning(lcWallpaper) << "JSON根元素不是数组";
+            fail("壁纸配置文件格式错误");
+            return;
+        }
 
-    QJsonArray wallpaperArray = jsonDoc.array();
+        QJsonArray wallpaperArray = jsonDoc.array();
 
-    // 遍历壁纸配置
-    for (int i = 0; i < wallpaperArray.size(); ++i) {
-        QJsonObject wallpaperObj = wallpaperArray[i].toObject();
+        // 遍历壁纸配置
+        auto entries = std::make_shared<QVector<Entry>>();
+        entries->reserve(wallpaperArray.size());
+        for (int i = 0; i < wallpaperArray.size(); ++i) {
+            QJsonObject wallpaperObj = wallpaperArray[i].toObject();
 
-        QString id = wallpaperObj["id"].toString();
-        QString name = wallpaperObj["name"].toString();
-        QString description = wallpaperObj["description"].toString();
-        QString fileName = wallpaperObj["file"].toString();
+            Entry entry;
+            entry.id = wallpaperObj["id"].toString();
+            entry.name = wallpaperObj["name"].toString();
+            entry.description = wallpaperObj["description"].toString();
+            QString fileName = wallpaperObj["file"].toString();
 
-        if (id.isEmpty() || fileName.isEmpty()) {
-            qWarning() << "壁纸配置缺少必要字段，跳过:" << i;
-            continue;
+            if (entry.id.isEmpty() || fileName.isEmpty()) {
+                qCWarning(lcWallpaper) << "壁纸配置缺少必要字段，跳过:" << i;
+                continue;
+            }
+
+            // 构建壁纸文件路径
+            entry.filePath = wallpapersDir + "/" + fileName;
+            entry.imagePath = QString("file:///" + entry.filePath).replace("\\", "/");
+            entries->append(entry);
+        }
+
+        if (entries->isEmpty()) {
+            fail("没有找到有效的壁纸");
+            return;
         }
 
-        // 构建壁纸文件路径
-        QString imagePath = "file:///" + wallpapersDir + "/" + fileName;
-        imagePath = imagePath.replace("\\", "/");
+        // 检查壁纸文件：分组在线程池中并行进行，最后完成的一组交回界面线程
+        const int taskCount = std::max(1, std::min(m_pool.maxThreadCount(),
+                                                    int(entries->size() / MIN_ENTRIES_PER_TASK)));
+        const int perTask = (int(entries->size()) + taskCount - 1) / taskCount;
+        auto remaining = std::make_shared<std::atomic<int>>(taskCount);
+
+        for (int task = 0; task < taskCount; ++task) {
+            const int begin = task * perTask;
+            const int end = std::min(int(entries->size()), begin + perTask);
+            m_pool.start([this, generation, current, entries, remaining, begin, end, timer]() {
+                for (int i = begin; i < end && current->load() == generation; ++i) {
+                    Entry &entry = (*entries)[i];
+                    entry.valid = QFileInfo(entry.filePath).isFile();
+                }
+
+                if (remaining->fetch_sub(1) == 1) {
+                    qCDebug(lcWallpaper) << "检查了" << entries->size() << "个壁纸，耗时" << timer.elapsed() << "毫秒";
+                    QMetaObject::invokeMethod(this, [this, generation, entries]() {
+                        finishLoading(generation, *entries, QString());
+                    }, Qt::QueuedConnection);
+                }
+            });
+        }
+    });
+
+    return true;
+}
 
-        // 检查壁纸文件是否存在
-        QString localFilePath = wallpapersDir + "/" + fileName;
-        if (!QFile::exists(localFilePath)) {
-            qWarning() << "壁纸文件不存在，跳过:" << localFilePath;
+void WallpaperManager::finishLoading(quint64 generation, QVector<Entry> entries, const QString &errorMessage)
+{
+    // 加载期间又开始了新的加载
+    if (generation != m_generation->load()) {
+        return;
+    }
+
+    QVector<Entry> validEntries;
+    validEntries.reserve(entries.size());
+    for (const Entry &entry : entries) {
+        if (!entry.valid) {
+            qCWarning(lcWallpaper) << "壁纸文件不存在，跳过:" << entry.filePath;
             continue;
         }
+        validEntries.append(entry);
+    }
+
+    beginResetModel();
+    m_entries = std::move(validEntries);
+    m_rowById.clear();
+    for (int row = 0; row < m_entries.size(); ++row) {
+        // ID重复时以第一个为准
+        if (!m_rowById.contains(m_entries[row].id)) {
+            m_rowById.insert(m_entries[row].id, row);
+        }
+    }
+    endResetModel();
+    emit countChanged();
 
-        // 创建壁纸信息对象
-        WallpaperInfo *wallpaper = new WallpaperInfo(id, name, description, imagePath, "", this);
-        m_wallpapers.append(wallpaper);
+    m_loading = false;
+    emit loadingChanged();
 
-        qDebug() << "加载壁纸:" << name << "路径:" << imagePath;
+    if (!errorMessage.isEmpty() || m_entries.isEmpty()) {
+        // 旧的播放顺序中的行号已经失效
+        if (m_slideshowRunning) {
+            suspendSlideshow();
+        }
+    }
+
+    if (!errorMessage.isEmpty()) {
+        emit wallpapersLoaded(false, errorMessage);
+        return;
     }
 
-    if (m_wallpapers.isEmpty()) {
-        qWarning() << "没有找到有效的壁纸";
+    if (m_entries.isEmpty()) {
+        qCWarning(lcWallpaper) << "没有找到有效的壁纸";
         emit wallpapersLoaded(false, "没有找到有效的壁纸");
-        return false;
+        return;
     }
 
-    qDebug() << "成功加载" << m_wallpapers.size() << "个壁纸";
+    qCDebug(lcWallpaper) << "成功加载" << m_entries.size() << "个壁纸";
     emit wallpapersLoaded(true);
-    return true;
+
+    if (m_slideshowRunning) {
+        restartSlideshow();
+    }
 }
 
 bool WallpaperManager::createDefaultJsonFile()
@@ -158,7 +321,7 @@ bool WallpaperManager::createDefaultJsonFile()
     // 写入JSON文件
     QFile jsonFile(jsonPath);
     if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << "无法创建JSON文件:" << jsonPath;
+        qCWarning(lcWallpaper) << "无法创建JSON文件:" << jsonPath;
         return false;
     }
 
@@ -166,7 +329,7 @@ bool WallpaperManager::createDefaultJsonFile()
     jsonFile.write(jsonDoc.toJson(QJsonDocument::Indented));
     jsonFile.close();
 
-    qDebug() << "已创建默认JSON配置文件:" << jsonPath;
+    qCDebug(lcWallpaper) << "已创建默认JSON配置文件:" << jsonPath;
 
     // 创建README文件说明如何添加壁纸
     QString readmePath = wallpapersDir + "/README.txt";
@@ -194,44 +357,228 @@ bool WallpaperManager::createDefaultJsonFile()
     return true;
 }
 
-bool WallpaperManager::validateWallpaperFiles()
+QVariantMap WallpaperManager::entryMap(const Entry &entry) const
 {
-    QString wallpapersDir = getWallpapersDir();
+    QVariantMap map;
+    map["id"] = entry.id;
+    map["name"] = entry.name;
+    map["description"] = entry.description;
+    map["imagePath"] = entry.imagePath;
+    map["thumbnail"] = ThumbnailService::instance()->source(entry.filePath);
+    return map;
+}
 
-    for (QObject *obj : m_wallpapers) {
-        WallpaperInfo *wallpaper = qobject_cast<WallpaperInfo*>(obj);
-        if (wallpaper) {
-            // 提取本地文件路径（移除file:///前缀）
-            QString imagePath = wallpaper->imagePath();
-            if (imagePath.startsWith("file:///")) {
-                imagePath = imagePath.mid(8);
-            }
+QVariantMap WallpaperManager::getWallpaperById(const QString &id) const
+{
+    const int row = m_rowById.value(id, -1);
+    return row >= 0 ? entryMap(m_entries[row]) : QVariantMap();
+}
 
-            if (!QFile::exists(imagePath)) {
-                qWarning() << "壁纸文件不存在:" << imagePath;
-                return false;
-            }
+QVariantMap WallpaperManager::getDefaultWallpaper() const
+{
+    if (!m_entries.isEmpty()) {
+        return entryMap(m_entries.first());
+    }
+    return QVariantMap();
+}
+
+void WallpaperManager::startSlideshow(int intervalSeconds, const QString &order, int width, int height,
+                                      qreal devicePixelRatio)
+{
+    const int interval = std::clamp(intervalSeconds, MIN_SLIDESHOW_INTERVAL, MAX_SLIDESHOW_INTERVAL) * 1000;
+    const bool random = order == "random";
+    const QSize size = WallpaperCache::physicalSize(QSize(width, height), devicePixelRatio);
+    if (size.isEmpty()) {
+        return;
+    }
+
+    m_slideshowTimer.setInterval(interval);
+
+    // 只改变间隔时继续当前的顺序
+    if (m_slideshowRunning && random == m_slideshowRandom && size == m_slideshowSize) {
+        if (m_slideshowTimer.isActive()) {
+            m_slideshowTimer.start();
         }
+        return;
     }
 
-    return true;
+    m_slideshowRandom = random;
+    m_slideshowSize = size;
+    if (!m_slideshowRunning) {
+        m_slideshowRunning = true;
+        emit slideshowRunningChanged();
+    }
+
+    qCDebug(lcWallpaper) << "幻灯片: 间隔" << interval / 1000 << "秒" << (random ? "随机" : "顺序") << size;
+
+    // 目录还没有加载时，加载完成后开始
+    if (m_entries.isEmpty()) {
+        if (!m_loading) {
+            loadWallpapers();
+        }
+        return;
+    }
+    restartSlideshow();
 }
 
-QObject* WallpaperManager::getWallpaperById(const QString &id)
+void WallpaperManager::stopSlideshow()
 {
-    for (QObject *obj : m_wallpapers) {
-        WallpaperInfo *wallpaper = qobject_cast<WallpaperInfo*>(obj);
-        if (wallpaper && wallpaper->id() == id) {
-            return wallpaper;
+    if (!m_slideshowRunning) {
+        return;
+    }
+
+    ++m_slideshowGeneration;
+    m_slideshowRunning = false;
+    m_slideshowTimer.stop();
+    m_slideshowDecoding = false;
+    m_slideshowAdvancePending = false;
+    m_slideshowCurrent.reset();
+    m_slideshowNext.reset();
+    m_slideshowCurrentId.clear();
+    m_slideshowSource.clear();
+    emit slideshowSourceChanged();
+    emit slideshowRunningChanged();
+
+    qCDebug(lcWallpaper) << "幻灯片已停止";
+}
+
+void WallpaperManager::slideshowTransitionFinished()
+{
+    if (m_slideshowRunning && !m_slideshowNext && !m_slideshowDecoding) {
+        decodeNextSlide();
+    }
+}
+
+void WallpaperManager::restartSlideshow()
+{
+    ++m_slideshowGeneration;
+    m_slideshowDecoding = false;
+    m_slideshowNext.reset();
+    m_slideshowFailures = 0;
+    buildSlideshowOrder();
+
+    // 第一张解码完成后立即显示，之后按间隔切换
+    m_slideshowTimer.stop();
+    m_slideshowAdvancePending = true;
+    decodeNextSlide();
+}
+
+void WallpaperManager::suspendSlideshow()
+{
+    // 保留正在显示的一张，停止切换并丢弃进行中的解码，下次加载成功后从头开始
+    ++m_slideshowGeneration;
+    m_slideshowTimer.stop();
+    m_slideshowOrder.clear();
+    m_slideshowPosition = 0;
+    m_slideshowDecoding = false;
+    m_slideshowAdvancePending = false;
+    m_slideshowNext.reset();
+
+    qCDebug(lcWallpaper) << "壁纸目录不可用，幻灯片暂停";
+}
+
+void WallpaperManager::buildSlideshowOrder()
+{
+    m_slideshowOrder.resize(m_entries.size());
+    std::iota(m_slideshowOrder.begin(), m_slideshowOrder.end(), 0);
+    m_slideshowPosition = 0;
+
+    const int currentRow = m_rowById.value(m_slideshowCurrentId, -1);
+    if (m_slideshowRandom) {
+        std::shuffle(m_slideshowOrder.begin(), m_slideshowOrder.end(), *QRandomGenerator::global());
+        if (m_slideshowOrder.size() > 1 && m_slideshowOrder.first() == currentRow) {
+            std::swap(m_slideshowOrder.first(), m_slideshowOrder.last());
         }
+    } else if (currentRow >= 0) {
+        // 顺序播放时从当前壁纸的下一张继续
+        m_slideshowPosition = (currentRow + 1) % int(m_slideshowOrder.size());
     }
-    return nullptr;
 }
 
-QObject* WallpaperManager::getDefaultWallpaper()
+void WallpaperManager::decodeNextSlide()
 {
-    if (!m_wallpapers.isEmpty()) {
-        return m_wallpapers.first();
+    if (m_slideshowOrder.isEmpty() || m_entries.isEmpty()) {
+        return;
+    }
+    if (m_slideshowPosition >= m_slideshowOrder.size()) {
+        buildSlideshowOrder();
     }
-    return nullptr;
+
+    const Entry &entry = m_entries[m_slideshowOrder[m_slideshowPosition++]];
+    const quint64 generation = m_slideshowGeneration;
+    const QString id = entry.id;
+    const QString imagePath = entry.imagePath;
+    const QSize size = m_slideshowSize;
+    std::shared_ptr<std::atomic<quint64>> current = m_generation;
+
+    m_slideshowDecoding = true;
+    m_pool.start([this, generation, current, id, imagePath, size]() {
+        if (current->load() == 0) {
+            return;
+        }
+
+        // 已有按屏幕缩小的壁纸缓存（例如当前设置的壁纸）时解码缓存；没有时直接解码原图，
+        // 不为幻灯片排队生成：缓存目录只保留几个文件，轮换整个目录会挤掉桌面和锁屏使用的版本
+        const QString variant = WallpaperCache::instance()->existingVariantFor(imagePath, size);
+        const QString source = variant.isEmpty() ? imagePath : variant;
+        SharedImage image = WallpaperImageProvider::preload(source, size);
+
+        QMetaObject::invokeMethod(this, [this, generation, id, source, image]() {
+            nextSlideReady(generation, id, source, image);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void WallpaperManager::nextSlideReady(quint64 generation, const QString &id, const QString &source, SharedImage image)
+{
+    if (generation != m_slideshowGeneration) {
+        return;
+    }
+    m_slideshowDecoding = false;
+
+    if (!image) {
+        // 跳过无法解码的壁纸，全部失败时不再尝试
+        if (++m_slideshowFailures < m_entries.size()) {
+            decodeNextSlide();
+        } else {
+            qCWarning(lcWallpaper) << "幻灯片中的壁纸都无法解码";
+        }
+        return;
+    }
+
+    m_slideshowFailures = 0;
+    m_slideshowNext = std::move(image);
+    m_slideshowNextSource = source;
+    m_slideshowNextId = id;
+
+    if (m_slideshowAdvancePending) {
+        advanceSlideshow();
+    }
+}
+
+void WallpaperManager::advanceSlideshow()
+{
+    if (!m_slideshowRunning) {
+        return;
+    }
+
+    // 下一张还在解码，解码完成后立即切换
+    if (!m_slideshowNext) {
+        m_slideshowAdvancePending = true;
+        if (!m_slideshowDecoding) {
+            decodeNextSlide();
+        }
+        return;
+    }
+
+    m_slideshowAdvancePending = false;
+
+    // 上一张由界面在淡入结束前继续持有，这里只保留当前这一张
+    m_slideshowCurrent = std::move(m_slideshowNext);
+    m_slideshowNext.reset();
+    m_slideshowCurrentId = m_slideshowNextId;
+    m_slideshowSource = m_slideshowNextSource;
+    emit slideshowSourceChanged();
+
+    m_slideshowTimer.start();
 }
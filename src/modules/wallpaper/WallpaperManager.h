@@ -2,6 +2,7 @@
 #ifndef WALLPAPERMANAGER_H
 #define WALLPAPERMANAGER_H
 
+#include <QAbstractListModel>
 #include <QObject>
 #include <QJsonDocument>
 #include <QJsonArray>
@@ -9,9 +10,15 @@
 #include <QFile>
 #include <QDir>
 #include <QDebug>
+#include <QHash>
 #include <QStandardPaths>
 #include <QImage>
 #include <QBuffer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+#include <memory>
 
 class WallpaperInfo : public QObject
 {
@@ -42,35 +49,111 @@ private:
     QString m_thumbnail;
 };
 
-class WallpaperManager : public QObject
+// 壁纸目录（wallpapers.json）的列表模型：
+// 解析和检查壁纸文件在后台线程池中进行（文件检查分组并行），界面打开时不等待；
+// 缩略图由ThumbnailService按需生成（只生成显示出来的格子），缓存在磁盘上。
+//
+// 幻灯片：按设置的间隔和顺序轮换目录中的壁纸。下一张在后台线程中按屏幕分辨率提前解码
+// （有缩小后的壁纸缓存时解码缓存），放入"image://wallpaper/"的共用表，界面切换时不需要解码。
+// 内存中最多同时有两张屏幕大小的图像：淡入期间是当前和上一张，淡入结束后是当前和下一张
+class WallpaperManager : public QAbstractListModel
 {
     Q_OBJECT
-    Q_PROPERTY(QList<QObject*> wallpapers READ wallpapers NOTIFY wallpapersLoaded)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
+    Q_PROPERTY(bool slideshowRunning READ isSlideshowRunning NOTIFY slideshowRunningChanged)
+    // 幻灯片当前壁纸的文件URL（已解码，界面通过WallpaperCache.imageSource显示）
+    Q_PROPERTY(QString slideshowSource READ slideshowSource NOTIFY slideshowSourceChanged)
 
 public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1,
+        NameRole,
+        DescriptionRole,
+        ImagePathRole,
+        ThumbnailRole       // 缩略图的Image.source（image://thumbnail/）
+    };
+
     explicit WallpaperManager(QObject *parent = nullptr);
+    ~WallpaperManager();
 
-    // 加载壁纸列表
-    Q_INVOKABLE bool loadWallpapers();
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
 
-    // 获取壁纸列表
-    QList<QObject*> wallpapers() const { return m_wallpapers; }
+    // 在后台加载壁纸列表，完成后发出wallpapersLoaded
+    Q_INVOKABLE bool loadWallpapers();
 
-    // 通过ID获取壁纸
-    Q_INVOKABLE QObject* getWallpaperById(const QString &id);
+    // 通过ID获取壁纸（id、name、description、imagePath、thumbnail），没有时返回空表
+    Q_INVOKABLE QVariantMap getWallpaperById(const QString &id) const;
 
     // 获取默认壁纸（第一个）
-    Q_INVOKABLE QObject* getDefaultWallpaper();
+    Q_INVOKABLE QVariantMap getDefaultWallpaper() const;
 
     // 获取壁纸数量
-    Q_INVOKABLE int count() const { return m_wallpapers.size(); }
+    Q_INVOKABLE int count() const { return m_entries.size(); }
+
+    bool isLoading() const { return m_loading; }
+
+    // 开始（或以新的参数继续）幻灯片：intervalSeconds为切换间隔，order为"sequential"或"random"，
+    // width×height为界面Image的sourceSize（逻辑像素），devicePixelRatio为窗口的缩放比例，
+    // 按与Image相同的方式换算为物理像素后提前解码，界面加载时直接使用
+    Q_INVOKABLE void startSlideshow(int intervalSeconds, const QString &order, int width, int height,
+                                    qreal devicePixelRatio);
+    Q_INVOKABLE void stopSlideshow();
+
+    // 界面的淡入动画结束、上一张已不再显示后调用，之后才开始解码下一张
+    Q_INVOKABLE void slideshowTransitionFinished();
+
+    bool isSlideshowRunning() const { return m_slideshowRunning; }
+    QString slideshowSource() const { return m_slideshowSource; }
+
+    // 一张壁纸（在后台线程中生成，加载完成后交给界面线程）
+    struct Entry {
+        QString id;
+        QString name;
+        QString description;
+        QString filePath;       // 本地路径
+        QString imagePath;      // file:// URL
+        bool valid = false;     // 壁纸文件存在
+    };
 
 signals:
     void wallpapersLoaded(bool success, const QString &errorMessage = "");
     void wallpaperSelected(const QString &id);
+    void countChanged();
+    void loadingChanged();
+    void slideshowRunningChanged();
+    void slideshowSourceChanged();
 
 private:
-    QList<QObject*> m_wallpapers;
+    QVector<Entry> m_entries;
+    QHash<QString, int> m_rowById;
+    bool m_loading;
+
+    // 当前加载的编号（析构时置为0）：后台任务发现编号变化后不再继续，旧的结果到达时丢弃
+    std::shared_ptr<std::atomic<quint64>> m_generation;
+
+    QThreadPool m_pool;
+
+    // 幻灯片
+    typedef std::shared_ptr<const QImage> SharedImage;
+    bool m_slideshowRunning;
+    bool m_slideshowRandom;
+    QSize m_slideshowSize;              // 解码大小（物理像素，与界面请求的大小一致）
+    QTimer m_slideshowTimer;
+    quint64 m_slideshowGeneration;      // 参数变化或停止后，之前开始的解码结果丢弃
+    QVector<int> m_slideshowOrder;      // 本轮播放顺序（行号）
+    int m_slideshowPosition;            // 下一张在m_slideshowOrder中的位置
+    int m_slideshowFailures;            // 连续解码失败的次数，全部失败时停止尝试
+    bool m_slideshowDecoding;
+    bool m_slideshowAdvancePending;     // 到了切换时间但下一张还没解码完成
+    QString m_slideshowSource;
+    QString m_slideshowCurrentId;
+    SharedImage m_slideshowCurrent;     // 当前显示的壁纸
+    SharedImage m_slideshowNext;        // 已提前解码的下一张
+    QString m_slideshowNextSource;
+    QString m_slideshowNextId;
 
     // 获取壁纸文件夹路径
     QString getWallpapersDir() const;
@@ -81,8 +164,28 @@ private:
     // 创建默认JSON文件
     bool createDefaultJsonFile();
 
-    // 验证壁纸文件是否存在
-    bool validateWallpaperFiles();
+    QVariantMap entryMap(const Entry &entry) const;
+
+    // 后台加载完成（界面线程）
+    void finishLoading(quint64 generation, QVector<Entry> entries, const QString &errorMessage);
+
+    // 目录或幻灯片参数变化后从头开始（保留当前显示的壁纸）
+    void restartSlideshow();
+
+    // 目录加载失败或为空时暂停幻灯片（清空播放顺序，保持运行状态）
+    void suspendSlideshow();
+
+    // 生成一轮播放顺序（随机顺序时第一张不是当前显示的壁纸）
+    void buildSlideshowOrder();
+
+    // 在后台解码下一张
+    void decodeNextSlide();
+
+    // 下一张已解码（界面线程）
+    void nextSlideReady(quint64 generation, const QString &id, const QString &source, SharedImage image);
+
+    // 切换到已解码的下一张
+    void advanceSlideshow();
 };
 
 #endif // WALLPAPERMANAGER_H
@@ -3,6 +3,8 @@ import QtQuick.Controls
 import QtQuick.Window
 import ZiyanOS.SettingsManager
 import ZiyanOS.SystemUtils
+import ZiyanOS.WallpaperCache
+import ZiyanOS.WallpaperManager
 
 ApplicationWindow {
     id: desktop
@@ -51,20 +53,152 @@ ApplicationWindow {
     property string desktopBackground: settingsManager.desktopBackground
     property string desktopWallpaper: settingsManager.desktopWallpaper
 
+    // 新增：按屏幕物理分辨率缩小后的壁纸（后台生成，生成之前按屏幕大小解码原图）；
+    // 传入屏幕的逻辑大小和缩放比例，物理大小在C++中按与设置壁纸时相同的方式换算
+    property int wallpaperCacheRevision: 0
+    property string wallpaperVariant: wallpaperCacheRevision >= 0
+                                      ? WallpaperCache.variantFor(desktopWallpaper, Screen.width, Screen.height,
+                                                                  Screen.devicePixelRatio)
+                                      : ""
+
+    Connections {
+        target: WallpaperCache
+        function onVariantReady(source) {
+            if (source === desktopWallpaper) {
+                wallpaperCacheRevision++
+            }
+        }
+    }
+
+    // 新增：壁纸幻灯片（在设置中开启，按间隔轮换系统壁纸，下一张提前在后台解码）
+    property bool slideshowEnabled: settingsManager.settings.slideshowEnabled === true
+    property int slideshowInterval: settingsManager.settings.slideshowInterval
+    property string slideshowOrder: settingsManager.settings.slideshowOrder
+    // 逻辑像素，物理像素在C++中按与Image相同的方式换算
+    property size slideshowSize: Qt.size(width, height)
+    property real slideshowPixelRatio: Screen.devicePixelRatio
+    // 第一张幻灯片淡入后不再显示（也不再加载）固定的壁纸
+    property bool slideshowShown: false
+
+    onSlideshowEnabledChanged: updateSlideshow()
+    onSlideshowIntervalChanged: updateSlideshow()
+    onSlideshowOrderChanged: updateSlideshow()
+    onSlideshowSizeChanged: updateSlideshow()
+    onSlideshowPixelRatioChanged: updateSlideshow()
+
+    WallpaperManager {
+        id: wallpaperSlideshow
+        onSlideshowSourceChanged: showSlide(slideshowSource)
+    }
+
+    function updateSlideshow() {
+        if (slideshowEnabled && slideshowSize.width > 0 && slideshowSize.height > 0) {
+            wallpaperSlideshow.startSlideshow(slideshowInterval, slideshowOrder,
+                                              slideshowSize.width, slideshowSize.height,
+                                              slideshowPixelRatio)
+        } else {
+            wallpaperSlideshow.stopSlideshow()
+        }
+    }
+
+    // 在下层的图片中加载新的壁纸（已经解码，加载不需要等待），加载完成后在上层淡入
+    function showSlide(source) {
+        slideFade.complete()
+        if (source === "") {
+            // 幻灯片停止，恢复固定的壁纸
+            slideshowShown = false
+            for (var image of [slideImage0, slideImage1]) {
+                image.source = ""
+                image.opacity = 0
+                image.z = 0
+            }
+            return
+        }
+        var incoming = slideImage0.z > slideImage1.z ? slideImage1 : slideImage0
+        incoming.opacity = 0
+        incoming.source = WallpaperCache.imageSource(source)
+    }
+
+    function slideLoaded(image) {
+        // 只处理正在淡入的一张（上层的图片重新加载时不再淡入）
+        if (image.opacity !== 0) {
+            return
+        }
+        if (image.status === Image.Ready) {
+            image.z = 2
+            slideFade.target = image
+            slideFade.start()
+        } else if (image.status === Image.Error) {
+            wallpaperSlideshow.slideshowTransitionFinished()
+        }
+    }
+
     // 存储打开的窗口
     property var openWindows: []
 
     // 桌面背景
     Rectangle {
         anchors.fill: parent
-        color: desktopWallpaper === "" ? desktopBackground : "transparent"
+        color: desktopWallpaper === "" && !slideshowShown ? desktopBackground : "transparent"
 
         // 如果设置了壁纸图片，显示图片
         Image {
             anchors.fill: parent
-            source: desktopWallpaper
+            // 新增：通过壁纸提供器加载，锁屏和桌面共用同一次解码；不进入引擎的图片缓存，没有界面显示时立即释放
+            source: desktopWallpaper === "" || slideshowShown ? ""
+                                            : WallpaperCache.imageSource(wallpaperVariant !== "" ? wallpaperVariant : desktopWallpaper)
+            // 新增：只按屏幕大小解码（逻辑像素，Image按窗口的缩放比例换算后请求），异步加载不阻塞界面
+            sourceSize: Qt.size(width, height)
+            asynchronous: true
+            cache: false
             fillMode: Image.PreserveAspectCrop
-            visible: desktopWallpaper !== ""
+            visible: desktopWallpaper !== "" && !slideshowShown
+        }
+
+        // 新增：幻灯片的两张图片交替显示，新的一张在上层淡入，淡入结束后释放下层的旧壁纸
+        Item {
+            anchors.fill: parent
+            visible: slideshowEnabled
+
+            Image {
+                id: slideImage0
+                anchors.fill: parent
+                sourceSize: slideshowSize
+                asynchronous: true
+                cache: false
+                fillMode: Image.PreserveAspectCrop
+                opacity: 0
+                onStatusChanged: slideLoaded(slideImage0)
+            }
+
+            Image {
+                id: slideImage1
+                anchors.fill: parent
+                sourceSize: slideshowSize
+                asynchronous: true
+                cache: false
+                fillMode: Image.PreserveAspectCrop
+                opacity: 0
+                onStatusChanged: slideLoaded(slideImage1)
+            }
+        }
+
+        NumberAnimation {
+            id: slideFade
+            property: "opacity"
+            from: 0
+            to: 1
+            duration: 1000
+            easing.type: Easing.InOutQuad
+            onFinished: {
+                var outgoing = slideFade.target === slideImage0 ? slideImage1 : slideImage0
+                outgoing.source = ""
+                outgoing.opacity = 0
+                outgoing.z = 0
+                slideFade.target.z = 1
+                slideshowShown = true
+                wallpaperSlideshow.slideshowTransitionFinished()
+            }
         }
 
         // 桌面图标区域 - GridView 布局实现竖向排列和自动换列
@@ -161,6 +295,13 @@ ApplicationWindow {
                             appType: "downloadmanager",
                             appId: "downloadmanager"
                     },
+                    {
+                        // 新增：日志查看器
+                        iconText: "📜",
+                        iconName: "日志查看器",
+                        appType: "logviewer",
+                        appId: "logviewer"
+                    },
                     {
                         iconText: "⚙️",
                         iconName: "设置",
@@ -401,6 +542,16 @@ ApplicationWindow {
         }
     }
 
+    // 新增：日志查看器
+    Component {
+        id: logViewerWindowComponent
+        LogViewerWindow {
+            onWindowClosing: {
+                removeWindow(this)
+            }
+        }
+    }
+
     Component {
             id: settingsWindowComponent
             SettingsWindow {
@@ -435,6 +586,7 @@ ApplicationWindow {
             case "musicplayer": return "🎵"
             case "videoplayer": return "🎬"
             case "downloadmanager": return "⬇️"
+            case "logviewer": return "📜"
             case "settings": return "⚙️"
             case "power": return "🔌"
             case "easteregg": return "🥚"
@@ -556,6 +708,14 @@ ApplicationWindow {
                     "initialUrl": downloadUrl
                 })
                 break
+            case "logviewer":  // 新增：日志查看器，参数为要打开的日志文件（默认跟随当前日志）
+                window = logViewerWindowComponent.createObject(desktop)
+                if (additionalParam && window.openLog) {
+                    Qt.callLater(function() {
+                        window.openLog(additionalParam)
+                    })
+                }
+                break
             case "easteregg":  // 新增：彩蛋应用
                 window = easterEggWindowComponent.createObject(desktop)
                 break
@@ -791,6 +951,9 @@ ApplicationWindow {
         console.log("加载持久化壁纸设置")
         settingsManager.loadSettings()
 
+        // 新增：开启了幻灯片时开始轮换壁纸
+        updateSlideshow()
+
         // 移除鼠标覆盖程序的相关代码，现在在main.cpp中处理
         // if (systemUtils.hasPecmdIni()) {
         //     console.log("检测到pecmd.ini（PE环境），启动鼠标覆盖程序")
@@ -3,6 +3,7 @@ import QtQuick.Controls
 import QtQuick.Layouts
 import Qt5Compat.GraphicalEffects
 import ZiyanOS.SettingsManager
+import ZiyanOS.WallpaperCache
 
 ApplicationWindow {
     id: lockScreen
@@ -24,6 +25,23 @@ ApplicationWindow {
     property string desktopBackground: settingsManager.desktopBackground
     property string desktopWallpaper: settingsManager.desktopWallpaper
 
+    // 新增：按屏幕物理分辨率缩小后的壁纸（后台生成，生成之前按屏幕大小解码原图）；
+    // 传入屏幕的逻辑大小和缩放比例，物理大小在C++中按与设置壁纸时相同的方式换算
+    property int wallpaperCacheRevision: 0
+    property string wallpaperVariant: wallpaperCacheRevision >= 0
+                                      ? WallpaperCache.variantFor(desktopWallpaper, Screen.width, Screen.height,
+                                                                  Screen.devicePixelRatio)
+                                      : ""
+
+    Connections {
+        target: WallpaperCache
+        function onVariantReady(source) {
+            if (source === desktopWallpaper) {
+                wallpaperCacheRevision++
+            }
+        }
+    }
+
     // 背景（壁纸）
     Rectangle {
         anchors.fill: parent
@@ -32,7 +50,13 @@ ApplicationWindow {
         // 如果设置了壁纸图片，显示图片
         Image {
             anchors.fill: parent
-            source: desktopWallpaper
+            // 新增：通过壁纸提供器加载，锁屏和桌面共用同一次解码；不进入引擎的图片缓存，没有界面显示时立即释放
+            source: desktopWallpaper === "" ? ""
+                                            : WallpaperCache.imageSource(wallpaperVariant !== "" ? wallpaperVariant : desktopWallpaper)
+            // 新增：只按屏幕大小解码（逻辑像素，Image按窗口的缩放比例换算后请求），异步加载不阻塞界面
+            sourceSize: Qt.size(width, height)
+            asynchronous: true
+            cache: false
             fillMode: Image.PreserveAspectCrop
             visible: desktopWallpaper !== ""
         }
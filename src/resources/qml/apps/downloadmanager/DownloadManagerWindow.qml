@@ -7,17 +7,19 @@ import ZiyanOS.FileSystem
 ZiyanWindow {
     id: downloadWindow
     width: 500
-    height: 450
+    height: 720
     windowTitle: "下载管理器"
 
     property var filePicker: null
     property var fileSystem: FileSystem {}
     property string selectedSavePath: ""
 
-    // 下载管理器
-    DownloadManager {
-        id: downloadManager
-        onDownloadProgress: (bytesReceived, bytesTotal) => {
+    // 下载管理器（新增：全局只有一个，关闭窗口后下载继续进行）
+    readonly property var downloadManager: DownloadManager
+
+    Connections {
+        target: DownloadManager
+        function onDownloadProgress(bytesReceived, bytesTotal) {
             var progress = 0
             if (bytesTotal > 0) {
                 progress = (bytesReceived / bytesTotal) * 100
@@ -30,7 +32,7 @@ ZiyanWindow {
             sizeText.text = downloaded + " / " + total
         }
 
-        onDownloadFinished: (filePath) => {
+        function onDownloadFinished(filePath) {
             statusText.text = "下载完成: " + filePath
             downloadProgress.text = "完成"
             progressBar.value = 100
@@ -40,7 +42,7 @@ ZiyanWindow {
             sizeText.text = ""
         }
 
-        onDownloadError: (errorMessage) => {
+        function onDownloadError(errorMessage) {
             statusText.text = "错误: " + errorMessage
             downloadProgress.text = "失败"
             downloadBtn.enabled = true
@@ -49,9 +51,39 @@ ZiyanWindow {
             sizeText.text = ""
         }
 
-        onDownloadStarted: (fileName, fileSize) => {
+        function onDownloadStarted(fileName, fileSize) {
             statusText.text = "开始下载: " + fileName
         }
+
+        function onTaskVerified(taskId, sha256, xxh64, matched) {
+            if (matched && checksumInput.text !== "") {
+                statusText.text += "\n✅ 校验通过"
+            }
+            console.log("下载任务", taskId, "SHA-256:", sha256, "XXH64:", xxh64)
+        }
+    }
+
+    // 任务状态显示文字（与DownloadManager::TaskState对应）
+    function stateText(state) {
+        switch (state) {
+        case 0: return "排队中"
+        case 1: return "下载中"
+        case 2: return "已完成"
+        case 3: return "失败"
+        case 4: return "已取消"
+        case 5: return "已暂停"
+        }
+        return ""
+    }
+
+    function stateColor(state) {
+        switch (state) {
+        case 1: return "#3498db"
+        case 2: return "#27ae60"
+        case 3: return "#e74c3c"
+        case 5: return "#f39c12"
+        }
+        return "#95a5a6"
     }
 
     function formatBytes(bytes) {
@@ -111,6 +143,49 @@ ZiyanWindow {
                 }
             }
 
+            // 校验值输入区域（可选）
+            ColumnLayout {
+                spacing: 4
+                Layout.fillWidth: true
+
+                Text {
+                    text: "校验值（可选）:"
+                    font.pixelSize: 13
+                    color: "#2c3e50"
+                }
+
+                Rectangle {
+                    Layout.fillWidth: true
+                    height: 32
+                    color: "white"
+                    border.color: "#bdc3c7"
+                    border.width: 1
+                    radius: 4
+
+                    TextInput {
+                        id: checksumInput
+                        anchors.fill: parent
+                        anchors.margins: 8
+                        verticalAlignment: TextInput.AlignVCenter
+                        font.pixelSize: 12
+                        selectByMouse: true
+                        clip: true
+                    }
+
+                    Text {
+                        text: "SHA-256值或.sha256文件链接"
+                        color: "#95a5a6"
+                        font.pixelSize: 12
+                        anchors {
+                            left: parent.left
+                            leftMargin: 8
+                            verticalCenter: parent.verticalCenter
+                        }
+                        visible: checksumInput.text === ""
+                    }
+                }
+            }
+
             // 保存路径选择
             ColumnLayout {
                 spacing: 4
@@ -211,6 +286,49 @@ ZiyanWindow {
                 }
             }
 
+            // 限速设置（修改后立即对正在进行的下载生效）
+            RowLayout {
+                Layout.fillWidth: true
+                spacing: 6
+
+                Text {
+                    text: "限速:"
+                    font.pixelSize: 13
+                    color: "#2c3e50"
+                }
+
+                Rectangle {
+                    width: 80
+                    height: 24
+                    color: "white"
+                    border.color: "#bdc3c7"
+                    border.width: 1
+                    radius: 3
+
+                    TextInput {
+                        id: rateLimitInput
+                        anchors.fill: parent
+                        anchors.margins: 4
+                        verticalAlignment: TextInput.AlignVCenter
+                        font.pixelSize: 12
+                        selectByMouse: true
+                        validator: IntValidator { bottom: 0 }
+                        text: downloadManager.globalRateLimit > 0 ? Math.round(downloadManager.globalRateLimit / 1024) : ""
+                        onEditingFinished: {
+                            var kbps = parseInt(text)
+                            downloadManager.globalRateLimit = isNaN(kbps) ? 0 : kbps * 1024
+                        }
+                    }
+                }
+
+                Text {
+                    text: downloadManager.globalRateLimit > 0 ? "KB/s" : "KB/s（留空表示不限速）"
+                    color: "#7f8c8d"
+                    font.pixelSize: 11
+                    Layout.fillWidth: true
+                }
+            }
+
             // 进度显示区域
             ColumnLayout {
                 spacing: 6
@@ -311,7 +429,11 @@ ZiyanWindow {
                             downloadBtn.enabled = false
                             urlInput.enabled = false
                             selectPathBtn.enabled = false
-                            downloadManager.startDownload(urlInput.text, selectedSavePath)
+                            if (checksumInput.text !== "") {
+                                downloadManager.startVerifiedDownload(urlInput.text, selectedSavePath, checksumInput.text)
+                            } else {
+                                downloadManager.startDownload(urlInput.text, selectedSavePath)
+                            }
                         }
                     }
                 }
@@ -343,7 +465,177 @@ ZiyanWindow {
                     }
                 }
             }
+
+            // 下载记录（历史任务较多时按页加载）
+            RowLayout {
+                Layout.fillWidth: true
+                spacing: 6
+
+                Text {
+                    text: "下载记录（" + downloadManager.taskModel.totalCount + "）"
+                    font.pixelSize: 13
+                    color: "#2c3e50"
+                }
+
+                // 新增：下载缓存命中统计
+                Text {
+                    text: "缓存命中 " + downloadManager.cacheHits + "/"
+                          + (downloadManager.cacheHits + downloadManager.cacheMisses)
+                          + "，节省 " + formatBytes(downloadManager.cacheBytesSaved)
+                    font.pixelSize: 11
+                    color: "#7f8c8d"
+                    elide: Text.ElideRight
+                    Layout.fillWidth: true
+                }
+
+                Rectangle {
+                    width: 70
+                    height: 24
+                    color: "#95a5a6"
+                    radius: 3
+
+                    Text {
+                        text: "清除记录"
+                        color: "white"
+                        font.pixelSize: 11
+                        anchors.centerIn: parent
+                    }
+
+                    MouseArea {
+                        anchors.fill: parent
+                        onClicked: downloadManager.clearHistory()
+                    }
+                }
+            }
+
+            Rectangle {
+                Layout.fillWidth: true
+                Layout.fillHeight: true
+                color: "#f8f9fa"
+                radius: 6
+                border.color: "#dee2e6"
+                border.width: 1
+
+                ListView {
+                    id: historyList
+                    anchors.fill: parent
+                    anchors.margins: 4
+                    clip: true
+                    model: downloadManager.taskModel
+                    cacheBuffer: 200
+                    ScrollBar.vertical: ScrollBar {}
+
+                    delegate: Rectangle {
+                        width: historyList.width
+                        height: 40
+                        color: index % 2 === 0 ? "white" : "#f8f9fa"
+
+                        ColumnLayout {
+                            anchors.fill: parent
+                            anchors.leftMargin: 8
+                            anchors.rightMargin: 8
+                            spacing: 2
+
+                            RowLayout {
+                                Layout.fillWidth: true
+                                spacing: 6
+
+                                Text {
+                                    text: model.fileName
+                                    font.pixelSize: 12
+                                    color: "#2c3e50"
+                                    elide: Text.ElideMiddle
+                                    Layout.fillWidth: true
+                                }
+
+                                Text {
+                                    text: downloadWindow.stateText(model.state)
+                                    font.pixelSize: 11
+                                    color: downloadWindow.stateColor(model.state)
+                                }
+
+                                // 新增：图片、音乐和视频不必等下载完成，直接边下边看
+                                Text {
+                                    visible: (model.state === 1 || model.state === 2 || model.state === 5)
+                                             && downloadWindow.viewerForFile(model.fileName) !== ""
+                                    text: "打开"
+                                    font.pixelSize: 11
+                                    color: "#27ae60"
+
+                                    MouseArea {
+                                        anchors.fill: parent
+                                        cursorShape: Qt.PointingHandCursor
+                                        onClicked: createApplicationWindow(downloadWindow.viewerForFile(model.fileName),
+                                                                           model.savePath)
+                                    }
+                                }
+
+                                // 暂停/继续（排队中、下载中、已暂停的任务）
+                                Text {
+                                    visible: model.state === 0 || model.state === 1 || model.state === 5
+                                    text: model.state === 5 ? "继续" : "暂停"
+                                    font.pixelSize: 11
+                                    color: "#3498db"
+
+                                    MouseArea {
+                                        anchors.fill: parent
+                                        cursorShape: Qt.PointingHandCursor
+                                        onClicked: {
+                                            if (model.state === 5) {
+                                                downloadManager.resumeTask(model.taskId)
+                                            } else {
+                                                downloadManager.pauseTask(model.taskId)
+                                            }
+                                        }
+                                    }
+                                }
+
+                                Text {
+                                    visible: model.state === 0 || model.state === 1 || model.state === 5
+                                    text: "取消"
+                                    font.pixelSize: 11
+                                    color: "#e74c3c"
+
+                                    MouseArea {
+                                        anchors.fill: parent
+                                        cursorShape: Qt.PointingHandCursor
+                                        onClicked: downloadManager.cancelTask(model.taskId)
+                                    }
+                                }
+                            }
+
+                            Text {
+                                text: model.totalSize > 0
+                                      ? formatBytes(model.downloadedSize) + " / " + formatBytes(model.totalSize)
+                                      : model.url
+                                font.pixelSize: 10
+                                color: "#7f8c8d"
+                                elide: Text.ElideMiddle
+                                Layout.fillWidth: true
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // 根据扩展名选择打开文件的应用，不支持边下边看的类型返回空字符串
+    function viewerForFile(fileName) {
+        var lowerName = fileName.toLowerCase()
+        var viewers = [
+            { app: "imageviewer", extensions: [".jpg", ".jpeg", ".png", ".bmp", ".gif", ".webp"] },
+            { app: "musicplayer", extensions: [".mp3", ".wav", ".ogg", ".flac", ".aac", ".m4a"] },
+            { app: "videoplayer", extensions: [".mp4", ".mkv", ".mov", ".webm", ".m4v"] }
+        ]
+        for (var i = 0; i < viewers.length; i++) {
+            for (var j = 0; j < viewers[i].extensions.length; j++) {
+                if (lowerName.endsWith(viewers[i].extensions[j])) {
+                    return viewers[i].app
+                }
+            }
         }
+        return ""
     }
 
     // 显示文件选择器
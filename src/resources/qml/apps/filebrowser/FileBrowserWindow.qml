@@ -3,6 +3,7 @@ import QtQuick.Controls
 import QtQuick.Layouts
 import ZiyanOS.FileSystem
 import ZiyanOS.SystemUtils
+import ZiyanOS.ThumbnailService  // 新增：图片文件的缩略图
 
 ZiyanWindow {
     id: fileBrowserWindow
@@ -300,10 +301,21 @@ ZiyanWindow {
                     radius: 5
                     anchors.verticalCenter: parent.verticalCenter
 
+                    // 新增：图片文件显示缩略图，生成之前显示类型图标
+                    Image {
+                        id: fileThumbnail
+                        anchors.fill: parent
+                        source: model.isDir ? "" : ThumbnailService.source(model.path)
+                        sourceSize: Qt.size(64, 64)
+                        fillMode: Image.PreserveAspectCrop
+                        asynchronous: true
+                    }
+
                     Text {
                         text: model.isDir ? "📁" : getFileIcon(model.name)
                         font.pixelSize: 16
                         anchors.centerIn: parent
+                        visible: fileThumbnail.status !== Image.Ready
                     }
                 }
 
@@ -2,6 +2,8 @@ import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
 import ZiyanOS.FileSystem
+import ZiyanOS.DownloadStream
+import ZiyanOS.ThumbnailService  // 新增：加载原图之前先显示缩略图
 
 ZiyanWindow {
     id: imageViewer
@@ -11,7 +13,10 @@ ZiyanWindow {
     contentBackground: "#2c3e50"
 
     property string currentImagePath: ""
+    // 新增：图片的实际来源（正在下载的图片通过image://download/读取已到达的数据，数据到齐后显示）
+    property string currentImageSource: ""
     property var fileSystem: FileSystem {}
+    property var downloadStream: DownloadStream {}
     property var filePicker: null
     
 
@@ -23,6 +28,19 @@ ZiyanWindow {
             id: imageView
             anchors.fill: parent
 
+            // 新增：缩略图预览 - 原图解码完成之前先显示缓存的小图（正在下载的图片没有缩略图）
+            Image {
+                id: preview
+                anchors.centerIn: parent
+                width: parent.width - 40
+                height: parent.height - 80
+                fillMode: Image.PreserveAspectFit
+                source: currentImageSource.startsWith("file:") ? ThumbnailService.source(currentImagePath) : ""
+                sourceSize: Qt.size(512, 512)
+                asynchronous: true
+                visible: image.status !== Image.Ready
+            }
+
             // 图片容器 - 始终居中
             Item {
                 id: imageContainer
@@ -36,7 +54,7 @@ ZiyanWindow {
                     width: parent.width
                     height: parent.height
                     fillMode: Image.PreserveAspectFit
-                    source: currentImagePath ? "file:///" + currentImagePath : ""
+                    source: currentImageSource
                     asynchronous: true
                     cache: false
 
@@ -170,6 +188,8 @@ ZiyanWindow {
     function loadImage(path) {
         console.log("加载图片: " + path)
         currentImagePath = path
+        currentImageSource = downloadStream.isDownloading(path) ? downloadStream.imageSource(path)
+                                                                : "file:///" + path
         imageViewer.windowTitle = "图片查看器 - " + getFileName(path)
     }
 
@@ -178,6 +198,7 @@ ZiyanWindow {
         console.log("图片查看器错误: " + message)
         // 可以添加错误对话框
         currentImagePath = ""
+        currentImageSource = ""
         imageViewer.windowTitle = "图片查看器"
     }
 
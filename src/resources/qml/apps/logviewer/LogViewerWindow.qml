@@ -0,0 +1,499 @@
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+import ZiyanOS.LogViewerModel 1.0
+
+ZiyanWindow {
+    id: logViewerWindow
+    width: 900
+    height: 620
+    windowTitle: "日志查看器"
+
+    property var filePicker: null
+
+    // 自动滚动到最新的日志
+    property bool followTail: true
+
+    // 当前选中的行（用于查找上一个/下一个匹配）
+    property int currentRow: -1
+
+    // 等级过滤按钮（与LogIndexer::Level对应）
+    readonly property var levels: [
+        { level: 0, label: "全部" },
+        { level: 1, label: "信息" },
+        { level: 2, label: "警告" },
+        { level: 3, label: "严重" }
+    ]
+
+    LogViewerModel {
+        id: logModel
+        followCurrentLog: true
+
+        onCountChanged: {
+            if (followTail) {
+                Qt.callLater(function() { logList.positionViewAtEnd() })
+            }
+        }
+    }
+
+    function levelColor(level) {
+        switch (level) {
+        case 0: return "#7f8c8d"
+        case 2: return "#d35400"
+        case 3: return "#c0392b"
+        case 4: return "#8e44ad"
+        }
+        return "#2c3e50"
+    }
+
+    function formatBytes(bytes) {
+        if (bytes < 1024) return bytes + " B"
+        if (bytes < 1024 * 1024) return (bytes / 1024).toFixed(1) + " KB"
+        if (bytes < 1024 * 1024 * 1024) return (bytes / (1024 * 1024)).toFixed(1) + " MB"
+        return (bytes / (1024 * 1024 * 1024)).toFixed(1) + " GB"
+    }
+
+    // 跳转到行或显示指定的行
+    function showRow(row) {
+        if (row < 0) {
+            return
+        }
+        followTail = false
+        currentRow = row
+        logList.positionViewAtIndex(row, ListView.Center)
+    }
+
+    // 跳转：纯数字为行号，否则按时间（yyyy-MM-dd HH:mm:ss）
+    function jumpTo(text) {
+        var value = text.trim()
+        if (value === "") {
+            return
+        }
+        if (/^\d+$/.test(value)) {
+            showRow(logModel.rowForLine(parseInt(value)))
+            return
+        }
+        var time = new Date(value.replace(" ", "T"))
+        if (isNaN(time.getTime())) {
+            jumpStatus.text = "格式: 行号或yyyy-MM-dd HH:mm:ss"
+            return
+        }
+        jumpStatus.text = ""
+        showRow(logModel.rowForTime(time))
+    }
+
+    // 打开其他日志文件
+    function openLog(path) {
+        if (path && typeof path === 'string') {
+            followTail = false
+            logModel.source = path
+        }
+    }
+
+    function showFilePicker() {
+        filePicker = filePickerComponent.createObject(logViewerWindow, {
+            "selectFolder": false,
+            "fileFilters": [".log", ".txt"],
+            "fileMode": "open"
+        })
+
+        filePicker.fileSelected.connect(function(path) {
+            openLog(path)
+            filePicker.destroy()
+        })
+
+        filePicker.canceled.connect(function() {
+            filePicker.destroy()
+        })
+
+        filePicker.showWindow()
+    }
+
+    // 输入停止后再搜索
+    Timer {
+        id: searchTimer
+        interval: 300
+        onTriggered: logModel.searchText = searchInput.text
+    }
+
+    contentItem: Item {
+        anchors.fill: parent
+
+        ColumnLayout {
+            anchors.fill: parent
+            anchors.margins: 10
+            spacing: 8
+
+            // 文件
+            RowLayout {
+                Layout.fillWidth: true
+                spacing: 6
+
+                Rectangle {
+                    Layout.fillWidth: true
+                    height: 30
+                    color: "#f8f9fa"
+                    border.color: "#bdc3c7"
+                    border.width: 1
+                    radius: 4
+
+                    Text {
+                        text: logModel.source ? logModel.source : "未打开日志"
+                        color: logModel.source ? "#2c3e50" : "#95a5a6"
+                        font.pixelSize: 12
+                        elide: Text.ElideLeft
+                        anchors {
+                            left: parent.left
+                            right: parent.right
+                            verticalCenter: parent.verticalCenter
+                            margins: 8
+                        }
+                    }
+                }
+
+                Rectangle {
+                    width: 80
+                    height: 30
+                    color: logModel.followCurrentLog ? "#27ae60" : "#95a5a6"
+                    radius: 4
+
+                    Text {
+                        text: "当前日志"
+                        color: "white"
+                        font.pixelSize: 12
+                        anchors.centerIn: parent
+                    }
+
+                    MouseArea {
+                        anchors.fill: parent
+                        onClicked: {
+                            logModel.followCurrentLog = true
+                            followTail = true
+                        }
+                    }
+                }
+
+                Rectangle {
+                    width: 60
+                    height: 30
+                    color: "#3498db"
+                    radius: 4
+
+                    Text {
+                        text: "打开"
+                        color: "white"
+                        font.pixelSize: 12
+                        anchors.centerIn: parent
+                    }
+
+                    MouseArea {
+                        anchors.fill: parent
+                        onClicked: showFilePicker()
+                    }
+                }
+            }
+
+            // 过滤
+            RowLayout {
+                Layout.fillWidth: true
+                spacing: 6
+
+                Text {
+                    text: "等级:"
+                    font.pixelSize: 13
+                    color: "#2c3e50"
+                }
+
+                Repeater {
+                    model: levels
+
+                    Rectangle {
+                        width: 48
+                        height: 26
+                        radius: 3
+                        color: logModel.minimumLevel === modelData.level ? "#3498db" : "#ecf0f1"
+                        border.color: "#bdc3c7"
+                        border.width: 1
+
+                        Text {
+                            text: modelData.label
+                            color: logModel.minimumLevel === modelData.level ? "white" : "#2c3e50"
+                            font.pixelSize: 12
+                            anchors.centerIn: parent
+                        }
+
+                        MouseArea {
+                            anchors.fill: parent
+                            onClicked: logModel.minimumLevel = modelData.level
+                        }
+                    }
+                }
+
+                Text {
+                    text: "分类:"
+                    font.pixelSize: 13
+                    color: "#2c3e50"
+                    Layout.leftMargin: 10
+                }
+
+                ComboBox {
+                    id: categoryBox
+                    Layout.preferredWidth: 180
+                    implicitHeight: 28
+                    font.pixelSize: 12
+                    model: ["全部"].concat(logModel.categories)
+                    currentIndex: logModel.category === "" ? 0 : logModel.categories.indexOf(logModel.category) + 1
+                    onActivated: (index) => {
+                        logModel.category = index === 0 ? "" : logModel.categories[index - 1]
+                    }
+                }
+
+                Item { Layout.fillWidth: true }
+
+                Rectangle {
+                    width: 60
+                    height: 26
+                    radius: 3
+                    color: followTail ? "#27ae60" : "#95a5a6"
+
+                    Text {
+                        text: "跟随"
+                        color: "white"
+                        font.pixelSize: 12
+                        anchors.centerIn: parent
+                    }
+
+                    MouseArea {
+                        anchors.fill: parent
+                        onClicked: {
+                            followTail = !followTail
+                            if (followTail) {
+                                logList.positionViewAtEnd()
+                            }
+                        }
+                    }
+                }
+            }
+
+            // 搜索和跳转
+            RowLayout {
+                Layout.fillWidth: true
+                spacing: 6
+
+                Rectangle {
+                    Layout.fillWidth: true
+                    height: 30
+                    color: "white"
+                    border.color: "#bdc3c7"
+                    border.width: 1
+                    radius: 4
+
+                    TextInput {
+                        id: searchInput
+                        anchors.fill: parent
+                        anchors.margins: 8
+                        verticalAlignment: TextInput.AlignVCenter
+                        font.pixelSize: 13
+                        selectByMouse: true
+                        clip: true
+                        onTextChanged: searchTimer.restart()
+                        onAccepted: showRow(logModel.nextMatch(currentRow))
+                    }
+
+                    Text {
+                        text: "搜索（回车查找下一个）"
+                        color: "#95a5a6"
+                        font.pixelSize: 13
+                        anchors {
+                            left: parent.left
+                            leftMargin: 8
+                            verticalCenter: parent.verticalCenter
+                        }
+                        visible: searchInput.text === ""
+                    }
+                }
+
+                CheckBox {
+                    text: "区分大小写"
+                    font.pixelSize: 12
+                    checked: logModel.caseSensitive
+                    onToggled: logModel.caseSensitive = checked
+                }
+
+                CheckBox {
+                    text: "只显示匹配"
+                    font.pixelSize: 12
+                    checked: logModel.matchesOnly
+                    onToggled: logModel.matchesOnly = checked
+                }
+
+                Button {
+                    text: "▲"
+                    implicitWidth: 32
+                    implicitHeight: 28
+                    enabled: logModel.matchCount > 0
+                    onClicked: showRow(logModel.previousMatch(currentRow))
+                }
+
+                Button {
+                    text: "▼"
+                    implicitWidth: 32
+                    implicitHeight: 28
+                    enabled: logModel.matchCount > 0
+                    onClicked: showRow(logModel.nextMatch(currentRow))
+                }
+
+                Text {
+                    text: logModel.searchText === "" ? "" : (logModel.matchCount + " 行匹配" + (logModel.searching ? "…" : ""))
+                    font.pixelSize: 12
+                    color: "#7f8c8d"
+                    Layout.preferredWidth: 90
+                }
+
+                Rectangle {
+                    width: 160
+                    height: 30
+                    color: "white"
+                    border.color: "#bdc3c7"
+                    border.width: 1
+                    radius: 4
+
+                    TextInput {
+                        id: jumpInput
+                        anchors.fill: parent
+                        anchors.margins: 8
+                        verticalAlignment: TextInput.AlignVCenter
+                        font.pixelSize: 12
+                        selectByMouse: true
+                        clip: true
+                        onAccepted: jumpTo(text)
+                    }
+
+                    Text {
+                        text: "跳到行号或时间"
+                        color: "#95a5a6"
+                        font.pixelSize: 12
+                        anchors {
+                            left: parent.left
+                            leftMargin: 8
+                            verticalCenter: parent.verticalCenter
+                        }
+                        visible: jumpInput.text === ""
+                    }
+                }
+            }
+
+            // 日志内容（固定行高，只创建可见的行）
+            Rectangle {
+                Layout.fillWidth: true
+                Layout.fillHeight: true
+                color: "white"
+                border.color: "#bdc3c7"
+                border.width: 1
+                radius: 4
+
+                ListView {
+                    id: logList
+                    anchors.fill: parent
+                    anchors.margins: 4
+                    clip: true
+                    model: logModel
+                    reuseItems: true
+                    boundsBehavior: Flickable.StopAtBounds
+                    ScrollBar.vertical: ScrollBar { policy: ScrollBar.AlwaysOn }
+
+                    // 用户向上滚动后停止跟随，滚到底部后恢复
+                    onMovementEnded: followTail = atYEnd
+
+                    delegate: Rectangle {
+                        width: logList.width
+                        height: 18
+                        color: index === currentRow ? "#d6eaf8" : (model.matched ? "#fcf3cf" : "transparent")
+
+                        Text {
+                            id: lineNumberText
+                            width: 64
+                            text: model.lineNumber
+                            color: "#95a5a6"
+                            font.family: "monospace"
+                            font.pixelSize: 12
+                            horizontalAlignment: Text.AlignRight
+                            anchors.verticalCenter: parent.verticalCenter
+                        }
+
+                        Text {
+                            text: model.text
+                            color: levelColor(model.level)
+                            font.family: "monospace"
+                            font.pixelSize: 12
+                            elide: Text.ElideRight
+                            textFormat: Text.PlainText
+                            anchors {
+                                left: lineNumberText.right
+                                leftMargin: 10
+                                right: parent.right
+                                verticalCenter: parent.verticalCenter
+                            }
+                        }
+
+                        MouseArea {
+                            anchors.fill: parent
+                            onClicked: currentRow = index
+                        }
+                    }
+                }
+
+                Text {
+                    anchors.centerIn: parent
+                    visible: logModel.errorString !== "" || (logModel.count === 0 && !logModel.indexing)
+                    text: logModel.errorString !== "" ? logModel.errorString : "没有日志"
+                    color: "#95a5a6"
+                    font.pixelSize: 14
+                }
+            }
+
+            // 状态栏
+            RowLayout {
+                Layout.fillWidth: true
+                spacing: 10
+
+                Text {
+                    text: logModel.count === logModel.lineCount
+                          ? logModel.lineCount + " 行"
+                          : "显示 " + logModel.count + " / " + logModel.lineCount + " 行"
+                    font.pixelSize: 12
+                    color: "#7f8c8d"
+                }
+
+                Text {
+                    text: formatBytes(logModel.fileSize)
+                    font.pixelSize: 12
+                    color: "#7f8c8d"
+                }
+
+                ProgressBar {
+                    Layout.preferredWidth: 160
+                    visible: logModel.indexing
+                    value: logModel.progress
+                }
+
+                Text {
+                    id: jumpStatus
+                    font.pixelSize: 12
+                    color: "#e74c3c"
+                    Layout.fillWidth: true
+                }
+            }
+        }
+    }
+
+    // 文件选择器组件
+    Component {
+        id: filePickerComponent
+        FilePicker {}
+    }
+
+    Component.onCompleted: {
+        console.log("日志查看器已加载")
+    }
+}
@@ -3,6 +3,7 @@ import QtQuick.Controls
 import QtQuick.Layouts
 import QtMultimedia
 import ZiyanOS.FileSystem
+import ZiyanOS.DownloadStream
 
 ZiyanWindow {
     id: musicPlayer
@@ -13,6 +14,8 @@ ZiyanWindow {
 
     property string currentMusicPath: ""
     property var fileSystem: FileSystem {}
+    // 新增：正在下载的文件边下边播
+    property var downloadStream: DownloadStream {}
     property var filePicker: null
 
 
@@ -50,6 +53,8 @@ ZiyanWindow {
     onWindowClosing: {
         console.log("音乐播放器窗口关闭，停止播放")
         isClosing = true
+        // 先唤醒可能阻塞在下载数据上的播放线程
+        downloadStream.detachPlayer(mediaPlayer)
         stopMusic()
 
         // 确保媒体资源被释放
@@ -59,6 +64,7 @@ ZiyanWindow {
     // 组件销毁时的清理
     Component.onDestruction: {
         console.log("音乐播放器组件销毁，清理资源")
+        downloadStream.detachPlayer(mediaPlayer)
         if (mediaPlayer.playbackState !== MediaPlayer.StoppedState) {
             mediaPlayer.stop()
         }
@@ -338,7 +344,11 @@ ZiyanWindow {
         console.log("加载音乐: " + path)
         currentMusicPath = path
         musicPlayer.windowTitle = "音乐播放器 - " + getFileName(path)
-        mediaPlayer.source = "file:///" + path
+        downloadStream.detachPlayer(mediaPlayer)
+        // 新增：文件还在下载时直接读取已到达的数据，不必等下载完成
+        if (!downloadStream.isDownloading(path) || !downloadStream.attachPlayer(mediaPlayer, path)) {
+            mediaPlayer.source = "file:///" + path
+        }
         playMusic()
     }
 
@@ -0,0 +1,162 @@
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+import ZiyanOS.LogFilter
+
+Item {
+    id: loggingPage
+    implicitHeight: loggingContent.height
+
+    // 可选的最低等级（空字符串表示使用配置文件中的规则）
+    readonly property var levels: [
+        { name: "", label: "默认" },
+        { name: "debug", label: "调试" },
+        { name: "info", label: "信息" },
+        { name: "warning", label: "警告" },
+        { name: "critical", label: "严重" },
+        { name: "off", label: "关闭" }
+    ]
+
+    // 分类等级改变后刷新按钮状态
+    property int revision: 0
+
+    Column {
+        id: loggingContent
+        width: parent.width
+        spacing: 25
+        padding: 20
+
+        // 页面标题
+        Text {
+            text: "日志设置"
+            font.pixelSize: 18
+            font.bold: true
+            color: "#2c3e50"
+        }
+
+        Text {
+            text: "为每个模块设置记录的最低等级，立即生效，重启后恢复为配置文件中的规则"
+            color: "#7f8c8d"
+            font.pixelSize: 12
+            width: parent.width - 40
+            wrapMode: Text.Wrap
+        }
+
+        // 各模块的最低等级
+        Column {
+            width: parent.width
+            spacing: 15
+
+            Repeater {
+                model: LogFilter.categories()
+
+                Column {
+                    spacing: 8
+
+                    property string category: modelData
+
+                    Text {
+                        text: category
+                        font.pixelSize: 14
+                        color: "#2c3e50"
+                    }
+
+                    Row {
+                        spacing: 10
+
+                        Repeater {
+                            model: loggingPage.levels
+
+                            Rectangle {
+                                width: 64
+                                height: 32
+                                radius: 5
+                                color: selected ? "#3498db" : "white"
+
+                                property bool selected: loggingPage.revision >= 0
+                                                        && LogFilter.categoryLevel(category) === modelData.name
+
+                                Text {
+                                    text: modelData.label
+                                    color: parent.selected ? "white" : "#2c3e50"
+                                    font.pixelSize: 13
+                                    anchors.centerIn: parent
+                                }
+
+                                MouseArea {
+                                    anchors.fill: parent
+                                    onClicked: {
+                                        LogFilter.setCategoryLevel(category, modelData.name)
+                                        loggingPage.revision++
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // 额外规则（与logging.ini的[Rules]段格式相同）
+        Column {
+            width: parent.width
+            spacing: 10
+
+            Text {
+                text: "额外规则（每行一条，例如 ziyanos.download.debug=true）"
+                font.pixelSize: 14
+                color: "#2c3e50"
+            }
+
+            Rectangle {
+                width: parent.width - 40
+                height: 100
+                color: "white"
+
+                TextEdit {
+                    id: rulesInput
+                    anchors.fill: parent
+                    anchors.margins: 5
+                    font.pixelSize: 13
+                    text: LogFilter.rules
+                    onTextChanged: rulesTimer.restart()
+                }
+            }
+
+            Text {
+                text: "配置文件: " + LogFilter.configPath
+                color: "#7f8c8d"
+                font.pixelSize: 12
+                width: parent.width - 40
+                wrapMode: Text.WrapAnywhere
+            }
+        }
+
+        // 当前生效的规则
+        Column {
+            width: parent.width
+            spacing: 10
+
+            Text {
+                text: "当前生效的规则"
+                font.pixelSize: 14
+                color: "#2c3e50"
+            }
+
+            Text {
+                text: LogFilter.effectiveRules === "" ? "（无，记录全部日志）" : LogFilter.effectiveRules
+                color: "#7f8c8d"
+                font.pixelSize: 12
+                width: parent.width - 40
+                wrapMode: Text.WrapAnywhere
+            }
+        }
+    }
+
+    // 输入停止后再应用规则
+    Timer {
+        id: rulesTimer
+        interval: 500
+        onTriggered: LogFilter.rules = rulesInput.text
+    }
+}
@@ -131,6 +131,28 @@ ZiyanWindow {
                             }
                         }
                     }
+
+                    // 新增：日志选项
+                    Rectangle {
+                        width: parent.width
+                        height: 50
+                        color: settingsStack.currentIndex === 4 ? "#34495e" : "transparent"
+
+                        Text {
+                            text: "日志"
+                            color: "white"
+                            font.pixelSize: 14
+                            font.bold: true
+                            anchors.centerIn: parent
+                        }
+
+                        MouseArea {
+                            anchors.fill: parent
+                            onClicked: {
+                                settingsStack.currentIndex = 4
+                            }
+                        }
+                    }
                 }
             }
 
@@ -195,6 +217,11 @@ ZiyanWindow {
                         ResolutionPage {
                             width: parent.width
                         }
+
+                        // 新增：日志过滤设置页面
+                        LoggingPage {
+                            width: parent.width
+                        }
                     }
                 }
             }
@@ -24,25 +24,9 @@ Item {
     // 设置管理器
     property var settingsManager: SettingsManager {}
 
-    // 壁纸管理器
+    // 壁纸管理器（新增：本身就是系统壁纸的列表模型，在后台加载）
     property var wallpaperManager: WallpaperManager {
         id: wallpaperManager
-        onWallpapersLoaded: {
-            if (success) {
-                // 更新系统壁纸列表
-                systemWallpaperModel.clear()
-                var wallpapers = wallpaperManager.wallpapers
-                for (var i = 0; i < wallpapers.length; i++) {
-                    var wp = wallpapers[i]
-                    systemWallpaperModel.append({
-                        id: wp.id,
-                        name: wp.name,
-                        description: wp.description,
-                        imagePath: wp.imagePath
-                    })
-                }
-            }
-        }
     }
 
     // 当前选中的壁纸ID
@@ -50,11 +34,6 @@ Item {
     property string currentWallpaperName: ""
     property string currentWallpaperDescription: ""
 
-    // 系统壁纸数据模型
-    ListModel {
-        id: systemWallpaperModel
-    }
-
     Column {
         id: wallpaperContent
         width: parent.width
@@ -195,16 +174,23 @@ Item {
                 }
             }
 
-            // 系统壁纸网格
+            // 系统壁纸网格（新增：最多显示4行，其余在网格内滚动，只创建可见的格子，
+            // 滚出可见区域的格子销毁时取消还没有开始的缩略图请求）
             GridView {
                 id: systemWallpaperGrid
                 width: parent.width
-                height: Math.ceil(systemWallpaperModel.count / 3) * 130
+                height: Math.min(Math.ceil(wallpaperManager.count / 3), 4) * cellHeight + 20
                 cellWidth: parent.width / 3 - 20
                 cellHeight: 100
-                model: systemWallpaperModel
+                model: wallpaperManager
                 clip: true
-                visible: systemWallpaperModel.count > 0
+                visible: wallpaperManager.count > 0
+                boundsBehavior: Flickable.StopAtBounds
+
+                ScrollBar.vertical: ScrollBar {
+                    policy: systemWallpaperGrid.contentHeight > systemWallpaperGrid.height
+                            ? ScrollBar.AlwaysOn : ScrollBar.AsNeeded
+                }
 
                 delegate: Rectangle {
                     width: systemWallpaperGrid.cellWidth - 10
@@ -221,10 +207,11 @@ Item {
                         border.width: currentWallpaperId === model.id ? 2 : 0
                         border.color: "#3498db"
 
-                        // 缩略图
+                        // 缩略图（新增：由缩略图服务按需生成并缓存，还没有生成时先显示底色）
                         Image {
                             anchors.fill: parent
-                            source: model.imagePath
+                            source: model.thumbnail
+                            sourceSize: Qt.size(width, height)
                             fillMode: Image.PreserveAspectCrop
                             asynchronous: true
                         }
@@ -280,7 +267,7 @@ Item {
                 height: 80
                 color: "#f8f9fa"
                 radius: 6
-                visible: systemWallpaperModel.count === 0
+                visible: wallpaperManager.count === 0 && !wallpaperManager.loading
 
                 Column {
                     anchors.centerIn: parent
@@ -384,6 +371,67 @@ Item {
                 }
             }
         }
+
+        // 新增：壁纸幻灯片（轮换系统壁纸，间隔和顺序保存在设置中）
+        Column {
+            width: parent.width
+            spacing: 10
+
+            Text {
+                text: "壁纸幻灯片"
+                font.pixelSize: 14
+                color: "#2c3e50"
+            }
+
+            Row {
+                spacing: 10
+
+                Switch {
+                    id: slideshowSwitch
+                    text: "轮换系统壁纸"
+                    checked: settingsManager.settings.slideshowEnabled === true
+                    onToggled: {
+                        settingsManager.settings.slideshowEnabled = checked
+                        settingsManager.saveSettings()
+                    }
+                }
+
+                ComboBox {
+                    width: 120
+                    enabled: slideshowSwitch.checked
+                    textRole: "text"
+                    valueRole: "value"
+                    model: [
+                        { text: "每1分钟", value: 60 },
+                        { text: "每5分钟", value: 300 },
+                        { text: "每15分钟", value: 900 },
+                        { text: "每30分钟", value: 1800 },
+                        { text: "每1小时", value: 3600 }
+                    ]
+                    Component.onCompleted: currentIndex = indexOfValue(settingsManager.settings.slideshowInterval)
+                    onActivated: {
+                        settingsManager.settings.slideshowInterval = currentValue
+                        settingsManager.saveSettings()
+                    }
+                }
+
+                ComboBox {
+                    width: 100
+                    enabled: slideshowSwitch.checked
+                    textRole: "text"
+                    valueRole: "value"
+                    model: [
+                        { text: "顺序", value: "sequential" },
+                        { text: "随机", value: "random" }
+                    ]
+                    Component.onCompleted: currentIndex = indexOfValue(settingsManager.settings.slideshowOrder)
+                    onActivated: {
+                        settingsManager.settings.slideshowOrder = currentValue
+                        settingsManager.saveSettings()
+                    }
+                }
+            }
+        }
     }
 
     // 加载系统壁纸
@@ -0,0 +1,314 @@
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QTextStream>
+
+#include "LogBinaryFormat.h"
+
+#ifdef ZIYANOS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// 日志等级的严重程度（QtMsgType的数值不是按严重程度排列的）
+static int severity(int level)
+{
+    switch (level) {
+    case QtDebugMsg:    return 0;
+    case QtInfoMsg:     return 1;
+    case QtWarningMsg:  return 2;
+    case QtCriticalMsg: return 3;
+    case QtFatalMsg:    return 4;
+    default:            return 0;
+    }
+}
+
+// 解析等级名称，无效时返回-1
+static int parseSeverity(const QString &name)
+{
+    const QString value = name.trimmed().toLower();
+    if (value == "debug") return 0;
+    if (value == "info") return 1;
+    if (value == "warning") return 2;
+    if (value == "critical") return 3;
+    if (value == "fatal") return 4;
+    return -1;
+}
+
+// 解析时间参数（本地时间），返回自纪元起的纳秒数，无效时返回false
+static bool parseTime(const QString &text, qint64 *timestamp)
+{
+    static const char *const formats[] = {
+        "yyyy-MM-dd HH:mm:ss.zzz",
+        "yyyy-MM-dd HH:mm:ss",
+        "yyyy-MM-dd HH:mm",
+        "yyyy-MM-dd",
+    };
+
+    QDateTime time;
+    for (const char *format : formats) {
+        time = QDateTime::fromString(text.trimmed(), QString::fromLatin1(format));
+        if (time.isValid()) {
+            break;
+        }
+    }
+    if (!time.isValid()) {
+        time = QDateTime::fromString(text.trimmed(), Qt::ISODateWithMs);
+    }
+    if (!time.isValid()) {
+        return false;
+    }
+
+    *timestamp = time.toMSecsSinceEpoch() * 1000000;
+    return true;
+}
+
+// 过滤条件
+struct Filter {
+    bool hasFrom = false;
+    bool hasTo = false;
+    qint64 from = 0;
+    qint64 to = 0;
+    QSet<QString> categories;   // 为空时不过滤，同时匹配分类和writeLog的标签
+    int minimumSeverity = 0;
+
+    bool accepts(const LogBinaryReader::Entry &entry) const
+    {
+        // 启动和结束标记没有时间和分类，只在不过滤时输出
+        if (entry.kind == LogRecord::Raw) {
+            return !hasFrom && !hasTo && categories.isEmpty() && minimumSeverity == 0;
+        }
+        if (hasFrom && entry.timestamp < from) {
+            return false;
+        }
+        if (hasTo && entry.timestamp > to) {
+            return false;
+        }
+        if (!categories.isEmpty() && !categories.contains(entry.category) && !categories.contains(entry.label)) {
+            return false;
+        }
+        return severity(entry.level) >= minimumSeverity;
+    }
+};
+
+static QJsonObject entryToJson(const LogBinaryReader::Entry &entry, LogLineFormatter *formatter)
+{
+    QJsonObject object;
+    if (entry.kind == LogRecord::Raw) {
+        object["message"] = entry.message;
+        return object;
+    }
+
+    object["time"] = formatter->formatTimestamp(entry.timestamp);
+    object["timestamp"] = QString::number(entry.timestamp);
+    object["thread"] = static_cast<qint64>(entry.threadId);
+    object["level"] = LogLineFormatter::levelName(entry.level);
+    object["category"] = entry.category;
+    if (!entry.label.isEmpty()) {
+        object["label"] = entry.label;
+    }
+    object["message"] = entry.message;
+
+    if (entry.kind == LogRecord::Structured) {
+        object["format"] = entry.format;
+        object["file"] = entry.file;
+        object["line"] = entry.line;
+
+        QJsonArray arguments;
+        for (const QVariant &argument : entry.arguments) {
+            arguments.append(QJsonValue::fromVariant(argument));
+        }
+        object["arguments"] = arguments;
+    }
+    return object;
+}
+
+// 读取日志分段压缩后的文件（.zlog.zst），解压到data
+static bool readCompressed(QFile *file, QByteArray *data, QString *error)
+{
+#ifdef ZIYANOS_HAVE_ZSTD
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    QByteArray output(static_cast<qsizetype>(ZSTD_DStreamOutSize()), Qt::Uninitialized);
+    size_t result = 0;
+
+    while (!file->atEnd()) {
+        const QByteArray chunk = file->read(static_cast<qint64>(ZSTD_DStreamInSize()));
+        ZSTD_inBuffer input = { chunk.constData(), static_cast<size_t>(chunk.size()), 0 };
+        // 输出缓冲区写满时解压器内可能还有数据，需要继续调用
+        bool outputFull = false;
+        while (input.pos < input.size || outputFull) {
+            ZSTD_outBuffer out = { output.data(), static_cast<size_t>(output.size()), 0 };
+            result = ZSTD_decompressStream(context, &out, &input);
+            if (ZSTD_isError(result)) {
+                *error = QString("解压失败: %1").arg(ZSTD_getErrorName(result));
+                ZSTD_freeDCtx(context);
+                return false;
+            }
+            data->append(output.constData(), static_cast<qsizetype>(out.pos));
+            outputFull = out.pos == out.size;
+        }
+    }
+    ZSTD_freeDCtx(context);
+
+    // 压缩中断的文件末尾不完整，已解压的部分仍然可以解码
+    if (result != 0) {
+        *error = "压缩文件不完整";
+    }
+    return true;
+#else
+    Q_UNUSED(file);
+    Q_UNUSED(data);
+    *error = "编译时未找到zstd，不支持压缩的日志文件";
+    return false;
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("ZiyanLogDecoder");
+    app.setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("字研OS二进制日志（.zlog）解码工具：转换为文本或JSON（每行一个对象），"
+                                     "可以按时间范围、分类和等级过滤");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("files", "要解码的.zlog文件（或分段压缩后的.zlog.zst）", "<文件...>");
+    parser.addOptions({
+        { "json", "输出JSON（每行一个对象）" },
+        { "from", "只输出这个时间之后的日志（本地时间，例如\"2025-01-01 12:00:00\"）", "时间" },
+        { "to", "只输出这个时间之前的日志", "时间" },
+        { "category", "只输出这些分类的日志，可以重复或用逗号分隔", "分类" },
+        { "level", "最低等级：debug、info、warning、critical、fatal", "等级" },
+        { { "o", "output" }, "输出到文件（默认输出到标准输出）", "文件" },
+    });
+    parser.process(app);
+
+    QTextStream err(stderr);
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        parser.showHelp(2);
+    }
+
+    Filter filter;
+    if (parser.isSet("from")) {
+        if (!parseTime(parser.value("from"), &filter.from)) {
+            err << "时间无效: " << parser.value("from") << Qt::endl;
+            return 2;
+        }
+        filter.hasFrom = true;
+    }
+    if (parser.isSet("to")) {
+        if (!parseTime(parser.value("to"), &filter.to)) {
+            err << "时间无效: " << parser.value("to") << Qt::endl;
+            return 2;
+        }
+        filter.hasTo = true;
+    }
+    for (const QString &value : parser.values("category")) {
+        for (const QString &category : value.split(',', Qt::SkipEmptyParts)) {
+            filter.categories.insert(category.trimmed());
+        }
+    }
+    if (parser.isSet("level")) {
+        filter.minimumSeverity = parseSeverity(parser.value("level"));
+        if (filter.minimumSeverity < 0) {
+            err << "等级无效: " << parser.value("level") << Qt::endl;
+            return 2;
+        }
+    }
+
+    QFile output;
+    if (parser.isSet("output")) {
+        output.setFileName(parser.value("output"));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "无法创建输出文件: " << output.fileName() << Qt::endl;
+            return 2;
+        }
+    } else if (!output.open(stdout, QIODevice::WriteOnly)) {
+        err << "无法打开标准输出" << Qt::endl;
+        return 2;
+    }
+
+    const bool json = parser.isSet("json");
+    LogLineFormatter formatter;
+    QString text;
+    int failures = 0;
+
+    for (const QString &path : files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "无法打开文件: " << path << Qt::endl;
+            failures++;
+            continue;
+        }
+
+        // 分段压缩后的文件先解压到内存
+        QByteArray decompressed;
+        QBuffer buffer(&decompressed);
+        QIODevice *device = &file;
+        if (path.endsWith(".zst")) {
+            QString error;
+            if (!readCompressed(&file, &decompressed, &error)) {
+                err << path << ": " << error << Qt::endl;
+                failures++;
+                continue;
+            }
+            if (!error.isEmpty()) {
+                err << path << ": " << error << Qt::endl;
+                failures++;
+            }
+            buffer.open(QIODevice::ReadOnly);
+            device = &buffer;
+        }
+
+        LogBinaryReader reader(device);
+        if (!reader.open()) {
+            err << path << ": " << reader.errorString() << Qt::endl;
+            failures++;
+            continue;
+        }
+
+        LogBinaryReader::Entry entry;
+        while (reader.next(&entry)) {
+            if (!filter.accepts(entry)) {
+                continue;
+            }
+
+            if (json) {
+                output.write(QJsonDocument(entryToJson(entry, &formatter)).toJson(QJsonDocument::Compact));
+                output.write("\n");
+            } else {
+                if (entry.kind == LogRecord::Raw) {
+                    text.append(entry.message);
+                    text.append(QLatin1Char('\n'));
+                } else {
+                    formatter.append(&text, entry.timestamp, entry.level, entry.label, entry.category, entry.message);
+                }
+                // 攒够一批再转换和写出
+                if (text.size() >= 64 * 1024) {
+                    output.write(text.toUtf8());
+                    text.clear();
+                }
+            }
+        }
+        if (!text.isEmpty()) {
+            output.write(text.toUtf8());
+            text.clear();
+        }
+
+        // 程序异常退出时文件末尾可能不完整，之前的日志仍然有效
+        if (!reader.errorString().isEmpty()) {
+            err << path << ": " << reader.errorString() << Qt::endl;
+            failures++;
+        }
+    }
+
+    return failures > 0 ? 1 : 0;
+}